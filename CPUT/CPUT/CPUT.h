@@ -282,6 +282,11 @@ enum CPUT_DATA_FORMAT_TYPE
 
     CPUT_CHAR=11,
     CPUT_BOOL=12,
+
+    // Quantized vertex data (see CPUTVertexQuantizer.h)
+    CPUT_F16=13,
+    CPUT_U16_NORM=14,
+    CPUT_I16_NORM=15,
 };
 
 // Corresponding sizes (in bytes) that match CPUT_DATA_FORMAT_TYPE
@@ -306,6 +311,10 @@ const int CPUT_DATA_FORMAT_SIZE[] =
 
         1, //CPUT_CHAR
         1, //CPUT_BOOL
+
+        2, //CPUT_F16
+        2, //CPUT_U16_NORM
+        2, //CPUT_I16_NORM
 };
 
 //-----------------------------------------------------------------------------
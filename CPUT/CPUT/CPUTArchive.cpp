@@ -0,0 +1,254 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTArchive.h"
+#include <algorithm>
+#include <string.h>
+
+#ifdef CPUT_ARCHIVE_LZ4
+#include <lz4.h>
+#endif
+#ifdef CPUT_ARCHIVE_ZSTD
+#include <zstd.h>
+#endif
+
+//-----------------------------------------------------------------------------
+CPUTArchive::CPUTArchive() :
+    mpHeader(NULL),
+    mpEntries(NULL),
+    mpNames(NULL)
+{
+}
+
+//-----------------------------------------------------------------------------
+CPUTArchive::~CPUTArchive()
+{
+    Close();
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTArchive::Open(const CPUTMappedFile::PathChar *fileName)
+{
+    Close();
+    if(!mFile.Open(fileName))
+    {
+        return false;
+    }
+
+    // Trust nothing in the header: every range must lie inside the file
+    const unsigned char *pBase = mFile.GetData();
+    uint64_t fileSize = mFile.GetSize();
+    const CPUTArchiveHeader *pHeader = (const CPUTArchiveHeader *)pBase;
+    if(fileSize < sizeof(CPUTArchiveHeader) ||
+       pHeader->magic != CPUT_ARCHIVE_MAGIC ||
+       pHeader->version != CPUT_ARCHIVE_VERSION ||
+       pHeader->headerSize != sizeof(CPUTArchiveHeader) ||
+       pHeader->tocOffset > fileSize ||
+       pHeader->entryCount > (fileSize - pHeader->tocOffset) / sizeof(CPUTArchiveEntry) ||
+       pHeader->namesOffset > fileSize ||
+       pHeader->namesSize > fileSize - pHeader->namesOffset)
+    {
+        Close();
+        return false;
+    }
+    const CPUTArchiveEntry *pEntries = (const CPUTArchiveEntry *)(pBase + pHeader->tocOffset);
+    for(uint32_t ii=0; ii<pHeader->entryCount; ii++)
+    {
+        const CPUTArchiveEntry &entry = pEntries[ii];
+        if(entry.offset > fileSize || entry.storedSize > fileSize - entry.offset ||
+           (uint64_t)entry.nameOffset + entry.nameLength > pHeader->namesSize ||
+           (entry.compression == CPUT_ARCHIVE_COMPRESSION_NONE && entry.storedSize != entry.size) ||
+           (ii > 0 && pEntries[ii-1].nameHash > entry.nameHash))
+        {
+            Close();
+            return false;
+        }
+    }
+    mpHeader  = pHeader;
+    mpEntries = pEntries;
+    mpNames   = (const char *)(pBase + pHeader->namesOffset);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTArchive::Close()
+{
+    mFile.Close();
+    mpHeader  = NULL;
+    mpEntries = NULL;
+    mpNames   = NULL;
+}
+
+//-----------------------------------------------------------------------------
+std::string CPUTArchive::NormalizeName(const std::string &name)
+{
+    std::string normalized(name);
+    for(size_t ii=0; ii<normalized.size(); ii++)
+    {
+        char ch = normalized[ii];
+        if(ch == '\\')
+        {
+            normalized[ii] = '/';
+        }
+        else if(ch >= 'A' && ch <= 'Z')
+        {
+            normalized[ii] = ch - 'A' + 'a';
+        }
+    }
+    size_t start = 0;
+    while(start < normalized.size() &&
+          (normalized[start] == '/' || (normalized[start] == '.' && start + 1 < normalized.size() && normalized[start+1] == '/')))
+    {
+        start += normalized[start] == '/' ? 1 : 2;
+    }
+    return normalized.substr(start);
+}
+
+//-----------------------------------------------------------------------------
+uint64_t CPUTArchive::HashName(const std::string &name)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for(size_t ii=0; ii<name.size(); ii++)
+    {
+        hash ^= (unsigned char)name[ii];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+//-----------------------------------------------------------------------------
+std::string CPUTArchive::GetName(const CPUTArchiveEntry *pEntry) const
+{
+    return std::string(mpNames + pEntry->nameOffset, pEntry->nameLength);
+}
+
+//-----------------------------------------------------------------------------
+const CPUTArchiveEntry *CPUTArchive::Find(const std::string &name) const
+{
+    if(!mpHeader)
+    {
+        return NULL;
+    }
+    uint64_t hash = HashName(name);
+    const CPUTArchiveEntry *pEnd = mpEntries + mpHeader->entryCount;
+    const CPUTArchiveEntry *pEntry = std::lower_bound(mpEntries, pEnd, hash,
+        [](const CPUTArchiveEntry &entry, uint64_t value) { return entry.nameHash < value; });
+    for(; pEntry != pEnd && pEntry->nameHash == hash; pEntry++)
+    {
+        if(pEntry->nameLength == name.size() && 0 == memcmp(mpNames + pEntry->nameOffset, name.data(), name.size()))
+        {
+            return pEntry;
+        }
+    }
+    return NULL;
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTArchive::Decompress(uint16_t compression, const void *pSrc, size_t srcSize, void *pDst, size_t dstSize)
+{
+    switch(compression)
+    {
+    case CPUT_ARCHIVE_COMPRESSION_NONE:
+        if(srcSize != dstSize)
+        {
+            return false;
+        }
+        memcpy(pDst, pSrc, srcSize);
+        return true;
+#ifdef CPUT_ARCHIVE_LZ4
+    case CPUT_ARCHIVE_COMPRESSION_LZ4:
+        if(srcSize > 0x7fffffff || dstSize > 0x7fffffff)
+        {
+            return false;
+        }
+        return LZ4_decompress_safe((const char *)pSrc, (char *)pDst, (int)srcSize, (int)dstSize) == (int)dstSize;
+#endif
+#ifdef CPUT_ARCHIVE_ZSTD
+    case CPUT_ARCHIVE_COMPRESSION_ZSTD:
+        {
+            size_t result = ZSTD_decompress(pDst, dstSize, pSrc, srcSize);
+            return !ZSTD_isError(result) && result == dstSize;
+        }
+#endif
+    default:
+        return false;
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTArchive::Compress(uint16_t compression, const void *pSrc, size_t srcSize, std::vector<unsigned char> *pDst)
+{
+    size_t compressedSize = 0;
+    switch(compression)
+    {
+#ifdef CPUT_ARCHIVE_LZ4
+    case CPUT_ARCHIVE_COMPRESSION_LZ4:
+        {
+            if(srcSize > LZ4_MAX_INPUT_SIZE)
+            {
+                return false;
+            }
+            pDst->resize(LZ4_compressBound((int)srcSize));
+            int result = LZ4_compress_default((const char *)pSrc, (char *)&(*pDst)[0], (int)srcSize, (int)pDst->size());
+            compressedSize = result > 0 ? (size_t)result : 0;
+        }
+        break;
+#endif
+#ifdef CPUT_ARCHIVE_ZSTD
+    case CPUT_ARCHIVE_COMPRESSION_ZSTD:
+        {
+            pDst->resize(ZSTD_compressBound(srcSize));
+            size_t result = ZSTD_compress(&(*pDst)[0], pDst->size(), pSrc, srcSize, 19);
+            compressedSize = ZSTD_isError(result) ? 0 : result;
+        }
+        break;
+#endif
+    default:
+        break;
+    }
+    if(0 == compressedSize)
+    {
+        (void)pSrc; // unused without either library
+        (void)srcSize;
+        return false;
+    }
+    pDst->resize(compressedSize);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTArchive::Read(const CPUTArchiveEntry *pEntry, CPUTArchiveData *pData) const
+{
+    const unsigned char *pStored = mFile.GetData() + pEntry->offset;
+    if(pEntry->compression == CPUT_ARCHIVE_COMPRESSION_NONE)
+    {
+        pData->pData = pStored;
+        pData->size  = (size_t)pEntry->size;
+        return true;
+    }
+    if(pEntry->size > (size_t)-1)
+    {
+        return false;
+    }
+    pData->storage.resize((size_t)pEntry->size);
+    if(!Decompress(pEntry->compression, pStored, (size_t)pEntry->storedSize, pData->storage.empty() ? NULL : &pData->storage[0], pData->storage.size()))
+    {
+        pData->storage.clear();
+        return false;
+    }
+    pData->pData = pData->storage.empty() ? NULL : &pData->storage[0];
+    pData->size  = pData->storage.size();
+    return true;
+}
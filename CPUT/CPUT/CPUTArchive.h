@@ -0,0 +1,139 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTARCHIVE_H__
+#define __CPUTARCHIVE_H__
+
+// Packed asset archive (.cpak): many media files in one, read through a single file mapping.
+//
+//   CPUTArchiveHeader
+//   payloads, each starting on a multiple of the header's alignment (4KB for .dds, .mdl,
+//             .set and .mtl, so they can be handed to the loaders and the GPU straight from
+//             the mapping), optionally LZ4 or zstd compressed
+//   CPUTArchiveEntry[entryCount], sorted by nameHash
+//   names, UTF-8, not terminated
+//
+// Names are paths relative to the packed directory, lower case, with '/' separators
+// (see NormalizeName()).  Lookups hash the name and binary search the table of contents.
+//
+// Only depends on the C++ standard library and CPUTMappedFile, so the packer tool shares it.
+// LZ4 and zstd entries need CPUT_ARCHIVE_LZ4 or CPUT_ARCHIVE_ZSTD defined (and the library linked);
+// without them those entries fail to read, and the rest of the archive still works.
+#include "CPUTMappedFile.h"
+#include <stdint.h>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#define CPUT_ARCHIVE_MAGIC     0x4B415043 // "CPAK"
+#define CPUT_ARCHIVE_VERSION   1
+#define CPUT_ARCHIVE_ALIGNMENT 4096
+
+enum CPUTArchiveCompression
+{
+    CPUT_ARCHIVE_COMPRESSION_NONE = 0,
+    CPUT_ARCHIVE_COMPRESSION_LZ4  = 1,
+    CPUT_ARCHIVE_COMPRESSION_ZSTD = 2,
+};
+
+#pragma pack(push,1)
+struct CPUTArchiveHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;
+    uint32_t entryCount;
+    uint32_t alignment;
+    uint64_t tocOffset;
+    uint64_t namesOffset;
+    uint64_t namesSize;
+};
+
+struct CPUTArchiveEntry
+{
+    uint64_t nameHash;
+    uint64_t offset;      // of the payload, from the start of the archive
+    uint64_t storedSize;  // bytes in the archive
+    uint64_t size;        // bytes once decompressed
+    uint32_t nameOffset;  // into the names block
+    uint16_t nameLength;
+    uint16_t compression; // CPUTArchiveCompression
+};
+#pragma pack(pop)
+
+// The bytes of one archived file.  Uncompressed entries point into the archive's mapping;
+// compressed ones are decompressed into storage.
+struct CPUTArchiveData
+{
+    const unsigned char        *pData;
+    size_t                      size;
+    std::vector<unsigned char>  storage;
+
+    CPUTArchiveData() : pData(NULL), size(0) {}
+};
+
+// Read only std::istream source over memory, for loaders written against streams
+class CPUTArchiveStreamBuf : public std::streambuf
+{
+public:
+    CPUTArchiveStreamBuf(const unsigned char *pData, size_t size)
+    {
+        char *pBegin = (char*)pData;
+        setg(pBegin, pBegin, pBegin + size);
+    }
+};
+
+class CPUTArchive
+{
+public:
+    CPUTArchive();
+    ~CPUTArchive();
+
+    // Maps the archive and validates its table of contents.  Returns false if it isn't one.
+    bool Open(const CPUTMappedFile::PathChar *fileName);
+    void Close();
+    bool IsOpen() const { return mpHeader != NULL; }
+
+    // name must already be normalized.  Returns NULL if it isn't in the archive.
+    const CPUTArchiveEntry *Find(const std::string &name) const;
+
+    // Fill pData with the entry's bytes.  Returns false on a decompression error or when the
+    // entry's compression isn't compiled in.
+    bool Read(const CPUTArchiveEntry *pEntry, CPUTArchiveData *pData) const;
+
+    uint32_t                GetEntryCount() const { return mpHeader ? mpHeader->entryCount : 0; }
+    const CPUTArchiveEntry *GetEntry(uint32_t index) const { return &mpEntries[index]; }
+    std::string             GetName(const CPUTArchiveEntry *pEntry) const;
+
+    // Lower case, '/' separators, no leading "./" or '/'
+    static std::string NormalizeName(const std::string &name);
+    // 64-bit FNV-1a of a normalized name
+    static uint64_t    HashName(const std::string &name);
+    // Decompress srcSize bytes into exactly dstSize bytes
+    static bool        Decompress(uint16_t compression, const void *pSrc, size_t srcSize, void *pDst, size_t dstSize);
+    // For tools.  Returns false if the compression isn't compiled in or fails.
+    static bool        Compress(uint16_t compression, const void *pSrc, size_t srcSize, std::vector<unsigned char> *pDst);
+
+private:
+    CPUTMappedFile           mFile;
+    const CPUTArchiveHeader *mpHeader;
+    const CPUTArchiveEntry  *mpEntries;
+    const char              *mpNames;
+
+    CPUTArchive(const CPUTArchive &);
+    CPUTArchive &operator=(const CPUTArchive &);
+};
+
+#endif // __CPUTARCHIVE_H__
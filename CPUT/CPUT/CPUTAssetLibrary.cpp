@@ -96,6 +96,23 @@ void CPUTAssetLibrary::RebindTexturesAndBuffers()
     }
 }
 
+//-----------------------------------------------------------------------------
+void CPUTAssetLibrary::RebindTexture(CPUTTexture *pTexture)
+{
+    CPUTAssetListEntry *pMaterial = mpMaterialList;
+    while( pMaterial )
+    {
+        ((CPUTMaterial*)pMaterial->pData)->RebindTexture( pTexture );
+        pMaterial = pMaterial->pNext;
+    }
+    pMaterial = mpInstancedMaterialList;
+    while( pMaterial )
+    {
+        ((CPUTMaterial*)pMaterial->pData)->RebindTexture( pTexture );
+        pMaterial = pMaterial->pNext;
+    }
+}
+
 //-----------------------------------------------------------------------------
 void CPUTAssetLibrary::DeleteAssetLibrary()
 {
@@ -401,28 +418,48 @@ CPUTLight *CPUTAssetLibrary::GetLight(const cString &name)
 }
 
 //-----------------------------------------------------------------------------
-CPUTTexture *CPUTAssetLibrary::GetTexture(const cString &name, bool nameIsFullPathAndFilename, bool loadAsSRGB )
+CPUTTexture *CPUTAssetLibrary::FindOrCreateTexture(const cString &name, bool nameIsFullPathAndFilename, bool loadAsSRGB, CPUTCreateTextureFunction pCreate )
 {
     cString finalName;
     if( name.at(0) == '$' )
     {
+        // Render targets and other named textures are created, not loaded
         finalName = name;
+        pCreate   = CPUTTexture::CreateTexture;
     } else
     {
         // Resolve name to absolute path
         CPUTOSServices *pServices = CPUTOSServices::GetOSServices();
         pServices->ResolveAbsolutePathAndFilename( nameIsFullPathAndFilename? name : (mTextureDirectoryName + name), &finalName);
     }
-    // If we already have one by this name, then return it
+    // If we already have one by this name (loaded, pending or streaming), then return it
     CPUTTexture *pTexture = FindTexture(finalName, true);
     if(NULL==pTexture)
     {
-        return CPUTTexture::CreateTexture( name, finalName, loadAsSRGB);
+        return pCreate( name, finalName, loadAsSRGB);
     }
     pTexture->AddRef();
     return pTexture;
 }
 
+//-----------------------------------------------------------------------------
+CPUTTexture *CPUTAssetLibrary::GetTexture(const cString &name, bool nameIsFullPathAndFilename, bool loadAsSRGB )
+{
+    return FindOrCreateTexture( name, nameIsFullPathAndFilename, loadAsSRGB, CPUTTexture::CreateTexture );
+}
+
+//-----------------------------------------------------------------------------
+CPUTTexture *CPUTAssetLibrary::GetTextureAsync(const cString &name, bool nameIsFullPathAndFilename, bool loadAsSRGB )
+{
+    return FindOrCreateTexture( name, nameIsFullPathAndFilename, loadAsSRGB, CPUTTexture::CreateTextureAsync );
+}
+
+//-----------------------------------------------------------------------------
+CPUTTexture *CPUTAssetLibrary::GetStreamingTexture(const cString &name, bool nameIsFullPathAndFilename, bool loadAsSRGB )
+{
+    return FindOrCreateTexture( name, nameIsFullPathAndFilename, loadAsSRGB, CPUTTexture::CreateTextureStreaming );
+}
+
 //-----------------------------------------------------------------------------
 CPUTBuffer *CPUTAssetLibrary::GetBuffer(const cString &name, const CPUTModel *pModel, int meshIndex )
 {
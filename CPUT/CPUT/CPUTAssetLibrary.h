@@ -68,6 +68,17 @@ protected:
     cString  mShaderDirectoryName;
     cString  mFontDirectoryName;
 
+    bool     mLoadTexturesAsync;
+    bool     mStreamTextures;
+    bool     mCacheTextureMetadata;
+    bool     mOptimizeMeshes;
+    bool     mQuantizeVertices;
+    bool     mClusterMeshes;
+    bool     mLoadAssetSetsInParallel;
+    UINT     mMeshLodCount;
+    bool     mShadowPositionStreams;
+    bool     mBatchStaticModels;
+
 public: // TODO: temporary for debug.
     // TODO: Make these lists static.  Share assets (e.g., texture) across all requests for this process.
     static CPUTAssetListEntry  *mpAssetSetList;
@@ -107,12 +118,15 @@ public: // TODO: temporary for debug.
 
     static void RebindTexturesAndBuffers();
     static void ReleaseTexturesAndBuffers();
+    // Points every material that uses pTexture at its current shader resource view, after the
+    // texture swapped views, leaving the other materials' bindings alone
+    static void RebindTexture(CPUTTexture *pTexture);
 
 public:
     static CPUTAssetLibrary *GetAssetLibrary(){ return mpAssetLibrary; }
     static void              DeleteAssetLibrary();
 
-    CPUTAssetLibrary() {}
+    CPUTAssetLibrary() : mLoadTexturesAsync(false), mStreamTextures(false), mCacheTextureMetadata(false), mOptimizeMeshes(false), mQuantizeVertices(false), mClusterMeshes(false), mLoadAssetSetsInParallel(false), mMeshLodCount(0), mShadowPositionStreams(false), mBatchStaticModels(false) {}
     virtual ~CPUTAssetLibrary() {}
 
     // Add/get/delete items to specified library
@@ -152,6 +166,49 @@ public:
     cString &GetShaderDirectoryName()   { return mShaderDirectoryName; }
     cString &GetFontDirectoryName()     { return mFontDirectoryName; }
 
+    // When set, materials load their textures with GetTextureAsync() instead of GetTexture()
+    void SetLoadTexturesAsync( bool loadTexturesAsync ) { mLoadTexturesAsync = loadTexturesAsync; }
+    bool GetLoadTexturesAsync() const                   { return mLoadTexturesAsync; }
+    // When set, materials load their textures with GetStreamingTexture().  Takes precedence over async.
+    void SetStreamTextures( bool streamTextures )       { mStreamTextures = streamTextures; }
+    bool GetStreamTextures() const                      { return mStreamTextures; }
+    // When set, loading name.dds reads or writes its parsed metadata in name.dds.ddscache (see DDSImageCache.h).
+    // Archived textures are always parsed.
+    void SetCacheTextureMetadata( bool cacheTextureMetadata ) { mCacheTextureMetadata = cacheTextureMetadata; }
+    bool GetCacheTextureMetadata() const                      { return mCacheTextureMetadata; }
+    // When set, models reorder their meshes for the vertex cache, overdraw and vertex fetch as they load
+    // (see CPUTMeshOptimizer.h).  That copies each mesh first; files cooked with MDLOptimize don't need it.
+    void SetOptimizeMeshes( bool optimizeMeshes )       { mOptimizeMeshes = optimizeMeshes; }
+    bool GetOptimizeMeshes() const                      { return mOptimizeMeshes; }
+    // When set, models pack their vertices into 16-bit positions, directions and texture coordinates
+    // as they load (see CPUTVertexQuantizer.h), which their shaders must decode; the default shader does.
+    void SetQuantizeVertices( bool quantizeVertices )   { mQuantizeVertices = quantizeVertices; }
+    bool GetQuantizeVertices() const                    { return mQuantizeVertices; }
+    // When set, models split their meshes into clusters as they load (see CPUTMeshClusters.h) and
+    // only draw the clusters the camera can see.  That copies each mesh's indices.
+    void SetClusterMeshes( bool clusterMeshes )         { mClusterMeshes = clusterMeshes; }
+    bool GetClusterMeshes() const                       { return mClusterMeshes; }
+    // When set, asset sets read and prepare their model files on the worker pool while the owning
+    // thread creates their nodes, materials and buffers in file order (see CPUTAssetSetDX11::LoadAssetSet()).
+    // Pair it with SetLoadTexturesAsync() to decode the materials' textures on the pool too.
+    void SetLoadAssetSetsInParallel( bool loadInParallel ) { mLoadAssetSetsInParallel = loadInParallel; }
+    bool GetLoadAssetSetsInParallel() const                { return mLoadAssetSetsInParallel; }
+    // Above 1, models build up to this many levels of detail per mesh as they load, each with about half
+    // the triangles of the one before (see CPUTMeshSimplifier.h), and draw the coarsest one whose error
+    // covers at most CPUT_MESH_LOD_SCREEN_ERROR of the screen.  That copies each mesh's indices.
+    void SetMeshLodCount( UINT meshLodCount )           { mMeshLodCount = meshLodCount; }
+    UINT GetMeshLodCount() const                        { return mMeshLodCount; }
+    // When set, models also give each mesh a vertex buffer of just its positions, packed or quantized like
+    // the full vertices, and the shadow pass draws from that instead of fetching whole vertices.
+    void SetShadowPositionStreams( bool shadowPositionStreams ) { mShadowPositionStreams = shadowPositionStreams; }
+    bool GetShadowPositionStreams() const                       { return mShadowPositionStreams; }
+    // When set, asset sets merge their small models that share a material into static batches, their
+    // vertices moved into world space once at load (see CPUTStaticBatch.h), and those models stop drawing
+    // themselves.  Only for scenes whose models stay put: moving a batched model doesn't move its batch.
+    // Quantized models and models under a light or camera keep drawing on their own.
+    void SetBatchStaticModels( bool batchStaticModels ) { mBatchStaticModels = batchStaticModels; }
+    bool GetBatchStaticModels() const                   { return mBatchStaticModels; }
+
     void AddAssetSet(        const cString &name, CPUTAssetSet         *pAssetSet)        { AddAsset( name, pAssetSet,         &mpAssetSetList,         &mpAssetSetListTail ); }
     void AddNullNode(        const cString &name, CPUTNullNode         *pNullNode)        { AddAsset( name, pNullNode,         &mpNullNodeList,         &mpNullNodeListTail ); }
     void AddModel(           const cString &name, CPUTModel            *pModel)           { AddAsset( name, pModel,            &mpModelList,            &mpModelListTail    ); }
@@ -193,6 +250,12 @@ public:
     CPUTModel            *GetModel(           const cString &name, bool nameIsFullPathAndFilename=false );
     CPUTMaterial         *GetMaterial(        const cString &name, bool nameIsFullPathAndFilename=false, const CPUTModel *pModel=NULL, int meshIndex=-1 );
     CPUTTexture          *GetTexture(         const cString &name, bool nameIsFullPathAndFilename=false, bool loadAsSRGB=true );
+    // Same as GetTexture(), but a texture that isn't loaded yet comes back bound to a placeholder
+    // and is read on the worker pool.  The real one is swapped in on a later frame.
+    CPUTTexture          *GetTextureAsync(    const cString &name, bool nameIsFullPathAndFilename=false, bool loadAsSRGB=true );
+    // Same as GetTexture(), but a texture that isn't loaded yet only has its mip tail read now.
+    // The bigger levels stream in on later frames.
+    CPUTTexture          *GetStreamingTexture(const cString &name, bool nameIsFullPathAndFilename=false, bool loadAsSRGB=true );
     CPUTRenderStateBlock *GetRenderStateBlock(const cString &name, bool nameIsFullPathAndFilename=false);
     CPUTBuffer           *GetBuffer(          const cString &name, const CPUTModel *pModel=NULL, int meshIndex=-1 );
     CPUTBuffer           *GetConstantBuffer(  const cString &name, const CPUTModel *pModel=NULL, int meshIndex=-1 );
@@ -205,6 +268,10 @@ protected:
     void ReleaseList(CPUTAssetListEntry *pLibraryRoot);
     void AddAsset( const cString &name, void *pAsset, CPUTAssetListEntry **pHead, CPUTAssetListEntry **pTail, const CPUTModel *pModel=NULL, int meshIndex=-1 );
     void AddAssetInstance( const cString &name, void *pAsset, CPUTAssetListEntry **pHead, CPUTAssetListEntry **pTail, CPUTAssetListEntry **pInstanceHead, CPUTAssetListEntry **pInstanceTail, const CPUTModel *pModel=NULL, int meshIndex=-1 );
+    // The Get*Texture() methods: resolve the name, return the library's texture if it has one,
+    // else make one with pCreate.  '$' names are created, not loaded, so they always use CreateTexture().
+    typedef CPUTTexture *(*CPUTCreateTextureFunction)( const cString &name, const cString absolutePathAndFilename, bool loadAsSRGB );
+    CPUTTexture *FindOrCreateTexture( const cString &name, bool nameIsFullPathAndFilename, bool loadAsSRGB, CPUTCreateTextureFunction pCreate );
 
     UINT CPUTComputeHash( const cString &string )
     {
@@ -14,6 +14,7 @@
 // limitations under the License.
 /////////////////////////////////////////////////////////////////////////////////////////////
 #include "CPUTAssetSet.h"
+#include "CPUTModel.h"
 #ifdef CPUT_FOR_DX11
     #include "CPUTAssetLibraryDX11.h"
 #else    
@@ -43,11 +44,48 @@ CPUTAssetSet::~CPUTAssetSet()
     }
 }
 
+//-----------------------------------------------------------------------------
+void CPUTAssetSet::CullModels(CPUTFrustum &frustum)
+{
+    // Models a static batch draws instead (see CPUTAssetSetDX11::LoadAssetSet()) aren't drawn or counted
+    mpCullModels.clear();
+    for( UINT ii=0; ii<mAssetCount; ii++ )
+    {
+        CPUTRenderNode *pNode = mppAssetList[ii];
+        if( pNode && pNode->IsModel() && ((CPUTModel*)pNode)->IsRenderable() )
+        {
+            mpCullModels.push_back( (CPUTModel*)pNode );
+        }
+    }
+    if( mpCullModels.empty() )
+    {
+        return;
+    }
+
+    mCullBoxes.Resize( (UINT)mpCullModels.size() );
+    for( UINT ii=0; ii<mpCullModels.size(); ii++ )
+    {
+        float3 center, half;
+        mpCullModels[ii]->GetBoundsWorldSpace( &center, &half );
+        mCullBoxes.Set( ii, center.f, half.f );
+    }
+    mCullVisible.resize( CPUTCullBoxMaskWords(mCullBoxes.count) );
+    frustum.CullBoxes( mCullBoxes, &mCullVisible[0] );
+    for( UINT ii=0; ii<mpCullModels.size(); ii++ )
+    {
+        mpCullModels[ii]->SetFrustumVisibility( frustum, 0 != ((mCullVisible[ii / 32] >> (ii % 32)) & 1) );
+    }
+}
+
 //-----------------------------------------------------------------------------
 void CPUTAssetSet::RenderRecursive(CPUTRenderParameters &renderParams )
 {
     if(mpRootNode)
     {
+        if( renderParams.mRenderOnlyVisibleModels && renderParams.mpCamera )
+        {
+            CullModels( renderParams.mpCamera->mFrustum );
+        }
         mpRootNode->RenderRecursive(renderParams);
     }
 }
@@ -57,6 +95,10 @@ void CPUTAssetSet::RenderShadowRecursive(CPUTRenderParameters &renderParams )
 {
     if(mpRootNode)
     {
+        if( renderParams.mRenderOnlyVisibleModels && renderParams.mpCamera )
+        {
+            CullModels( renderParams.mpCamera->mFrustum );
+        }
         mpRootNode->RenderShadowRecursive(renderParams);
     }
 }
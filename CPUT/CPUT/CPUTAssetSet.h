@@ -19,9 +19,12 @@
 #include "CPUTRefCount.h"
 #include "CPUTNullNode.h"
 #include "CPUTCamera.h"
+#include "CPUTBoxCulling.h"
+#include <vector>
 
 class CPUTRenderNode;
 class CPUTNullNode;
+class CPUTModel;
 class CPUTRenderParameters;
 
 // initial size and growth defines
@@ -34,6 +37,11 @@ protected:
     CPUTCamera      *mpFirstCamera;
     UINT             mCameraCount;
 
+    // Scratch for CullModels()
+    std::vector<CPUTModel*> mpCullModels;
+    CPUTCullBoxSet          mCullBoxes;
+    std::vector<UINT>       mCullVisible;
+
     ~CPUTAssetSet(); // Destructor is not public.  Must release instead of delete.
 
 public:
@@ -47,6 +55,10 @@ public:
     CPUTRenderNode    *GetRoot() { if(mpRootNode){mpRootNode->AddRef();} return mpRootNode; }
     void               SetRoot( CPUTNullNode *pRoot) { SAFE_RELEASE(mpRootNode); mpRootNode = pRoot; }
     CPUTCamera        *GetFirstCamera() { if(mpFirstCamera){mpFirstCamera->AddRef();} return mpFirstCamera; } // TODO: Consider supporting indexed access to each asset type
+    // Frustum culls every model in the set at once, leaving each its result for its Render() and
+    // RenderShadow() instead of them testing one at a time.  The recursive renders do it first
+    // when the render parameters ask for only the visible models.
+    void               CullModels(CPUTFrustum &frustum);
     void               RenderRecursive(CPUTRenderParameters &renderParams);
     void               RenderShadowRecursive(CPUTRenderParameters &renderParams);
 
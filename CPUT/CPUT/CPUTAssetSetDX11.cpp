@@ -19,6 +19,134 @@
 #include "CPUTAssetLibraryDX11.h"
 #include "CPUTCamera.h"
 #include "CPUTLight.h"
+#include "CPUTMaterial.h"
+#include "CPUTWorkerPool.h"
+#include "CPUTStaticBatch.h"
+#include <algorithm>
+#include <float.h>
+#include <map>
+#include <set>
+#include <string.h>
+
+// The distinct model files of an asset set, read and prepared on the worker pool (see
+// CPUTModel::PrepareModelPayload()) a window ahead of the owning thread, which waits for each
+// in the order the set first uses them and creates the models from them.  Started serially,
+// each is prepared on the owning thread instead, the first time it's waited for.
+//-----------------------------------------------------------------------------
+class CPUTAssetSetPayloads
+{
+public:
+    CPUTAssetSetPayloads() : mSubmitted(0), mWindow(0), mParallel(false) {}
+    ~CPUTAssetSetPayloads()
+    {
+        // Tasks still in flight write to their payloads
+        std::unique_lock<std::mutex> lock(mMutex);
+        for( UINT ii=0; ii<mSubmitted; ii++ )
+        {
+            mReady.wait(lock, [this, ii]() { return mpPayloads[ii]->ready; });
+        }
+        lock.unlock();
+        for( UINT ii=0; ii<mpPayloads.size(); ii++ )
+        {
+            delete mpPayloads[ii]->pPayload;
+            delete mpPayloads[ii];
+        }
+    }
+
+    // Index of the payload for this file, added the first time it's asked for
+    UINT Add(const cString &file, UINT meshCount)
+    {
+        std::map<cString, UINT>::iterator found = mIndices.find(file);
+        if( found != mIndices.end() )
+        {
+            mpPayloads[found->second]->useCount++;
+            return found->second;
+        }
+        Payload *pPayload   = new Payload();
+        pPayload->file      = file;
+        pPayload->meshCount = meshCount;
+        pPayload->useCount  = 1;
+        pPayload->ready     = false;
+        pPayload->pPayload  = new CPUTModelPayload();
+        mIndices[file] = (UINT)mpPayloads.size();
+        mpPayloads.push_back(pPayload);
+        return (UINT)mpPayloads.size() - 1;
+    }
+
+    // Blocks until payload index is prepared.  Call once per Add(), then Release().
+    const CPUTModelPayload *Wait(UINT index)
+    {
+        if( !mParallel )
+        {
+            Payload *pPayload = mpPayloads[index];
+            if( !pPayload->ready )
+            {
+                CPUTModel::PrepareModelPayload(pPayload->file, pPayload->meshCount, pPayload->pPayload);
+                pPayload->ready = true;
+            }
+            return pPayload->pPayload;
+        }
+        Submit(index + mWindow);
+        std::unique_lock<std::mutex> lock(mMutex);
+        mReady.wait(lock, [this, index]() { return mpPayloads[index]->ready; });
+        return mpPayloads[index]->pPayload;
+    }
+
+    // Frees the payload once every model using it has been created
+    void Release(UINT index)
+    {
+        Payload *pPayload = mpPayloads[index];
+        if( 0 == --pPayload->useCount )
+        {
+            SAFE_DELETE(pPayload->pPayload);
+        }
+    }
+
+    // Start preparing the first window of payloads
+    void Start(bool inParallel)
+    {
+        mParallel = inParallel;
+        if( mParallel )
+        {
+            mWindow = 2 * CPUTWorkerPool::GetWorkerPool()->GetThreadCount();
+            Submit(mWindow);
+        }
+    }
+
+private:
+    // Start preparing the payloads up to, but not including, end
+    void Submit(UINT end)
+    {
+        CPUTWorkerPool *pPool = CPUTWorkerPool::GetWorkerPool();
+        for( ; mSubmitted < end && mSubmitted < mpPayloads.size(); mSubmitted++ )
+        {
+            Payload *pPayload = mpPayloads[mSubmitted];
+            pPool->Submit( [this, pPayload]()
+            {
+                CPUTModel::PrepareModelPayload(pPayload->file, pPayload->meshCount, pPayload->pPayload);
+                std::unique_lock<std::mutex> lock(mMutex);
+                pPayload->ready = true;
+                mReady.notify_all();
+            });
+        }
+    }
+
+    struct Payload
+    {
+        cString           file;
+        UINT              meshCount;
+        UINT              useCount;
+        bool              ready;
+        CPUTModelPayload *pPayload;
+    };
+    std::vector<Payload*>    mpPayloads;
+    std::map<cString, UINT>  mIndices;
+    UINT                     mSubmitted;
+    UINT                     mWindow;
+    bool                     mParallel;
+    std::mutex               mMutex;
+    std::condition_variable  mReady;
+};
 
 //-----------------------------------------------------------------------------
 CPUTAssetSetDX11::~CPUTAssetSetDX11()
@@ -55,6 +183,42 @@ CPUTResult CPUTAssetSetDX11::LoadAssetSet(cString name)
 
     CPUTAssetLibraryDX11 *pAssetLibrary = (CPUTAssetLibraryDX11*)CPUTAssetLibrary::GetAssetLibrary();
 
+    // Loading in parallel, every block is parsed before anything is created, and the model files
+    // are prepared on the worker pool, each once however many models use it.  Everything else
+    // happens below in block order on this thread, as it does otherwise: shaders compile, the
+    // library dedupes shared materials and textures by name, and parents link to children
+    // exactly as they would without the pool.
+    // Batching static models keeps every model's payload, instances' their master's, until all
+    // the models are loaded and BatchStaticModels() has read their vertices.
+    CPUTAssetSetPayloads payloads;
+    std::vector<int> payloadIndices(mAssetCount-1, -1);
+    bool batchStaticModels = pAssetLibrary->GetBatchStaticModels();
+    if( pAssetLibrary->GetLoadAssetSetsInParallel() || batchStaticModels )
+    {
+        for(UINT ii=0; ii<mAssetCount-1; ii++)
+        {
+            CPUTConfigBlock *pBlock = ConfigFile.GetBlock(ii);
+            if( !pBlock || 0!=pBlock->GetValueByName(_L("type"))->ValueAsString().compare(_L("model")) )
+            {
+                continue;
+            }
+            CPUTConfigEntry *pInstance = pBlock->GetValueByName(_L("instance"));
+            if( pInstance == &CPUTConfigEntry::sNullConfigValue )
+            {
+                // Same file CPUTModelDX11::LoadModel() resolves
+                cString modelLocation = pAssetLibrary->GetModelDirectoryName() + pBlock->GetValueByName(_L("name"))->ValueAsString() + _L(".mdl");
+                cString resolvedPathAndFile;
+                CPUTOSServices::GetOSServices()->ResolveAbsolutePathAndFilename(modelLocation, &resolvedPathAndFile);
+                payloadIndices[ii] = payloads.Add(resolvedPathAndFile, pBlock->GetValueByName(_L("meshcount"))->ValueAsInt());
+            }
+            else if( batchStaticModels && pInstance->ValueAsInt() >= 0 && pInstance->ValueAsInt() < (int)ii )
+            {
+                payloadIndices[ii] = payloadIndices[pInstance->ValueAsInt()];
+            }
+        }
+        payloads.Start( pAssetLibrary->GetLoadAssetSetsInParallel() );
+    }
+
     for(UINT ii=0; ii<mAssetCount-1; ii++) // Note: -1 because we added one for the root node (we don't load it)
     {
         CPUTConfigBlock *pBlock = ConfigFile.GetBlock(ii);
@@ -88,7 +252,18 @@ CPUTResult CPUTAssetSetDX11::LoadAssetSet(cString name)
             if( pValue == &CPUTConfigEntry::sNullConfigValue )
             {
                 // Not found.  So, not an instance.
-                pModel->LoadModel(pBlock, &parentIndex, NULL);
+                if( payloadIndices[ii] >= 0 )
+                {
+                    pModel->LoadModel(pBlock, &parentIndex, NULL, payloads.Wait(payloadIndices[ii]));
+                    if( !batchStaticModels )
+                    {
+                        payloads.Release(payloadIndices[ii]);
+                    }
+                }
+                else
+                {
+                    pModel->LoadModel(pBlock, &parentIndex, NULL);
+                }
             }
             else
             {
@@ -146,9 +321,241 @@ CPUTResult CPUTAssetSetDX11::LoadAssetSet(cString name)
         // Net effect is 0 (+1 to add to list, and -1 because we're done with it)
         // pNode->AddRef();
     }
+    if( batchStaticModels )
+    {
+        BatchStaticModels(ConfigFile, payloads, payloadIndices);
+    }
+
+    // The set's tree is complete, batches and all
+    mpRootNode->FlattenTransforms();
     return result;
 }
 
+// One mesh of a model going into a static batch
+struct CPUTStaticBatchEntry
+{
+    CPUTModel                  *pModel;
+    const CPUTModelPayloadMesh *pMesh;
+    CPUTMaterial               *pMaterial;
+    UINT                        order;      // of the model's centre along a Morton curve through the set
+};
+
+// Batches share a material and a vertex layout, and take their meshes in Morton order so
+// each batch covers a compact part of the set and culls as a whole.
+//-----------------------------------------------------------------------------
+static int CompareStaticBatchGroups(const CPUTStaticBatchEntry &a, const CPUTStaticBatchEntry &b)
+{
+    if( a.pMaterial != b.pMaterial )
+    {
+        return a.pMaterial < b.pMaterial ? -1 : 1;
+    }
+    const CPUTModelFileMesh &fileA = a.pMesh->file;
+    const CPUTModelFileMesh &fileB = b.pMesh->file;
+    if( fileA.vertexStride != fileB.vertexStride )
+    {
+        return fileA.vertexStride < fileB.vertexStride ? -1 : 1;
+    }
+    if( fileA.pHeader->formatDescriptorCount != fileB.pHeader->formatDescriptorCount )
+    {
+        return fileA.pHeader->formatDescriptorCount < fileB.pHeader->formatDescriptorCount ? -1 : 1;
+    }
+    return memcmp(fileA.pElements, fileB.pElements, fileA.pHeader->formatDescriptorCount * sizeof(CPUTModelFileElement));
+}
+
+//-----------------------------------------------------------------------------
+static bool StaticBatchOrder(const CPUTStaticBatchEntry &a, const CPUTStaticBatchEntry &b)
+{
+    int group = CompareStaticBatchGroups(a, b);
+    return group ? group < 0 : a.order < b.order;
+}
+
+// The low 10 bits of value, spread out to every third bit
+//-----------------------------------------------------------------------------
+static UINT SpreadMortonBits(UINT value)
+{
+    value &= 0x3ff;
+    value = (value | (value << 16)) & 0x030000ff;
+    value = (value | (value <<  8)) & 0x0300f00f;
+    value = (value | (value <<  4)) & 0x030c30c3;
+    value = (value | (value <<  2)) & 0x09249249;
+    return value;
+}
+
+// A model batches when each of its meshes can: small, in floats, and with a material that
+// isn't cloned per model
+//-----------------------------------------------------------------------------
+static bool CanBatchModel(CPUTModel *pModel, const CPUTModelPayload &payload)
+{
+    if( CPUTFAILED(payload.result) || payload.quantized || payload.meshCount != (UINT)pModel->GetMeshCount() )
+    {
+        return false;
+    }
+    for(UINT ii=0; ii<payload.meshCount; ii++)
+    {
+        const CPUTModelPayloadMesh &mesh = payload.pMeshes[ii];
+        CPUTMaterial *pMaterial = pModel->GetMaterial(ii);
+        if( !pMaterial || pMaterial->MaterialRequiresPerModelPayload() ||
+            !mesh.pVertices || !mesh.pIndices || !mesh.vertexCount || !mesh.indexCount ||
+            mesh.vertexCount > CPUT_STATIC_BATCH_MODEL_VERTICES ||
+            !CPUTCanBatchMesh(mesh.file.pElements, mesh.file.pHeader->formatDescriptorCount, mesh.file.vertexStride) )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTAssetSetDX11::BatchStaticModels(CPUTConfigFile &configFile, CPUTAssetSetPayloads &payloads, const std::vector<int> &payloadIndices)
+{
+    // Applications move lights and cameras, and whatever hangs off them.  Everything else is
+    // taken to stay where the set puts it.  Parents come before their children.
+    std::vector<bool> isStatic(mAssetCount, false);
+    isStatic[0] = true;
+    std::vector<CPUTModel*> models;
+    std::vector<const CPUTModelPayload*> modelPayloads;
+    for(UINT ii=0; ii<mAssetCount-1; ii++)
+    {
+        CPUTConfigBlock *pBlock = configFile.GetBlock(ii);
+        cString nodeType = pBlock->GetValueByName(_L("type"))->ValueAsString();
+        int parentIndex  = pBlock->GetValueByName(_L("parent"))->ValueAsInt();
+        bool isModel     = 0==nodeType.compare(_L("model"));
+        isStatic[ii+1] = (isModel || 0==nodeType.compare(_L("null"))) &&
+                         parentIndex >= -1 && parentIndex < (int)ii && isStatic[parentIndex+1];
+        if( isModel && isStatic[ii+1] && payloadIndices[ii] >= 0 )
+        {
+            CPUTModel *pModel = (CPUTModel*)mppAssetList[ii+1];
+            const CPUTModelPayload *pPayload = payloads.Wait(payloadIndices[ii]);
+            if( CanBatchModel(pModel, *pPayload) )
+            {
+                models.push_back(pModel);
+                modelPayloads.push_back(pPayload);
+            }
+        }
+    }
+    if( models.empty() )
+    {
+        return;
+    }
+
+    float3 minCenter(FLT_MAX), maxCenter(-FLT_MAX);
+    std::vector<float3> centers(models.size());
+    for(UINT ii=0; ii<models.size(); ii++)
+    {
+        float3 half;
+        models[ii]->GetBoundsWorldSpace(&centers[ii], &half);
+        minCenter = Min(centers[ii], minCenter);
+        maxCenter = Max(centers[ii], maxCenter);
+    }
+    float3 extent = maxCenter - minCenter;
+    std::vector<CPUTStaticBatchEntry> entries;
+    for(UINT ii=0; ii<models.size(); ii++)
+    {
+        UINT order = 0;
+        for(int cc=0; cc<3; cc++)
+        {
+            float position = extent.f[cc] > 0.0f ? (centers[ii].f[cc] - minCenter.f[cc]) / extent.f[cc] : 0.0f;
+            order |= SpreadMortonBits((UINT)(position * 1023.0f)) << cc;
+        }
+        for(UINT mm=0; mm<modelPayloads[ii]->meshCount; mm++)
+        {
+            CPUTStaticBatchEntry entry = { models[ii], &modelPayloads[ii]->pMeshes[mm], models[ii]->GetMaterial(mm), order };
+            entries.push_back(entry);
+        }
+    }
+    std::sort(entries.begin(), entries.end(), StaticBatchOrder);
+
+    // A mesh alone with its material and layout gains nothing from a batch, so its model
+    // keeps drawing itself
+    std::set<CPUTModel*> alone;
+    for(size_t first=0; first<entries.size(); first++)
+    {
+        if( (first == 0 || CompareStaticBatchGroups(entries[first-1], entries[first])) &&
+            (first+1 == entries.size() || CompareStaticBatchGroups(entries[first], entries[first+1])) )
+        {
+            alone.insert(entries[first].pModel);
+        }
+    }
+    entries.erase( std::remove_if(entries.begin(), entries.end(),
+                   [&alone](const CPUTStaticBatchEntry &entry) { return alone.count(entry.pModel) != 0; }), entries.end() );
+    models.erase( std::remove_if(models.begin(), models.end(),
+                  [&alone](CPUTModel *pModel) { return alone.count(pModel) != 0; }), models.end() );
+
+    // Each run of one material and layout, cut into batches of up to CPUT_STATIC_BATCH_VERTICES
+    std::vector<CPUTModelDX11*> batches;
+    for(size_t first=0; first<entries.size(); )
+    {
+        size_t end = first + 1;
+        while( end < entries.size() && 0==CompareStaticBatchGroups(entries[first], entries[end]) )
+        {
+            end++;
+        }
+        while( first < end )
+        {
+            CPUTModelPayload batch;
+            batch.meshCount = 1;
+            batch.pMeshes   = new CPUTModelPayloadMesh[1];
+            CPUTModelPayloadMesh &batchMesh = batch.pMeshes[0];
+            const CPUTModelFileMesh &file = entries[first].pMesh->file;
+            batchMesh.file = file;
+            UINT vertexCount = 0;
+            size_t last = first;
+            for( ; last < end && (last == first || vertexCount + entries[last].pMesh->vertexCount <= CPUT_STATIC_BATCH_VERTICES); last++ )
+            {
+                const CPUTModelPayloadMesh &mesh = *entries[last].pMesh;
+                // Levels of detail follow the full mesh in the indices; batches draw the full mesh
+                UINT indexCount = mesh.lods.empty() ? mesh.indexCount : mesh.lods[0].indexCount;
+                CPUTAppendStaticBatchMesh(file.pElements, file.pHeader->formatDescriptorCount, file.vertexStride,
+                                          mesh.pVertices, mesh.vertexCount, mesh.pIndices, indexCount, mesh.is16Bit,
+                                          (const float *)entries[last].pModel->GetWorldMatrix(),
+                                          &batchMesh.vertices, &batchMesh.indices, &batchMesh.clusters);
+                vertexCount += mesh.vertexCount;
+            }
+            batchMesh.pVertices   = &batchMesh.vertices[0];
+            batchMesh.vertexCount = vertexCount;
+            batchMesh.indexCount  = (UINT)batchMesh.indices.size();
+            if( CPUTNarrowIndices(&batchMesh.indices[0], batchMesh.indexCount, vertexCount, &batchMesh.narrowedIndices) )
+            {
+                batchMesh.pIndices = &batchMesh.narrowedIndices[0];
+                batchMesh.is16Bit  = true;
+            }
+            else
+            {
+                batchMesh.pIndices = &batchMesh.indices[0];
+            }
+
+            CPUTModelDX11 *pBatch = new CPUTModelDX11();
+            cStringStream name;
+            name << _L("_CPUTStaticBatch") << batches.size() << _L("_");
+            pBatch->LoadStaticBatch(name.str(), batch, &entries[first].pMaterial, entries[first].pModel->GetShadowCastMaterial());
+            batches.push_back(pBatch);
+            first = last;
+        }
+    }
+    for(UINT ii=0; ii<models.size(); ii++)
+    {
+        models[ii]->SetRenderable(false);
+    }
+
+    // The batches hang off the root with identity transforms, and the set owns them like the rest
+    CPUTRenderNode **ppAssetList = new CPUTRenderNode*[mAssetCount + batches.size()];
+    memcpy(ppAssetList, mppAssetList, mAssetCount * sizeof(CPUTRenderNode*));
+    SAFE_DELETE_ARRAY(mppAssetList);
+    mppAssetList = ppAssetList;
+    for(UINT ii=0; ii<batches.size(); ii++)
+    {
+        CPUTModelDX11 *pBatch = batches[ii];
+        pBatch->SetParent( mpRootNode );
+        mpRootNode->AddChild( pBatch );
+        pBatch->UpdateBoundsWorldSpace();
+        mppAssetList[mAssetCount++] = pBatch;
+    }
+
+    cStringStream report;
+    report << _L("Batched ") << models.size() << _L(" static models, ") << entries.size() << _L(" meshes, into ") << batches.size() << _L(" batches\n");
+    TRACE(report.str().c_str());
+}
+
 //-----------------------------------------------------------------------------
 CPUTAssetSet *CPUTAssetSetDX11::CreateAssetSet( const cString &name, const cString &absolutePathAndFilename )
 {
@@ -17,9 +17,16 @@
 #define __CPUTASSETSETDX11_H__
 
 #include "CPUTAssetSet.h"
+#include <vector>
+
+class CPUTAssetSetPayloads;
+class CPUTConfigFile;
 
 class CPUTAssetSetDX11 : public CPUTAssetSet
 {
+    // Merge the loaded models CPUTAssetLibrary::SetBatchStaticModels() allows into static batches
+    void BatchStaticModels(CPUTConfigFile &configFile, CPUTAssetSetPayloads &payloads, const std::vector<int> &payloadIndices);
+
 public:
     static CPUTAssetSet *CreateAssetSet( const cString &name, const cString &absolutePathAndFilename );
 
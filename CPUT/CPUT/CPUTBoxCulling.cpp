@@ -0,0 +1,228 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTBoxCulling.h"
+#include <math.h>
+#include <string.h>
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+#define CPUT_CULL_BOX_WIDTH 16
+#elif defined(__AVX__)
+#include <immintrin.h>
+#define CPUT_CULL_BOX_WIDTH 8
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define CPUT_CULL_BOX_WIDTH 4
+#else
+#define CPUT_CULL_BOX_WIDTH 1
+#endif
+
+//-----------------------------------------------------------------------------
+void CPUTCullBoxSet::Resize(uint32_t boxCount)
+{
+    // Padding boxes are empty; their bits get cleared whatever they test as
+    size_t padded = ((size_t)boxCount + CPUT_CULL_BOX_BATCH - 1) / CPUT_CULL_BOX_BATCH * CPUT_CULL_BOX_BATCH;
+    centerX.resize(padded, 0.0f);
+    centerY.resize(padded, 0.0f);
+    centerZ.resize(padded, 0.0f);
+    halfX.resize(padded, 0.0f);
+    halfY.resize(padded, 0.0f);
+    halfZ.resize(padded, 0.0f);
+    count = boxCount;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTCullBoxSet::Set(uint32_t index, const float pCenter[3], const float pHalf[3])
+{
+    centerX[index] = pCenter[0];
+    centerY[index] = pCenter[1];
+    centerZ[index] = pCenter[2];
+    halfX[index]   = fabsf(pHalf[0]);
+    halfY[index]   = fabsf(pHalf[1]);
+    halfZ[index]   = fabsf(pHalf[2]);
+}
+
+// A box is outside a plane when its centre is further out than the box reaches towards the
+// plane: a cx + b cy + c cz + d > |a| hx + |b| hy + |c| hz.  These return the bits of the
+// CPUT_CULL_BOX_WIDTH boxes starting at first that aren't outside any plane.
+#if CPUT_CULL_BOX_WIDTH == 16
+//-----------------------------------------------------------------------------
+static uint32_t CullBatch(const CPUTCullBoxSet &boxes, const float pPlanes[6][4], const float pAbsPlanes[6][3], uint32_t first)
+{
+    __m512 cx = _mm512_loadu_ps(&boxes.centerX[first]);
+    __m512 cy = _mm512_loadu_ps(&boxes.centerY[first]);
+    __m512 cz = _mm512_loadu_ps(&boxes.centerZ[first]);
+    __m512 hx = _mm512_loadu_ps(&boxes.halfX[first]);
+    __m512 hy = _mm512_loadu_ps(&boxes.halfY[first]);
+    __m512 hz = _mm512_loadu_ps(&boxes.halfZ[first]);
+    __mmask16 outside = 0;
+    for(int pp=0; pp<6; pp++)
+    {
+        __m512 distance = _mm512_fmadd_ps(cx, _mm512_set1_ps(pPlanes[pp][0]),
+                          _mm512_fmadd_ps(cy, _mm512_set1_ps(pPlanes[pp][1]),
+                          _mm512_fmadd_ps(cz, _mm512_set1_ps(pPlanes[pp][2]), _mm512_set1_ps(pPlanes[pp][3]))));
+        __m512 reach    = _mm512_fmadd_ps(hx, _mm512_set1_ps(pAbsPlanes[pp][0]),
+                          _mm512_fmadd_ps(hy, _mm512_set1_ps(pAbsPlanes[pp][1]),
+                          _mm512_mul_ps(hz, _mm512_set1_ps(pAbsPlanes[pp][2]))));
+        outside = (__mmask16)(outside | _mm512_cmp_ps_mask(distance, reach, _CMP_GT_OQ));
+    }
+    return (uint32_t)(uint16_t)~outside;
+}
+#elif CPUT_CULL_BOX_WIDTH == 8
+//-----------------------------------------------------------------------------
+static uint32_t CullBatch(const CPUTCullBoxSet &boxes, const float pPlanes[6][4], const float pAbsPlanes[6][3], uint32_t first)
+{
+    __m256 cx = _mm256_loadu_ps(&boxes.centerX[first]);
+    __m256 cy = _mm256_loadu_ps(&boxes.centerY[first]);
+    __m256 cz = _mm256_loadu_ps(&boxes.centerZ[first]);
+    __m256 hx = _mm256_loadu_ps(&boxes.halfX[first]);
+    __m256 hy = _mm256_loadu_ps(&boxes.halfY[first]);
+    __m256 hz = _mm256_loadu_ps(&boxes.halfZ[first]);
+    __m256 outside = _mm256_setzero_ps();
+    for(int pp=0; pp<6; pp++)
+    {
+        __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx, _mm256_set1_ps(pPlanes[pp][0])),
+                                                      _mm256_mul_ps(cy, _mm256_set1_ps(pPlanes[pp][1]))),
+                                        _mm256_add_ps(_mm256_mul_ps(cz, _mm256_set1_ps(pPlanes[pp][2])),
+                                                      _mm256_set1_ps(pPlanes[pp][3])));
+        __m256 reach    = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(hx, _mm256_set1_ps(pAbsPlanes[pp][0])),
+                                                      _mm256_mul_ps(hy, _mm256_set1_ps(pAbsPlanes[pp][1]))),
+                                        _mm256_mul_ps(hz, _mm256_set1_ps(pAbsPlanes[pp][2])));
+        outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, reach, _CMP_GT_OQ));
+    }
+    return (uint32_t)~_mm256_movemask_ps(outside) & 0xff;
+}
+#elif CPUT_CULL_BOX_WIDTH == 4
+//-----------------------------------------------------------------------------
+static uint32_t CullBatch(const CPUTCullBoxSet &boxes, const float pPlanes[6][4], const float pAbsPlanes[6][3], uint32_t first)
+{
+    __m128 cx = _mm_loadu_ps(&boxes.centerX[first]);
+    __m128 cy = _mm_loadu_ps(&boxes.centerY[first]);
+    __m128 cz = _mm_loadu_ps(&boxes.centerZ[first]);
+    __m128 hx = _mm_loadu_ps(&boxes.halfX[first]);
+    __m128 hy = _mm_loadu_ps(&boxes.halfY[first]);
+    __m128 hz = _mm_loadu_ps(&boxes.halfZ[first]);
+    __m128 outside = _mm_setzero_ps();
+    for(int pp=0; pp<6; pp++)
+    {
+        __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(pPlanes[pp][0])),
+                                                _mm_mul_ps(cy, _mm_set1_ps(pPlanes[pp][1]))),
+                                     _mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(pPlanes[pp][2])),
+                                                _mm_set1_ps(pPlanes[pp][3])));
+        __m128 reach    = _mm_add_ps(_mm_add_ps(_mm_mul_ps(hx, _mm_set1_ps(pAbsPlanes[pp][0])),
+                                                _mm_mul_ps(hy, _mm_set1_ps(pAbsPlanes[pp][1]))),
+                                     _mm_mul_ps(hz, _mm_set1_ps(pAbsPlanes[pp][2])));
+        outside = _mm_or_ps(outside, _mm_cmpgt_ps(distance, reach));
+    }
+    return (uint32_t)~_mm_movemask_ps(outside) & 0xf;
+}
+#else
+//-----------------------------------------------------------------------------
+static uint32_t CullBatch(const CPUTCullBoxSet &boxes, const float pPlanes[6][4], const float pAbsPlanes[6][3], uint32_t first)
+{
+    for(int pp=0; pp<6; pp++)
+    {
+        float distance = boxes.centerX[first]*pPlanes[pp][0] + boxes.centerY[first]*pPlanes[pp][1] + boxes.centerZ[first]*pPlanes[pp][2] + pPlanes[pp][3];
+        float reach    = boxes.halfX[first]*pAbsPlanes[pp][0] + boxes.halfY[first]*pAbsPlanes[pp][1] + boxes.halfZ[first]*pAbsPlanes[pp][2];
+        if(distance > reach)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+#endif
+
+//-----------------------------------------------------------------------------
+static uint32_t CountBits(uint32_t bits)
+{
+    bits = bits - ((bits >> 1) & 0x55555555);
+    bits = (bits & 0x33333333) + ((bits >> 2) & 0x33333333);
+    return (((bits + (bits >> 4)) & 0x0f0f0f0f) * 0x01010101) >> 24;
+}
+
+//-----------------------------------------------------------------------------
+uint32_t CPUTCullBoxes(const CPUTCullBoxSet &boxes, const float pPlanes[6][4], uint32_t *pVisible)
+{
+    float absPlanes[6][3];
+    for(int pp=0; pp<6; pp++)
+    {
+        for(int cc=0; cc<3; cc++)
+        {
+            absPlanes[pp][cc] = fabsf(pPlanes[pp][cc]);
+        }
+    }
+
+    uint32_t wordCount = CPUTCullBoxMaskWords(boxes.count);
+    uint32_t visibleCount = 0;
+    for(uint32_t ww=0; ww<wordCount; ww++)
+    {
+        // Padding makes whole batches of every word but the last, which may stop at CPUT_CULL_BOX_BATCH
+        uint32_t first = ww * 32;
+        uint32_t end   = first + 32 < (uint32_t)boxes.centerX.size() ? first + 32 : (uint32_t)boxes.centerX.size();
+        uint32_t word  = 0;
+        for(uint32_t bb=first; bb<end; bb+=CPUT_CULL_BOX_WIDTH)
+        {
+            word |= CullBatch(boxes, pPlanes, absPlanes, bb) << (bb - first);
+        }
+        if(first + 32 > boxes.count)
+        {
+            word &= (1u << (boxes.count - first)) - 1;
+        }
+        pVisible[ww] = word;
+        visibleCount += CountBits(word);
+    }
+    return visibleCount;
+}
+
+//-----------------------------------------------------------------------------
+uint32_t CPUTListVisibleBoxes(const uint32_t *pVisible, uint32_t count, uint32_t *pIndices)
+{
+    uint32_t listed = 0;
+    uint32_t wordCount = CPUTCullBoxMaskWords(count);
+    for(uint32_t ww=0; ww<wordCount; ww++)
+    {
+        uint32_t word = pVisible[ww];
+        while(word)
+        {
+            // Isolate the lowest set bit, then find it by halving
+            uint32_t lowest = word & (0u - word);
+            uint32_t bit = 0;
+            if(lowest & 0xffff0000) { bit += 16; }
+            if(lowest & 0xff00ff00) { bit += 8; }
+            if(lowest & 0xf0f0f0f0) { bit += 4; }
+            if(lowest & 0xcccccccc) { bit += 2; }
+            if(lowest & 0xaaaaaaaa) { bit += 1; }
+            pIndices[listed++] = ww * 32 + bit;
+            word ^= lowest;
+        }
+    }
+    return listed;
+}
+
+//-----------------------------------------------------------------------------
+const char *CPUTCullBoxesInstructionSet()
+{
+#if CPUT_CULL_BOX_WIDTH == 16
+    return "AVX-512";
+#elif CPUT_CULL_BOX_WIDTH == 8
+    return "AVX";
+#elif CPUT_CULL_BOX_WIDTH == 4
+    return "SSE";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,59 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTBOXCULLING_H__
+#define __CPUTBOXCULLING_H__
+
+// Frustum culling many axis aligned boxes at once.  The boxes are kept as a structure of arrays,
+// one array per coordinate of their centres and half sizes, so each plane test runs on a whole
+// register of boxes: 16 at a time with AVX-512, 8 with AVX and 4 with SSE, whichever is the
+// widest the build targets (/arch:AVX, /arch:AVX512, -mavx, -mavx512f), else one at a time.
+// The results are a bitmask, which CPUTListVisibleBoxes() turns into a list of indices.
+// Only depends on the C++ standard library, so tools built on it also run off Windows.
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#define CPUT_CULL_BOX_BATCH 16  // the arrays are padded to a multiple of this many boxes, the widest batch
+
+struct CPUTCullBoxSet
+{
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> halfX, halfY, halfZ;     // not negative
+    uint32_t           count;
+
+    CPUTCullBoxSet() : count(0) {}
+
+    // Room for boxCount boxes, keeping those already set below it
+    void Resize(uint32_t boxCount);
+    void Set(uint32_t index, const float pCenter[3], const float pHalf[3]);
+};
+
+// Words of visibility bits for count boxes
+inline uint32_t CPUTCullBoxMaskWords(uint32_t count) { return (count + 31) / 32; }
+
+// Sets bit ii % 32 of pVisible[ii / 32] when box ii is at least partly inside all six planes
+// (a, b, c, d), each with its normal pointing out so that ax + by + cz + d > 0 is outside, and
+// clears it otherwise; CPUTFrustum::GetPlanes() gives them.  Bits past the last box are clear.
+// Returns the number of visible boxes.
+uint32_t CPUTCullBoxes(const CPUTCullBoxSet &boxes, const float pPlanes[6][4], uint32_t *pVisible);
+
+// The indices of the set bits, in order.  Returns how many there are.
+uint32_t CPUTListVisibleBoxes(const uint32_t *pVisible, uint32_t count, uint32_t *pIndices);
+
+// "AVX-512", "AVX", "SSE" or "scalar": what CPUTCullBoxes() was built with
+const char *CPUTCullBoxesInstructionSet();
+
+#endif // __CPUTBOXCULLING_H__
@@ -74,6 +74,7 @@ void CPUTCamera::LookAt( float xx, float yy, float zz )
          look.x,  look.y,  look.z, 0.0f,
           pos.x,   pos.y,   pos.z, 1.0f
     );
+    MarkDirty();
 }
 
 //-----------------------------------------------------------------------------
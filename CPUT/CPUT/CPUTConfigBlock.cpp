@@ -138,6 +138,14 @@ static void AssignStr(cString &dest, const char *start, const char *end, _locale
 //----------------------------------------------------------------
 void CPUTConfigEntry::ValueAsFloatArray(float *pFloats, int count)
 {
+    if(mNumberCount)
+    {
+        for(int ii=0; ii<count; ii++)
+        {
+            pFloats[ii] = ii < (int)mNumberCount ? mNumbers[ii] : 0.0f;
+        }
+        return;
+    }
     cString valueCopy = szValue;
     TCHAR *szOrigValue = (TCHAR*)valueCopy.c_str();
 
@@ -199,6 +207,8 @@ CPUTConfigEntry *CPUTConfigBlock::AddValue(const cString &szName, const cString
     CPUTConfigEntry *pEntry = &mpValues[mnValueCount++];
     pEntry->szName  = szNameLower;
     pEntry->szValue = szValueLower;
+    pEntry->mNumberCount = 0;
+    pEntry->mIsInteger   = false;
     return pEntry;
 }
 //----------------------------------------------------------------
@@ -256,23 +266,41 @@ CPUTResult CPUTConfigFile::LoadFile(const cString &szFilename)
     CPUTConfigBlock    *pCurrBlock = NULL;
     FILE               *pFile = NULL;
     int                 nCurrBlock = 0;
-    CPUTResult result = CPUTOSServices::GetOSServices()->OpenFile(szFilename, &pFile);
-    if(CPUTFAILED(result))
+    char               *pFileContents = NULL;
+    int                 nBytes = 0;
+
+    // Archived files are stored in binary, so lines may end in \r\n; the parser trims whitespace anyway
+    CPUTArchiveData archived;
+    if(CPUTOSServices::GetOSServices()->ReadArchivedFile(szFilename, &archived))
     {
-        return result;
+        if(CPUTIsCookedConfig(archived.pData, archived.size))
+        {
+            return LoadCookedFile(szFilename, archived);
+        }
+        nBytes = (int)archived.size;
+        pFileContents = new char[nBytes + 1];
+        memcpy(pFileContents, archived.pData, nBytes);
     }
+    else
+    {
+        CPUTResult result = CPUTOSServices::GetOSServices()->OpenFile(szFilename, &pFile);
+        if(CPUTFAILED(result))
+        {
+            return result;
+        }
 
-	_locale_t locale = _get_current_locale();
+        /* Determine file size */
+        fseek(pFile, 0, SEEK_END);
+        nBytes = ftell(pFile); // for text files, this is an overestimate
+        fseek(pFile, 0, SEEK_SET);
 
-	/* Determine file size */
-	fseek(pFile, 0, SEEK_END);
-	int nBytes = ftell(pFile); // for text files, this is an overestimate
-	fseek(pFile, 0, SEEK_SET);
+        /* Read the whole thing */
+        pFileContents = new char[nBytes + 1];
+        nBytes = (int)fread(pFileContents, 1, nBytes, pFile);
+        fclose(pFile);
+    }
 
-	/* Read the whole thing */
-	char *pFileContents = new char[nBytes + 1];
-	nBytes = (int)fread(pFileContents, 1, nBytes, pFile);
-	fclose(pFile);
+	_locale_t locale = _get_current_locale();
 
 	pFileContents[nBytes] = 0; // add 0-terminator
 
@@ -380,6 +408,54 @@ CPUTResult CPUTConfigFile::LoadFile(const cString &szFilename)
     return CPUT_SUCCESS;
 }
 
+//----------------------------------------------------------------
+static void AssignCookedStr(cString &dest, const CPUTCookedString &source)
+{
+#if defined(UNICODE) || defined(_UNICODE)
+	dest.assign((const wchar_t *)source.pChars, source.length);
+#else
+	dest.assign(source.pChars, source.pChars + source.length);
+#endif
+}
+
+// The blocks come out as the text they were cooked from would have parsed, without parsing
+// anything: fixing up the offsets is the only pass over the data before copying it out.
+//----------------------------------------------------------------
+CPUTResult CPUTConfigFile::LoadCookedFile(const cString &szFilename, const CPUTArchiveData &archived)
+{
+    // The archive's mapping is read only, and the offsets are fixed up in place
+    std::vector<uint64_t> image((archived.size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+    memcpy(&image[0], archived.pData, archived.size);
+    const CPUTCookedConfigHeader *pHeader = CPUTFixUpCookedConfig(&image[0], archived.size);
+    if(!pHeader || !pHeader->blockCount)
+    {
+        ASSERT( 0, _L("Invalid cooked config file: ") + szFilename );
+        return CPUT_ERROR_FILE_READ_ERROR;
+    }
+
+    const CPUTCookedConfigBlock *pCookedBlocks = (const CPUTCookedConfigBlock *)((const unsigned char *)pHeader + pHeader->blocksOffset);
+    mnBlockCount = (int)pHeader->blockCount;
+    mpBlocks = new CPUTConfigBlock[mnBlockCount];
+    for(int ii=0; ii<mnBlockCount; ++ii)
+    {
+        const CPUTCookedConfigBlock &cookedBlock = pCookedBlocks[ii];
+        CPUTConfigBlock &block = mpBlocks[ii];
+        AssignCookedStr(block.mszName, cookedBlock.name);
+        block.mnValueCount = (int)cookedBlock.entryCount;
+        for(UINT jj=0; jj<cookedBlock.entryCount; ++jj)
+        {
+            const CPUTCookedConfigEntry &cookedEntry = cookedBlock.pEntries[jj];
+            CPUTConfigEntry &entry = block.mpValues[jj];
+            AssignCookedStr(entry.szName,  cookedEntry.name);
+            AssignCookedStr(entry.szValue, cookedEntry.value);
+            memcpy(entry.mNumbers, cookedEntry.numbers, sizeof(entry.mNumbers));
+            entry.mNumberCount = cookedEntry.numberCount;
+            entry.mIsInteger   = 0 != (cookedEntry.flags & CPUT_COOKED_CONFIG_INTEGER);
+        }
+    }
+    return CPUT_SUCCESS;
+}
+
 //----------------------------------------------------------------
 CPUTConfigBlock *CPUTConfigFile::GetBlock(int nBlockIndex)
 {
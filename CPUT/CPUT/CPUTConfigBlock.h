@@ -19,6 +19,7 @@
 
 
 #include "CPUT.h"
+#include "CPUTCookedConfig.h"
 
 #include <algorithm> // for std::transform
 
@@ -33,18 +34,25 @@
 
 typedef UINT UINT;
 
+struct CPUTArchiveData;
+
 class CPUTConfigEntry
 {
 private:
     cString szName;
     cString szValue;
 
+    // Cooked files (see CPUTCookedConfig.h) come with numeric values already parsed
+    float   mNumbers[CPUT_COOKED_CONFIG_NUMBERS];
+    UINT    mNumberCount;
+    bool    mIsInteger;
+
     friend class CPUTConfigBlock;
     friend class CPUTConfigFile;
 
 public:
-    CPUTConfigEntry() {}
-    CPUTConfigEntry(const cString &name, const cString &value): szName(name), szValue(value){};
+    CPUTConfigEntry() : mNumberCount(0), mIsInteger(false) {}
+    CPUTConfigEntry(const cString &name, const cString &value): szName(name), szValue(value), mNumberCount(0), mIsInteger(false){};
 
     static CPUTConfigEntry  &sNullConfigValue;
 
@@ -53,6 +61,10 @@ public:
 	bool IsValid(void){ return !szName.empty(); }
     float ValueAsFloat(void)
     {
+        if(mNumberCount)
+        {
+            return mNumbers[0];
+        }
         float fValue=0;
         int retVal;
         retVal=swscanf_s(szValue.c_str(), _L("%g"), &fValue ); // float (regular float, or E exponentially notated float)
@@ -61,6 +73,10 @@ public:
     }
     int ValueAsInt(void)
     {
+        if(mIsInteger)
+        {
+            return (int)mNumbers[0];
+        }
         int nValue=0;
         int retVal;
         retVal=swscanf_s(szValue.c_str(), _L("%d"), &nValue ); // signed int (NON-hex)
@@ -69,6 +85,10 @@ public:
     }
     UINT ValueAsUint(void)
     {
+        if(mIsInteger && mNumbers[0] >= 0.0f)
+        {
+            return (UINT)mNumbers[0];
+        }
         UINT nValue=0;
         int retVal;
         retVal=swscanf_s(szValue.c_str(), _L("%u"), &nValue ); // unsigned int
@@ -113,12 +133,15 @@ public:
     CPUTConfigFile();
     ~CPUTConfigFile();
 
+    // Text, or a cooked config (see CPUTCookedConfig.h) in a mounted archive
     CPUTResult LoadFile(const cString &szFilename);
 
     CPUTConfigBlock *GetBlock(int nBlockIndex);
     CPUTConfigBlock *GetBlockByName(const cString &szBlockName);
     int BlockCount(void);
 private:
+    CPUTResult LoadCookedFile(const cString &szFilename, const CPUTArchiveData &archived);
+
     CPUTConfigBlock    *mpBlocks;
     int                 mnBlockCount;
 };
@@ -0,0 +1,425 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTCookedConfig.h"
+#include <stdlib.h>
+#include <string.h>
+
+//-----------------------------------------------------------------------------
+static bool IsWhite(char ch)
+{
+    return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+}
+
+//-----------------------------------------------------------------------------
+static std::string Lower(const char *pStart, const char *pEnd)
+{
+    std::string lower(pStart, pEnd);
+    for(size_t ii=0; ii<lower.size(); ii++)
+    {
+        if(lower[ii] >= 'A' && lower[ii] <= 'Z')
+        {
+            lower[ii] = lower[ii] - 'A' + 'a';
+        }
+    }
+    return lower;
+}
+
+//-----------------------------------------------------------------------------
+static bool HasEntry(const CPUTConfigTextBlock &block, const std::string &name)
+{
+    for(size_t ii=0; ii<block.entries.size(); ii++)
+    {
+        if(block.entries[ii].name == name)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The [ and ] of a block header line, if it is one
+//-----------------------------------------------------------------------------
+static bool FindBlockName(const char *pStart, const char *pEnd, const char **ppOpen, const char **ppClose)
+{
+    const char *pOpen = (const char *)memchr(pStart, '[', pEnd - pStart);
+    if(!pOpen)
+    {
+        return false;
+    }
+    for(const char *pClose = pEnd; --pClose > pOpen; )
+    {
+        if(*pClose == ']')
+        {
+            *ppOpen  = pOpen;
+            *ppClose = pClose;
+            return true;
+        }
+    }
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTParseConfigText(const char *pText, size_t size, std::vector<CPUTConfigTextBlock> *pBlocks)
+{
+    // Text stops at the first NUL, as it does for the runtime's parser
+    const char *pNul = (const char *)memchr(pText, '\0', size);
+    const char *pTextEnd = pNul ? pNul : pText + size;
+
+    pBlocks->clear();
+    pBlocks->resize(1);
+    size_t blockCount = 0;
+    CPUTConfigTextBlock *pBlock = &(*pBlocks)[0];
+    for(const char *pLine = pText; pLine < pTextEnd; )
+    {
+        const char *pNewLine = (const char *)memchr(pLine, '\n', pTextEnd - pLine);
+        const char *pLineEnd = pNewLine ? pNewLine : pTextEnd;
+        const char *pStart = pLine;
+        const char *pEnd   = pLineEnd;
+        pLine = pNewLine ? pNewLine + 1 : pTextEnd;
+        while(pStart < pEnd && (*pStart == ' ' || *pStart == '\t'))
+        {
+            ++pStart;
+        }
+        while(pEnd > pStart && IsWhite(pEnd[-1]))
+        {
+            --pEnd;
+        }
+        if(pStart == pEnd)
+        {
+            continue;
+        }
+
+        const char *pOpen, *pClose;
+        if(FindBlockName(pStart, pEnd, &pOpen, &pClose))
+        {
+            // The first header names the block that lines before it went into
+            if(blockCount++)
+            {
+                pBlocks->resize(blockCount);
+            }
+            pBlock = &pBlocks->back();
+            pBlock->name = Lower(pOpen + 1, pClose);
+            continue;
+        }
+
+        CPUTConfigTextEntry entry;
+        const char *pEquals = (const char *)memchr(pStart, '=', pEnd - pStart);
+        if(!pEquals)
+        {
+            // No value, just a key, which keeps its case
+            entry.name.assign(pStart, pEnd);
+        }
+        else
+        {
+            const char *pNameStart = pStart;
+            const char *pNameEnd   = pEquals;
+            const char *pValStart  = pEquals + 1;
+            while(pNameStart < pNameEnd && IsWhite(*pNameStart))
+            {
+                ++pNameStart;
+            }
+            while(pNameEnd > pNameStart && IsWhite(pNameEnd[-1]))
+            {
+                --pNameEnd;
+            }
+            while(pValStart < pEnd && IsWhite(*pValStart))
+            {
+                ++pValStart;
+            }
+            entry.name = Lower(pNameStart, pNameEnd);
+            entry.value.assign(pValStart, pEnd);
+        }
+        if(!HasEntry(*pBlock, entry.name))
+        {
+            pBlock->entries.push_back(entry);
+        }
+    }
+}
+
+// A decimal number, the way the runtime's _wtof() and swscanf() read it, but nothing they'd
+// only read part of
+//-----------------------------------------------------------------------------
+static bool ParseNumber(const std::string &word, float *pNumber, bool *pIsInteger)
+{
+    size_t ii = 0;
+    if(ii < word.size() && (word[ii] == '+' || word[ii] == '-'))
+    {
+        ++ii;
+    }
+    size_t digits = 0;
+    while(ii < word.size() && word[ii] >= '0' && word[ii] <= '9')
+    {
+        ++ii; ++digits;
+    }
+    *pIsInteger = digits > 0 && ii == word.size();
+    if(ii < word.size() && word[ii] == '.')
+    {
+        ++ii;
+        while(ii < word.size() && word[ii] >= '0' && word[ii] <= '9')
+        {
+            ++ii; ++digits;
+        }
+    }
+    if(!digits)
+    {
+        return false;
+    }
+    if(ii < word.size() && (word[ii] == 'e' || word[ii] == 'E'))
+    {
+        ++ii;
+        if(ii < word.size() && (word[ii] == '+' || word[ii] == '-'))
+        {
+            ++ii;
+        }
+        size_t exponentDigits = 0;
+        while(ii < word.size() && word[ii] >= '0' && word[ii] <= '9')
+        {
+            ++ii; ++exponentDigits;
+        }
+        if(!exponentDigits)
+        {
+            return false;
+        }
+    }
+    if(ii != word.size())
+    {
+        return false;
+    }
+    double number = strtod(word.c_str(), NULL);
+    *pNumber = (float)number;
+    *pIsInteger = *pIsInteger && number >= -16777216.0 && number <= 16777216.0;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+static void ParseNumbers(const std::string &value, CPUTCookedConfigEntry *pEntry)
+{
+    pEntry->numberCount = 0;
+    pEntry->flags       = 0;
+    for(size_t ii=0; ii<CPUT_COOKED_CONFIG_NUMBERS; ii++)
+    {
+        pEntry->numbers[ii] = 0.0f;
+    }
+
+    // Words are split on spaces only, as ValueAsFloatArray() splits them
+    uint32_t count = 0;
+    for(size_t start = 0; start < value.size(); )
+    {
+        size_t end = value.find(' ', start);
+        if(end == std::string::npos)
+        {
+            end = value.size();
+        }
+        if(end > start)
+        {
+            float number;
+            bool isInteger;
+            if(count == CPUT_COOKED_CONFIG_NUMBERS || !ParseNumber(value.substr(start, end - start), &number, &isInteger))
+            {
+                for(size_t ii=0; ii<CPUT_COOKED_CONFIG_NUMBERS; ii++)
+                {
+                    pEntry->numbers[ii] = 0.0f;
+                }
+                pEntry->flags = 0;
+                return;
+            }
+            if(count == 0 && isInteger)
+            {
+                pEntry->flags |= CPUT_COOKED_CONFIG_INTEGER;
+            }
+            pEntry->numbers[count++] = number;
+        }
+        start = end + 1;
+    }
+    pEntry->numberCount = count;
+}
+
+//-----------------------------------------------------------------------------
+static void AddString(const std::string &text, std::vector<uint16_t> *pStrings, CPUTCookedString *pString)
+{
+    pString->offset   = pStrings->size() * sizeof(uint16_t); // from the start of the strings, for now
+    pString->length   = (uint32_t)text.size();
+    pString->reserved = 0;
+    for(size_t ii=0; ii<text.size(); ii++)
+    {
+        pStrings->push_back((unsigned char)text[ii]);
+    }
+    pStrings->push_back(0);
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTCookConfig(const std::vector<CPUTConfigTextBlock> &blocks, std::vector<unsigned char> *pCooked)
+{
+    std::vector<CPUTCookedConfigBlock> cookedBlocks(blocks.size());
+    std::vector<CPUTCookedConfigEntry> cookedEntries;
+    std::vector<uint16_t> strings;
+    for(size_t ii=0; ii<blocks.size(); ii++)
+    {
+        const CPUTConfigTextBlock &block = blocks[ii];
+        if(block.entries.size() > CPUT_COOKED_CONFIG_ENTRIES)
+        {
+            return false;
+        }
+        CPUTCookedConfigBlock &cookedBlock = cookedBlocks[ii];
+        AddString(block.name, &strings, &cookedBlock.name);
+        cookedBlock.entriesOffset = cookedEntries.size() * sizeof(CPUTCookedConfigEntry); // from the first entry, for now
+        cookedBlock.entryCount    = (uint32_t)block.entries.size();
+        cookedBlock.reserved      = 0;
+        for(size_t jj=0; jj<block.entries.size(); jj++)
+        {
+            CPUTCookedConfigEntry cookedEntry;
+            AddString(block.entries[jj].name,  &strings, &cookedEntry.name);
+            AddString(block.entries[jj].value, &strings, &cookedEntry.value);
+            ParseNumbers(block.entries[jj].value, &cookedEntry);
+            cookedEntries.push_back(cookedEntry);
+        }
+    }
+
+    CPUTCookedConfigHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic         = CPUT_COOKED_CONFIG_MAGIC;
+    header.version       = CPUT_COOKED_CONFIG_VERSION;
+    header.headerSize    = sizeof(CPUTCookedConfigHeader);
+    header.blockCount    = (uint32_t)cookedBlocks.size();
+    header.entryCount    = (uint32_t)cookedEntries.size();
+    header.blocksOffset  = sizeof(CPUTCookedConfigHeader);
+    header.entriesOffset = header.blocksOffset + cookedBlocks.size() * sizeof(CPUTCookedConfigBlock);
+    header.stringsOffset = header.entriesOffset + cookedEntries.size() * sizeof(CPUTCookedConfigEntry);
+    header.stringsSize   = strings.size() * sizeof(uint16_t);
+
+    // Offsets from the start of the image
+    for(size_t ii=0; ii<cookedBlocks.size(); ii++)
+    {
+        cookedBlocks[ii].name.offset   += header.stringsOffset;
+        cookedBlocks[ii].entriesOffset += header.entriesOffset;
+    }
+    for(size_t ii=0; ii<cookedEntries.size(); ii++)
+    {
+        cookedEntries[ii].name.offset  += header.stringsOffset;
+        cookedEntries[ii].value.offset += header.stringsOffset;
+    }
+
+    pCooked->resize((size_t)(header.stringsOffset + header.stringsSize));
+    unsigned char *pData = &(*pCooked)[0];
+    memcpy(pData, &header, sizeof(header));
+    if(!cookedBlocks.empty())
+    {
+        memcpy(pData + header.blocksOffset, &cookedBlocks[0], cookedBlocks.size() * sizeof(CPUTCookedConfigBlock));
+    }
+    if(!cookedEntries.empty())
+    {
+        memcpy(pData + header.entriesOffset, &cookedEntries[0], cookedEntries.size() * sizeof(CPUTCookedConfigEntry));
+    }
+    if(!strings.empty())
+    {
+        memcpy(pData + header.stringsOffset, &strings[0], (size_t)header.stringsSize);
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTIsCookedConfig(const void *pData, size_t size)
+{
+    uint32_t magic;
+    if(size < sizeof(CPUTCookedConfigHeader))
+    {
+        return false;
+    }
+    memcpy(&magic, pData, sizeof(magic));
+    return magic == CPUT_COOKED_CONFIG_MAGIC;
+}
+
+//-----------------------------------------------------------------------------
+static bool IsValidString(const unsigned char *pData, const CPUTCookedConfigHeader &header, const CPUTCookedString &string)
+{
+    uint64_t end = header.stringsOffset + header.stringsSize;
+    if(string.offset < header.stringsOffset || string.offset >= end || (string.offset - header.stringsOffset) % sizeof(uint16_t))
+    {
+        return false;
+    }
+    if(((uint64_t)string.length + 1) * sizeof(uint16_t) > end - string.offset)
+    {
+        return false;
+    }
+    uint16_t terminator;
+    memcpy(&terminator, pData + string.offset + (uint64_t)string.length * sizeof(uint16_t), sizeof(terminator));
+    return terminator == 0;
+}
+
+//-----------------------------------------------------------------------------
+const CPUTCookedConfigHeader *CPUTFixUpCookedConfig(void *pData, size_t size)
+{
+    if(!CPUTIsCookedConfig(pData, size) || ((uintptr_t)pData % 8))
+    {
+        return NULL;
+    }
+    unsigned char *pBytes = (unsigned char *)pData;
+    CPUTCookedConfigHeader *pHeader = (CPUTCookedConfigHeader *)pData;
+    if(pHeader->version != CPUT_COOKED_CONFIG_VERSION || pHeader->headerSize != sizeof(CPUTCookedConfigHeader) || pHeader->fixedUp)
+    {
+        return NULL;
+    }
+
+    // The tables are 8 byte aligned, in order, and inside the image
+    if(pHeader->blocksOffset  < sizeof(CPUTCookedConfigHeader) || pHeader->blocksOffset % 8 || pHeader->entriesOffset % 8 ||
+       pHeader->blocksOffset  > size || (size - pHeader->blocksOffset)  / sizeof(CPUTCookedConfigBlock) < pHeader->blockCount ||
+       pHeader->entriesOffset < pHeader->blocksOffset + (uint64_t)pHeader->blockCount * sizeof(CPUTCookedConfigBlock) ||
+       pHeader->entriesOffset > size || (size - pHeader->entriesOffset) / sizeof(CPUTCookedConfigEntry) < pHeader->entryCount ||
+       pHeader->stringsOffset < pHeader->entriesOffset + (uint64_t)pHeader->entryCount * sizeof(CPUTCookedConfigEntry) ||
+       pHeader->stringsOffset > size || pHeader->stringsSize > size - pHeader->stringsOffset)
+    {
+        return NULL;
+    }
+    CPUTCookedConfigBlock *pBlocks  = (CPUTCookedConfigBlock *)(pBytes + pHeader->blocksOffset);
+    CPUTCookedConfigEntry *pEntries = (CPUTCookedConfigEntry *)(pBytes + pHeader->entriesOffset);
+
+    // Check everything before changing anything
+    for(uint32_t ii=0; ii<pHeader->blockCount; ii++)
+    {
+        const CPUTCookedConfigBlock &block = pBlocks[ii];
+        uint64_t first = (block.entriesOffset - pHeader->entriesOffset) / sizeof(CPUTCookedConfigEntry);
+        if(!IsValidString(pBytes, *pHeader, block.name) || block.entryCount > CPUT_COOKED_CONFIG_ENTRIES ||
+           block.entriesOffset < pHeader->entriesOffset || (block.entriesOffset - pHeader->entriesOffset) % sizeof(CPUTCookedConfigEntry) ||
+           first > pHeader->entryCount || block.entryCount > pHeader->entryCount - first)
+        {
+            return NULL;
+        }
+    }
+    for(uint32_t ii=0; ii<pHeader->entryCount; ii++)
+    {
+        const CPUTCookedConfigEntry &entry = pEntries[ii];
+        if(!IsValidString(pBytes, *pHeader, entry.name) || !IsValidString(pBytes, *pHeader, entry.value) ||
+           entry.numberCount > CPUT_COOKED_CONFIG_NUMBERS)
+        {
+            return NULL;
+        }
+    }
+
+    for(uint32_t ii=0; ii<pHeader->blockCount; ii++)
+    {
+        CPUTCookedConfigBlock &block = pBlocks[ii];
+        block.name.pChars = (const uint16_t *)(pBytes + block.name.offset);
+        block.pEntries    = (const CPUTCookedConfigEntry *)(pBytes + block.entriesOffset);
+    }
+    for(uint32_t ii=0; ii<pHeader->entryCount; ii++)
+    {
+        CPUTCookedConfigEntry &entry = pEntries[ii];
+        entry.name.pChars  = (const uint16_t *)(pBytes + entry.name.offset);
+        entry.value.pChars = (const uint16_t *)(pBytes + entry.value.offset);
+    }
+    pHeader->fixedUp = 1;
+    return pHeader;
+}
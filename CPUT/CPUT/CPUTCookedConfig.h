@@ -0,0 +1,123 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTCOOKEDCONFIG_H__
+#define __CPUTCOOKEDCONFIG_H__
+
+// Cooked config files: .set, .mtl and other CPUTConfigFile text parsed offline into a binary
+// image the loader fixes up in place, skipping the line scanning, multibyte conversion and
+// per-value swscanf of the text path.
+//
+//   CPUTCookedConfigHeader
+//   CPUTCookedConfigBlock[blockCount]
+//   CPUTCookedConfigEntry[entryCount], each block's entries together and in order
+//   strings, UTF-16, each NUL terminated
+//
+// Names come out of the text parser as CPUTConfigFile::LoadFile() leaves them (block names and
+// entry names lower case, values as written), bytes widened one to one as it does.  Values of
+// up to CPUT_COOKED_CONFIG_NUMBERS space separated decimal numbers, like matrix columns, bounds
+// and colors, are also stored parsed.  CPUTPack --cook writes these into archives under the
+// text files' names, and CPUTConfigFile::LoadFile() recognizes them there by their magic.
+//
+// Only depends on the C++ standard library, so the packer tool shares it.
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define CPUT_COOKED_CONFIG_MAGIC   0x47464343 // "CCFG"
+#define CPUT_COOKED_CONFIG_VERSION 1
+#define CPUT_COOKED_CONFIG_NUMBERS 4
+#define CPUT_COOKED_CONFIG_ENTRIES 64 // per block, as many as a CPUTConfigBlock holds
+
+// Set on entries whose first word is a decimal integer small enough to be exact in a float
+#define CPUT_COOKED_CONFIG_INTEGER 0x1
+
+// Offsets from the start of the image in the file; pointers once fixed up
+struct CPUTCookedString
+{
+    union
+    {
+        uint64_t        offset;
+        const uint16_t *pChars;
+    };
+    uint32_t length;    // characters, not counting the NUL
+    uint32_t reserved;
+};
+
+struct CPUTCookedConfigEntry
+{
+    CPUTCookedString name;
+    CPUTCookedString value;
+    float            numbers[CPUT_COOKED_CONFIG_NUMBERS];
+    uint32_t         numberCount;   // 0 unless every word of the value is a number
+    uint32_t         flags;
+};
+
+struct CPUTCookedConfigBlock
+{
+    CPUTCookedString name;
+    union
+    {
+        uint64_t                     entriesOffset;
+        const CPUTCookedConfigEntry *pEntries;
+    };
+    uint32_t entryCount;
+    uint32_t reserved;
+};
+
+struct CPUTCookedConfigHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;
+    uint32_t blockCount;
+    uint32_t entryCount;
+    uint64_t blocksOffset;
+    uint64_t entriesOffset;
+    uint64_t stringsOffset;
+    uint64_t stringsSize;   // bytes
+    uint32_t fixedUp;       // 0 in the file
+    uint32_t reserved;
+};
+
+// A config file as text parses it
+struct CPUTConfigTextEntry
+{
+    std::string name;
+    std::string value;
+};
+
+struct CPUTConfigTextBlock
+{
+    std::string                      name;
+    std::vector<CPUTConfigTextEntry> entries;
+};
+
+// Same rules as CPUTConfigFile::LoadFile(): lines before the first [block] belong to the
+// first block, a file without any gets one unnamed block, and repeated names keep the first.
+void CPUTParseConfigText(const char *pText, size_t size, std::vector<CPUTConfigTextBlock> *pBlocks);
+
+// The cooked image of blocks.  Returns false if a block has more than CPUT_COOKED_CONFIG_ENTRIES entries.
+bool CPUTCookConfig(const std::vector<CPUTConfigTextBlock> &blocks, std::vector<unsigned char> *pCooked);
+
+// Whether size bytes at pData start like a cooked config
+bool CPUTIsCookedConfig(const void *pData, size_t size);
+
+// Checks a cooked image and turns its offsets into pointers, in place.  pData must be 8 byte
+// aligned and writable.  Returns NULL if it isn't a valid image.
+const CPUTCookedConfigHeader *CPUTFixUpCookedConfig(void *pData, size_t size);
+
+#endif // __CPUTCOOKEDCONFIG_H__
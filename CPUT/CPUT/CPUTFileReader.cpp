@@ -0,0 +1,167 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTFileReader.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+//-----------------------------------------------------------------------------
+CPUTFileReader::CPUTFileReader() :
+    mSize(0),
+#ifdef _WIN32
+    mhFile(NULL)
+#else
+    mFd(-1)
+#endif
+{
+}
+
+//-----------------------------------------------------------------------------
+CPUTFileReader::~CPUTFileReader()
+{
+    Close();
+}
+
+#ifdef _WIN32
+//-----------------------------------------------------------------------------
+bool CPUTFileReader::Open(const PathChar *fileName)
+{
+    Close();
+
+    HANDLE hFile = CreateFileW(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                               FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+    if(hFile == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    mhFile = hFile;
+
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(hFile, &fileSize))
+    {
+        Close();
+        return false;
+    }
+    mSize = (uint64_t)fileSize.QuadPart;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTFileReader::Close()
+{
+    if(mhFile)
+    {
+        CloseHandle((HANDLE)mhFile);
+        mhFile = NULL;
+    }
+    mSize = 0;
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTFileReader::IsOpen() const
+{
+    return mhFile != NULL;
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTFileReader::ReadAt(uint64_t offset, void *pBuffer, size_t size) const
+{
+    unsigned char *pDest = (unsigned char *)pBuffer;
+    while(size)
+    {
+        // ReadFile takes a DWORD count
+        DWORD chunk = size > 0x40000000 ? 0x40000000 : (DWORD)size;
+        OVERLAPPED overlapped = {};
+        overlapped.Offset     = (DWORD)offset;
+        overlapped.OffsetHigh = (DWORD)(offset >> 32);
+        DWORD bytesRead = 0;
+        if(!ReadFile((HANDLE)mhFile, pDest, chunk, &bytesRead, &overlapped) || bytesRead == 0)
+        {
+            return false;
+        }
+        pDest  += bytesRead;
+        offset += bytesRead;
+        size   -= bytesRead;
+    }
+    return true;
+}
+
+#else
+//-----------------------------------------------------------------------------
+bool CPUTFileReader::Open(const PathChar *fileName)
+{
+    Close();
+
+    mFd = open(fileName, O_RDONLY);
+    if(mFd < 0)
+    {
+        return false;
+    }
+    struct stat fileStat;
+    if(fstat(mFd, &fileStat) != 0)
+    {
+        Close();
+        return false;
+    }
+    mSize = (uint64_t)fileStat.st_size;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTFileReader::Close()
+{
+    if(mFd >= 0)
+    {
+        close(mFd);
+        mFd = -1;
+    }
+    mSize = 0;
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTFileReader::IsOpen() const
+{
+    return mFd >= 0;
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTFileReader::ReadAt(uint64_t offset, void *pBuffer, size_t size) const
+{
+    unsigned char *pDest = (unsigned char *)pBuffer;
+    while(size)
+    {
+        ssize_t bytesRead = pread(mFd, pDest, size, (off_t)offset);
+        if(bytesRead < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(bytesRead <= 0)
+        {
+            return false;
+        }
+        pDest  += bytesRead;
+        offset += (uint64_t)bytesRead;
+        size   -= (size_t)bytesRead;
+    }
+    return true;
+}
+#endif
@@ -0,0 +1,60 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTFILEREADER_H__
+#define __CPUTFILEREADER_H__
+
+// Read-only file for random access.  ReadAt() takes an explicit offset (pread, or ReadFile with an
+// OVERLAPPED offset on Windows) and never moves a shared file pointer, so any number of threads
+// can read different ranges of one open file at the same time.  Only depends on the platform
+// API, so tools built on it also run off Windows.
+#include <stddef.h>
+#include <stdint.h>
+
+class CPUTFileReader
+{
+public:
+#ifdef _WIN32
+    typedef wchar_t PathChar;
+#else
+    typedef char    PathChar;
+#endif
+
+    CPUTFileReader();
+    ~CPUTFileReader();
+
+    // Returns false if the file can't be opened
+    bool Open(const PathChar *fileName);
+    void Close();
+
+    bool     IsOpen()  const;
+    uint64_t GetSize() const { return mSize; }
+
+    // Read exactly size bytes starting at offset.  Returns false on an error or a short read.
+    bool ReadAt(uint64_t offset, void *pBuffer, size_t size) const;
+
+private:
+    uint64_t mSize;
+#ifdef _WIN32
+    void    *mhFile;
+#else
+    int      mFd;
+#endif
+
+    CPUTFileReader(const CPUTFileReader &);
+    CPUTFileReader &operator=(const CPUTFileReader &);
+};
+
+#endif // __CPUTFILEREADER_H__
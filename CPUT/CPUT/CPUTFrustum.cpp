@@ -49,6 +49,7 @@ void CPUTFrustum::InitializeFrustum
 
     mNumFrustumVisibleModels = 0;
     mNumFrustumCulledModels  = 0;
+    mGeneration++;
 
     // We have the camera's up and look, but we also need right.
     float3 right = cross3( up, look );
@@ -137,3 +138,29 @@ bool CPUTFrustum::IsVisible(
     return true;
 }
 
+
+//-----------------------------------------------
+void CPUTFrustum::GetPlanes( float pPlanes[6][4] ) const
+{
+    // Same points on the planes as IsVisible(), so both decide every box the same way
+    for( UINT ii=0; ii<6; ii++ )
+    {
+        const float3 &normal = mpNormal[ii];
+        const float3 &point  = mpPosition[ii < 3 ? 0 : 6];
+        pPlanes[ii][0] = normal.x;
+        pPlanes[ii][1] = normal.y;
+        pPlanes[ii][2] = normal.z;
+        pPlanes[ii][3] = -dot3( normal, point );
+    }
+}
+
+//-----------------------------------------------
+UINT CPUTFrustum::CullBoxes( const CPUTCullBoxSet &boxes, UINT *pVisible )
+{
+    float planes[6][4];
+    GetPlanes( planes );
+    UINT visibleCount = CPUTCullBoxes( boxes, planes, pVisible );
+    mNumFrustumVisibleModels += visibleCount;
+    mNumFrustumCulledModels  += boxes.count - visibleCount;
+    return visibleCount;
+}
@@ -18,6 +18,7 @@
 
 #include "CPUT.h"
 #include "CPUTMath.h"
+#include "CPUTBoxCulling.h"
 
 class CPUTCamera;
 
@@ -27,10 +28,16 @@ public:
     float3 mpPosition[8];
     float3 mpNormal[6];
 
+    // Models CPUTModelDX11::Render() and CullBoxes() found inside and outside the frustum since
+    // InitializeFrustum() or ResetModelCounts()
     UINT mNumFrustumVisibleModels;
     UINT mNumFrustumCulledModels;
 
-    CPUTFrustum(){}
+    // Counts InitializeFrustum() calls, so results culled against one state of the frustum can
+    // be told from the next
+    UINT mGeneration;
+
+    CPUTFrustum() : mNumFrustumVisibleModels(0), mNumFrustumCulledModels(0), mGeneration(0) {}
     ~CPUTFrustum(){}
 
     void InitializeFrustum
@@ -51,6 +58,15 @@ public:
         const float3 &half
     );
 
+    // The six planes as CPUTCullBoxes() and CPUTCullMeshClusters() take them, in world space
+    void GetPlanes( float pPlanes[6][4] ) const;
+
+    // IsVisible() for a whole set of boxes at once (see CPUTBoxCulling.h), counting them as models.
+    // Returns the number visible.
+    UINT CullBoxes( const CPUTCullBoxSet &boxes, UINT *pVisible );
+
+    void ResetModelCounts() { mNumFrustumVisibleModels = 0; mNumFrustumCulledModels = 0; }
+
 };
 
 #endif // _CPUTFRUSTUM_H
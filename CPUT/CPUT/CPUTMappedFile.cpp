@@ -0,0 +1,167 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTMappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+//-----------------------------------------------------------------------------
+CPUTMappedFile::CPUTMappedFile() :
+    mpData(NULL),
+    mSize(0),
+#ifdef _WIN32
+    mhFile(NULL),
+    mhMapping(NULL)
+#else
+    mFd(-1)
+#endif
+{
+}
+
+//-----------------------------------------------------------------------------
+CPUTMappedFile::~CPUTMappedFile()
+{
+    Close();
+}
+
+#ifdef _WIN32
+//-----------------------------------------------------------------------------
+bool CPUTMappedFile::Open(const PathChar *fileName)
+{
+    Close();
+
+    HANDLE hFile = CreateFileW(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                               FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if(hFile == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    mhFile = hFile;
+
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart == 0 || (ULONGLONG)fileSize.QuadPart > (size_t)-1)
+    {
+        Close();
+        return false;
+    }
+    mhMapping = CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(mhMapping == NULL)
+    {
+        Close();
+        return false;
+    }
+    mpData = (const unsigned char *)MapViewOfFile((HANDLE)mhMapping, FILE_MAP_READ, 0, 0, 0);
+    if(mpData == NULL)
+    {
+        Close();
+        return false;
+    }
+    mSize = (size_t)fileSize.QuadPart;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTMappedFile::Close()
+{
+    if(mpData)
+    {
+        UnmapViewOfFile(mpData);
+        mpData = NULL;
+    }
+    if(mhMapping)
+    {
+        CloseHandle((HANDLE)mhMapping);
+        mhMapping = NULL;
+    }
+    if(mhFile)
+    {
+        CloseHandle((HANDLE)mhFile);
+        mhFile = NULL;
+    }
+    mSize = 0;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTMappedFile::WillNeed() const
+{
+#if (_WIN32_WINNT >= 0x0602 /*_WIN32_WINNT_WIN8*/)
+    if(mpData)
+    {
+        WIN32_MEMORY_RANGE_ENTRY range = { (PVOID)mpData, mSize };
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+#endif
+}
+
+#else
+//-----------------------------------------------------------------------------
+bool CPUTMappedFile::Open(const PathChar *fileName)
+{
+    Close();
+
+    mFd = open(fileName, O_RDONLY);
+    if(mFd < 0)
+    {
+        return false;
+    }
+    struct stat fileStat;
+    if(fstat(mFd, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        Close();
+        return false;
+    }
+    void *pData = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, mFd, 0);
+    if(pData == MAP_FAILED)
+    {
+        Close();
+        return false;
+    }
+    mpData = (const unsigned char *)pData;
+    mSize  = (size_t)fileStat.st_size;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTMappedFile::Close()
+{
+    if(mpData)
+    {
+        munmap((void *)mpData, mSize);
+        mpData = NULL;
+    }
+    if(mFd >= 0)
+    {
+        close(mFd);
+        mFd = -1;
+    }
+    mSize = 0;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTMappedFile::WillNeed() const
+{
+    if(mpData)
+    {
+        madvise((void *)mpData, mSize, MADV_WILLNEED);
+    }
+}
+#endif
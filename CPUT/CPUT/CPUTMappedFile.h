@@ -0,0 +1,61 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTMAPPEDFILE_H__
+#define __CPUTMAPPEDFILE_H__
+
+// Read-only view of a whole file.  Uses a file mapping on Windows and mmap elsewhere, so the
+// bytes are paged in on demand straight from the file cache instead of being copied into a heap
+// buffer first.  Only depends on the platform API, so tools built on it also run off Windows.
+#include <stddef.h>
+
+class CPUTMappedFile
+{
+public:
+#ifdef _WIN32
+    typedef wchar_t PathChar;
+#else
+    typedef char    PathChar;
+#endif
+
+    CPUTMappedFile();
+    ~CPUTMappedFile();
+
+    // Returns false if the file can't be opened or mapped.  Empty files can't be mapped.
+    bool Open(const PathChar *fileName);
+    void Close();
+
+    bool                 IsOpen()  const { return mpData != NULL; }
+    const unsigned char *GetData() const { return mpData; }
+    size_t               GetSize() const { return mSize; }
+
+    // Tell the OS the whole view is about to be read front to back
+    void WillNeed() const;
+
+private:
+    const unsigned char *mpData;
+    size_t               mSize;
+#ifdef _WIN32
+    void                *mhFile;
+    void                *mhMapping;
+#else
+    int                  mFd;
+#endif
+
+    CPUTMappedFile(const CPUTMappedFile &);
+    CPUTMappedFile &operator=(const CPUTMappedFile &);
+};
+
+#endif // __CPUTMAPPEDFILE_H__
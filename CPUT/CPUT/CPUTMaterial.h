@@ -103,12 +103,14 @@ public:
     virtual CPUTResult    LoadMaterial(const cString &fileName, const CPUTModel *pModel=NULL, int meshIndex=-1) = 0;
     virtual void          ReleaseTexturesAndBuffers() = 0;
     virtual void          RebindTexturesAndBuffers() = 0;
+    virtual void          RebindTexture(CPUTTexture *pTexture) = 0;
     virtual void          SetRenderStates(CPUTRenderParameters &renderParams) { if( mpRenderStateBlock ) { mpRenderStateBlock->SetRenderStates(renderParams); } }
     virtual bool          MaterialRequiresPerModelPayload() = 0;
     virtual CPUTMaterial *CloneMaterial( const cString &absolutePathAndFilename, const CPUTModel *pModel=NULL, int meshIndex=-1 ) = 0;
     CPUTMaterial         *GetNextClone() { return mpMaterialNextClone; }
     const CPUTModel      *GetModel() { return mpModel; }
     int                   GetMeshIndex() { return mMeshIndex; }
+    CPUTRenderStateBlock *GetRenderStateBlock() { return mpRenderStateBlock; }
     UINT                  GetBufferCount() { return mBufferCount; }
     CPUTBuffer           *GetBuffer( UINT bufferIndex ) { return mpBuffer[bufferIndex]; }
 };
@@ -18,6 +18,7 @@
 #include "CPUTRenderStateBlockDX11.h"
 #include "D3DCompiler.h"
 #include "CPUTTextureDX11.h"
+#include "CPUTTextureCacheDX11.h"
 #include "CPUTBufferDX11.h"
 #include "CPUTVertexShaderDX11.h"
 #include "CPUTPixelShaderDX11.h"
@@ -59,7 +60,8 @@ CPUTMaterialDX11::CPUTMaterialDX11() :
     mpGeometryShader(NULL),
     mpHullShader(NULL),
     mpDomainShader(NULL),
-    mRequiresPerModelPayload(-1)
+    mRequiresPerModelPayload(-1),
+    mLastUsedFrame(0)
 {
 	// TODO: Is there a better/safer way to initialize this list?
     mpShaderParametersList[0] =  &mPixelShaderParameters,
@@ -154,6 +156,17 @@ void CPUTMaterialDX11::SetRenderStates(CPUTRenderParameters &renderParams)
 {
     ID3D11DeviceContext *pContext = ((CPUTRenderParametersDX*)&renderParams)->mpContext;
 
+    // Tell the texture cache our textures are in use.  Once per frame is enough.
+    UINT frame = CPUTTextureCacheDX11::GetFrame();
+    if( mLastUsedFrame != frame )
+    {
+        mLastUsedFrame = frame;
+        for( UINT ii=0; ii<CPUT_MATERIAL_MAX_TEXTURE_SLOTS && mpTexture[ii]; ii++ )
+        {
+            ((CPUTTextureDX11*)mpTexture[ii])->SetLastUsedFrame( frame );
+        }
+    }
+
     bool same = true;
 
     SET_SHADER_RESOURCES( Vertex,    VS );
@@ -352,7 +365,18 @@ void CPUTMaterialDX11::BindTextures( CPUTShaderParameters &params, const CPUTMod
 
         if( !mpTexture[textureCount] )
         {
-            mpTexture[textureCount] = pAssetLibrary->GetTexture( textureName, false, loadAsSRGB );
+            if( pAssetLibrary->GetStreamTextures() )
+            {
+                mpTexture[textureCount] = pAssetLibrary->GetStreamingTexture( textureName, false, loadAsSRGB );
+            }
+            else if( pAssetLibrary->GetLoadTexturesAsync() )
+            {
+                mpTexture[textureCount] = pAssetLibrary->GetTextureAsync( textureName, false, loadAsSRGB );
+            }
+            else
+            {
+                mpTexture[textureCount] = pAssetLibrary->GetTexture( textureName, false, loadAsSRGB );
+            }
             ASSERT( mpTexture[textureCount], _L("Failed getting texture ") + textureName);
         }
 
@@ -722,6 +746,26 @@ void CPUTMaterialDX11::RebindTexturesAndBuffers()
     }
 }
 
+// Like RebindTexturesAndBuffers(), for the bind points that use one texture
+//-----------------------------------------------------------------------------
+void CPUTMaterialDX11::RebindTexture(CPUTTexture *pTexture)
+{
+    for( CPUTShaderParameters **pCur = mpShaderParametersList; *pCur; pCur++ )
+    {
+        for( UINT ii=0; ii<(*pCur)->mTextureCount; ii++ )
+        {
+            if( mpTexture[ii] != pTexture )
+            {
+                continue;
+            }
+            UINT bindPoint = (*pCur)->mpTextureParameterBindPoint[ii];
+            SAFE_RELEASE((*pCur)->mppBindViews[bindPoint]);
+            (*pCur)->mppBindViews[bindPoint] = ((CPUTTextureDX11*)pTexture)->GetShaderResourceView();
+            (*pCur)->mppBindViews[bindPoint]->AddRef();
+        }
+    }
+}
+
 //-----------------------------------------------------------------------------
 void CPUTMaterialDX11::ReleaseTexturesAndBuffers()
 {
@@ -174,6 +174,7 @@ protected:
     CPUTHullShaderDX11       *mpHullShader;
     CPUTDomainShaderDX11     *mpDomainShader;
     int                       mRequiresPerModelPayload;
+    UINT                      mLastUsedFrame; // last CPUTTextureCacheDX11 frame our textures were stamped with
 
 public:
     CPUTShaderParameters     mPixelShaderParameters;
@@ -201,6 +202,7 @@ public:
     CPUTResult    LoadMaterial(const cString &fileName, const CPUTModel *pModel=NULL, int meshIndex=-1);
     void          ReleaseTexturesAndBuffers();
     void          RebindTexturesAndBuffers();
+    void          RebindTexture(CPUTTexture *pTexture);
     CPUTVertexShaderDX11   *GetVertexShader()   { return mpVertexShader; }
     CPUTPixelShaderDX11    *GetPixelShader()    { return mpPixelShader; }
     CPUTGeometryShaderDX11 *GetGeometryShader() { return mpGeometryShader; }
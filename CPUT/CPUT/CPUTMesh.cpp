@@ -29,7 +29,7 @@ const char *CPUT_VERTEX_ELEMENT_SEMANTIC_AS_STRING[] =
     "BINORMAL"
 };
 //-----------------------------------------------------------------------------
-void CPUTVertexElementDesc::Read(std::ifstream &meshFile)
+void CPUTVertexElementDesc::Read(std::istream &meshFile)
 {
     meshFile.read((char*)this, sizeof(*this));
 }
@@ -45,7 +45,7 @@ void CPUTRawMeshData::Allocate(__int32 numElements)
 }
 
 //-----------------------------------------------------------------------------
-bool CPUTRawMeshData::Read(std::ifstream &modelFile)
+bool CPUTRawMeshData::Read(std::istream &modelFile)
 {
     unsigned __int32 magicCookie;
     modelFile.read((char*)&magicCookie,sizeof(magicCookie));
@@ -74,10 +74,12 @@ bool CPUTRawMeshData::Read(std::ifstream &modelFile)
     modelFile.read((char*)&mIndexType, sizeof(mIndexType));
     ASSERT( modelFile.good(), _L("Bad model file(1)." ) );
 
-    mpIndices = new UINT[mIndexCount];
+    ASSERT( mIndexType == tUINT16 || mIndexType == tUINT32, _L("Unsupported index type.") );
+    UINT indexSize = (mIndexType == tUINT16) ? sizeof(UINT16) : sizeof(UINT32);
+    mpIndices = (void*)new char[mIndexCount * indexSize];
     if( mIndexCount != 0 )
     {
-        modelFile.read((char*)mpIndices, mIndexCount * sizeof(UINT));
+        modelFile.read((char*)mpIndices, mIndexCount * indexSize);
     }
     modelFile.read((char*)&magicCookie, sizeof(magicCookie));
     ASSERT( magicCookie == 1234, _L("Model file missing magic cookie.") );
@@ -19,6 +19,8 @@
 #include "CPUTRefCount.h"
 #include <fstream>
 #include "CPUT.h"
+#include "CPUTMeshClusters.h"
+#include "CPUTMeshSimplifier.h"
 
 class CPUTRenderParameters;
 class CPUTMaterial;
@@ -109,7 +111,7 @@ struct CPUTVertexElementDesc
     UINT                          mElementSizeInBytes;   // # bytes of this element
     UINT                          mOffset;   // what is the offset within the vertex data
 
-    void Read(std::ifstream &meshFile);
+    void Read(std::istream &meshFile);
 };
 
 //-----------------------------------------------------------------------------
@@ -119,7 +121,7 @@ struct CPUTRawMeshData
     UINT                       mVertexCount;
     void                      *mpVertices;
     UINT                       mIndexCount;
-    UINT                      *mpIndices; // TODO: what about 16-bit indices?  Use void*?
+    void                      *mpIndices; // mIndexCount UINT16s or UINTs, per mIndexType
     UINT                       mFormatDescriptorCount;
     CPUTVertexElementDesc     *mpElements;
     unsigned __int64           mTotalVerticesSizeInBytes;
@@ -152,7 +154,7 @@ struct CPUTRawMeshData
         delete[] mpIndices;
     }
     void Allocate(__int32 numElements);
-    bool Read(std::ifstream &mdlfile);
+    bool Read(std::istream &mdlfile);
 };
 
 //-----------------------------------------------------------------------------
@@ -174,6 +176,8 @@ class CPUTMesh : public CPUTRefCount
 protected:
     eCPUT_MESH_TOPOLOGY mMeshTopology;
     UINT mInstanceCount;
+    std::vector<CPUTMeshCluster> mClusters;
+    std::vector<CPUTMeshLod> mLods;
 
 public:
     CPUTMesh() : mInstanceCount(1) {}
@@ -196,9 +200,19 @@ public:
         CPUTBufferInfo *pIndexInfo,
         void           *pIndex
     ) = 0;
+    // A second vertex buffer of pPositionInfo's element alone, packed, for DrawShadow().  Call it
+    // after CreateNativeResources(); without one, the shadow pass fetches whole vertices.
+    virtual CPUTResult CreateShadowPositions(CPUTBufferInfo *pPositionInfo, void *pPositions) = 0;
 
     virtual void Draw(CPUTRenderParameters &renderParams, CPUTModel *pModel) = 0;
     virtual void DrawShadow(CPUTRenderParameters &renderParams, CPUTModel *pModel) = 0;
+    // Empty unless the mesh was split into clusters when it loaded
+    void SetClusters(std::vector<CPUTMeshCluster> *pClusters) { mClusters.swap(*pClusters); }
+    const std::vector<CPUTMeshCluster> &GetClusters() const { return mClusters; }
+    // Empty unless levels of detail were built when the mesh loaded; the first is the full mesh,
+    // whose clusters these are, and the rest follow it in the index buffer
+    void SetLods(std::vector<CPUTMeshLod> *pLods) { mLods.swap(*pLods); }
+    const std::vector<CPUTMeshLod> &GetLods() const { return mLods; }
     void IncrementInstanceCount() { mInstanceCount++; }
     void DecrementInstanceCount() { mInstanceCount--; }
 };
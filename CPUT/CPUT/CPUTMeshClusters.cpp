@@ -0,0 +1,312 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTMeshClusters.h"
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+//-----------------------------------------------------------------------------
+static void ReadPosition(const unsigned char *pPositions, uint32_t positionStride, uint32_t vertex, float pPosition[3])
+{
+    memcpy(pPosition, pPositions + (size_t)vertex * positionStride, 3 * sizeof(float));
+}
+
+// Bounding box and normal cone of the triangles in one index range
+//-----------------------------------------------------------------------------
+static void ComputeClusterBounds(const uint32_t *pIndices, const unsigned char *pPositions, uint32_t positionStride,
+                                 std::vector<float> *pNormals, CPUTMeshCluster *pCluster)
+{
+    float minimum[3] = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
+    float maximum[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    double axis[3] = { 0.0, 0.0, 0.0 };
+    pNormals->clear();
+    for(uint32_t ii=0; ii<pCluster->indexCount; ii+=3)
+    {
+        float corner[3][3];
+        for(int vv=0; vv<3; vv++)
+        {
+            ReadPosition(pPositions, positionStride, pIndices[pCluster->indexStart + ii + vv], corner[vv]);
+            for(int cc=0; cc<3; cc++)
+            {
+                minimum[cc] = corner[vv][cc] < minimum[cc] ? corner[vv][cc] : minimum[cc];
+                maximum[cc] = corner[vv][cc] > maximum[cc] ? corner[vv][cc] : maximum[cc];
+            }
+        }
+        double edge0[3], edge1[3];
+        for(int cc=0; cc<3; cc++)
+        {
+            edge0[cc] = (double)corner[1][cc] - corner[0][cc];
+            edge1[cc] = (double)corner[2][cc] - corner[0][cc];
+        }
+        double normal[3] = {
+            edge0[1]*edge1[2] - edge0[2]*edge1[1],
+            edge0[2]*edge1[0] - edge0[0]*edge1[2],
+            edge0[0]*edge1[1] - edge0[1]*edge1[0]
+        };
+        double length = sqrt(normal[0]*normal[0] + normal[1]*normal[1] + normal[2]*normal[2]);
+        if(length > 0.0)
+        {
+            // Every triangle counts the same, however small, since any of them can face the camera
+            for(int cc=0; cc<3; cc++)
+            {
+                pNormals->push_back((float)(normal[cc] / length));
+                axis[cc] += normal[cc] / length;
+            }
+        }
+    }
+    for(int cc=0; cc<3; cc++)
+    {
+        pCluster->boundsCenter[cc] = (minimum[cc] + maximum[cc]) * 0.5f;
+        pCluster->boundsHalf[cc]   = (maximum[cc] - minimum[cc]) * 0.5f;
+    }
+
+    // The cone spans every normal.  Past a right angle it can't rule anything out, and neither
+    // can a cluster of degenerate triangles.
+    double axisLength = sqrt(axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2]);
+    double cosine = axisLength > 0.0 ? 1.0 : 0.0;
+    for(int cc=0; cc<3; cc++)
+    {
+        axis[cc] = axisLength > 0.0 ? axis[cc] / axisLength : 0.0;
+        pCluster->coneAxis[cc] = (float)axis[cc];
+    }
+    for(size_t ii=0; ii<pNormals->size() && cosine > 0.0; ii+=3)
+    {
+        const float *pNormal = &(*pNormals)[ii];
+        double dot = pNormal[0]*axis[0] + pNormal[1]*axis[1] + pNormal[2]*axis[2];
+        cosine = dot < cosine ? dot : cosine;
+    }
+    // Round the cone out a little so float error in the test can't cull a cluster edge on
+    cosine = cosine > 0.0 ? cosine - 1e-4 : 0.0;
+    pCluster->coneCosine = (float)(cosine > 0.0 ? cosine : 0.0);
+    pCluster->coneSine   = (float)sqrt(1.0 - (double)pCluster->coneCosine * pCluster->coneCosine);
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTBuildMeshClusters(uint32_t *pIndices, size_t indexCount, const unsigned char *pPositions, uint32_t positionStride, uint32_t vertexCount,
+                           uint32_t maxTriangles, std::vector<CPUTMeshCluster> *pClusters)
+{
+    if(indexCount % 3 || !maxTriangles || indexCount / 3 > UINT32_MAX)
+    {
+        return false;
+    }
+    for(size_t ii=0; ii<indexCount; ii++)
+    {
+        if(pIndices[ii] >= vertexCount)
+        {
+            return false;
+        }
+    }
+    pClusters->clear();
+    uint32_t triangleCount = (uint32_t)(indexCount / 3);
+
+    // The triangles around each vertex
+    std::vector<uint32_t> firstTriangle(vertexCount + 1, 0);
+    for(size_t ii=0; ii<indexCount; ii++)
+    {
+        firstTriangle[pIndices[ii] + 1]++;
+    }
+    for(uint32_t ii=0; ii<vertexCount; ii++)
+    {
+        firstTriangle[ii+1] += firstTriangle[ii];
+    }
+    std::vector<uint32_t> triangles(indexCount);
+    std::vector<uint32_t> fill(firstTriangle.begin(), firstTriangle.end() - 1);
+    for(size_t ii=0; ii<indexCount; ii++)
+    {
+        triangles[fill[pIndices[ii]]++] = (uint32_t)(ii / 3);
+    }
+
+    std::vector<float> centroids(triangleCount * 3);
+    for(uint32_t ii=0; ii<triangleCount; ii++)
+    {
+        float corner[3][3];
+        for(int vv=0; vv<3; vv++)
+        {
+            ReadPosition(pPositions, positionStride, pIndices[ii*3 + vv], corner[vv]);
+        }
+        for(int cc=0; cc<3; cc++)
+        {
+            centroids[ii*3 + cc] = (corner[0][cc] + corner[1][cc] + corner[2][cc]) / 3.0f;
+        }
+    }
+
+    // Stamps are the cluster number + 1, so nothing needs clearing between clusters
+    std::vector<uint32_t> vertexStamp(vertexCount, 0);
+    std::vector<uint32_t> candidateStamp(triangleCount, 0);
+    std::vector<bool>     emitted(triangleCount, false);
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> output;
+    output.reserve(indexCount);
+    uint32_t seed = 0;
+    while(output.size() < indexCount)
+    {
+        uint32_t stamp = (uint32_t)pClusters->size() + 1;
+        CPUTMeshCluster cluster;
+        cluster.indexStart = (uint32_t)output.size();
+        double centroid[3] = { 0.0, 0.0, 0.0 };
+        uint32_t clusterTriangles = 0;
+        candidates.clear();
+        while(clusterTriangles < maxTriangles)
+        {
+            // The neighbour bringing in the fewest new vertices, then the one closest to the
+            // middle of the cluster.  Emitted candidates are dropped on the way.
+            int64_t best = -1;
+            int bestNew = 4;
+            double bestDistance = 0.0;
+            for(size_t ii=0; ii<candidates.size(); )
+            {
+                uint32_t triangle = candidates[ii];
+                if(emitted[triangle])
+                {
+                    candidates[ii] = candidates.back();
+                    candidates.pop_back();
+                    continue;
+                }
+                int newVertices = 0;
+                for(int vv=0; vv<3; vv++)
+                {
+                    newVertices += vertexStamp[pIndices[triangle*3 + vv]] != stamp ? 1 : 0;
+                }
+                double distance = 0.0;
+                for(int cc=0; cc<3; cc++)
+                {
+                    double delta = centroids[triangle*3 + cc] - centroid[cc] / clusterTriangles;
+                    distance += delta * delta;
+                }
+                if(newVertices < bestNew || (newVertices == bestNew && distance < bestDistance))
+                {
+                    best = triangle;
+                    bestNew = newVertices;
+                    bestDistance = distance;
+                }
+                ii++;
+            }
+            if(best < 0)
+            {
+                // Nothing adjacent left: carry on from the next triangle in the original order,
+                // which a vertex cache optimized mesh keeps close by
+                while(seed < triangleCount && emitted[seed])
+                {
+                    seed++;
+                }
+                if(seed == triangleCount)
+                {
+                    break;
+                }
+                best = seed;
+            }
+
+            uint32_t triangle = (uint32_t)best;
+            emitted[triangle] = true;
+            clusterTriangles++;
+            for(int cc=0; cc<3; cc++)
+            {
+                centroid[cc] += centroids[triangle*3 + cc];
+            }
+            for(int vv=0; vv<3; vv++)
+            {
+                uint32_t vertex = pIndices[triangle*3 + vv];
+                output.push_back(vertex);
+                vertexStamp[vertex] = stamp;
+                for(uint32_t jj=firstTriangle[vertex]; jj<firstTriangle[vertex+1]; jj++)
+                {
+                    uint32_t neighbour = triangles[jj];
+                    if(!emitted[neighbour] && candidateStamp[neighbour] != stamp)
+                    {
+                        candidateStamp[neighbour] = stamp;
+                        candidates.push_back(neighbour);
+                    }
+                }
+            }
+        }
+        cluster.indexCount = (uint32_t)output.size() - cluster.indexStart;
+        pClusters->push_back(cluster);
+    }
+
+    memcpy(pIndices, &output[0], indexCount * sizeof(uint32_t));
+    std::vector<float> normals;
+    for(size_t ii=0; ii<pClusters->size(); ii++)
+    {
+        ComputeClusterBounds(pIndices, pPositions, positionStride, &normals, &(*pClusters)[ii]);
+    }
+    return true;
+}
+
+// Every triangle in the cluster faces away from the eye when the sphere around its bounding box
+// lies inside the cone of directions, with its apex at the eye, that see the back of every normal
+// the cluster's cone holds: half angle 90 degrees minus the normal cone's.
+//-----------------------------------------------------------------------------
+static bool FacesAway(const CPUTMeshCluster &cluster, const float *pEye)
+{
+    if(cluster.coneCosine <= 0.0f)
+    {
+        return false;
+    }
+    float toCluster[3], radiusSquared = 0.0f, distanceSquared = 0.0f, along = 0.0f;
+    for(int cc=0; cc<3; cc++)
+    {
+        toCluster[cc]    = cluster.boundsCenter[cc] - pEye[cc];
+        radiusSquared   += cluster.boundsHalf[cc] * cluster.boundsHalf[cc];
+        distanceSquared += toCluster[cc] * toCluster[cc];
+        along           += toCluster[cc] * cluster.coneAxis[cc];
+    }
+    float across = distanceSquared - along * along;
+    across = across > 0.0f ? sqrtf(across) : 0.0f;
+    return cluster.coneCosine * along - cluster.coneSine * across > sqrtf(radiusSquared);
+}
+
+//-----------------------------------------------------------------------------
+static bool InsideFrustum(const CPUTMeshCluster &cluster, const float pPlanes[6][4])
+{
+    for(int ii=0; ii<6; ii++)
+    {
+        const float *pPlane = pPlanes[ii];
+        float distance = pPlane[0] * cluster.boundsCenter[0] + pPlane[1] * cluster.boundsCenter[1] + pPlane[2] * cluster.boundsCenter[2] + pPlane[3];
+        float extent   = fabsf(pPlane[0]) * cluster.boundsHalf[0] + fabsf(pPlane[1]) * cluster.boundsHalf[1] + fabsf(pPlane[2]) * cluster.boundsHalf[2];
+        if(distance > extent)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+size_t CPUTCullMeshClusters(const CPUTMeshCluster *pClusters, size_t clusterCount, const float pPlanes[6][4], const float *pEye,
+                            std::vector<CPUTMeshClusterRange> *pRanges)
+{
+    pRanges->clear();
+    size_t indexCount = 0;
+    for(size_t ii=0; ii<clusterCount; ii++)
+    {
+        const CPUTMeshCluster &cluster = pClusters[ii];
+        if(!InsideFrustum(cluster, pPlanes) || (pEye && FacesAway(cluster, pEye)))
+        {
+            continue;
+        }
+        indexCount += cluster.indexCount;
+        if(!pRanges->empty() && pRanges->back().indexStart + pRanges->back().indexCount == cluster.indexStart)
+        {
+            pRanges->back().indexCount += cluster.indexCount;
+        }
+        else
+        {
+            CPUTMeshClusterRange range = { cluster.indexStart, cluster.indexCount };
+            pRanges->push_back(range);
+        }
+    }
+    return indexCount;
+}
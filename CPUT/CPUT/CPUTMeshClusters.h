@@ -0,0 +1,67 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTMESHCLUSTERS_H__
+#define __CPUTMESHCLUSTERS_H__
+
+// Splits indexed triangle lists into clusters of up to a hundred or so neighbouring triangles,
+// each with an object space bounding box and a cone around its triangles' normals, so a model
+// can draw just the clusters inside the frustum and facing the camera instead of all or nothing.
+//
+// Clusters are grown one triangle at a time from a seed, always taking the adjacent triangle
+// that brings in the fewest new vertices, then the one closest to the cluster's centre, which
+// keeps them compact.  The indices are rewritten cluster by cluster, so every cluster is one
+// contiguous index range and neighbouring visible clusters merge into one draw.
+// Only depends on the C++ standard library, so tools built on it also run off Windows.
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#define CPUT_MESH_CLUSTER_TRIANGLES 128
+
+struct CPUTMeshCluster
+{
+    uint32_t indexStart;
+    uint32_t indexCount;
+    float    boundsCenter[3];   // object space
+    float    boundsHalf[3];
+    float    coneAxis[3];       // average front face normal
+    float    coneCosine;        // cosine of the widest angle off coneAxis; 0 or less can't be backface culled
+    float    coneSine;
+};
+
+// One DrawIndexed()
+struct CPUTMeshClusterRange
+{
+    uint32_t indexStart;
+    uint32_t indexCount;
+};
+
+// Cluster a triangle list, reordering pIndices in place.  positions are three floats,
+// positionStride bytes apart, and front faces wind so that cross(b - a, c - a) points out of
+// them, as they do for Direct3D's default clockwise front faces in a left handed space.
+// Returns false, changing nothing, if the indices aren't a triangle list over the vertices.
+bool CPUTBuildMeshClusters(uint32_t *pIndices, size_t indexCount, const unsigned char *pPositions, uint32_t positionStride, uint32_t vertexCount,
+                           uint32_t maxTriangles, std::vector<CPUTMeshCluster> *pClusters);
+
+// The clusters at least partly inside all six planes (a, b, c, d), each with its normal
+// pointing out so that ax + by + cz + d > 0 is outside, and not facing away from pEye, as
+// merged index ranges.  Planes and eye are in the clusters' object space; pass a NULL pEye to
+// keep clusters facing away, e.g. when the material doesn't cull back faces.
+// Returns the number of indices in the ranges.
+size_t CPUTCullMeshClusters(const CPUTMeshCluster *pClusters, size_t clusterCount, const float pPlanes[6][4], const float *pEye,
+                            std::vector<CPUTMeshClusterRange> *pRanges);
+
+#endif // __CPUTMESHCLUSTERS_H__
@@ -30,6 +30,8 @@ CPUTMeshDX11::CPUTMeshDX11():
     mpVertexView(NULL),
     mpStagingVertexBuffer(NULL),
     mVertexBufferMappedType(CPUT_MAP_UNDEFINED),
+    mpShadowVertexBuffer(NULL),
+    mShadowVertexStride(0),
     mIndexBufferMappedType(CPUT_MAP_UNDEFINED),
     mIndexCount(0),
     mIndexBufferFormat(DXGI_FORMAT_UNKNOWN),
@@ -58,6 +60,7 @@ void CPUTMeshDX11::ClearAllObjects()
     SAFE_RELEASE(mpVertexBufferForSRVDX);
     SAFE_RELEASE(mpVertexBufferForSRV);
     SAFE_RELEASE(mpVertexView);
+    SAFE_RELEASE(mpShadowVertexBuffer);
     SAFE_RELEASE(mpInputLayout);
     SAFE_RELEASE(mpShadowInputLayout);
 
@@ -180,6 +183,45 @@ CPUTResult CPUTMeshDX11::CreateNativeResources(
     return result;
 }
 
+// The shadow pass's own vertex buffer, just the positions, and a layout for it alone
+//-----------------------------------------------------------------------------
+CPUTResult CPUTMeshDX11::CreateShadowPositions( CPUTBufferInfo *pPositionInfo, void *pPositions )
+{
+    ID3D11Device *pD3dDevice = CPUT_DX11::GetDevice();
+    SAFE_RELEASE(mpShadowVertexBuffer);
+
+    mShadowVertexStride = pPositionInfo->mElementSizeInBytes;
+
+    D3D11_BUFFER_DESC desc;
+    ZeroMemory( &desc, sizeof(desc) );
+    desc.Usage          = D3D11_USAGE_DEFAULT;
+    desc.ByteWidth      = mVertexCount * mShadowVertexStride;
+    desc.BindFlags      = D3D11_BIND_VERTEX_BUFFER;
+    desc.CPUAccessFlags = 0;
+
+    D3D11_SUBRESOURCE_DATA resourceData;
+    ZeroMemory( &resourceData, sizeof(resourceData) );
+    resourceData.pSysMem = pPositions;
+    HRESULT hr = pD3dDevice->CreateBuffer( &desc, &resourceData, &mpShadowVertexBuffer );
+    ASSERT( !FAILED(hr), _L("Failed creating shadow vertex buffer") );
+    if( FAILED(hr) )
+    {
+        // DrawShadow() falls back to the whole vertices
+        mpShadowVertexBuffer = NULL;
+        return CPUT_SUCCESS;
+    }
+    CPUTSetDebugName( mpShadowVertexBuffer, _L("Shadow vertex buffer") );
+
+    ZeroMemory( mpShadowLayoutDescription, sizeof(mpShadowLayoutDescription) );
+    mpShadowLayoutDescription[0].SemanticName      = pPositionInfo->mpSemanticName;
+    mpShadowLayoutDescription[0].SemanticIndex     = pPositionInfo->mSemanticIndex;
+    mpShadowLayoutDescription[0].Format            = ConvertToDirectXFormat(pPositionInfo->mElementType, pPositionInfo->mElementComponentCount);
+    mpShadowLayoutDescription[0].InputSlot         = 0;
+    mpShadowLayoutDescription[0].AlignedByteOffset = 0;
+    mpShadowLayoutDescription[0].InputSlotClass    = D3D11_INPUT_PER_VERTEX_DATA;
+    return CPUT_SUCCESS;
+}
+
 //-----------------------------------------------------------------------------
 void CPUTMeshDX11::Draw(CPUTRenderParameters &renderParams, CPUTModel *pModel, ID3D11InputLayout *pInputLayout )
 {
@@ -194,7 +236,50 @@ void CPUTMeshDX11::Draw(CPUTRenderParameters &renderParams, CPUTModel *pModel, I
 
     pContext->IASetInputLayout( pInputLayout );
 
-    pContext->DrawIndexed( mIndexCount, 0, 0 );
+    pContext->DrawIndexed( GetDrawIndexCount(), 0, 0 );
+}
+
+// Positions alone when the mesh has them, whole vertices otherwise
+//-----------------------------------------------------------------------------
+void CPUTMeshDX11::DrawShadow(CPUTRenderParameters &renderParams, CPUTModel *pModel)
+{
+    if( !mpShadowVertexBuffer )
+    {
+        Draw(renderParams, pModel, mpShadowInputLayout);
+        return;
+    }
+    if( !mIndexCount ) { return; }
+
+    ID3D11DeviceContext *pContext = ((CPUTRenderParametersDX*)&renderParams)->mpContext;
+    UINT offset = 0;
+
+    pContext->IASetPrimitiveTopology( mD3DMeshTopology );
+    pContext->IASetVertexBuffers(0, 1, &mpShadowVertexBuffer, &mShadowVertexStride, &offset);
+    pContext->IASetIndexBuffer(mpIndexBuffer, mIndexBufferFormat, 0);
+
+    pContext->IASetInputLayout( mpShadowInputLayout );
+
+    pContext->DrawIndexed( GetDrawIndexCount(), 0, 0 );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTMeshDX11::DrawRanges(CPUTRenderParameters &renderParams, CPUTModel *pModel, const CPUTMeshClusterRange *pRanges, UINT rangeCount)
+{
+    // Skip empty meshes, and meshes with nothing left to draw.
+    if( !mIndexCount || !rangeCount ) { return; }
+
+    ID3D11DeviceContext *pContext = ((CPUTRenderParametersDX*)&renderParams)->mpContext;
+
+    pContext->IASetPrimitiveTopology( mD3DMeshTopology );
+    pContext->IASetVertexBuffers(0, 1, &mpVertexBuffer, &mVertexStride, &mVertexBufferOffset);
+    pContext->IASetIndexBuffer(mpIndexBuffer, mIndexBufferFormat, 0);
+
+    pContext->IASetInputLayout( mpInputLayout );
+
+    for( UINT ii=0; ii<rangeCount; ii++ )
+    {
+        pContext->DrawIndexed( pRanges[ii].indexCount, pRanges[ii].indexStart, 0 );
+    }
 }
 
 // Sets the mesh topology, and converts it to it's DX format
@@ -246,6 +331,39 @@ DXGI_FORMAT CPUTMeshDX11::ConvertToDirectXFormat(CPUT_DATA_FORMAT_TYPE dataForma
         };
         return componentCountToFormat[componentCount-1];
     }
+    case CPUT_F16:
+    {
+        ASSERT( 3 != componentCount, _L("Invalid vertex element count.") );
+        const DXGI_FORMAT componentCountToFormat[4] = {
+            DXGI_FORMAT_R16_FLOAT,
+            DXGI_FORMAT_R16G16_FLOAT,
+            DXGI_FORMAT_UNKNOWN, // Count of 3 is invalid for 16-bit type
+            DXGI_FORMAT_R16G16B16A16_FLOAT
+        };
+        return componentCountToFormat[componentCount-1];
+    }
+    case CPUT_U16_NORM:
+    {
+        ASSERT( 3 != componentCount, _L("Invalid vertex element count.") );
+        const DXGI_FORMAT componentCountToFormat[4] = {
+            DXGI_FORMAT_R16_UNORM,
+            DXGI_FORMAT_R16G16_UNORM,
+            DXGI_FORMAT_UNKNOWN, // Count of 3 is invalid for 16-bit type
+            DXGI_FORMAT_R16G16B16A16_UNORM
+        };
+        return componentCountToFormat[componentCount-1];
+    }
+    case CPUT_I16_NORM:
+    {
+        ASSERT( 3 != componentCount, _L("Invalid vertex element count.") );
+        const DXGI_FORMAT componentCountToFormat[4] = {
+            DXGI_FORMAT_R16_SNORM,
+            DXGI_FORMAT_R16G16_SNORM,
+            DXGI_FORMAT_UNKNOWN, // Count of 3 is invalid for 16-bit type
+            DXGI_FORMAT_R16G16B16A16_SNORM
+        };
+        return componentCountToFormat[componentCount-1];
+    }
     default:
     {
         // todo: add all the other data types you want to support
@@ -274,7 +392,8 @@ void CPUTMeshDX11::BindVertexShaderLayout( CPUTMaterial *pMaterial, CPUTMaterial
     {
         CPUTVertexShaderDX11 *pVertexShader = ((CPUTMaterialDX11*)pShadowCastMaterial)->GetVertexShader();
         SAFE_RELEASE(mpShadowInputLayout);
-        CPUTInputLayoutCacheDX11::GetInputLayoutCache()->GetLayout(pDevice, mpLayoutDescription, pVertexShader, &mpShadowInputLayout);
+        D3D11_INPUT_ELEMENT_DESC *pLayoutDescription = mpShadowVertexBuffer ? mpShadowLayoutDescription : mpLayoutDescription;
+        CPUTInputLayoutCacheDX11::GetInputLayoutCache()->GetLayout(pDevice, pLayoutDescription, pVertexShader, &mpShadowInputLayout);
     }
 }
 
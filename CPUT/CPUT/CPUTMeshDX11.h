@@ -51,6 +51,10 @@ class CPUTMeshDX11 : public CPUTMesh
     CPUTBufferDX11           *mpVertexBufferForSRV;
 
 
+    ID3D11Buffer             *mpShadowVertexBuffer;   // positions alone, when the mesh has them
+    UINT                      mShadowVertexStride;
+    D3D11_INPUT_ELEMENT_DESC  mpShadowLayoutDescription[2];
+
     UINT                      mIndexCount;
     DXGI_FORMAT               mIndexBufferFormat;
     ID3D11Buffer             *mpIndexBuffer;
@@ -67,18 +71,23 @@ public:
     ID3D11Buffer             *GetVertexBuffer() { return mpVertexBuffer; }
     void                      SetMeshTopology(const eCPUT_MESH_TOPOLOGY eDrawTopology);
     CPUTResult                CreateNativeResources( CPUTModel *pModel, UINT meshIdx, int vertexDataInfoArraySize, CPUTBufferInfo *pVertexInfo, void *pVertexData, CPUTBufferInfo *pIndexInfo, void *pIndex );
+    CPUTResult                CreateShadowPositions( CPUTBufferInfo *pPositionInfo, void *pPositions );
     void                      BindVertexShaderLayout(CPUTMaterial *pMaterial, CPUTMaterial *pShadowCastMaterial);
     void                      Draw(CPUTRenderParameters &renderParams, CPUTModel *pModel)       { Draw(renderParams, pModel, mpInputLayout);}
-    void                      DrawShadow(CPUTRenderParameters &renderParams, CPUTModel *pModel) { Draw(renderParams, pModel, mpShadowInputLayout);}
+    void                      DrawShadow(CPUTRenderParameters &renderParams, CPUTModel *pModel);
     void                      Draw(CPUTRenderParameters &renderParams, CPUTModel *pModel, ID3D11InputLayout *pLayout);
+    // One DrawIndexed() per range, e.g. the visible clusters from CPUTCullMeshClusters()
+    void                      DrawRanges(CPUTRenderParameters &renderParams, CPUTModel *pModel, const CPUTMeshClusterRange *pRanges, UINT rangeCount);
 
     D3D11_MAPPED_SUBRESOURCE  MapVertices(   CPUTRenderParameters &params, eCPUTMapType type, bool wait=true );
     D3D11_MAPPED_SUBRESOURCE  MapIndices(    CPUTRenderParameters &params, eCPUTMapType type, bool wait=true );
     void                      UnmapVertices( CPUTRenderParameters &params );
     void                      UnmapIndices(  CPUTRenderParameters &params );
-    UINT                      GetTriangleCount() { return mIndexCount/3; }
+    UINT                      GetTriangleCount() { return GetDrawIndexCount()/3; }
     UINT                      GetVertexCount() { return mVertexCount; }
     UINT                      GetIndexCount()  { return mIndexCount; }
+    // The full mesh's indices, without the levels of detail after them
+    UINT                      GetDrawIndexCount() { return mLods.empty() ? mIndexCount : mLods[0].indexCount; }
 
 protected:
     // Mapping vertex and index buffers is very similar.  This internal function does both
@@ -0,0 +1,370 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTMeshOptimizer.h"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+// FIFO post-transform cache.  Each miss stamps the vertex with the running miss count; a vertex
+// is cached while fewer than cacheSize misses have happened since its own.
+//-----------------------------------------------------------------------------
+class VertexCache
+{
+public:
+    VertexCache(uint32_t vertexCount, uint32_t cacheSize) : mStamps(vertexCount, 0), mCacheSize(cacheSize), mTime(cacheSize) {}
+
+    // Returns true on a miss
+    bool Use(uint32_t vertex)
+    {
+        if(mTime - mStamps[vertex] < mCacheSize)
+        {
+            return false;
+        }
+        mStamps[vertex] = ++mTime;
+        return true;
+    }
+    void Flush() { mTime += mCacheSize; }
+
+private:
+    std::vector<uint64_t> mStamps;
+    uint64_t              mCacheSize;
+    uint64_t              mTime;
+};
+
+//-----------------------------------------------------------------------------
+void CPUTAnalyzeVertexCache(const uint32_t *pIndices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize, CPUTVertexCacheStats *pStats)
+{
+    VertexCache cache(vertexCount, cacheSize);
+    std::vector<bool> used(vertexCount, false);
+    uint64_t misses = 0, usedCount = 0;
+    for(size_t ii=0; ii<indexCount; ii++)
+    {
+        // An index past the vertices can only be a miss
+        uint32_t vertex = pIndices[ii];
+        if(vertex >= vertexCount)
+        {
+            misses++;
+            continue;
+        }
+        misses += cache.Use(vertex) ? 1 : 0;
+        if(!used[vertex])
+        {
+            used[vertex] = true;
+            usedCount++;
+        }
+    }
+    pStats->cacheSize     = cacheSize;
+    pStats->triangleCount = indexCount / 3;
+    pStats->vertexCount   = usedCount;
+    pStats->missCount     = misses;
+    pStats->acmr          = pStats->triangleCount ? (double)misses / pStats->triangleCount : 0.0;
+    pStats->atvr          = usedCount ? (double)misses / usedCount : 0.0;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTOptimizeVertexCache(uint32_t *pDst, const uint32_t *pIndices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize, std::vector<uint32_t> *pClusters)
+{
+    size_t triangleCount = indexCount / 3;
+    pClusters->clear();
+
+    // The triangles around each vertex, and how many of them are still to be emitted
+    std::vector<uint32_t> liveCount(vertexCount, 0);
+    for(size_t ii=0; ii<triangleCount*3; ii++)
+    {
+        liveCount[pIndices[ii]]++;
+    }
+    std::vector<uint32_t> firstTriangle(vertexCount + 1, 0);
+    for(uint32_t ii=0; ii<vertexCount; ii++)
+    {
+        firstTriangle[ii+1] = firstTriangle[ii] + liveCount[ii];
+    }
+    std::vector<uint32_t> triangles(triangleCount*3);
+    std::vector<uint32_t> fill(firstTriangle.begin(), firstTriangle.end() - 1);
+    for(size_t ii=0; ii<triangleCount*3; ii++)
+    {
+        triangles[fill[pIndices[ii]]++] = (uint32_t)(ii / 3);
+    }
+
+    // Tipsify's cache model: a vertex is cached while fewer than cacheSize others were
+    // transformed after it
+    std::vector<int64_t>  cacheTime(vertexCount, 0);
+    int64_t               time = (int64_t)cacheSize + 1;
+    std::vector<bool>     emitted(triangleCount, false);
+    std::vector<uint32_t> deadEnds;
+    std::vector<uint32_t> candidates;
+    uint32_t              cursor = 0;
+    size_t                out = 0;
+    bool                  newCluster = true;
+
+    while(cursor < vertexCount && !liveCount[cursor])
+    {
+        cursor++;
+    }
+    int64_t fan = cursor < vertexCount ? (int64_t)cursor : -1;
+    while(fan >= 0)
+    {
+        // Emit every triangle left around the fanning vertex
+        candidates.clear();
+        for(uint32_t tt=firstTriangle[(size_t)fan]; tt<firstTriangle[(size_t)fan+1]; tt++)
+        {
+            uint32_t triangle = triangles[tt];
+            if(emitted[triangle])
+            {
+                continue;
+            }
+            emitted[triangle] = true;
+            if(newCluster)
+            {
+                pClusters->push_back((uint32_t)(out / 3));
+                newCluster = false;
+            }
+            for(int kk=0; kk<3; kk++)
+            {
+                uint32_t vertex = pIndices[triangle*3 + kk];
+                pDst[out++] = vertex;
+                deadEnds.push_back(vertex);
+                candidates.push_back(vertex);
+                liveCount[vertex]--;
+                if(time - cacheTime[vertex] > (int64_t)cacheSize)
+                {
+                    cacheTime[vertex] = time++;
+                }
+            }
+        }
+
+        // Fan next around the oldest of those vertices that will still be cached once all of
+        // its triangles are emitted, or failing that any with triangles left
+        int64_t next = -1, bestPriority = -1;
+        for(size_t ii=0; ii<candidates.size(); ii++)
+        {
+            uint32_t vertex = candidates[ii];
+            if(!liveCount[vertex])
+            {
+                continue;
+            }
+            int64_t priority = 0;
+            if(time - cacheTime[vertex] + 2 * (int64_t)liveCount[vertex] <= (int64_t)cacheSize)
+            {
+                priority = time - cacheTime[vertex];
+            }
+            if(priority > bestPriority)
+            {
+                bestPriority = priority;
+                next = vertex;
+            }
+        }
+
+        // Dead end: back up to a recent vertex with triangles left, or skip ahead
+        if(next < 0)
+        {
+            newCluster = true;
+            while(!deadEnds.empty() && next < 0)
+            {
+                uint32_t vertex = deadEnds.back();
+                deadEnds.pop_back();
+                next = liveCount[vertex] ? (int64_t)vertex : -1;
+            }
+            while(next < 0 && cursor < vertexCount)
+            {
+                next = liveCount[cursor] ? (int64_t)cursor : -1;
+                cursor += next < 0 ? 1 : 0;
+            }
+        }
+        fan = next;
+    }
+}
+
+//-----------------------------------------------------------------------------
+static void ReadPosition(const unsigned char *pPositions, uint32_t positionStride, uint32_t vertex, double *pPosition)
+{
+    float position[3];
+    memcpy(position, pPositions + (size_t)vertex * positionStride, sizeof(position));
+    pPosition[0] = position[0];
+    pPosition[1] = position[1];
+    pPosition[2] = position[2];
+}
+
+struct ClusterOrder
+{
+    uint32_t first, count;
+    double   key;
+
+    bool operator<(const ClusterOrder &other) const { return key > other.key; }
+};
+
+//-----------------------------------------------------------------------------
+void CPUTOptimizeOverdraw(uint32_t *pDst, const uint32_t *pIndices, size_t indexCount, const unsigned char *pPositions, uint32_t positionStride,
+                          const std::vector<uint32_t> &clusters, uint32_t vertexCount, uint32_t cacheSize, float threshold)
+{
+    uint32_t triangleCount = (uint32_t)(indexCount / 3);
+
+    // Split each cluster wherever the triangles so far, starting from an empty cache, have
+    // an ACMR within threshold of the whole cluster's: the split costs little locality
+    std::vector<uint32_t> splits;
+    VertexCache cache(vertexCount, cacheSize);
+    for(size_t ii=0; ii<clusters.size(); ii++)
+    {
+        uint32_t begin = clusters[ii];
+        uint32_t end   = ii + 1 < clusters.size() ? clusters[ii+1] : triangleCount;
+        cache.Flush();
+        uint32_t clusterMisses = 0;
+        for(uint32_t tt=begin*3; tt<end*3; tt++)
+        {
+            clusterMisses += cache.Use(pIndices[tt]) ? 1 : 0;
+        }
+        double limit = threshold * (double)clusterMisses / (end - begin);
+
+        cache.Flush();
+        splits.push_back(begin);
+        uint32_t start = begin, misses = 0;
+        for(uint32_t tt=begin; tt<end; tt++)
+        {
+            for(int kk=0; kk<3; kk++)
+            {
+                misses += cache.Use(pIndices[tt*3 + kk]) ? 1 : 0;
+            }
+            if(tt + 1 < end && (double)misses / (tt + 1 - start) <= limit)
+            {
+                splits.push_back(tt + 1);
+                start  = tt + 1;
+                misses = 0;
+                cache.Flush();
+            }
+        }
+    }
+
+    // Area weighted centroid and normal of each cluster, and the centroid of the whole mesh
+    std::vector<ClusterOrder> order(splits.size());
+    std::vector<double> centroids(splits.size() * 3, 0.0), normals(splits.size() * 3, 0.0), areas(splits.size(), 0.0);
+    double meshCentroid[3] = { 0.0, 0.0, 0.0 }, meshArea = 0.0;
+    for(size_t ii=0; ii<splits.size(); ii++)
+    {
+        order[ii].first = splits[ii];
+        order[ii].count = (ii + 1 < splits.size() ? splits[ii+1] : triangleCount) - splits[ii];
+        for(uint32_t tt=order[ii].first; tt<order[ii].first+order[ii].count; tt++)
+        {
+            double p0[3], p1[3], p2[3];
+            ReadPosition(pPositions, positionStride, pIndices[tt*3+0], p0);
+            ReadPosition(pPositions, positionStride, pIndices[tt*3+1], p1);
+            ReadPosition(pPositions, positionStride, pIndices[tt*3+2], p2);
+            double e1[3] = { p1[0]-p0[0], p1[1]-p0[1], p1[2]-p0[2] };
+            double e2[3] = { p2[0]-p0[0], p2[1]-p0[1], p2[2]-p0[2] };
+            double normal[3] = { e1[1]*e2[2] - e1[2]*e2[1], e1[2]*e2[0] - e1[0]*e2[2], e1[0]*e2[1] - e1[1]*e2[0] };
+            double area = sqrt(normal[0]*normal[0] + normal[1]*normal[1] + normal[2]*normal[2]);
+            for(int kk=0; kk<3; kk++)
+            {
+                double center = (p0[kk] + p1[kk] + p2[kk]) / 3.0;
+                centroids[ii*3+kk] += center * area;
+                normals[ii*3+kk]   += normal[kk];
+                meshCentroid[kk]   += center * area;
+            }
+            areas[ii] += area;
+            meshArea  += area;
+        }
+    }
+    for(int kk=0; kk<3; kk++)
+    {
+        meshCentroid[kk] = meshArea > 0.0 ? meshCentroid[kk] / meshArea : 0.0;
+    }
+
+    // Draw the clusters that face away from the middle first
+    for(size_t ii=0; ii<order.size(); ii++)
+    {
+        double *pNormal = &normals[ii*3];
+        double length = sqrt(pNormal[0]*pNormal[0] + pNormal[1]*pNormal[1] + pNormal[2]*pNormal[2]);
+        order[ii].key = 0.0;
+        if(areas[ii] > 0.0 && length > 0.0)
+        {
+            for(int kk=0; kk<3; kk++)
+            {
+                order[ii].key += (centroids[ii*3+kk] / areas[ii] - meshCentroid[kk]) * pNormal[kk] / length;
+            }
+        }
+    }
+    std::stable_sort(order.begin(), order.end());
+
+    size_t out = 0;
+    for(size_t ii=0; ii<order.size(); ii++)
+    {
+        memcpy(pDst + out, pIndices + (size_t)order[ii].first * 3, (size_t)order[ii].count * 3 * sizeof(uint32_t));
+        out += (size_t)order[ii].count * 3;
+    }
+}
+
+//-----------------------------------------------------------------------------
+uint32_t CPUTOptimizeVertexFetch(unsigned char *pDstVertices, uint32_t *pIndices, size_t indexCount, const unsigned char *pVertices, uint32_t vertexCount, uint32_t vertexStride)
+{
+    std::vector<uint32_t> remap(vertexCount, UINT32_MAX);
+    uint32_t next = 0;
+    for(size_t ii=0; ii<indexCount; ii++)
+    {
+        uint32_t vertex = pIndices[ii];
+        if(remap[vertex] == UINT32_MAX)
+        {
+            remap[vertex] = next;
+            memcpy(pDstVertices + (size_t)next * vertexStride, pVertices + (size_t)vertex * vertexStride, vertexStride);
+            next++;
+        }
+        pIndices[ii] = remap[vertex];
+    }
+    return next;
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTOptimizeMesh(std::vector<uint32_t> *pIndices, std::vector<unsigned char> *pVertices, uint32_t vertexStride, int positionOffset,
+                      const CPUTMeshOptimizerOptions &options)
+{
+    size_t indexCount = pIndices->size();
+    if(!vertexStride || pVertices->size() % vertexStride || pVertices->size() / vertexStride > UINT32_MAX ||
+       indexCount % 3 || !options.cacheSize)
+    {
+        return false;
+    }
+    uint32_t vertexCount = (uint32_t)(pVertices->size() / vertexStride);
+    for(size_t ii=0; ii<indexCount; ii++)
+    {
+        if((*pIndices)[ii] >= vertexCount)
+        {
+            return false;
+        }
+    }
+    if(!indexCount)
+    {
+        return true;
+    }
+
+    std::vector<uint32_t> reordered(indexCount), clusters;
+    CPUTOptimizeVertexCache(&reordered[0], &(*pIndices)[0], indexCount, vertexCount, options.cacheSize, &clusters);
+
+    if(options.optimizeOverdraw && positionOffset >= 0 && (uint32_t)positionOffset + 3 * sizeof(float) <= vertexStride)
+    {
+        CPUTOptimizeOverdraw(&(*pIndices)[0], &reordered[0], indexCount, &(*pVertices)[positionOffset], vertexStride,
+                             clusters, vertexCount, options.cacheSize, options.overdrawThreshold);
+    }
+    else
+    {
+        pIndices->swap(reordered);
+    }
+
+    if(options.optimizeVertexFetch)
+    {
+        std::vector<unsigned char> vertices(pVertices->size());
+        uint32_t usedCount = CPUTOptimizeVertexFetch(&vertices[0], &(*pIndices)[0], indexCount, &(*pVertices)[0], vertexCount, vertexStride);
+        vertices.resize((size_t)usedCount * vertexStride);
+        pVertices->swap(vertices);
+    }
+    return true;
+}
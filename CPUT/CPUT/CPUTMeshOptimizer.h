@@ -0,0 +1,81 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTMESHOPTIMIZER_H__
+#define __CPUTMESHOPTIMIZER_H__
+
+// Reorders indexed triangle lists for the GPU, in three passes:
+//
+//   vertex cache   Tipsify (Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex
+//                  Locality and Reduced Overdraw", 2007): fans around recently used vertices so
+//                  most of them are still in the post-transform cache
+//   overdraw       splits that order into clusters that each keep the cache hit rate, then
+//                  draws the clusters facing out from the middle of the mesh first, so they
+//                  tend to occlude the rest
+//   vertex fetch   renumbers the vertices in the order the indices first use them, so the
+//                  vertex buffer is read front to back, and drops the ones no triangle uses
+//
+// Only depends on the C++ standard library, so the cooking tool and the loader share it.
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#define CPUT_MESH_OPTIMIZER_CACHE_SIZE          16
+#define CPUT_MESH_OPTIMIZER_OVERDRAW_THRESHOLD  1.05f
+
+struct CPUTVertexCacheStats
+{
+    uint32_t cacheSize;
+    uint64_t triangleCount;
+    uint64_t vertexCount;   // distinct vertices the triangles use
+    uint64_t missCount;     // vertices transformed, with a FIFO cache of cacheSize
+    double   acmr;          // misses per triangle: 3 at worst, around 0.5 for a large regular mesh
+    double   atvr;          // misses per vertex used: 1 is the best possible
+};
+
+struct CPUTMeshOptimizerOptions
+{
+    uint32_t cacheSize;
+    float    overdrawThreshold;   // how much worse than its cluster's ACMR a split may make it
+    bool     optimizeOverdraw;
+    bool     optimizeVertexFetch;
+
+    CPUTMeshOptimizerOptions() :
+        cacheSize(CPUT_MESH_OPTIMIZER_CACHE_SIZE),
+        overdrawThreshold(CPUT_MESH_OPTIMIZER_OVERDRAW_THRESHOLD),
+        optimizeOverdraw(true),
+        optimizeVertexFetch(true) {}
+};
+
+// Simulate a FIFO post-transform cache of cacheSize vertices over a triangle list.  Safe on any indices.
+void CPUTAnalyzeVertexCache(const uint32_t *pIndices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize, CPUTVertexCacheStats *pStats);
+
+// The passes on their own.  Indices must be below vertexCount, and pDst can't be pIndices.
+// CPUTOptimizeVertexCache() returns the first triangle of each cluster it ends up making (a new
+// one starts every time it runs out of neighbours to fan around) for CPUTOptimizeOverdraw().
+// positions are three floats, positionStride bytes apart.  CPUTOptimizeVertexFetch() renumbers
+// the indices in place, writes the vertices they use to pDstVertices and returns their count.
+void     CPUTOptimizeVertexCache(uint32_t *pDst, const uint32_t *pIndices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize, std::vector<uint32_t> *pClusters);
+void     CPUTOptimizeOverdraw(uint32_t *pDst, const uint32_t *pIndices, size_t indexCount, const unsigned char *pPositions, uint32_t positionStride,
+                              const std::vector<uint32_t> &clusters, uint32_t vertexCount, uint32_t cacheSize, float threshold);
+uint32_t CPUTOptimizeVertexFetch(unsigned char *pDstVertices, uint32_t *pIndices, size_t indexCount, const unsigned char *pVertices, uint32_t vertexCount, uint32_t vertexStride);
+
+// Every pass the options ask for.  The position is three floats positionOffset bytes into each
+// vertex; pass -1 if there isn't one and the overdraw pass is skipped.  Returns false, changing
+// nothing, if the indices aren't a triangle list over the vertices.
+bool CPUTOptimizeMesh(std::vector<uint32_t> *pIndices, std::vector<unsigned char> *pVertices, uint32_t vertexStride, int positionOffset,
+                      const CPUTMeshOptimizerOptions &options);
+
+#endif // __CPUTMESHOPTIMIZER_H__
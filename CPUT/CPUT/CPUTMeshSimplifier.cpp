@@ -0,0 +1,751 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTMeshSimplifier.h"
+#include "CPUTMeshOptimizer.h"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+// Border planes count this much more than faces, so open edges hold their shape
+#define BORDER_WEIGHT 10.0
+
+// A collapse may turn a surviving triangle by up to about 75 degrees (cos^2 = 1/16)
+#define FLIP_COSINE_SQUARED 0.0625
+
+enum VertexKind
+{
+    VERTEX_MANIFOLD,    // may collapse onto any neighbour that isn't a seam
+    VERTEX_BORDER,      // on one open boundary: may collapse along it onto its neighbours there
+    VERTEX_LOCKED,      // stays put; may still be collapsed onto unless it's a seam
+};
+
+// Symmetric 4x4 error quadric of squared distances to planes, weighted by area
+struct Quadric
+{
+    double a00, a11, a22, a10, a20, a21;
+    double b0, b1, b2;
+    double c;
+    double weight;
+};
+
+//-----------------------------------------------------------------------------
+static void ReadPosition(const unsigned char *pPositions, uint32_t positionStride, uint32_t vertex, double pPosition[3])
+{
+    float position[3];
+    memcpy(position, pPositions + (size_t)vertex * positionStride, sizeof(position));
+    pPosition[0] = position[0];
+    pPosition[1] = position[1];
+    pPosition[2] = position[2];
+}
+
+//-----------------------------------------------------------------------------
+static void AddPlane(Quadric *pQuadric, const double normal[3], double distance, double weight)
+{
+    pQuadric->a00 += weight * normal[0] * normal[0];
+    pQuadric->a11 += weight * normal[1] * normal[1];
+    pQuadric->a22 += weight * normal[2] * normal[2];
+    pQuadric->a10 += weight * normal[1] * normal[0];
+    pQuadric->a20 += weight * normal[2] * normal[0];
+    pQuadric->a21 += weight * normal[2] * normal[1];
+    pQuadric->b0  += weight * normal[0] * distance;
+    pQuadric->b1  += weight * normal[1] * distance;
+    pQuadric->b2  += weight * normal[2] * distance;
+    pQuadric->c   += weight * distance * distance;
+    pQuadric->weight += weight;
+}
+
+//-----------------------------------------------------------------------------
+static void AddQuadric(Quadric *pQuadric, const Quadric &other)
+{
+    pQuadric->a00 += other.a00; pQuadric->a11 += other.a11; pQuadric->a22 += other.a22;
+    pQuadric->a10 += other.a10; pQuadric->a20 += other.a20; pQuadric->a21 += other.a21;
+    pQuadric->b0  += other.b0;  pQuadric->b1  += other.b1;  pQuadric->b2  += other.b2;
+    pQuadric->c   += other.c;
+    pQuadric->weight += other.weight;
+}
+
+// Weighted sum of squared distances from p to the quadric's planes
+//-----------------------------------------------------------------------------
+static double QuadricError(const Quadric &quadric, const double p[3])
+{
+    double rx = quadric.b0 + quadric.a00 * p[0] + quadric.a10 * p[1] + quadric.a20 * p[2];
+    double ry = quadric.b1 + quadric.a10 * p[0] + quadric.a11 * p[1] + quadric.a21 * p[2];
+    double rz = quadric.b2 + quadric.a20 * p[0] + quadric.a21 * p[1] + quadric.a22 * p[2];
+    double error = rx * p[0] + ry * p[1] + rz * p[2] + quadric.b0 * p[0] + quadric.b1 * p[1] + quadric.b2 * p[2] + quadric.c;
+    return error > 0.0 ? error : 0.0;
+}
+
+//-----------------------------------------------------------------------------
+static void Cross(const double a[3], const double b[3], double pResult[3])
+{
+    pResult[0] = a[1]*b[2] - a[2]*b[1];
+    pResult[1] = a[2]*b[0] - a[0]*b[2];
+    pResult[2] = a[0]*b[1] - a[1]*b[0];
+}
+
+//-----------------------------------------------------------------------------
+static double Dot(const double a[3], const double b[3])
+{
+    return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+}
+
+// The first used vertex at each used vertex's position; unused ones stay themselves.
+// -0 and 0 are the same place.
+//-----------------------------------------------------------------------------
+static void WeldPositions(const unsigned char *pPositions, uint32_t positionStride, const std::vector<uint8_t> &used, std::vector<uint32_t> *pWelded)
+{
+    struct Key
+    {
+        float    position[3];
+        uint32_t vertex;
+        bool operator<(const Key &other) const
+        {
+            int order = memcmp(position, other.position, sizeof(position));
+            return order != 0 ? order < 0 : vertex < other.vertex;
+        }
+    };
+    std::vector<Key> keys;
+    pWelded->resize(used.size());
+    for(uint32_t ii=0; ii<(uint32_t)used.size(); ii++)
+    {
+        (*pWelded)[ii] = ii;
+        if(used[ii])
+        {
+            Key key;
+            memcpy(key.position, pPositions + (size_t)ii * positionStride, sizeof(key.position));
+            for(int cc=0; cc<3; cc++)
+            {
+                key.position[cc] += 0.0f;
+            }
+            key.vertex = ii;
+            keys.push_back(key);
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+
+    for(size_t ii=0; ii<keys.size(); )
+    {
+        uint32_t first = keys[ii].vertex;
+        size_t jj = ii;
+        while(jj < keys.size() && memcmp(keys[jj].position, keys[ii].position, sizeof(keys[ii].position)) == 0)
+        {
+            (*pWelded)[keys[jj].vertex] = first;
+            jj++;
+        }
+        ii = jj;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTFindMeshWedges(const unsigned char *pVertices, uint32_t vertexStride, uint32_t vertexCount,
+                        const CPUTMeshWedgeAttribute *pAttributes, uint32_t attributeCount, std::vector<uint32_t> *pWedges)
+{
+    struct Order
+    {
+        const unsigned char          *pVertices;
+        uint32_t                      vertexStride;
+        const CPUTMeshWedgeAttribute *pAttributes;
+        uint32_t                      attributeCount;
+
+        int Compare(uint32_t a, uint32_t b) const
+        {
+            for(uint32_t ii=0; ii<attributeCount; ii++)
+            {
+                int order = memcmp(pVertices + (size_t)a * vertexStride + pAttributes[ii].offset,
+                                   pVertices + (size_t)b * vertexStride + pAttributes[ii].offset, pAttributes[ii].size);
+                if(order != 0)
+                {
+                    return order;
+                }
+            }
+            return 0;
+        }
+        bool operator()(uint32_t a, uint32_t b) const
+        {
+            int order = Compare(a, b);
+            return order != 0 ? order < 0 : a < b;
+        }
+    };
+    Order order = { pVertices, vertexStride, pAttributes, attributeCount };
+
+    std::vector<uint32_t> sorted(vertexCount);
+    for(uint32_t ii=0; ii<vertexCount; ii++)
+    {
+        sorted[ii] = ii;
+    }
+    std::sort(sorted.begin(), sorted.end(), order);
+
+    pWedges->resize(vertexCount);
+    for(uint32_t ii=0; ii<vertexCount; ii++)
+    {
+        (*pWedges)[sorted[ii]] = (ii > 0 && order.Compare(sorted[ii - 1], sorted[ii]) == 0) ? (*pWedges)[sorted[ii - 1]] : sorted[ii];
+    }
+}
+
+// Simplification state for one call.  Vertices are identified by their welded position,
+// which is always a vertex number, so collapsing u onto v maps one vertex number to another
+// as long as neither is a seam.
+class CPUTMeshSimplifier
+{
+public:
+    CPUTMeshSimplifier(const unsigned char *pPositions, uint32_t positionStride, uint32_t vertexCount) :
+        mpPositions(pPositions),
+        mPositionStride(positionStride),
+        mVertexCount(vertexCount) {}
+
+    size_t Simplify(uint32_t *pDst, const uint32_t *pIndices, size_t indexCount, const uint32_t *pWedges, size_t targetIndexCount, float *pError);
+
+private:
+    void   Classify(const std::vector<uint32_t> &indices);
+    void   ComputeQuadrics(const std::vector<uint32_t> &indices);
+    void   BuildAdjacency(const std::vector<uint32_t> &indices);
+    bool   CanCollapse(uint32_t from, uint32_t to) const;
+    bool   KeepsTopology(uint32_t from, uint32_t to, const std::vector<uint32_t> &indices, uint32_t *pSharedTriangles);
+    bool   KeepsOrientation(uint32_t from, uint32_t to, const std::vector<uint32_t> &indices) const;
+    size_t RunPass(std::vector<uint32_t> *pIndices, size_t targetTriangleCount, double *pMaxError);
+
+    const unsigned char  *mpPositions;
+    uint32_t              mPositionStride;
+    uint32_t              mVertexCount;
+
+    std::vector<uint32_t> mWelded;          // vertex -> first vertex at its position
+    std::vector<uint32_t> mUses;            // vertices at each welded position that triangles use
+    std::vector<uint8_t>  mKind;
+    std::vector<uint32_t> mBorderNext;      // along the open boundary, for VERTEX_BORDER
+    std::vector<uint32_t> mBorderPrev;
+    std::vector<Quadric>  mQuadrics;
+
+    std::vector<uint32_t> mTriangleOffsets; // welded vertex -> its triangles, rebuilt each pass
+    std::vector<uint32_t> mTriangles;
+    std::vector<uint32_t> mMarks;
+    uint32_t              mMark;
+};
+
+//-----------------------------------------------------------------------------
+void CPUTMeshSimplifier::Classify(const std::vector<uint32_t> &indices)
+{
+    mUses.assign(mVertexCount, 0);
+    std::vector<uint8_t> used(mVertexCount, 0);
+    for(size_t ii=0; ii<indices.size(); ii++)
+    {
+        if(!used[indices[ii]])
+        {
+            used[indices[ii]] = 1;
+            mUses[mWelded[indices[ii]]]++;
+        }
+    }
+
+    // Directed edges between welded vertices.  An edge without its reverse is on an open
+    // boundary; one that appears twice the same way is non-manifold.
+    std::vector<uint64_t> edges;
+    edges.reserve(indices.size());
+    for(size_t ii=0; ii<indices.size(); ii+=3)
+    {
+        for(int ee=0; ee<3; ee++)
+        {
+            uint32_t from = mWelded[indices[ii + ee]];
+            uint32_t to   = mWelded[indices[ii + (ee + 1) % 3]];
+            edges.push_back((uint64_t)from << 32 | to);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    mKind.assign(mVertexCount, VERTEX_MANIFOLD);
+    mBorderNext.assign(mVertexCount, ~0u);
+    mBorderPrev.assign(mVertexCount, ~0u);
+    std::vector<uint8_t> borderOut(mVertexCount, 0), borderIn(mVertexCount, 0);
+    for(size_t ii=0; ii<edges.size(); ii++)
+    {
+        uint32_t from = (uint32_t)(edges[ii] >> 32);
+        uint32_t to   = (uint32_t)edges[ii];
+        if(from == to)
+        {
+            continue;
+        }
+        if((ii > 0 && edges[ii - 1] == edges[ii]) || (ii + 1 < edges.size() && edges[ii + 1] == edges[ii]))
+        {
+            mKind[from] = VERTEX_LOCKED;
+            mKind[to]   = VERTEX_LOCKED;
+            continue;
+        }
+        if(!std::binary_search(edges.begin(), edges.end(), (uint64_t)to << 32 | from))
+        {
+            borderOut[from]++;
+            borderIn[to]++;
+            mBorderNext[from] = to;
+            mBorderPrev[to]   = from;
+        }
+    }
+    for(uint32_t ii=0; ii<mVertexCount; ii++)
+    {
+        if(mUses[ii] > 1)
+        {
+            mKind[ii] = VERTEX_LOCKED;
+        }
+        else if(mKind[ii] == VERTEX_MANIFOLD && (borderOut[ii] || borderIn[ii]))
+        {
+            mKind[ii] = borderOut[ii] == 1 && borderIn[ii] == 1 ? VERTEX_BORDER : VERTEX_LOCKED;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTMeshSimplifier::ComputeQuadrics(const std::vector<uint32_t> &indices)
+{
+    Quadric zero;
+    memset(&zero, 0, sizeof(zero));
+    mQuadrics.assign(mVertexCount, zero);
+    for(size_t ii=0; ii<indices.size(); ii+=3)
+    {
+        uint32_t corner[3];
+        double   position[3][3];
+        for(int vv=0; vv<3; vv++)
+        {
+            corner[vv] = mWelded[indices[ii + vv]];
+            ReadPosition(mpPositions, mPositionStride, corner[vv], position[vv]);
+        }
+        double edge0[3], edge1[3], normal[3];
+        for(int cc=0; cc<3; cc++)
+        {
+            edge0[cc] = position[1][cc] - position[0][cc];
+            edge1[cc] = position[2][cc] - position[0][cc];
+        }
+        Cross(edge0, edge1, normal);
+        double length = sqrt(Dot(normal, normal));
+        if(length == 0.0)
+        {
+            continue;
+        }
+        for(int cc=0; cc<3; cc++)
+        {
+            normal[cc] /= length;
+        }
+
+        // Each corner gets the triangle's plane, weighted by its area
+        double distance = -Dot(normal, position[0]);
+        for(int vv=0; vv<3; vv++)
+        {
+            AddPlane(&mQuadrics[corner[vv]], normal, distance, length * 0.5);
+        }
+
+        // Open edges also get a plane through them, at right angles to the triangle
+        for(int ee=0; ee<3; ee++)
+        {
+            uint32_t from = corner[ee];
+            uint32_t to   = corner[(ee + 1) % 3];
+            if(mBorderNext[from] != to)
+            {
+                continue;
+            }
+            double edge[3], edgeNormal[3];
+            for(int cc=0; cc<3; cc++)
+            {
+                edge[cc] = position[(ee + 1) % 3][cc] - position[ee][cc];
+            }
+            Cross(edge, normal, edgeNormal);
+            double edgeLength = sqrt(Dot(edgeNormal, edgeNormal));
+            if(edgeLength == 0.0)
+            {
+                continue;
+            }
+            for(int cc=0; cc<3; cc++)
+            {
+                edgeNormal[cc] /= edgeLength;
+            }
+            double edgeDistance = -Dot(edgeNormal, position[ee]);
+            AddPlane(&mQuadrics[from], edgeNormal, edgeDistance, edgeLength * edgeLength * BORDER_WEIGHT);
+            AddPlane(&mQuadrics[to],   edgeNormal, edgeDistance, edgeLength * edgeLength * BORDER_WEIGHT);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTMeshSimplifier::BuildAdjacency(const std::vector<uint32_t> &indices)
+{
+    mTriangleOffsets.assign(mVertexCount + 1, 0);
+    for(size_t ii=0; ii<indices.size(); ii++)
+    {
+        mTriangleOffsets[mWelded[indices[ii]] + 1]++;
+    }
+    for(uint32_t ii=0; ii<mVertexCount; ii++)
+    {
+        mTriangleOffsets[ii + 1] += mTriangleOffsets[ii];
+    }
+    mTriangles.resize(indices.size());
+    std::vector<uint32_t> fill(mTriangleOffsets.begin(), mTriangleOffsets.end() - 1);
+    for(size_t ii=0; ii<indices.size(); ii++)
+    {
+        mTriangles[fill[mWelded[indices[ii]]]++] = (uint32_t)(ii / 3);
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTMeshSimplifier::CanCollapse(uint32_t from, uint32_t to) const
+{
+    if(mUses[to] > 1)
+    {
+        return false;
+    }
+    switch(mKind[from])
+    {
+    case VERTEX_MANIFOLD:
+        return true;
+    case VERTEX_BORDER:
+        return (mKind[to] != VERTEX_MANIFOLD) && (mBorderNext[from] == to || mBorderPrev[from] == to);
+    default:
+        return false;
+    }
+}
+
+// The link condition: the only neighbours from and to share are the far corners of the
+// triangles on the edge between them, or the collapse would pinch the surface.
+//-----------------------------------------------------------------------------
+bool CPUTMeshSimplifier::KeepsTopology(uint32_t from, uint32_t to, const std::vector<uint32_t> &indices, uint32_t *pSharedTriangles)
+{
+    uint32_t toMark = ++mMark;
+    for(uint32_t ii=mTriangleOffsets[to]; ii<mTriangleOffsets[to + 1]; ii++)
+    {
+        const uint32_t *pTriangle = &indices[(size_t)mTriangles[ii] * 3];
+        for(int vv=0; vv<3; vv++)
+        {
+            mMarks[mWelded[pTriangle[vv]]] = toMark;
+        }
+    }
+    uint32_t fromMark = ++mMark;
+    uint32_t common = 0, shared = 0;
+    for(uint32_t ii=mTriangleOffsets[from]; ii<mTriangleOffsets[from + 1]; ii++)
+    {
+        const uint32_t *pTriangle = &indices[(size_t)mTriangles[ii] * 3];
+        bool hasTo = false;
+        for(int vv=0; vv<3; vv++)
+        {
+            uint32_t vertex = mWelded[pTriangle[vv]];
+            hasTo |= vertex == to;
+            if(vertex != from && vertex != to && mMarks[vertex] == toMark)
+            {
+                mMarks[vertex] = fromMark;
+                common++;
+            }
+        }
+        shared += hasTo ? 1 : 0;
+    }
+    *pSharedTriangles = shared;
+    return shared > 0 && common <= shared;
+}
+
+// Whether the triangles that move with from still face the same way
+//-----------------------------------------------------------------------------
+bool CPUTMeshSimplifier::KeepsOrientation(uint32_t from, uint32_t to, const std::vector<uint32_t> &indices) const
+{
+    double target[3];
+    ReadPosition(mpPositions, mPositionStride, to, target);
+    for(uint32_t ii=mTriangleOffsets[from]; ii<mTriangleOffsets[from + 1]; ii++)
+    {
+        const uint32_t *pTriangle = &indices[(size_t)mTriangles[ii] * 3];
+        int corner = 0;
+        bool hasTo = false;
+        for(int vv=0; vv<3; vv++)
+        {
+            uint32_t vertex = mWelded[pTriangle[vv]];
+            corner = vertex == from ? vv : corner;
+            hasTo |= vertex == to;
+        }
+        if(hasTo)
+        {
+            continue;   // collapses away
+        }
+        double position[3][3];
+        for(int vv=0; vv<3; vv++)
+        {
+            ReadPosition(mpPositions, mPositionStride, mWelded[pTriangle[(corner + vv) % 3]], position[vv]);
+        }
+        double edge0[3], edge1[3], moved0[3], moved1[3], before[3], after[3];
+        for(int cc=0; cc<3; cc++)
+        {
+            edge0[cc]  = position[1][cc] - position[0][cc];
+            edge1[cc]  = position[2][cc] - position[0][cc];
+            moved0[cc] = position[1][cc] - target[cc];
+            moved1[cc] = position[2][cc] - target[cc];
+        }
+        Cross(edge0, edge1, before);
+        Cross(moved0, moved1, after);
+        double dot = Dot(before, after);
+        if(dot <= 0.0 || dot * dot < FLIP_COSINE_SQUARED * Dot(before, before) * Dot(after, after))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Collapses the cheapest edges it can without touching any triangle twice, then drops the
+// triangles that collapsed.  Returns the number of collapses.
+//-----------------------------------------------------------------------------
+size_t CPUTMeshSimplifier::RunPass(std::vector<uint32_t> *pIndices, size_t targetTriangleCount, double *pMaxError)
+{
+    std::vector<uint32_t> &indices = *pIndices;
+    BuildAdjacency(indices);
+
+    struct Candidate
+    {
+        double   cost;
+        uint32_t from;
+        uint32_t to;
+        bool operator<(const Candidate &other) const { return cost < other.cost; }
+    };
+    std::vector<Candidate> candidates;
+    candidates.reserve(indices.size() * 2);
+    for(size_t ii=0; ii<indices.size(); ii+=3)
+    {
+        for(int ee=0; ee<3; ee++)
+        {
+            uint32_t a = mWelded[indices[ii + ee]];
+            uint32_t b = mWelded[indices[ii + (ee + 1) % 3]];
+            for(int dd=0; dd<2; dd++)
+            {
+                uint32_t from = dd ? b : a;
+                uint32_t to   = dd ? a : b;
+                if(from != to && CanCollapse(from, to))
+                {
+                    double target[3];
+                    ReadPosition(mpPositions, mPositionStride, to, target);
+                    Candidate candidate = { QuadricError(mQuadrics[from], target), from, to };
+                    candidates.push_back(candidate);
+                }
+            }
+        }
+    }
+    std::stable_sort(candidates.begin(), candidates.end());
+
+    // A collapse locks both ends and everything around the vertex that moved, so the
+    // neighbourhoods the later checks look at are still the ones in the index list
+    std::vector<uint8_t>  locked(mVertexCount, 0);
+    std::vector<uint32_t> collapse(mVertexCount, ~0u);
+    size_t triangleCount = indices.size() / 3;
+    size_t collapses = 0;
+    for(size_t ii=0; ii<candidates.size() && triangleCount > targetTriangleCount; ii++)
+    {
+        const Candidate &candidate = candidates[ii];
+        uint32_t shared;
+        if(locked[candidate.from] || locked[candidate.to] ||
+           !KeepsTopology(candidate.from, candidate.to, indices, &shared) ||
+           !KeepsOrientation(candidate.from, candidate.to, indices))
+        {
+            continue;
+        }
+        collapse[candidate.from] = candidate.to;
+        for(uint32_t tt=mTriangleOffsets[candidate.from]; tt<mTriangleOffsets[candidate.from + 1]; tt++)
+        {
+            const uint32_t *pTriangle = &indices[(size_t)mTriangles[tt] * 3];
+            for(int vv=0; vv<3; vv++)
+            {
+                locked[mWelded[pTriangle[vv]]] = 1;
+            }
+        }
+        locked[candidate.to] = 1;
+
+        const Quadric &quadric = mQuadrics[candidate.from];
+        double error = quadric.weight > 0.0 ? sqrt(candidate.cost / quadric.weight) : 0.0;
+        *pMaxError = error > *pMaxError ? error : *pMaxError;
+        AddQuadric(&mQuadrics[candidate.to], quadric);
+        triangleCount -= shared < triangleCount ? shared : triangleCount;
+        collapses++;
+    }
+    if(!collapses)
+    {
+        return 0;
+    }
+
+    // Neither end of a collapse is a seam, so its welded vertex is the one the indices use
+    size_t kept = 0;
+    for(size_t ii=0; ii<indices.size(); ii+=3)
+    {
+        uint32_t corner[3];
+        for(int vv=0; vv<3; vv++)
+        {
+            uint32_t vertex = indices[ii + vv];
+            corner[vv] = collapse[vertex] != ~0u ? collapse[vertex] : vertex;
+        }
+        uint32_t a = mWelded[corner[0]], b = mWelded[corner[1]], c = mWelded[corner[2]];
+        if(a == b || b == c || c == a)
+        {
+            continue;
+        }
+        indices[kept++] = corner[0];
+        indices[kept++] = corner[1];
+        indices[kept++] = corner[2];
+    }
+    indices.resize(kept);
+    return collapses;
+}
+
+//-----------------------------------------------------------------------------
+size_t CPUTMeshSimplifier::Simplify(uint32_t *pDst, const uint32_t *pIndices, size_t indexCount, const uint32_t *pWedges, size_t targetIndexCount, float *pError)
+{
+    *pError = 0.0f;
+    if(indexCount % 3 || !mVertexCount)
+    {
+        return 0;
+    }
+    for(size_t ii=0; ii<indexCount; ii++)
+    {
+        if(pIndices[ii] >= mVertexCount || (pWedges && pWedges[pIndices[ii]] >= mVertexCount))
+        {
+            return 0;
+        }
+    }
+
+    // Drawing every wedge with its first vertex leaves one vertex per position wherever the
+    // mesh has no seam, which is all a collapse needs to move it
+    std::vector<uint32_t> indices(pIndices, pIndices + indexCount);
+    if(pWedges)
+    {
+        for(size_t ii=0; ii<indexCount; ii++)
+        {
+            indices[ii] = pWedges[indices[ii]];
+        }
+    }
+    std::vector<uint8_t> used(mVertexCount, 0);
+    for(size_t ii=0; ii<indexCount; ii++)
+    {
+        used[indices[ii]] = 1;
+    }
+    WeldPositions(mpPositions, mPositionStride, used, &mWelded);
+
+    // Triangles already degenerate in position have nothing to collapse and only confuse the
+    // boundary search
+    size_t kept = 0;
+    for(size_t ii=0; ii<indexCount; ii+=3)
+    {
+        uint32_t a = mWelded[indices[ii]], b = mWelded[indices[ii + 1]], c = mWelded[indices[ii + 2]];
+        if(a != b && b != c && c != a)
+        {
+            indices[kept++] = indices[ii];
+            indices[kept++] = indices[ii + 1];
+            indices[kept++] = indices[ii + 2];
+        }
+    }
+    indices.resize(kept);
+
+    // Again without the vertices only those used, so every welded vertex is one the indices use
+    used.assign(mVertexCount, 0);
+    for(size_t ii=0; ii<indices.size(); ii++)
+    {
+        used[indices[ii]] = 1;
+    }
+    WeldPositions(mpPositions, mPositionStride, used, &mWelded);
+
+    Classify(indices);
+    ComputeQuadrics(indices);
+    mMarks.assign(mVertexCount, 0);
+    mMark = 0;
+
+    double maxError = 0.0;
+    size_t targetTriangleCount = targetIndexCount / 3;
+    while(indices.size() / 3 > targetTriangleCount)
+    {
+        size_t before = indices.size();
+        if(!RunPass(&indices, targetTriangleCount, &maxError) || indices.size() >= before)
+        {
+            break;
+        }
+    }
+
+    std::copy(indices.begin(), indices.end(), pDst);
+    *pError = (float)maxError;
+    return indices.size();
+}
+
+//-----------------------------------------------------------------------------
+size_t CPUTSimplifyMesh(uint32_t *pDst, const uint32_t *pIndices, size_t indexCount, const unsigned char *pPositions, uint32_t positionStride,
+                        uint32_t vertexCount, const uint32_t *pWedges, size_t targetIndexCount, float *pError)
+{
+    CPUTMeshSimplifier simplifier(pPositions, positionStride, vertexCount);
+    return simplifier.Simplify(pDst, pIndices, indexCount, pWedges, targetIndexCount, pError);
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTBuildMeshLods(std::vector<uint32_t> *pIndices, const unsigned char *pPositions, uint32_t positionStride, uint32_t vertexCount,
+                       const uint32_t *pWedges, uint32_t lodCount, std::vector<CPUTMeshLod> *pLods)
+{
+    std::vector<uint32_t> &indices = *pIndices;
+    if(indices.size() % 3 || indices.size() > 0xffffffffu)
+    {
+        return false;
+    }
+    for(size_t ii=0; ii<indices.size(); ii++)
+    {
+        if(indices[ii] >= vertexCount || (pWedges && pWedges[indices[ii]] >= vertexCount))
+        {
+            return false;
+        }
+    }
+
+    pLods->clear();
+    CPUTMeshLod full = { 0, (uint32_t)indices.size(), 0.0f };
+    pLods->push_back(full);
+
+    std::vector<uint32_t> simplified, ordered, clusters;
+    float error = 0.0f;
+    for(uint32_t ii=1; ii<lodCount && !indices.empty(); ii++)
+    {
+        const CPUTMeshLod &previous = pLods->back();
+        size_t target = (size_t)(previous.indexCount / 3 * CPUT_MESH_LOD_RATIO) * 3;
+        simplified.resize(previous.indexCount);
+
+        // Simplifying the previous level rather than the full mesh keeps each level's
+        // triangles a subset of the collapses before it, so levels don't pop sideways
+        float levelError;
+        size_t count = CPUTSimplifyMesh(&simplified[0], &indices[previous.indexStart], previous.indexCount, pPositions, positionStride,
+                                        vertexCount, pWedges, target, &levelError);
+        if(!count || count > previous.indexCount - (size_t)(previous.indexCount * CPUT_MESH_LOD_MIN_SAVING) ||
+           indices.size() + count > 0xffffffffu)
+        {
+            break;
+        }
+        // Each level's error is measured from the one before it
+        error += levelError;
+
+        ordered.resize(count);
+        CPUTOptimizeVertexCache(&ordered[0], &simplified[0], count, vertexCount, CPUT_MESH_OPTIMIZER_CACHE_SIZE, &clusters);
+        CPUTMeshLod lod = { (uint32_t)indices.size(), (uint32_t)count, error };
+        indices.insert(indices.end(), ordered.begin(), ordered.end());
+        pLods->push_back(lod);
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+uint32_t CPUTSelectMeshLod(const CPUTMeshLod *pLods, uint32_t lodCount, float worldScale, float distance, float projectionScale, float maxScreenError)
+{
+    if(distance <= 0.0f)
+    {
+        return 0;
+    }
+
+    // Projected height over the screen's height, which spans two units of clip space
+    float scale = worldScale * projectionScale * 0.5f / distance;
+    uint32_t lod = 0;
+    for(uint32_t ii=1; ii<lodCount; ii++)
+    {
+        if(pLods[ii].error * scale > maxScreenError)
+        {
+            break;
+        }
+        lod = ii;
+    }
+    return lod;
+}
@@ -0,0 +1,78 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTMESHSIMPLIFIER_H__
+#define __CPUTMESHSIMPLIFIER_H__
+
+// Levels of detail for indexed triangle lists, by quadric error edge collapse (Garland and
+// Heckbert, "Surface Simplification Using Quadric Error Metrics", 1997).
+//
+// Vertices only ever collapse onto one of their neighbours, so every level is just another
+// index list over the mesh's own vertex buffer: a model keeps one vertex buffer per mesh and
+// appends its levels to the index buffer, and picking a level is picking an index range.
+// Vertices where the mesh has a texture or normal seam, on non-manifold edges or on more than
+// one open boundary stay put; open boundaries only shorten along themselves, so meshes don't
+// pull away from their neighbours.  Copies of a vertex that only differ in attributes a
+// coarser level can do without, typically tangent frames exporters split per face, are
+// wedges of one vertex and don't make a seam.
+// Only depends on the C++ standard library, so tools built on it also run off Windows.
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#define CPUT_MESH_LOD_RATIO       0.5f  // each level keeps about this fraction of the previous one's triangles
+#define CPUT_MESH_LOD_MIN_SAVING  0.1f  // levels that drop fewer of the previous one's triangles are left out
+#define CPUT_MESH_LOD_SCREEN_ERROR 0.001f // fraction of the screen's height a drawn level's error may cover
+
+// A byte range of the vertex that copies at one position must share to be wedges of one vertex
+struct CPUTMeshWedgeAttribute
+{
+    uint32_t offset;
+    uint32_t size;
+};
+
+struct CPUTMeshLod
+{
+    uint32_t indexStart;
+    uint32_t indexCount;
+    float    error;         // object space distance the surface may have moved; 0 for the full mesh
+};
+
+// (*pWedges)[v] is the first vertex with the same bytes as v in every attribute, which should
+// include the position.
+void CPUTFindMeshWedges(const unsigned char *pVertices, uint32_t vertexStride, uint32_t vertexCount,
+                        const CPUTMeshWedgeAttribute *pAttributes, uint32_t attributeCount, std::vector<uint32_t> *pWedges);
+
+// Simplify a triangle list to at most targetIndexCount indices, or as close as it gets, into
+// pDst (room for indexCount).  positions are three floats, positionStride bytes apart, and
+// pWedges is CPUTFindMeshWedges()'s, or NULL to keep every copy of a vertex apart; the result
+// draws each wedge's first vertex.  Returns the number of indices written, or 0 if the
+// indices aren't a triangle list over the vertices.  *pError gets the level's CPUTMeshLod::error.
+size_t CPUTSimplifyMesh(uint32_t *pDst, const uint32_t *pIndices, size_t indexCount, const unsigned char *pPositions, uint32_t positionStride,
+                        uint32_t vertexCount, const uint32_t *pWedges, size_t targetIndexCount, float *pError);
+
+// The full mesh and up to lodCount - 1 simpler ones, each about CPUT_MESH_LOD_RATIO of the one
+// before it, appended to *pIndices.  pLods[0] is the full mesh.  Returns false, changing nothing,
+// if the indices aren't a triangle list over the vertices.
+bool CPUTBuildMeshLods(std::vector<uint32_t> *pIndices, const unsigned char *pPositions, uint32_t positionStride, uint32_t vertexCount,
+                       const uint32_t *pWedges, uint32_t lodCount, std::vector<CPUTMeshLod> *pLods);
+
+// The coarsest level whose error, scaled by worldScale and seen from distance through a
+// projection whose vertical scale (the projection matrix's [1][1]) is projectionScale, covers
+// at most maxScreenError of the screen's height.  distance <= 0 means the camera is inside the
+// bounds and picks the full mesh.
+uint32_t CPUTSelectMeshLod(const CPUTMeshLod *pLods, uint32_t lodCount, float worldScale, float distance, float projectionScale, float maxScreenError);
+
+#endif // __CPUTMESHSIMPLIFIER_H__
@@ -18,11 +18,45 @@
 #include "CPUTMesh.h"
 #include "CPUTAssetLibrary.h"
 #include "CPUTBuffer.h"
+#include "CPUTModelFile.h"
+#include "CPUTMeshOptimizer.h"
+#include "CPUTMeshClusters.h"
+#include "CPUTMeshSimplifier.h"
+#include "CPUTVertexQuantizer.h"
+#include "CPUTMappedFile.h"
+#include "CPUTFrustum.h"
+#include <float.h>
+#include <string.h>
 
 CPUTMaterial  *CPUTModel::mpShadowCastMaterialMaster = NULL;
 CPUTMaterial  *CPUTModel::mpBoundingBoxMaterialMaster = NULL;
 CPUTMesh      *CPUTModel::mpBoundingBoxMesh=NULL;
 
+static_assert(ARRAYSIZE(CPUT_FILE_ELEMENT_TYPE_TO_CPUT_TYPE_CONVERT) == CPUT_MODEL_FILE_TYPE_LAST + 1, "the parser's element type range must match the table");
+
+// Copies of a vertex that only differ in their tangent frame are wedges of one vertex to the
+// simplifier: exporters often split those per face, and a coarser level can share one.
+//-----------------------------------------------------------------------------
+static void FindLodWedges(const CPUTModelFileMesh &mesh, const void *pVertices, UINT vertexCount, std::vector<uint32_t> *pWedges)
+{
+    std::vector<CPUTMeshWedgeAttribute> attributes;
+    uint32_t offset = 0;
+    for(uint32_t ii=0; ii<mesh.pHeader->formatDescriptorCount; ii++)
+    {
+        const CPUTModelFileElement &element = mesh.pElements[ii];
+        if(element.vertexElementSemantic != CPUT_MODEL_FILE_SEMANTIC_TANGENT &&
+           element.vertexElementSemantic != CPUT_MODEL_FILE_SEMANTIC_BINORMAL &&
+           offset + element.elementSizeInBytes <= mesh.vertexStride)
+        {
+            CPUTMeshWedgeAttribute attribute = { offset, element.elementSizeInBytes };
+            attributes.push_back(attribute);
+        }
+        offset += element.elementSizeInBytes;
+    }
+    CPUTFindMeshWedges((const unsigned char *)pVertices, mesh.vertexStride, vertexCount,
+                       attributes.empty() ? NULL : &attributes[0], (uint32_t)attributes.size(), pWedges);
+}
+
 //-----------------------------------------------------------------------------
 CPUTModel::~CPUTModel()
 {
@@ -99,40 +133,299 @@ void CPUTModel::UpdateBoundsWorldSpace()
     }
     mBoundingBoxCenterWorldSpace = (maxPosition + minPosition) * 0.5f;
     mBoundingBoxHalfWorldSpace   = (maxPosition - minPosition) * 0.5f;
+
+    // Culled where it was
+    mpCulledFrustum = NULL;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTModel::MarkDirty()
+{
+    // Culled where it was
+    mpCulledFrustum = NULL;
+    CPUTRenderNode::MarkDirty();
+}
+
+//-----------------------------------------------------------------------------
+void CPUTModel::SetFrustumVisibility(const CPUTFrustum &frustum, bool isVisible)
+{
+    mpCulledFrustum   = &frustum;
+    mCulledGeneration = frustum.mGeneration;
+    mCulledVisible    = isVisible;
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTModel::GetFrustumVisibility(const CPUTFrustum &frustum, bool *pIsVisible) const
+{
+    if( mpCulledFrustum != &frustum || mCulledGeneration != frustum.mGeneration )
+    {
+        return false;
+    }
+    *pIsVisible = mCulledVisible;
+    return true;
 }
 
 //-----------------------------------------------------------------------------
 CPUTResult CPUTModel::LoadModelPayload(const cString &File)
 {
-    CPUTResult result = CPUT_SUCCESS;
+    CPUTModelPayload payload;
+    PrepareModelPayload(File, mMeshCount, &payload);
+    return CreateModelPayload(File, payload);
+}
+
+// Runs on worker threads: no ASSERTs, and nothing but the file and the payload is touched
+//-----------------------------------------------------------------------------
+CPUTResult CPUTModel::PrepareModelPayload(const cString &File, UINT meshCount, CPUTModelPayload *pPayload)
+{
+    // Models in a mounted archive are parsed straight out of its mapping, loose ones out of
+    // their own.  Either way the meshes' vertices and indices go to the GPU from where they lie.
+    const unsigned char *pData;
+    size_t size;
+    if(CPUTOSServices::GetOSServices()->ReadArchivedFile(File, &pPayload->archived))
+    {
+        pData = pPayload->archived.pData;
+        size  = pPayload->archived.size;
+    }
+    else
+    {
+        if(!pPayload->diskFile.Open(File.c_str()))
+        {
+            return pPayload->result = CPUT_ERROR_FILE_NOT_FOUND;
+        }
+        pPayload->diskFile.WillNeed();
+        pData = pPayload->diskFile.GetData();
+        size  = pPayload->diskFile.GetSize();
+    }
 
-    std::ifstream file(File.c_str(), std::ios::in | std::ios::binary);
-    ASSERT( !file.fail(), _L("CPUTModelDX11::LoadModelPayload() - Could not find binary model file: ") + File );
+    std::vector<CPUTModelFileMesh> meshes;
+    if(CPUTParseModelFile(pData, size, &meshes) != CPUT_MODEL_FILE_OK)
+    {
+        return pPayload->result = CPUT_ERROR_FILE_READ_ERROR;
+    }
+    if(meshes.size() > meshCount)
+    {
+        cString message = _L("Actual mesh count doesn't match stated mesh count in '") + File + _L("'\n");
+        TRACE(message.c_str());
+        meshes.resize(meshCount);
+    }
+    pPayload->meshCount = (UINT)meshes.size();
+    pPayload->pMeshes   = new CPUTModelPayloadMesh[meshes.size()];
 
-    // set up for mesh creation loop
-    UINT meshIndex = 0;
-    while(file.good() && !file.eof())
+    bool optimizeMeshes = CPUTAssetLibrary::GetAssetLibrary()->GetOptimizeMeshes();
+    bool clusterMeshes  = CPUTAssetLibrary::GetAssetLibrary()->GetClusterMeshes();
+    UINT meshLodCount   = CPUTAssetLibrary::GetAssetLibrary()->GetMeshLodCount();
+    bool shadowPositionStreams = CPUTAssetLibrary::GetAssetLibrary()->GetShadowPositionStreams();
+
+    // Quantizing needs every mesh planned first: the shaders decode the whole model with one box
+    // and one direction encoding, so it goes for all of the meshes or none of them.
+    bool quantizeVertices = CPUTAssetLibrary::GetAssetLibrary()->GetQuantizeVertices();
+    if(quantizeVertices)
     {
-        // TODO: rearrange while() to avoid if(eof).  Should perform only one branch per loop iteration, not two
-        CPUTRawMeshData vertexFormatDesc;
-        vertexFormatDesc.Read(file);
-        if(file.eof())
+        float minimum[3] = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
+        float maximum[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+        for(UINT meshIndex = 0; meshIndex < meshes.size() && quantizeVertices; ++meshIndex)
+        {
+            const CPUTModelFileMesh &mesh = meshes[meshIndex];
+            if(!mesh.pVertices)
+            {
+                continue;
+            }
+            std::vector<CPUTQuantizedElement> &plan = pPayload->pMeshes[meshIndex].quantizationPlan;
+            quantizeVertices = 0 != CPUTPlanVertexQuantization(mesh.pElements, mesh.pHeader->formatDescriptorCount, &plan);
+            CPUTGrowQuantizationBounds((const unsigned char *)mesh.pVertices, mesh.pHeader->vertexCount, mesh.vertexStride,
+                                       plan, minimum, maximum);
+        }
+        if(quantizeVertices)
         {
-            // TODO:  Wtf?  Why would we get here?  We check eof at the top of loop.  If it isn't eof there, why is it eof here?
-            break;
+            CPUTMakeQuantizationBox(minimum, maximum, &pPayload->quantizationBox);
+            pPayload->quantized = true;
         }
-        ASSERT( meshIndex < mMeshCount, _L("Actual mesh count doesn't match stated mesh count"));
+        else
+        {
+            for(UINT meshIndex = 0; meshIndex < meshes.size(); ++meshIndex)
+            {
+                pPayload->pMeshes[meshIndex].quantizationPlan.clear();
+            }
+            cString message = _L("Not quantizing '") + File + _L("': a position, normal, tangent or binormal isn't three floats\n");
+            TRACE(message.c_str());
+        }
+    }
+    for(UINT meshIndex = 0; meshIndex < meshes.size(); ++meshIndex)
+    {
+        const CPUTModelFileMesh &vertexFormatDesc = meshes[meshIndex];
+        CPUTModelPayloadMesh &mesh = pPayload->pMeshes[meshIndex];
+        mesh.file = vertexFormatDesc;
+
+        // Draw from the file as it is, or from an optimized copy when the asset library asks for one
+        mesh.pVertices   = vertexFormatDesc.pVertices;
+        mesh.pIndices    = vertexFormatDesc.pIndices;
+        mesh.vertexCount = vertexFormatDesc.pHeader->vertexCount;
+        mesh.indexCount  = vertexFormatDesc.indexCount;
+        mesh.is16Bit     = vertexFormatDesc.indexType == tUINT16;
+        if(optimizeMeshes && mesh.pVertices && vertexFormatDesc.indexCount)
+        {
+            const unsigned char *pBytes = (const unsigned char *)mesh.pVertices;
+            CPUTReadModelFileIndices(vertexFormatDesc, &mesh.indices);
+            mesh.vertices.assign(pBytes, pBytes + vertexFormatDesc.verticesSizeInBytes);
+            if(CPUTOptimizeMesh(&mesh.indices, &mesh.vertices, vertexFormatDesc.vertexStride,
+                                CPUTGetModelFilePositionOffset(vertexFormatDesc), CPUTMeshOptimizerOptions()))
+            {
+                mesh.pVertices   = &mesh.vertices[0];
+                mesh.pIndices    = &mesh.indices[0];
+                mesh.vertexCount = (UINT)(mesh.vertices.size() / vertexFormatDesc.vertexStride);
+                mesh.is16Bit     = false;
+            }
+        }
+        // Clusters are cut from the float positions, before any quantizing
+        int positionOffset = CPUTGetModelFilePositionOffset(vertexFormatDesc);
+        if(clusterMeshes && mesh.pVertices && vertexFormatDesc.indexCount && positionOffset >= 0)
+        {
+            if(mesh.pIndices == vertexFormatDesc.pIndices)
+            {
+                CPUTReadModelFileIndices(vertexFormatDesc, &mesh.indices);
+            }
+            if(CPUTBuildMeshClusters(&mesh.indices[0], mesh.indices.size(), (const unsigned char *)mesh.pVertices + positionOffset,
+                                     vertexFormatDesc.vertexStride, mesh.vertexCount, CPUT_MESH_CLUSTER_TRIANGLES, &mesh.clusters))
+            {
+                mesh.pIndices = &mesh.indices[0];
+                mesh.is16Bit  = false;
+            }
+        }
+        // So are the levels of detail.  They reuse the mesh's vertices and follow its indices, so
+        // they come after the clusters, which only cover the full mesh.
+        if(meshLodCount > 1 && mesh.pVertices && vertexFormatDesc.indexCount && positionOffset >= 0)
+        {
+            if(mesh.pIndices == vertexFormatDesc.pIndices)
+            {
+                CPUTReadModelFileIndices(vertexFormatDesc, &mesh.indices);
+            }
+            std::vector<uint32_t> wedges;
+            FindLodWedges(vertexFormatDesc, mesh.pVertices, mesh.vertexCount, &wedges);
+            if(CPUTBuildMeshLods(&mesh.indices, (const unsigned char *)mesh.pVertices + positionOffset, vertexFormatDesc.vertexStride,
+                                 mesh.vertexCount, wedges.empty() ? NULL : &wedges[0], meshLodCount, &mesh.lods) && mesh.lods.size() > 1)
+            {
+                mesh.pIndices   = &mesh.indices[0];
+                mesh.indexCount = (UINT)mesh.indices.size();
+                mesh.is16Bit    = false;
+            }
+            else
+            {
+                mesh.lods.clear();
+            }
+        }
+        if(pPayload->quantized && mesh.pVertices && mesh.vertexCount)
+        {
+            const CPUTQuantizedElement &last = mesh.quantizationPlan.back();
+            std::vector<unsigned char> quantizedVertices((size_t)mesh.vertexCount * (last.offset + last.size));
+            CPUTQuantizationError error;
+            CPUTQuantizeVertices(&quantizedVertices[0], (const unsigned char *)mesh.pVertices, mesh.vertexCount, vertexFormatDesc.vertexStride,
+                                 mesh.quantizationPlan, pPayload->quantizationBox, &error);
+            mesh.vertices.swap(quantizedVertices);
+            mesh.pVertices = &mesh.vertices[0];
+
+            cStringStream report;
+            report << File << _L(" mesh ") << meshIndex << _L(": ") << vertexFormatDesc.vertexStride << _L(" -> ")
+                   << (last.offset + last.size) << _L(" bytes per vertex, off by at most ") << error.position << _L(" in position, ")
+                   << error.direction << _L(" degrees in direction, ") << error.texCoord << _L(" in texture coordinates\n");
+            TRACE(report.str().c_str());
+        }
+        else
+        {
+            mesh.quantizationPlan.clear();
+        }
+
+        // The shadow pass only reads positions, so it can have them on their own, in whatever
+        // format the full vertices have them
+        if(shadowPositionStreams && mesh.pVertices && mesh.vertexCount)
+        {
+            const std::vector<CPUTQuantizedElement> &plan = mesh.quantizationPlan;
+            uint32_t stride = plan.empty() ? vertexFormatDesc.vertexStride : plan.back().offset + plan.back().size;
+            uint32_t offset = 0;
+            for(uint32_t ii=0; ii<vertexFormatDesc.pHeader->formatDescriptorCount; ii++)
+            {
+                const CPUTModelFileElement &element = vertexFormatDesc.pElements[ii];
+                uint32_t elementOffset = plan.empty() ? offset : plan[ii].offset;
+                uint32_t elementSize   = plan.empty() ? element.elementSizeInBytes : plan[ii].size;
+                offset += element.elementSizeInBytes;
+                if(element.vertexElementSemantic != CPUT_MODEL_FILE_SEMANTIC_POSITION || elementOffset + elementSize > stride)
+                {
+                    continue;
+                }
+                if(elementSize < stride)
+                {
+                    const unsigned char *pSource = (const unsigned char *)mesh.pVertices + elementOffset;
+                    mesh.shadowVertices.resize((size_t)mesh.vertexCount * elementSize);
+                    for(UINT vv=0; vv<mesh.vertexCount; vv++)
+                    {
+                        memcpy(&mesh.shadowVertices[(size_t)vv * elementSize], pSource + (size_t)vv * stride, elementSize);
+                    }
+                    mesh.shadowPositionElement = ii;
+
+                    cStringStream report;
+                    report << File << _L(" mesh ") << meshIndex << _L(": shadow pass fetches ") << elementSize << _L(" of ") << stride
+                           << _L(" bytes per vertex, ") << (100 - 100 * elementSize / stride) << _L("% less, for ")
+                           << mesh.shadowVertices.size() << _L(" more bytes of vertices\n");
+                    TRACE(report.str().c_str());
+                }
+                break;
+            }
+        }
+
+        // 32-bit indices of meshes small enough for 16-bit ones are narrowed, halving the index
+        // buffer and the index fetch bandwidth; the rest go from the file as they are.
+        if(!mesh.is16Bit && mesh.indexCount &&
+           CPUTNarrowIndices(mesh.pIndices, mesh.indexCount, mesh.vertexCount, &mesh.narrowedIndices))
+        {
+            mesh.pIndices = &mesh.narrowedIndices[0];
+            mesh.is16Bit  = true;
+        }
+    }
+    return pPayload->result = CPUT_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+CPUTResult CPUTModel::CreateModelPayload(const cString &File, const CPUTModelPayload &payload)
+{
+    CPUTResult result = payload.result;
+    if(CPUTFAILED(result))
+    {
+        ASSERT( result != CPUT_ERROR_FILE_NOT_FOUND, _L("CPUTModelDX11::LoadModelPayload() - Could not find binary model file: ") + File );
+        ASSERT( result != CPUT_ERROR_FILE_READ_ERROR, _L("CPUTModelDX11::LoadModelPayload() - Invalid model file: ") + File );
+        return result;
+    }
+    if(payload.quantized)
+    {
+        mQuantizedPositionScale = float3(payload.quantizationBox.scale);
+        mQuantizedPositionBias  = float3(payload.quantizationBox.bias);
+        mOctahedralDirections   = true;
+    }
+    for(UINT meshIndex = 0; meshIndex < payload.meshCount && meshIndex < mMeshCount; ++meshIndex)
+    {
+        const CPUTModelPayloadMesh &payloadMesh = payload.pMeshes[meshIndex];
+        const CPUTVertexElementDesc *pElements = (const CPUTVertexElementDesc *)payloadMesh.file.pElements;
+        UINT formatDescriptorCount = payloadMesh.file.pHeader->formatDescriptorCount;
+        const std::vector<CPUTQuantizedElement> *pQuantizationPlan = payloadMesh.quantizationPlan.empty() ? NULL : &payloadMesh.quantizationPlan;
 
         // create the mesh.
         CPUTMesh *pMesh = mpMesh[meshIndex];
+        if(!payloadMesh.clusters.empty())
+        {
+            std::vector<CPUTMeshCluster> clusters(payloadMesh.clusters);
+            pMesh->SetClusters(&clusters);
+        }
+        if(!payloadMesh.lods.empty())
+        {
+            std::vector<CPUTMeshLod> lods(payloadMesh.lods);
+            pMesh->SetLods(&lods);
+        }
 
         // always a triangle list (at this point)
         pMesh->SetMeshTopology(CPUT_TOPOLOGY_INDEXED_TRIANGLE_LIST);
 
         // get number of data blocks in the vertex element (pos,norm,uv,etc)
         // YUCK! TODO: Use fixed-size array of elements
-        CPUTBufferInfo *pVertexElementInfo = new CPUTBufferInfo[vertexFormatDesc.mFormatDescriptorCount];
-        // pMesh->SetBounds(vertexFormatDesc.mBboxCenter, vertexFormatDesc.mBboxHalf);
+        CPUTBufferInfo *pVertexElementInfo = new CPUTBufferInfo[formatDescriptorCount];
+        // pMesh->SetBounds(vertexFormatDesc.pHeader->bboxCenter, vertexFormatDesc.pHeader->bboxHalf);
 
         // running count of each type of  element
         int positionStreamCount=0;
@@ -143,17 +436,38 @@ CPUTResult CPUTModel::LoadModelPayload(const cString &File)
         int colorStreamCount=0;
 
         int RunningOffset = 0;
-        for(UINT ii=0; ii<vertexFormatDesc.mFormatDescriptorCount; ii++)
+        for(UINT ii=0; ii<formatDescriptorCount; ii++)
         {
-            // lookup the CPUT data type equivalent
-            pVertexElementInfo[ii].mElementType = CPUT_FILE_ELEMENT_TYPE_TO_CPUT_TYPE_CONVERT[vertexFormatDesc.mpElements[ii].mVertexElementType];
+            // lookup the CPUT data type equivalent; CPUTParseModelFileMesh() only passes types the table has
+            pVertexElementInfo[ii].mElementType = CPUT_FILE_ELEMENT_TYPE_TO_CPUT_TYPE_CONVERT[pElements[ii].mVertexElementType];
             ASSERT((pVertexElementInfo[ii].mElementType !=CPUT_UNKNOWN ) , _L(".MDL file load error.  This model file has an unknown data type in it's model data."));
             // calculate the number of elements in this stream block (i.e. F32F32F32 = 3xF32)
-            pVertexElementInfo[ii].mElementComponentCount = vertexFormatDesc.mpElements[ii].mElementSizeInBytes/CPUT_DATA_FORMAT_SIZE[pVertexElementInfo[ii].mElementType];
+            pVertexElementInfo[ii].mElementComponentCount = pElements[ii].mElementSizeInBytes/CPUT_DATA_FORMAT_SIZE[pVertexElementInfo[ii].mElementType];
             // store the size of each element type in bytes (i.e. 3xF32, each element = F32 = 4 bytes)
-            pVertexElementInfo[ii].mElementSizeInBytes = vertexFormatDesc.mpElements[ii].mElementSizeInBytes;
+            pVertexElementInfo[ii].mElementSizeInBytes = pElements[ii].mElementSizeInBytes;
+            // quantized elements are smaller and decoded by the input assembler or the shader
+            if(pQuantizationPlan)
+            {
+                const CPUTQuantizedElement &quantized = (*pQuantizationPlan)[ii];
+                switch(quantized.format)
+                {
+                case CPUT_QUANTIZED_POSITION_UNORM16:
+                    pVertexElementInfo[ii].mElementType = CPUT_U16_NORM;
+                    break;
+                case CPUT_QUANTIZED_OCTAHEDRAL_SNORM16:
+                    pVertexElementInfo[ii].mElementType = CPUT_I16_NORM;
+                    break;
+                case CPUT_QUANTIZED_HALF2:
+                    pVertexElementInfo[ii].mElementType = CPUT_F16;
+                    break;
+                default:
+                    break;
+                }
+                pVertexElementInfo[ii].mElementComponentCount = quantized.size/CPUT_DATA_FORMAT_SIZE[pVertexElementInfo[ii].mElementType];
+                pVertexElementInfo[ii].mElementSizeInBytes    = quantized.size;
+            }
             // store the number of elements (i.e. 3xF32, 3 elements)
-            pVertexElementInfo[ii].mElementCount = vertexFormatDesc.mVertexCount;
+            pVertexElementInfo[ii].mElementCount = payloadMesh.vertexCount;
             // calculate the offset from the first element of the stream - assumes all blocks appear in the vertex stream as the order that appears here
             pVertexElementInfo[ii].mOffset = RunningOffset;
             RunningOffset = RunningOffset + pVertexElementInfo[ii].mElementSizeInBytes;
@@ -161,7 +475,7 @@ CPUTResult CPUTModel::LoadModelPayload(const cString &File)
             // extract the name of stream
             pVertexElementInfo[ii].mpSemanticName = CPUT_VERTEX_ELEMENT_SEMANTIC_AS_STRING[ii];
 
-            switch(vertexFormatDesc.mpElements[ii].mVertexElementSemantic)
+            switch(pElements[ii].mVertexElementSemantic)
             {
             case CPUT_VERTEX_ELEMENT_POSITON:
                 pVertexElementInfo[ii].mpSemanticName = "POSITION";
@@ -194,40 +508,42 @@ CPUTResult CPUTModel::LoadModelPayload(const cString &File)
             }
         }
 
-        // Index buffer
         CPUTBufferInfo indexDataInfo;
-        indexDataInfo.mElementType           = (vertexFormatDesc.mIndexType == tUINT32) ? CPUT_U32 : CPUT_U16;
+        indexDataInfo.mElementType           = payloadMesh.is16Bit ? CPUT_U16 : CPUT_U32;
         indexDataInfo.mElementComponentCount = 1;
-        indexDataInfo.mElementSizeInBytes    = (vertexFormatDesc.mIndexType == tUINT32) ? sizeof(UINT32) : sizeof(UINT16);
-        indexDataInfo.mElementCount          = vertexFormatDesc.mIndexCount;
+        indexDataInfo.mElementSizeInBytes    = payloadMesh.is16Bit ? sizeof(UINT16) : sizeof(UINT32);
+        indexDataInfo.mElementCount          = payloadMesh.indexCount;
         indexDataInfo.mOffset                = 0;
         indexDataInfo.mSemanticIndex         = 0;
         indexDataInfo.mpSemanticName         = NULL;
 
-        if( pVertexElementInfo->mElementCount && indexDataInfo.mElementCount )
+        if( pVertexElementInfo->mElementCount && indexDataInfo.mElementCount && payloadMesh.pVertices )
         {
             result = pMesh->CreateNativeResources(
                 this,
                 meshIndex,
-                vertexFormatDesc.mFormatDescriptorCount,
+                formatDescriptorCount,
                 pVertexElementInfo,
-                (void*)vertexFormatDesc.mpVertices,
+                (void*)payloadMesh.pVertices,
                 &indexDataInfo,
-                &vertexFormatDesc.mpIndices[0]
+                (void*)payloadMesh.pIndices
             );
             if(CPUTFAILED(result))
             {
                 return result;
             }
+            if(!payloadMesh.shadowVertices.empty())
+            {
+                result = pMesh->CreateShadowPositions(&pVertexElementInfo[payloadMesh.shadowPositionElement], (void*)&payloadMesh.shadowVertices[0]);
+                if(CPUTFAILED(result))
+                {
+                    return result;
+                }
+            }
         }
         delete [] pVertexElementInfo;
         pVertexElementInfo = NULL;
-        ++meshIndex;
     }
-    ASSERT( file.eof(), _L("") );
-
-    // close file
-    file.close();
 
     return result;
 }
@@ -24,9 +24,56 @@
 #include "CPUTMath.h"
 #include "CPUTConfigBlock.h"
 #include "CPUTMesh.h"
+#include "CPUTModelFile.h"
+#include "CPUTMappedFile.h"
+#include "CPUTArchive.h"
+#include "CPUTVertexQuantizer.h"
 
 class CPUTMaterial;
 class CPUTMesh;
+class CPUTFrustum;
+
+// One mesh of a CPUTModelPayload, ready for CPUTMesh::CreateNativeResources()
+struct CPUTModelPayloadMesh
+{
+    CPUTModelFileMesh                  file;              // points into the payload's file
+    const void                        *pVertices;         // into the file, or vertices
+    const void                        *pIndices;          // into the file, indices or narrowedIndices
+    UINT                               vertexCount;
+    UINT                               indexCount;        // with the levels of detail after the full mesh
+    bool                               is16Bit;
+    std::vector<unsigned char>         vertices;
+    std::vector<uint32_t>              indices;
+    std::vector<uint16_t>              narrowedIndices;
+    std::vector<CPUTQuantizedElement>  quantizationPlan;  // empty unless quantized
+    std::vector<CPUTMeshCluster>       clusters;
+    std::vector<CPUTMeshLod>           lods;
+    std::vector<unsigned char>         shadowVertices;    // the positions alone, for the shadow pass
+    UINT                               shadowPositionElement;
+
+    CPUTModelPayloadMesh() : pVertices(NULL), pIndices(NULL), vertexCount(0), indexCount(0), is16Bit(false), shadowPositionElement(0) {}
+};
+
+// A model file read, optimized, clustered, simplified and quantized the way the asset library asks, but
+// with nothing created on the device yet.  Preparing one only touches the file and the payload,
+// so asset sets prepare theirs on the worker pool and create them on the owning thread.
+// Not copyable: the meshes point into the mapping and into each other's vectors.
+struct CPUTModelPayload
+{
+    CPUTResult                          result;
+    CPUTArchiveData                     archived;
+    CPUTMappedFile                      diskFile;
+    CPUTModelPayloadMesh               *pMeshes;
+    UINT                                meshCount;
+    bool                                quantized;
+    CPUTQuantizationBox                 quantizationBox;
+
+    CPUTModelPayload() : result(CPUT_SUCCESS), pMeshes(NULL), meshCount(0), quantized(false) {}
+    ~CPUTModelPayload() { delete [] pMeshes; }
+private:
+    CPUTModelPayload(const CPUTModelPayload &);
+    CPUTModelPayload &operator=(const CPUTModelPayload &);
+};
 
 //-----------------------------------------------------------------------------
 class CPUTModel : public CPUTRenderNode
@@ -48,6 +95,18 @@ protected:
     float3         mBoundingBoxHalfWorldSpace;
     CPUTMaterial  *mpBoundingBoxMaterial;
 
+    // How the shaders decode quantized vertices: object space position = POSITION * scale + bias,
+    // and NORMAL, TANGENT and BINORMAL are octahedral when mOctahedralDirections is set
+    float3         mQuantizedPositionScale;
+    float3         mQuantizedPositionBias;
+    bool           mOctahedralDirections;
+
+    // The last batched frustum test (see CPUTAssetSet::CullModels()): whether the model was inside
+    // mpCulledFrustum as it was at mCulledGeneration
+    const CPUTFrustum *mpCulledFrustum;
+    UINT               mCulledGeneration;
+    bool               mCulledVisible;
+
 public:
     CPUTModel():
         mMeshCount(0),
@@ -58,7 +117,13 @@ public:
         mBoundingBoxCenterWorldSpace(0.0f),
         mBoundingBoxHalfWorldSpace(0.0f),
         mpBoundingBoxMaterial(NULL),
-        mpShadowCastMaterial(NULL)
+        mQuantizedPositionScale(1.0f),
+        mQuantizedPositionBias(0.0f),
+        mOctahedralDirections(false),
+        mpShadowCastMaterial(NULL),
+        mpCulledFrustum(NULL),
+        mCulledGeneration(0),
+        mCulledVisible(true)
     {}
     virtual ~CPUTModel();
     static void ReleaseStaticResources();
@@ -66,13 +131,24 @@ public:
     bool               IsRenderable() { return mIsRenderable; }
     void               SetRenderable(bool isRenderable) { mIsRenderable = isRenderable; }
     virtual bool       IsModel() { return true; }
+    // Also drops the stored frustum test.  Under FlattenTransforms() the models below this one keep theirs.
+    virtual void       MarkDirty();
     void               GetBoundsObjectSpace(float3 *pCenter, float3 *pHalf);
     void               GetBoundsWorldSpace(float3 *pCenter, float3 *pHalf);
     void               UpdateBoundsWorldSpace();
+    void               SetFrustumVisibility(const CPUTFrustum &frustum, bool isVisible);
+    // false if the model hasn't been culled against frustum as it is now
+    bool               GetFrustumVisibility(const CPUTFrustum &frustum, bool *pIsVisible) const;
     int                GetMeshCount() const { return mMeshCount; }
     CPUTMesh          *GetMesh( UINT ii ) { return mpMesh[ii]; }
-    virtual CPUTResult LoadModel(CPUTConfigBlock *pBlock, int *pParentID, CPUTModel *pMasterModel=NULL) = 0;
+    // pPayload, if given, was prepared from this block's model file and is used instead of loading it
+    virtual CPUTResult LoadModel(CPUTConfigBlock *pBlock, int *pParentID, CPUTModel *pMasterModel=NULL, const CPUTModelPayload *pPayload=NULL) = 0;
     CPUTResult         LoadModelPayload(const cString &File);
+    // LoadModelPayload() in two halves.  PrepareModelPayload() can run on any thread, any number
+    // at once; CreateModelPayload() creates the meshes' buffers and so runs on the owning thread.
+    // One prepared payload can create any number of models.
+    static CPUTResult  PrepareModelPayload(const cString &File, UINT meshCount, CPUTModelPayload *pPayload);
+    CPUTResult         CreateModelPayload(const cString &File, const CPUTModelPayload &payload);
     virtual void       SetMaterial(UINT ii, CPUTMaterial *pMaterial);
 #ifdef SUPPORT_DRAWING_BOUNDING_BOXES
     virtual void       DrawBoundingBox(CPUTRenderParameters &renderParams) = 0;
@@ -100,6 +176,7 @@ public:
     }
     CPUTMaterial *GetMaterial( const cString name, int meshIndex ) const;
     CPUTMaterial *GetMaterial( int meshIndex ) const { return mpMaterial[meshIndex]; }
+    CPUTMaterial *GetShadowCastMaterial() const { return mpShadowCastMaterial; }
     CPUTBuffer   *GetBuffer( const cString &name, int meshIndex ) const;
 };
 #endif // __CPUTMODEL_H__
\ No newline at end of file
@@ -19,6 +19,8 @@
 #include "CPUTFrustum.h"
 #include "CPUTTextureDX11.h"
 #include "CPUTBufferDX11.h"
+#include "CPUTRenderStateBlockDX11.h"
+#include <float.h>
 
 ID3D11Buffer *CPUTModelDX11::mpModelConstantBuffer = NULL;
 
@@ -31,6 +33,66 @@ CPUTMeshDX11* CPUTModelDX11::GetMesh(const UINT index) const
 
 float3 gLightDir = float3(0.7f, -0.5f, -0.1f);
 
+std::vector<CPUTMeshClusterRange> CPUTModelDX11::mVisibleClusterRanges;
+
+// The camera's frustum planes and position in the space of a model with this world matrix.
+// Returns false if the matrix mirrors, which swaps the faces the rasterizer culls.
+//-----------------------------------------------------------------------------
+static bool GetObjectSpaceView( const float4x4 &world, CPUTCamera *pCamera, float pPlanes[6][4], float pEye[3] )
+{
+    // A world space plane (n, -n.p) holds the points x with [x 1] * (n, -n.p) = 0, and with
+    // row vectors an object space point goes to world space as [x 1] * world, so the plane in
+    // object space is world * (n, -n.p).
+    CPUTFrustum &frustum = pCamera->mFrustum;
+    for( int ii=0; ii<6; ii++ )
+    {
+        const float3 &normal = frustum.mpNormal[ii];
+        const float3 &point  = frustum.mpPosition[ii < 3 ? 0 : 6]; // see CPUTFrustum::IsVisible()
+        float4 plane = world * float4( normal, -dot3( normal, point ) );
+        pPlanes[ii][0] = plane.x;
+        pPlanes[ii][1] = plane.y;
+        pPlanes[ii][2] = plane.z;
+        pPlanes[ii][3] = plane.w;
+    }
+    float4 eye = float4( pCamera->GetPosition(), 1.0f ) * inverse( world );
+    pEye[0] = eye.x;
+    pEye[1] = eye.y;
+    pEye[2] = eye.z;
+    return world.determinant() > 0.0f;
+}
+
+// Whether the material's rasterizer state drops the back faces of CPUTMeshClusters.h's front
+// faces.  Without a state block the rasterizer keeps whatever state was set last, so no.
+//-----------------------------------------------------------------------------
+static bool CullsBackfaces( CPUTMaterial *pMaterial )
+{
+    CPUTRenderStateBlockDX11 *pRenderStateBlock = (CPUTRenderStateBlockDX11*)pMaterial->GetRenderStateBlock();
+    if( !pRenderStateBlock )
+    {
+        return false;
+    }
+    const D3D11_RASTERIZER_DESC &rasterizerDesc = pRenderStateBlock->GetState()->RasterizerDesc;
+    return rasterizerDesc.CullMode == D3D11_CULL_BACK && !rasterizerDesc.FrontCounterClockwise;
+}
+
+// How the camera sees a model with this world matrix and bounds, for CPUTSelectMeshLod().  The
+// distance is to the nearest point of the bounds' sphere; an orthographic camera sees every
+// distance the same.
+//-----------------------------------------------------------------------------
+static void GetLodView( const float4x4 &world, const float3 &center, const float3 &half, CPUTCamera *pCamera,
+                        float *pWorldScale, float *pDistance, float *pProjectionScale )
+{
+    float scaleX = float3( world.r0.x, world.r0.y, world.r0.z ).length();
+    float scaleY = float3( world.r1.x, world.r1.y, world.r1.z ).length();
+    float scaleZ = float3( world.r2.x, world.r2.y, world.r2.z ).length();
+    *pWorldScale = scaleX > scaleY ? ( scaleX > scaleZ ? scaleX : scaleZ ) : ( scaleY > scaleZ ? scaleY : scaleZ );
+
+    const float4x4 &projection = *pCamera->GetProjectionMatrix();
+    bool perspective = projection.r2.w != 0.0f;
+    *pDistance        = perspective ? ( pCamera->GetPosition() - center ).length() - half.length() : 1.0f;
+    *pProjectionScale = projection.r1.y;
+}
+
 // Set the render state before drawing this object
 //-----------------------------------------------------------------------------
 void CPUTModelDX11::UpdateShaderConstants(CPUTRenderParameters &renderParams)
@@ -79,6 +141,8 @@ void CPUTModelDX11::UpdateShaderConstants(CPUTRenderParameters &renderParams)
         cb.BoundingBoxHalfWorldSpace    = DirectX::XMLoadFloat3(&DirectX::XMFLOAT3( bbHWS[0], bbHWS[1], bbHWS[2] )); ;
         cb.BoundingBoxCenterObjectSpace = DirectX::XMLoadFloat3(&DirectX::XMFLOAT3( bbCOS[0], bbCOS[1], bbCOS[2] )); ;
         cb.BoundingBoxHalfObjectSpace   = DirectX::XMLoadFloat3(&DirectX::XMFLOAT3( bbHOS[0], bbHOS[1], bbHOS[2] )); ;
+        cb.QuantizedPositionScale = DirectX::XMVectorSet( mQuantizedPositionScale.x, mQuantizedPositionScale.y, mQuantizedPositionScale.z, 0.0f );
+        cb.QuantizedPositionBias  = DirectX::XMVectorSet( mQuantizedPositionBias.x,  mQuantizedPositionBias.y,  mQuantizedPositionBias.z,  mOctahedralDirections ? 1.0f : 0.0f );
 
         // Shadow camera
         DirectX::XMMATRIX    shadowView, shadowProjection;
@@ -98,6 +162,9 @@ void CPUTModelDX11::UpdateShaderConstants(CPUTRenderParameters &renderParams)
 //-----------------------------------------------------------------------------
 void CPUTModelDX11::Render(CPUTRenderParameters &renderParams)
 {
+    // e.g., a static batch draws this model's meshes instead
+    if( !mIsRenderable ) { return; }
+
     CPUTRenderParametersDX *pParams = (CPUTRenderParametersDX*)&renderParams;
     CPUTCamera             *pCamera = pParams->mpCamera;
 
@@ -112,15 +179,65 @@ void CPUTModelDX11::Render(CPUTRenderParameters &renderParams)
     // Update the model's render states only once (and then iterate over materials)
     UpdateShaderConstants(renderParams);
 
+    // Asset sets cull all their models at once before drawing them (see CPUTAssetSet::CullModels())
     bool isVisible = true;
-    isVisible = !pParams->mRenderOnlyVisibleModels || !pCamera || pCamera->mFrustum.IsVisible( mBoundingBoxCenterWorldSpace, mBoundingBoxHalfWorldSpace );
+    if( pParams->mRenderOnlyVisibleModels && pCamera && !GetFrustumVisibility( pCamera->mFrustum, &isVisible ) )
+    {
+        isVisible = pCamera->mFrustum.IsVisible( mBoundingBoxCenterWorldSpace, mBoundingBoxHalfWorldSpace );
+        if( isVisible )
+        {
+            pCamera->mFrustum.mNumFrustumVisibleModels++;
+        }
+        else
+        {
+            pCamera->mFrustum.mNumFrustumCulledModels++;
+        }
+    }
     if( isVisible )
     {
+        // Meshes split into clusters draw only the clusters inside the frustum and, when their
+        // material culls back faces, facing the camera.  Both tests run in object space.
+        bool  cullClusters = pParams->mRenderOnlyVisibleModels && pCamera;
+        bool  canCullBackfaces = false;
+        float planes[6][4];
+        float eye[3];
+        if( cullClusters )
+        {
+            canCullBackfaces = GetObjectSpaceView( *GetWorldMatrix(), pCamera, planes, eye );
+        }
+
+        // Meshes with levels of detail draw the coarsest one that still looks like the full mesh
+        // from here.  Only the full mesh has clusters.
+        float lodWorldScale = 1.0f, lodDistance = 0.0f, lodProjectionScale = 1.0f;
+        if( pCamera )
+        {
+            GetLodView( *GetWorldMatrix(), mBoundingBoxCenterWorldSpace, mBoundingBoxHalfWorldSpace, pCamera,
+                        &lodWorldScale, &lodDistance, &lodProjectionScale );
+        }
+
         // loop over all meshes in this model and draw them
         for(UINT ii=0; ii<mMeshCount; ii++)
         {
             mpMaterial[ii]->SetRenderStates(renderParams);
-            ((CPUTMeshDX11*)mpMesh[ii])->Draw(renderParams, this);
+            CPUTMeshDX11 *pMesh = (CPUTMeshDX11*)mpMesh[ii];
+            const std::vector<CPUTMeshCluster> &clusters = pMesh->GetClusters();
+            const std::vector<CPUTMeshLod>     &lods     = pMesh->GetLods();
+            UINT lod = lods.empty() ? 0 : CPUTSelectMeshLod( &lods[0], (UINT)lods.size(), lodWorldScale, lodDistance, lodProjectionScale, CPUT_MESH_LOD_SCREEN_ERROR );
+            if( lod )
+            {
+                CPUTMeshClusterRange range = { lods[lod].indexStart, lods[lod].indexCount };
+                pMesh->DrawRanges( renderParams, this, &range, 1 );
+            }
+            else if( cullClusters && !clusters.empty() )
+            {
+                bool cullBackfaces = canCullBackfaces && CullsBackfaces( mpMaterial[ii] );
+                CPUTCullMeshClusters( &clusters[0], clusters.size(), planes, cullBackfaces ? eye : NULL, &mVisibleClusterRanges );
+                pMesh->DrawRanges( renderParams, this, mVisibleClusterRanges.empty() ? NULL : &mVisibleClusterRanges[0], (UINT)mVisibleClusterRanges.size() );
+            }
+            else
+            {
+                pMesh->Draw(renderParams, this);
+            }
         }
     }
 }
@@ -129,6 +246,8 @@ void CPUTModelDX11::Render(CPUTRenderParameters &renderParams)
 //-----------------------------------------------------------------------------
 void CPUTModelDX11::RenderShadow(CPUTRenderParameters &renderParams)
 {
+    if( !mIsRenderable ) { return; }
+
     CPUTRenderParametersDX *pParams = (CPUTRenderParametersDX*)&renderParams;
     CPUTCamera             *pCamera = pParams->mpCamera;
 
@@ -141,7 +260,12 @@ void CPUTModelDX11::RenderShadow(CPUTRenderParameters &renderParams)
     if( !renderParams.mDrawModels ) { return; }
 
     // TODO: add world-space bounding box to model so we don't need to do that work every frame
-    if( !pParams->mRenderOnlyVisibleModels || !pCamera || pCamera->mFrustum.IsVisible( mBoundingBoxCenterWorldSpace, mBoundingBoxHalfWorldSpace ) )
+    bool isVisible = true;
+    if( pParams->mRenderOnlyVisibleModels && pCamera && !GetFrustumVisibility( pCamera->mFrustum, &isVisible ) )
+    {
+        isVisible = pCamera->mFrustum.IsVisible( mBoundingBoxCenterWorldSpace, mBoundingBoxHalfWorldSpace );
+    }
+    if( isVisible )
     {
         // Update the model's render states only once (and then iterate over materials)
         UpdateShaderConstants(renderParams);
@@ -194,7 +318,7 @@ void CPUTModelDX11::CreateModelConstantBuffer()
 }
 
 //-----------------------------------------------------------------------------
-CPUTResult CPUTModelDX11::LoadModel(CPUTConfigBlock *pBlock, int *pParentID, CPUTModel *pMasterModel)
+CPUTResult CPUTModelDX11::LoadModel(CPUTConfigBlock *pBlock, int *pParentID, CPUTModel *pMasterModel, const CPUTModelPayload *pPayload)
 {
     CPUTResult result = CPUT_SUCCESS;
     CPUTAssetLibraryDX11 *pAssetLibrary = (CPUTAssetLibraryDX11*)CPUTAssetLibrary::GetAssetLibrary();
@@ -252,7 +376,7 @@ CPUTResult CPUTModelDX11::LoadModel(CPUTConfigBlock *pBlock, int *pParentID, CPU
     {
         // Not a clone/instance.  So, load the model's binary payload (i.e., vertex and index buffers)
         // TODO: Change to use GetModel()
-        result = LoadModelPayload(resolvedPathAndFile);
+        result = pPayload ? CreateModelPayload(resolvedPathAndFile, *pPayload) : LoadModelPayload(resolvedPathAndFile);
         ASSERT( CPUTSUCCESS(result), _L("Failed loading model") );
     }
 
@@ -299,6 +423,54 @@ CPUTResult CPUTModelDX11::LoadModel(CPUTConfigBlock *pBlock, int *pParentID, CPU
     return result;
 }
 
+//-----------------------------------------------------------------------------
+CPUTResult CPUTModelDX11::LoadStaticBatch(const cString &name, const CPUTModelPayload &payload, CPUTMaterial **ppMaterials, CPUTMaterial *pShadowCastMaterial)
+{
+    mName      = name;
+    mMeshCount = payload.meshCount;
+    mpMesh     = new CPUTMesh*[mMeshCount];
+    mpMaterial = new CPUTMaterial*[mMeshCount];
+    memset( mpMaterial, 0, mMeshCount * sizeof(CPUTMaterial*) );
+    for(UINT ii=0; ii<mMeshCount; ii++)
+    {
+        mpMesh[ii] = new CPUTMeshDX11();
+    }
+    CPUTResult result = CreateModelPayload(mName, payload);
+    ASSERT( CPUTSUCCESS(result), _L("Failed creating static batch") );
+
+    // The batch is the union of its meshes' bounds, and its world matrix stays the identity
+    float3 minExtent( FLT_MAX), maxExtent(-FLT_MAX);
+    for(UINT ii=0; ii<mMeshCount; ii++)
+    {
+        const std::vector<CPUTMeshCluster> &clusters = payload.pMeshes[ii].clusters;
+        for(UINT cc=0; cc<clusters.size(); cc++)
+        {
+            float3 center(clusters[cc].boundsCenter[0], clusters[cc].boundsCenter[1], clusters[cc].boundsCenter[2]);
+            float3 half(clusters[cc].boundsHalf[0], clusters[cc].boundsHalf[1], clusters[cc].boundsHalf[2]);
+            float3 minCorner = center - half;
+            float3 maxCorner = center + half;
+            minExtent = Min( minCorner, minExtent );
+            maxExtent = Max( maxCorner, maxExtent );
+        }
+    }
+    if( minExtent.x <= maxExtent.x )
+    {
+        mBoundingBoxCenterObjectSpace = (maxExtent + minExtent) * 0.5f;
+        mBoundingBoxHalfObjectSpace   = (maxExtent - minExtent) * 0.5f;
+    }
+
+    mpShadowCastMaterial = pShadowCastMaterial;
+    if( mpShadowCastMaterial )
+    {
+        mpShadowCastMaterial->AddRef();
+    }
+    for(UINT ii=0; ii<mMeshCount; ii++)
+    {
+        SetMaterial(ii, ppMaterials[ii]);
+    }
+    return result;
+}
+
 // Set the material associated with this mesh and create/re-use a
 //-----------------------------------------------------------------------------
 void CPUTModelDX11::SetMaterial(UINT ii, CPUTMaterial *pMaterial)
@@ -310,7 +482,7 @@ void CPUTModelDX11::SetMaterial(UINT ii, CPUTMaterial *pMaterial)
     D3D11_INPUT_ELEMENT_DESC *pDesc = pMesh->GetLayoutDescription();
     if( pDesc )
     {
-        pMesh->BindVertexShaderLayout(pMaterial, mpMaterial[ii]);
+        pMesh->BindVertexShaderLayout(pMaterial, mpShadowCastMaterial);
     }
 }
 
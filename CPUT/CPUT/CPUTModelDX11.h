@@ -37,6 +37,8 @@ struct CPUTModelConstantBuffer
     DirectX::XMVECTOR  BoundingBoxHalfWorldSpace;
     DirectX::XMVECTOR  BoundingBoxCenterObjectSpace;
     DirectX::XMVECTOR  BoundingBoxHalfObjectSpace;
+    DirectX::XMVECTOR  QuantizedPositionScale;
+    DirectX::XMVECTOR  QuantizedPositionBias;   // w is 1 when directions are octahedral encoded
 };
 
 //--------------------------------------------------------------------------------------
@@ -45,6 +47,7 @@ class CPUTModelDX11 : public CPUTModel
     friend class CPUTMaterialDX11;
 protected:
     static ID3D11Buffer *mpModelConstantBuffer;
+    static std::vector<CPUTMeshClusterRange> mVisibleClusterRanges; // scratch for Render()
 
     // Destructor is not public.  Must release instead of delete.
     ~CPUTModelDX11(){ SAFE_RELEASE(mpModelConstantBuffer); }
@@ -55,7 +58,10 @@ public:
     static void CreateModelConstantBuffer();
 
     CPUTMeshDX11 *GetMesh(const UINT index) const;
-    CPUTResult    LoadModel(CPUTConfigBlock *pBlock, int *pParentID, CPUTModel *pMasterModel=NULL);
+    CPUTResult    LoadModel(CPUTConfigBlock *pBlock, int *pParentID, CPUTModel *pMasterModel=NULL, const CPUTModelPayload *pPayload=NULL);
+    // A model of static batches (see CPUTStaticBatch.h): payload's meshes are already in world
+    // space and clustered one cluster per batched mesh.  One material per mesh.
+    CPUTResult    LoadStaticBatch(const cString &name, const CPUTModelPayload &payload, CPUTMaterial **ppMaterials, CPUTMaterial *pShadowCastMaterial);
     void          UpdateShaderConstants(CPUTRenderParameters &renderParams);
     void          Render(CPUTRenderParameters &renderParams);
     void          RenderShadow(CPUTRenderParameters &renderParams);
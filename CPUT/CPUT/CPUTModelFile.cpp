@@ -0,0 +1,256 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTModelFile.h"
+#include <string.h>
+
+//-----------------------------------------------------------------------------
+static bool ReadUINT32(const unsigned char *pData, size_t size, size_t *pOffset, uint32_t *pValue)
+{
+    if(size - *pOffset < sizeof(uint32_t))
+    {
+        return false;
+    }
+    memcpy(pValue, pData + *pOffset, sizeof(uint32_t));
+    *pOffset += sizeof(uint32_t);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+static CPUTModelFileResult ReadCookie(const unsigned char *pData, size_t size, size_t *pOffset)
+{
+    uint32_t cookie;
+    if(!ReadUINT32(pData, size, pOffset, &cookie))
+    {
+        return CPUT_MODEL_FILE_TRUNCATED;
+    }
+    return cookie == CPUT_MODEL_FILE_COOKIE ? CPUT_MODEL_FILE_OK : CPUT_MODEL_FILE_BAD_COOKIE;
+}
+
+//-----------------------------------------------------------------------------
+CPUTModelFileResult CPUTParseModelFileMesh(const unsigned char *pData, size_t size, size_t *pOffset, CPUTModelFileMesh *pMesh)
+{
+    // Every count is checked against what's left before it's used, so a damaged file
+    // can't send a pointer past the end of the data
+    size_t offset = *pOffset;
+    if(offset > size)
+    {
+        return CPUT_MODEL_FILE_TRUNCATED;
+    }
+    CPUTModelFileResult result = ReadCookie(pData, size, &offset);
+    if(result != CPUT_MODEL_FILE_OK)
+    {
+        return result;
+    }
+
+    CPUTModelFileMesh mesh;
+    if(size - offset < sizeof(CPUTModelFileMeshHeader))
+    {
+        return CPUT_MODEL_FILE_TRUNCATED;
+    }
+    mesh.pHeader = (const CPUTModelFileMeshHeader *)(pData + offset);
+    offset += sizeof(CPUTModelFileMeshHeader);
+
+    uint32_t elementCount = mesh.pHeader->formatDescriptorCount;
+    if(elementCount > (size - offset) / sizeof(CPUTModelFileElement))
+    {
+        return CPUT_MODEL_FILE_TRUNCATED;
+    }
+    mesh.pElements = (const CPUTModelFileElement *)(pData + offset);
+    offset += elementCount * sizeof(CPUTModelFileElement);
+    for(uint32_t ii=0; ii<elementCount; ii++)
+    {
+        // The runtime looks the type up in a table, so it must be one of the table's rows
+        uint32_t type = mesh.pElements[ii].vertexElementType;
+        if(type < CPUT_MODEL_FILE_TYPE_FIRST || type > CPUT_MODEL_FILE_TYPE_LAST)
+        {
+            return CPUT_MODEL_FILE_INVALID;
+        }
+    }
+
+    if(!ReadUINT32(pData, size, &offset, &mesh.indexCount) ||
+       !ReadUINT32(pData, size, &offset, &mesh.indexType))
+    {
+        return CPUT_MODEL_FILE_TRUNCATED;
+    }
+    switch(mesh.indexType)
+    {
+    case CPUT_MODEL_FILE_INDEX_UINT16: mesh.indexSize = sizeof(uint16_t); break;
+    case CPUT_MODEL_FILE_INDEX_UINT32: mesh.indexSize = sizeof(uint32_t); break;
+    default: return CPUT_MODEL_FILE_INVALID;
+    }
+    if(mesh.indexCount > (size - offset) / mesh.indexSize)
+    {
+        return CPUT_MODEL_FILE_TRUNCATED;
+    }
+    mesh.pIndices = pData + offset;
+    offset += (size_t)mesh.indexCount * mesh.indexSize;
+
+    result = ReadCookie(pData, size, &offset);
+    if(result != CPUT_MODEL_FILE_OK)
+    {
+        return result;
+    }
+
+    // The stored total is ignored; like CPUTRawMeshData::Allocate(), the size comes from the count and padded stride
+    mesh.vertexStride = mesh.pHeader->stride + mesh.pHeader->paddingSize;
+    if(mesh.vertexStride < mesh.pHeader->stride)
+    {
+        return CPUT_MODEL_FILE_INVALID;
+    }
+    if(mesh.pHeader->totalVerticesSizeInBytes != 0)
+    {
+        mesh.verticesSizeInBytes = (uint64_t)mesh.pHeader->vertexCount * mesh.vertexStride;
+        if(mesh.verticesSizeInBytes > size - offset)
+        {
+            return CPUT_MODEL_FILE_TRUNCATED;
+        }
+        mesh.pVertices = pData + offset;
+        offset += (size_t)mesh.verticesSizeInBytes;
+    }
+
+    result = ReadCookie(pData, size, &offset);
+    if(result != CPUT_MODEL_FILE_OK)
+    {
+        return result;
+    }
+
+    // The runtime packs the elements back to back to find the stride it gives the GPU;
+    // if they add up to more than the stride in the file, it would read past the vertices
+    uint64_t elementBytes = 0;
+    for(uint32_t ii=0; ii<elementCount; ii++)
+    {
+        elementBytes += mesh.pElements[ii].elementSizeInBytes;
+    }
+    if(mesh.pVertices && elementBytes > mesh.vertexStride)
+    {
+        return CPUT_MODEL_FILE_INVALID;
+    }
+
+    *pMesh   = mesh;
+    *pOffset = offset;
+    return CPUT_MODEL_FILE_OK;
+}
+
+//-----------------------------------------------------------------------------
+CPUTModelFileResult CPUTParseModelFile(const unsigned char *pData, size_t size, std::vector<CPUTModelFileMesh> *pMeshes)
+{
+    pMeshes->clear();
+    size_t offset = 0;
+    while(offset < size)
+    {
+        CPUTModelFileMesh mesh;
+        CPUTModelFileResult result = CPUTParseModelFileMesh(pData, size, &offset, &mesh);
+        if(result != CPUT_MODEL_FILE_OK)
+        {
+            return result;
+        }
+        pMeshes->push_back(mesh);
+    }
+    return CPUT_MODEL_FILE_OK;
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTNarrowIndices(const void *pIndices, uint32_t indexCount, uint32_t vertexCount, std::vector<uint16_t> *pNarrowed)
+{
+    pNarrowed->clear();
+    if(vertexCount > 0xFFFF)
+    {
+        return false;
+    }
+    pNarrowed->resize(indexCount);
+    const unsigned char *pSource = (const unsigned char *)pIndices;
+    uint32_t maxIndex = 0;
+    for(uint32_t ii=0; ii<indexCount; ii++)
+    {
+        // The indices may not be 4 byte aligned in the file
+        uint32_t index;
+        memcpy(&index, pSource + ii * sizeof(uint32_t), sizeof(uint32_t));
+        maxIndex = index > maxIndex ? index : maxIndex;
+        (*pNarrowed)[ii] = (uint16_t)index;
+    }
+    // 0xFFFF stays out: it cuts strips if the buffer is ever drawn with a strip topology
+    if(maxIndex >= 0xFFFF)
+    {
+        pNarrowed->clear();
+        return false;
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTReadModelFileIndices(const CPUTModelFileMesh &mesh, std::vector<uint32_t> *pIndices)
+{
+    pIndices->resize(mesh.indexCount);
+    const unsigned char *pSource = (const unsigned char *)mesh.pIndices;
+    for(uint32_t ii=0; ii<mesh.indexCount; ii++)
+    {
+        if(mesh.indexSize == sizeof(uint16_t))
+        {
+            uint16_t index;
+            memcpy(&index, pSource + ii * sizeof(uint16_t), sizeof(uint16_t));
+            (*pIndices)[ii] = index;
+        }
+        else
+        {
+            memcpy(&(*pIndices)[ii], pSource + ii * sizeof(uint32_t), sizeof(uint32_t));
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+int CPUTGetModelFilePositionOffset(const CPUTModelFileMesh &mesh)
+{
+    uint32_t offset = 0;
+    for(uint32_t ii=0; ii<mesh.pHeader->formatDescriptorCount; ii++)
+    {
+        const CPUTModelFileElement &element = mesh.pElements[ii];
+        if(element.vertexElementSemantic == CPUT_MODEL_FILE_SEMANTIC_POSITION &&
+           element.vertexElementType == CPUT_MODEL_FILE_TYPE_FLOAT &&
+           element.elementSizeInBytes >= 3 * sizeof(float))
+        {
+            return offset + element.elementSizeInBytes <= mesh.vertexStride ? (int)offset : -1;
+        }
+        offset += element.elementSizeInBytes;
+    }
+    return -1;
+}
+
+//-----------------------------------------------------------------------------
+static void Append(std::vector<unsigned char> *pFile, const void *pData, size_t size)
+{
+    const unsigned char *pBytes = (const unsigned char *)pData;
+    pFile->insert(pFile->end(), pBytes, pBytes + size);
+}
+
+//-----------------------------------------------------------------------------
+void CPUTAppendModelFileMesh(std::vector<unsigned char> *pFile, const CPUTModelFileMeshHeader &header, const CPUTModelFileElement *pElements,
+                             uint32_t indexCount, uint32_t indexType, const void *pIndices, const void *pVertices)
+{
+    uint32_t cookie = CPUT_MODEL_FILE_COOKIE;
+    size_t indexSize = indexType == CPUT_MODEL_FILE_INDEX_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+    Append(pFile, &cookie, sizeof(cookie));
+    Append(pFile, &header, sizeof(header));
+    Append(pFile, pElements, header.formatDescriptorCount * sizeof(CPUTModelFileElement));
+    Append(pFile, &indexCount, sizeof(indexCount));
+    Append(pFile, &indexType, sizeof(indexType));
+    Append(pFile, pIndices, indexCount * indexSize);
+    Append(pFile, &cookie, sizeof(cookie));
+    if(header.totalVerticesSizeInBytes != 0)
+    {
+        Append(pFile, pVertices, (size_t)header.vertexCount * (header.stride + header.paddingSize));
+    }
+    Append(pFile, &cookie, sizeof(cookie));
+}
@@ -0,0 +1,129 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTMODELFILE_H__
+#define __CPUTMODELFILE_H__
+
+// In place parser for binary model files (.mdl).  A model file is a run of meshes, each one
+//
+//   cookie (1234)
+//   CPUTModelFileMeshHeader
+//   CPUTModelFileElement[formatDescriptorCount]
+//   index count, index type
+//   indices, indexCount 16-bit (tUINT16) or 32-bit (tUINT32) values
+//   cookie (1234)
+//   vertices, vertexCount * (stride + paddingSize) bytes, only if totalVerticesSizeInBytes != 0
+//   cookie (1234)
+//
+// The parser checks the framing and that every range lies inside the data, then hands back
+// pointers into it, so a mapped file's vertices and indices go to the GPU without being copied.
+// Only depends on the C++ standard library, so tools built on it also run off Windows.
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#define CPUT_MODEL_FILE_COOKIE 1234
+
+// The index types a model file may use; same values as tUINT16 and tUINT32 in eCPUT_VERTEX_ELEMENT_TYPE
+#define CPUT_MODEL_FILE_INDEX_UINT16 5
+#define CPUT_MODEL_FILE_INDEX_UINT32 7
+
+// Same values as eCPUT_VERTEX_ELEMENT_SEMANTIC and tFLOAT
+#define CPUT_MODEL_FILE_SEMANTIC_POSITION 2
+#define CPUT_MODEL_FILE_SEMANTIC_NORMAL   3
+#define CPUT_MODEL_FILE_SEMANTIC_TEXCOORD 4
+#define CPUT_MODEL_FILE_SEMANTIC_TANGENT  6
+#define CPUT_MODEL_FILE_SEMANTIC_BINORMAL 7
+#define CPUT_MODEL_FILE_TYPE_FLOAT        14
+
+// The element types the runtime knows, tINT8 through tDOUBLE; the rows of CPUT_FILE_ELEMENT_TYPE_TO_CPUT_TYPE_CONVERT
+#define CPUT_MODEL_FILE_TYPE_FIRST        2
+#define CPUT_MODEL_FILE_TYPE_LAST         15
+
+#pragma pack(push,1)
+// Same layout as the fields CPUTRawMeshData::Read() reads
+struct CPUTModelFileMeshHeader
+{
+    uint32_t stride;
+    uint32_t paddingSize;
+    uint64_t totalVerticesSizeInBytes;
+    uint32_t vertexCount;
+    uint32_t topology;              // eCPUT_MESH_TOPOLOGY
+    float    bboxCenter[3];
+    float    bboxHalf[3];
+    uint32_t formatDescriptorCount;
+};
+
+// Same layout as CPUTVertexElementDesc
+struct CPUTModelFileElement
+{
+    uint32_t vertexElementSemantic; // eCPUT_VERTEX_ELEMENT_SEMANTIC
+    uint32_t vertexElementType;     // eCPUT_VERTEX_ELEMENT_TYPE
+    uint32_t elementSizeInBytes;
+    uint32_t offset;
+};
+#pragma pack(pop)
+
+enum CPUTModelFileResult
+{
+    CPUT_MODEL_FILE_OK = 0,
+    CPUT_MODEL_FILE_BAD_COOKIE,   // the framing is off: not a model file, or a damaged one
+    CPUT_MODEL_FILE_TRUNCATED,    // a count runs past the end of the data
+    CPUT_MODEL_FILE_INVALID,      // well framed, but the vertex elements don't fit the stride, or an unknown index or element type
+};
+
+// One mesh, pointing into the parsed data.  None of the pointers are aligned beyond a byte.
+struct CPUTModelFileMesh
+{
+    const CPUTModelFileMeshHeader *pHeader;
+    const CPUTModelFileElement    *pElements;     // pHeader->formatDescriptorCount of them
+    uint32_t                       indexCount;
+    uint32_t                       indexType;     // CPUT_MODEL_FILE_INDEX_UINT16 or CPUT_MODEL_FILE_INDEX_UINT32
+    uint32_t                       indexSize;     // 2 or 4 bytes
+    const void                    *pIndices;      // indexCount indices of indexSize bytes
+    uint32_t                       vertexStride;  // stride + paddingSize
+    const void                    *pVertices;     // vertexCount * vertexStride bytes, NULL if the file has none
+    uint64_t                       verticesSizeInBytes;
+
+    CPUTModelFileMesh() :
+        pHeader(NULL), pElements(NULL), indexCount(0), indexType(0), indexSize(0), pIndices(NULL),
+        vertexStride(0), pVertices(NULL), verticesSizeInBytes(0) {}
+};
+
+// Parse the mesh starting *pOffset bytes into pData and move *pOffset to the one after it.
+// Nothing is written to pMesh unless the whole mesh checks out.
+CPUTModelFileResult CPUTParseModelFileMesh(const unsigned char *pData, size_t size, size_t *pOffset, CPUTModelFileMesh *pMesh);
+
+// Parse every mesh.  The data must end right after the last one.
+CPUTModelFileResult CPUTParseModelFile(const unsigned char *pData, size_t size, std::vector<CPUTModelFileMesh> *pMeshes);
+
+// Narrow 32-bit indices to 16 bits when every one of them fits, which is always the case for a
+// well formed mesh of at most 65535 vertices.  Returns false, leaving pNarrowed empty, when the
+// mesh has more vertices or an index doesn't fit.
+bool CPUTNarrowIndices(const void *pIndices, uint32_t indexCount, uint32_t vertexCount, std::vector<uint16_t> *pNarrowed);
+
+// The mesh's indices as 32-bit values, whichever size the file stores
+void CPUTReadModelFileIndices(const CPUTModelFileMesh &mesh, std::vector<uint32_t> *pIndices);
+
+// Byte offset of the first position (at least three floats) in each vertex, or -1 if there isn't one.
+// Elements are packed in order, as the loader lays them out.
+int CPUTGetModelFilePositionOffset(const CPUTModelFileMesh &mesh);
+
+// Append one mesh to pFile.  header's vertex count, stride and padding describe pVertices, which
+// is only written if header.totalVerticesSizeInBytes != 0; indexType says how big the indices are.
+void CPUTAppendModelFileMesh(std::vector<unsigned char> *pFile, const CPUTModelFileMeshHeader &header, const CPUTModelFileElement *pElements,
+                             uint32_t indexCount, uint32_t indexType, const void *pIndices, const void *pVertices);
+
+#endif // __CPUTMODELFILE_H__
@@ -29,6 +29,7 @@ CPUTOSServices::CPUTOSServices():mhWnd(NULL)
 //-----------------------------------------------------------------------------
 CPUTOSServices::~CPUTOSServices()
 {
+    UnmountArchives();
     //mCPUTMediaDirectory.clear();
     mCPUTResourceDirectory.clear();
 }
@@ -220,6 +221,11 @@ CPUTResult CPUTOSServices::ResolveAbsolutePathAndFilename(const cString &fileNam
 //-----------------------------------------------------------------------------
 CPUTResult CPUTOSServices::DoesFileExist(const cString &pathAndFilename)
 {
+    if(IsFileArchived(pathAndFilename))
+    {
+        return CPUT_SUCCESS;
+    }
+
     // check for file existence
     // attempt to open it where they said it was
     FILE *pFile = NULL;
@@ -272,6 +278,15 @@ CPUTResult CPUTOSServices::OpenFile(const cString &fileName, FILE **ppFilePointe
 //-----------------------------------------------------------------------------
 CPUTResult CPUTOSServices::ReadFileContents(const cString &fileName, UINT *pSizeInBytes, void **ppData)
 {
+    CPUTArchiveData archived;
+    if(ReadArchivedFile(fileName, &archived))
+    {
+        *pSizeInBytes = (UINT)archived.size;
+        *ppData = (void*) new char[*pSizeInBytes];
+        memcpy(*ppData, archived.pData, archived.size);
+        return CPUT_SUCCESS;
+    }
+
     FILE *pFile = NULL;
 #if defined (UNICODE) || defined(_UNICODE)
     errno_t err = _wfopen_s(&pFile, fileName.c_str(), _L("r"));
@@ -302,6 +317,101 @@ CPUTResult CPUTOSServices::ReadFileContents(const cString &fileName, UINT *pSize
     return TranslateFileError(err);
 }
 
+// Absolute, normalized UTF-8 form of a path, for matching against archive names
+//-----------------------------------------------------------------------------
+static std::string ArchivePathName(const cString &fileName)
+{
+    TCHAR pFullPathAndFilename[CPUT_MAX_PATH];
+    DWORD length = GetFullPathName(fileName.c_str(), CPUT_MAX_PATH, pFullPathAndFilename, NULL);
+    if(0 == length || length >= CPUT_MAX_PATH)
+    {
+        return std::string();
+    }
+#if defined (UNICODE) || defined(_UNICODE)
+    char pUtf8[CPUT_MAX_PATH * 3];
+    int utf8Length = WideCharToMultiByte(CP_UTF8, 0, pFullPathAndFilename, (int)length, pUtf8, sizeof(pUtf8), NULL, NULL);
+    return CPUTArchive::NormalizeName(std::string(pUtf8, utf8Length));
+#else
+    return CPUTArchive::NormalizeName(std::string(pFullPathAndFilename, length));
+#endif
+}
+
+// Mount a packed archive over a directory
+//-----------------------------------------------------------------------------
+CPUTResult CPUTOSServices::MountArchive(const cString &archiveFileName, const cString &mountDirectory)
+{
+    std::string mountPrefix = ArchivePathName(mountDirectory);
+    if(mountPrefix.empty())
+    {
+        return CPUT_ERROR_INVALID_PARAMETER;
+    }
+    if(mountPrefix[mountPrefix.size()-1] != '/')
+    {
+        mountPrefix += '/';
+    }
+
+    CPUTArchive *pArchive = new CPUTArchive();
+    if(!pArchive->Open(archiveFileName.c_str()))
+    {
+        delete pArchive;
+        return CPUT_ERROR_FILE_READ_ERROR;
+    }
+    MountedArchive mounted;
+    mounted.pArchive    = pArchive;
+    mounted.mountPrefix = mountPrefix;
+    mArchives.push_back(mounted);
+    return CPUT_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTOSServices::UnmountArchives()
+{
+    for(size_t ii=0; ii<mArchives.size(); ii++)
+    {
+        SAFE_DELETE(mArchives[ii].pArchive);
+    }
+    mArchives.clear();
+}
+
+//-----------------------------------------------------------------------------
+const CPUTArchiveEntry *CPUTOSServices::FindArchivedFile(const cString &fileName, const CPUTArchive **ppArchive)
+{
+    if(mArchives.empty())
+    {
+        return NULL;
+    }
+    std::string name = ArchivePathName(fileName);
+    for(size_t ii=mArchives.size(); ii-- > 0; )
+    {
+        const MountedArchive &mounted = mArchives[ii];
+        if(name.size() > mounted.mountPrefix.size() && 0 == name.compare(0, mounted.mountPrefix.size(), mounted.mountPrefix))
+        {
+            const CPUTArchiveEntry *pEntry = mounted.pArchive->Find(name.substr(mounted.mountPrefix.size()));
+            if(pEntry)
+            {
+                *ppArchive = mounted.pArchive;
+                return pEntry;
+            }
+        }
+    }
+    return NULL;
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTOSServices::IsFileArchived(const cString &fileName)
+{
+    const CPUTArchive *pArchive = NULL;
+    return NULL != FindArchivedFile(fileName, &pArchive);
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTOSServices::ReadArchivedFile(const cString &fileName, CPUTArchiveData *pData)
+{
+    const CPUTArchive *pArchive = NULL;
+    const CPUTArchiveEntry *pEntry = FindArchivedFile(fileName, &pArchive);
+    return pEntry && pArchive->Read(pEntry, pData);
+}
+
 // Open the OS's 'open a file' dialog box
 //-----------------------------------------------------------------------------
 CPUTResult CPUTOSServices::OpenFileDialog(const cString &filter, cString *pfileName)
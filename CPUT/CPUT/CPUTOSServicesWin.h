@@ -19,11 +19,13 @@
 
 
 #include "CPUT.h"
+#include "CPUTArchive.h"
 
 // OS includes
 #include <windows.h>
 #include <errno.h>  // file open error codes
 #include <string>   // wstring
+#include <vector>
 
 
 
@@ -61,6 +63,16 @@ public:
     CPUTResult OpenFile(const cString &fileName, FILE **pFilePointer);
     CPUTResult ReadFileContents(const cString &fileName, UINT *psizeInBytes, void **ppData);
 
+    // Packed archives (see CPUTArchive.h).  While one is mounted, files under mountDirectory
+    // are served from it rather than from the disk; archives mounted later take precedence.
+    // Mount before loading and unmount after the last asset is released: uncompressed
+    // reads point straight into the archive's mapping.
+    CPUTResult MountArchive(const cString &archiveFileName, const cString &mountDirectory);
+    void       UnmountArchives();
+    bool       IsFileArchived(const cString &fileName);
+    // Returns false if no mounted archive holds the file.  Safe to call from worker threads.
+    bool       ReadArchivedFile(const cString &fileName, CPUTArchiveData *pData);
+
     // File dialog box
     CPUTResult OpenFileDialog(const cString &filter, cString *pfileName);
 
@@ -89,6 +101,14 @@ private:
     cString                mCPUTResourceDirectory;
     bool                   FileFoundButWithError(CPUTResult result);
 
+    struct MountedArchive
+    {
+        CPUTArchive *pArchive;
+        std::string  mountPrefix; // normalized absolute directory, '/' terminated
+    };
+    std::vector<MountedArchive> mArchives;
+    const CPUTArchiveEntry *FindArchivedFile(const cString &fileName, const CPUTArchive **ppArchive);
+
 #ifdef CPUT_GPA_INSTRUMENTATION
 public:
     // GPA instrumentation (only available in Profile build)
@@ -16,6 +16,7 @@
 #include "CPUTRenderNode.h"
 
 #include "CPUTOSServicesWin.h" // for OutputDebugString();
+#include <string.h>
 
 
 // Constructor
@@ -23,7 +24,10 @@
 CPUTRenderNode::CPUTRenderNode():
     mpParent(NULL),
     mpChild(NULL),
-    mpSibling(NULL)
+    mpSibling(NULL),
+    mpTransforms(NULL),
+    mTransformIndex(0),
+    mOwnsTransforms(false)
 {
     // set transform to identity
     mWorldMatrix  = float4x4Identity();
@@ -37,6 +41,10 @@ CPUTRenderNode::CPUTRenderNode():
 //-----------------------------------------------------------------------------
 CPUTRenderNode::~CPUTRenderNode()
 {
+    if( mOwnsTransforms )
+    {
+        DropTransforms();
+    }
     SAFE_RELEASE(mpParent);
     SAFE_RELEASE(mpChild);
     SAFE_RELEASE(mpSibling);
@@ -62,6 +70,9 @@ int CPUTRenderNode::ReleaseRecursive()
         OutputDebugString( msg.c_str() );
     }
 #endif
+    // The hierarchy's nodes are about to come apart
+    DropTransforms();
+
     // Release the parent.  Note: we don't want to recursively release it, or it would release us = infinite loop.
     SAFE_RELEASE(mpParent);
 
@@ -94,6 +105,7 @@ int CPUTRenderNode::ReleaseRecursive()
 //-----------------------------------------------------------------------------
 void CPUTRenderNode::SetParent(CPUTRenderNode *pParent)
 {
+    DropTransforms();
     SAFE_RELEASE(mpParent);
     if(NULL!=pParent)
     {
@@ -106,6 +118,8 @@ void CPUTRenderNode::SetParent(CPUTRenderNode *pParent)
 void CPUTRenderNode::AddChild(CPUTRenderNode *pNode )
 {
     ASSERT( NULL != pNode, _L("Can't add NULL node.") );
+    DropTransforms();
+    pNode->DropTransforms();
     if( mpChild )
     {
         mpChild->AddSibling( pNode );
@@ -121,6 +135,8 @@ void CPUTRenderNode::AddChild(CPUTRenderNode *pNode )
 void CPUTRenderNode::AddSibling(CPUTRenderNode *pNode )
 {
     ASSERT( NULL != pNode, _L("Can't add NULL node.") );
+    DropTransforms();
+    pNode->DropTransforms();
 
     if( mpSibling )
     {
@@ -137,6 +153,12 @@ void CPUTRenderNode::AddSibling(CPUTRenderNode *pNode )
 //-----------------------------------------------------------------------------
 float4x4* CPUTRenderNode::GetWorldMatrix()
 {
+    if(mpTransforms)
+    {
+        // The hierarchy's matrices are only as aligned as its heap block, less than a float4x4 wants on Win32
+        memcpy(&mWorldMatrix, mpTransforms->GetWorld(mTransformIndex), sizeof(mWorldMatrix));
+        return &mWorldMatrix;
+    }
     if(mWorldMatrixDirty)
     {
         if(NULL!=mpParent)
@@ -155,21 +177,87 @@ float4x4* CPUTRenderNode::GetWorldMatrix()
     return &mWorldMatrix;
 }
 
-// Recursively visit all sub-nodes in breadth-first mode and mark their
-// cumulative transforms as dirty
+// Mark the cumulative transforms of this node and everything under it as dirty.
+// Its siblings don't depend on it, so they stay as they are.
 //-----------------------------------------------------------------------------
 void CPUTRenderNode::MarkDirty()
 {
+    if(mpTransforms)
+    {
+        mpTransforms->SetLocal(mTransformIndex, (const float*)&mParentMatrix);
+        return;
+    }
     mWorldMatrixDirty = true;
 
-    if(mpSibling)
+    for(CPUTRenderNode *pChild = mpChild; pChild; pChild = pChild->mpSibling)
     {
-        mpSibling->MarkDirty();
+        pChild->MarkDirty();
     }
+}
 
-    if(mpChild)
+//-----------------------------------------------------------------------------
+void CPUTRenderNode::FlattenTransforms()
+{
+    ASSERT( NULL == mpParent, _L("Transforms flatten from the root of a tree.") );
+    DropTransforms();
+
+    CPUTTransformHierarchy *pTransforms = new CPUTTransformHierarchy();
+    FlattenSubtree(pTransforms, -1);
+    mOwnsTransforms = true;
+}
+
+// Depth first, so each subtree takes a contiguous range
+//-----------------------------------------------------------------------------
+void CPUTRenderNode::FlattenSubtree(CPUTTransformHierarchy *pTransforms, int parentIndex)
+{
+    // A node flattened on its own before joins this hierarchy instead
+    DropTransforms();
+    mpTransforms    = pTransforms;
+    mTransformIndex = pTransforms->Add(parentIndex, (const float*)&mParentMatrix);
+
+    for(CPUTRenderNode *pChild = mpChild; pChild; pChild = pChild->mpSibling)
+    {
+        // Children with a different parent don't take their transform from this node
+        if( pChild->mpParent == this )
+        {
+            pChild->FlattenSubtree(pTransforms, (int)mTransformIndex);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderNode::DropTransforms()
+{
+    if(!mpTransforms)
+    {
+        return;
+    }
+
+    // Every node in a hierarchy reaches the one that owns it through its parents
+    CPUTTransformHierarchy *pTransforms = mpTransforms;
+    CPUTRenderNode *pOwner = this;
+    while(!pOwner->mOwnsTransforms)
+    {
+        pOwner = pOwner->mpParent;
+    }
+    pOwner->UnbindSubtree(pTransforms);
+    pOwner->mOwnsTransforms = false;
+    delete pTransforms;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTRenderNode::UnbindSubtree(CPUTTransformHierarchy *pTransforms)
+{
+    if(mpTransforms != pTransforms)
+    {
+        return;
+    }
+    mpTransforms      = NULL;
+    mWorldMatrixDirty = true;
+
+    for(CPUTRenderNode *pChild = mpChild; pChild; pChild = pChild->mpSibling)
     {
-        mpChild->MarkDirty();
+        pChild->UnbindSubtree(pTransforms);
     }
 }
 
@@ -20,6 +20,7 @@
 #include "CPUTRefCount.h"
 #include "CPUTMath.h"
 #include "CPUTConfigBlock.h"
+#include "CPUTTransformHierarchy.h"
 
 // forward declarations
 class CPUTCamera;
@@ -35,8 +36,19 @@ protected:
     float4x4            mWorldMatrix; // transform of this object combined with it's parent(s) transform(s)
     float4x4            mParentMatrix;   // transform of this object relative to it's parent
     cString             mPrefix;
+
+    // Set once FlattenTransforms() has moved this node's transforms into a hierarchy: the world
+    // matrix comes from there, at mTransformIndex, and mParentMatrix is copied in when it changes.
+    // The node FlattenTransforms() was called on owns it.
+    CPUTTransformHierarchy *mpTransforms;
+    UINT                    mTransformIndex;
+    bool                    mOwnsTransforms;
+
     ~CPUTRenderNode(); // Destructor is not public.  Must release instead of delete.
 
+    void FlattenSubtree(CPUTTransformHierarchy *pTransforms, int parentIndex);
+    void UnbindSubtree(CPUTTransformHierarchy *pTransforms);
+
 public:
     CPUTRenderNode();
 
@@ -122,7 +134,13 @@ public:
     virtual bool     IsModel()         { return false; }
     float4x4        *GetParentMatrix() { return &mParentMatrix; }
     float4x4        *GetWorldMatrix();
-    void             MarkDirty();
+    virtual void     MarkDirty();
+    // Keeps the transforms of this node and everything under it in one CPUTTransformHierarchy, so
+    // moving a node only dirties its own subtree and the next GetWorldMatrix() brings them all up
+    // to date in one pass.  Reparenting or adding a node anywhere in it hands every node its own
+    // transforms back; call this again after changing the tree.
+    void             FlattenTransforms();
+    void             DropTransforms();
     void             AddChild(CPUTRenderNode *pNode);
     void             AddSibling(CPUTRenderNode *pNode);
     virtual void     Update( float deltaSeconds = 0.0f ){}
@@ -0,0 +1,202 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTStaticBatch.h"
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+//-----------------------------------------------------------------------------
+bool CPUTCanBatchMesh(const CPUTModelFileElement *pElements, uint32_t elementCount, uint32_t vertexStride)
+{
+    bool hasPosition = false;
+    uint32_t offset = 0;
+    for(uint32_t ii=0; ii<elementCount; ii++)
+    {
+        const CPUTModelFileElement &element = pElements[ii];
+        switch(element.vertexElementSemantic)
+        {
+        case CPUT_MODEL_FILE_SEMANTIC_POSITION:
+            if(element.vertexElementType != CPUT_MODEL_FILE_TYPE_FLOAT || element.elementSizeInBytes < 3 * sizeof(float))
+            {
+                return false;
+            }
+            hasPosition = true;
+            break;
+        case CPUT_MODEL_FILE_SEMANTIC_NORMAL:
+        case CPUT_MODEL_FILE_SEMANTIC_TANGENT:
+        case CPUT_MODEL_FILE_SEMANTIC_BINORMAL:
+            if(element.vertexElementType != CPUT_MODEL_FILE_TYPE_FLOAT ||
+               (element.elementSizeInBytes != 3 * sizeof(float) && element.elementSizeInBytes != 4 * sizeof(float)))
+            {
+                return false;
+            }
+            break;
+        default:
+            break;
+        }
+        offset += element.elementSizeInBytes;
+    }
+    return hasPosition && offset <= vertexStride;
+}
+
+// [x y z] * the 3x3 m, renormalized
+//-----------------------------------------------------------------------------
+static void TransformDirection(float pDirection[3], const float m[3][3])
+{
+    float x = pDirection[0], y = pDirection[1], z = pDirection[2];
+    for(int cc=0; cc<3; cc++)
+    {
+        pDirection[cc] = x*m[0][cc] + y*m[1][cc] + z*m[2][cc];
+    }
+    float length = sqrtf(pDirection[0]*pDirection[0] + pDirection[1]*pDirection[1] + pDirection[2]*pDirection[2]);
+    if(length > 0.0f)
+    {
+        for(int cc=0; cc<3; cc++)
+        {
+            pDirection[cc] /= length;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTAppendStaticBatchMesh(const CPUTModelFileElement *pElements, uint32_t elementCount, uint32_t vertexStride,
+                               const void *pVertices, uint32_t vertexCount, const void *pIndices, uint32_t indexCount, bool is16Bit,
+                               const float world[16], std::vector<unsigned char> *pBatchVertices, std::vector<uint32_t> *pBatchIndices,
+                               std::vector<CPUTMeshCluster> *pBatchMeshes)
+{
+    // Directions: the upper 3x3, and its cofactors, which are the inverse transpose times the
+    // determinant.  Dividing by the determinant's sign alone keeps normals on the side they were.
+    float direction[3][3], normal[3][3];
+    for(int rr=0; rr<3; rr++)
+    {
+        for(int cc=0; cc<3; cc++)
+        {
+            direction[rr][cc] = world[rr*4 + cc];
+        }
+    }
+    for(int rr=0; rr<3; rr++)
+    {
+        const float *pA = direction[(rr+1)%3];
+        const float *pB = direction[(rr+2)%3];
+        normal[rr][0] = pA[1]*pB[2] - pA[2]*pB[1];
+        normal[rr][1] = pA[2]*pB[0] - pA[0]*pB[2];
+        normal[rr][2] = pA[0]*pB[1] - pA[1]*pB[0];
+    }
+    float determinant = direction[0][0]*normal[0][0] + direction[0][1]*normal[0][1] + direction[0][2]*normal[0][2];
+    bool mirrors = determinant < 0.0f;
+    if(mirrors)
+    {
+        for(int rr=0; rr<3; rr++)
+        {
+            for(int cc=0; cc<3; cc++)
+            {
+                normal[rr][cc] = -normal[rr][cc];
+            }
+        }
+    }
+
+    size_t   firstByte   = pBatchVertices->size();
+    uint32_t firstVertex = (uint32_t)(firstByte / vertexStride);
+    pBatchVertices->resize(firstByte + (size_t)vertexCount * vertexStride);
+    if(vertexCount)
+    {
+        memcpy(&(*pBatchVertices)[firstByte], pVertices, (size_t)vertexCount * vertexStride);
+    }
+
+    float minimum[3] = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
+    float maximum[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for(uint32_t vv=0; vv<vertexCount; vv++)
+    {
+        unsigned char *pVertex = &(*pBatchVertices)[firstByte + (size_t)vv * vertexStride];
+        bool firstPosition = true;
+        uint32_t offset = 0;
+        for(uint32_t ii=0; ii<elementCount; ii++)
+        {
+            const CPUTModelFileElement &element = pElements[ii];
+            float value[4];
+            memcpy(value, pVertex + offset, element.elementSizeInBytes < sizeof(value) ? element.elementSizeInBytes : sizeof(value));
+            switch(element.vertexElementSemantic)
+            {
+            case CPUT_MODEL_FILE_SEMANTIC_POSITION:
+                {
+                    float x = value[0], y = value[1], z = value[2];
+                    for(int cc=0; cc<3; cc++)
+                    {
+                        value[cc] = x*world[cc] + y*world[4 + cc] + z*world[8 + cc] + world[12 + cc];
+                    }
+                    memcpy(pVertex + offset, value, 3 * sizeof(float));
+                    if(firstPosition)
+                    {
+                        for(int cc=0; cc<3; cc++)
+                        {
+                            minimum[cc] = value[cc] < minimum[cc] ? value[cc] : minimum[cc];
+                            maximum[cc] = value[cc] > maximum[cc] ? value[cc] : maximum[cc];
+                        }
+                        firstPosition = false;
+                    }
+                }
+                break;
+            case CPUT_MODEL_FILE_SEMANTIC_NORMAL:
+                TransformDirection(value, normal);
+                memcpy(pVertex + offset, value, 3 * sizeof(float));
+                break;
+            case CPUT_MODEL_FILE_SEMANTIC_TANGENT:
+            case CPUT_MODEL_FILE_SEMANTIC_BINORMAL:
+                TransformDirection(value, direction);
+                if(mirrors && element.elementSizeInBytes == 4 * sizeof(float))
+                {
+                    value[3] = -value[3];
+                }
+                memcpy(pVertex + offset, value, element.elementSizeInBytes);
+                break;
+            default:
+                break;
+            }
+            offset += element.elementSizeInBytes;
+        }
+    }
+
+    CPUTMeshCluster mesh;
+    memset(&mesh, 0, sizeof(mesh));
+    mesh.indexStart = (uint32_t)pBatchIndices->size();
+    mesh.indexCount = indexCount;
+    for(int cc=0; cc<3; cc++)
+    {
+        mesh.boundsCenter[cc] = vertexCount ? (maximum[cc] + minimum[cc]) * 0.5f : 0.0f;
+        mesh.boundsHalf[cc]   = vertexCount ? (maximum[cc] - minimum[cc]) * 0.5f : 0.0f;
+    }
+    mesh.coneCosine = -1.0f;
+    pBatchMeshes->push_back(mesh);
+
+    pBatchIndices->resize(mesh.indexStart + (size_t)indexCount);
+    const unsigned char *pSrc = (const unsigned char *)pIndices;
+    for(uint32_t ii=0; ii<indexCount; ii++)
+    {
+        // Indices straight out of a model file needn't be aligned
+        uint32_t index;
+        if(is16Bit)
+        {
+            uint16_t narrow;
+            memcpy(&narrow, pSrc + ii * sizeof(uint16_t), sizeof(narrow));
+            index = narrow;
+        }
+        else
+        {
+            memcpy(&index, pSrc + ii * sizeof(uint32_t), sizeof(index));
+        }
+        (*pBatchIndices)[mesh.indexStart + ii] = firstVertex + index;
+    }
+}
@@ -0,0 +1,51 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTSTATICBATCH_H__
+#define __CPUTSTATICBATCH_H__
+
+// Static batches: the meshes of many small models that never move, moved into world space once
+// at load and merged into one vertex and one index buffer, so they draw with one material bind
+// and a few DrawIndexed() calls instead of one round of constant buffer updates and draws each.
+//
+// Every mesh appended to a batch becomes one CPUTMeshCluster of it, bounding that mesh in world
+// space and never backface culled, so a batch still culls its meshes one by one.
+// Only depends on the C++ standard library, so tools built on it also run off Windows.
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "CPUTModelFile.h"
+#include "CPUTMeshClusters.h"
+
+#define CPUT_STATIC_BATCH_MODEL_VERTICES 4096   // models with a bigger mesh than this draw on their own
+#define CPUT_STATIC_BATCH_VERTICES       65535  // per batch, so its indices fit in 16 bits
+
+// Whether meshes with these elements, packed in order into vertexStride bytes, can be moved
+// into world space: float positions of at least three components, and normals, tangents and
+// binormals, if any, of three or four floats.  Everything else is copied as it is.
+bool CPUTCanBatchMesh(const CPUTModelFileElement *pElements, uint32_t elementCount, uint32_t vertexStride);
+
+// Append a mesh, in world space, to a batch of meshes with the same elements.  world is a row
+// major float4x4 taking row vectors to world space, as CPUTRenderNode::GetWorldMatrix() has it.
+// Positions move by it, the first of them bounding the mesh, normals by its inverse transpose,
+// tangents and binormals by its upper 3x3; directions are renormalized, and a tangent's fourth
+// component, its handedness, flips when world mirrors.  Indices are 16-bit when is16Bit, else
+// 32-bit, and come out rebased onto the batch's vertices.
+void CPUTAppendStaticBatchMesh(const CPUTModelFileElement *pElements, uint32_t elementCount, uint32_t vertexStride,
+                               const void *pVertices, uint32_t vertexCount, const void *pIndices, uint32_t indexCount, bool is16Bit,
+                               const float world[16], std::vector<unsigned char> *pBatchVertices, std::vector<uint32_t> *pBatchIndices,
+                               std::vector<CPUTMeshCluster> *pBatchMeshes);
+
+#endif // __CPUTSTATICBATCH_H__
@@ -34,3 +34,23 @@ CPUTTexture *CPUTTexture::CreateTexture( const cString &name, const cString abso
 #endif
     
 }
+
+//--------------------------------------------------------------------------------------
+CPUTTexture *CPUTTexture::CreateTextureAsync( const cString &name, const cString absolutePathAndFilename, bool loadAsSRGB )
+{
+#ifdef CPUT_FOR_DX11
+    return CPUTTextureDX11::CreateTextureAsync( name, absolutePathAndFilename, loadAsSRGB );
+#else    
+    #error You must supply a target graphics API (ex: #define CPUT_FOR_DX11), or implement the target API for this file.
+#endif
+}
+
+//--------------------------------------------------------------------------------------
+CPUTTexture *CPUTTexture::CreateTextureStreaming( const cString &name, const cString absolutePathAndFilename, bool loadAsSRGB )
+{
+#ifdef CPUT_FOR_DX11
+    return CPUTTextureDX11::CreateTextureStreaming( name, absolutePathAndFilename, loadAsSRGB );
+#else    
+    #error You must supply a target graphics API (ex: #define CPUT_FOR_DX11), or implement the target API for this file.
+#endif
+}
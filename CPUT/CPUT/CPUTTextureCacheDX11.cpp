@@ -0,0 +1,275 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTTextureCacheDX11.h"
+#include "CPUTTextureDX11.h"
+#include "CPUTTextureLoaderDX11.h"
+#include "CPUTTextureStreamerDX11.h"
+#include "CPUTAssetLibrary.h"
+
+#include "DDSImage.h"
+#include <algorithm>
+
+CPUTTextureCacheDX11 *CPUTTextureCacheDX11::mpTextureCache = NULL;
+UINT                  CPUTTextureCacheDX11::mFrame = 1; // 0 means never drawn
+
+//-----------------------------------------------------------------------------
+CPUTTextureCacheDX11 *CPUTTextureCacheDX11::GetTextureCache()
+{
+    if(NULL == mpTextureCache)
+    {
+        mpTextureCache = new CPUTTextureCacheDX11();
+    }
+    return mpTextureCache;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTTextureCacheDX11::DeleteTextureCache()
+{
+    delete mpTextureCache;
+    mpTextureCache = NULL;
+}
+
+//-----------------------------------------------------------------------------
+CPUTTextureCacheDX11::CPUTTextureCacheDX11() :
+    mBudgetBytes(0),
+    mResidentBytes(0),
+    mMinIdleFrames(4),
+    mDemoteToTail(true),
+    mHits(0),
+    mMisses(0),
+    mEvictions(0),
+    mDemotions(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+CPUTTextureCacheDX11::~CPUTTextureCacheDX11()
+{
+    for( size_t ii=0; ii<mEntries.size(); ii++ )
+    {
+        SAFE_RELEASE( mEntries[ii].pTexture );
+    }
+    mEntries.clear();
+}
+
+// The same sum as allocateBytes in the sample's Create(), but sized per format with
+// GetSurfaceInfo(), so block compressed and non 32-bit formats come out right.
+//-----------------------------------------------------------------------------
+UINT64 CPUTTextureCacheDX11::ComputeTextureBytes( ID3D11Resource *pResource )
+{
+    if( !pResource )
+    {
+        return 0;
+    }
+    UINT width, height, depth, mipLevels, arraySize;
+    DXGI_FORMAT format;
+
+    D3D11_RESOURCE_DIMENSION dimension;
+    pResource->GetType( &dimension );
+    switch( dimension )
+    {
+    case D3D11_RESOURCE_DIMENSION_TEXTURE1D:
+        {
+            D3D11_TEXTURE1D_DESC desc;
+            ((ID3D11Texture1D*)pResource)->GetDesc( &desc );
+            width = desc.Width; height = 1; depth = 1;
+            mipLevels = desc.MipLevels; arraySize = desc.ArraySize; format = desc.Format;
+        }
+        break;
+    case D3D11_RESOURCE_DIMENSION_TEXTURE2D:
+        {
+            D3D11_TEXTURE2D_DESC desc;
+            ((ID3D11Texture2D*)pResource)->GetDesc( &desc );
+            width = desc.Width; height = desc.Height; depth = 1;
+            mipLevels = desc.MipLevels; arraySize = desc.ArraySize * desc.SampleDesc.Count; format = desc.Format;
+        }
+        break;
+    case D3D11_RESOURCE_DIMENSION_TEXTURE3D:
+        {
+            D3D11_TEXTURE3D_DESC desc;
+            ((ID3D11Texture3D*)pResource)->GetDesc( &desc );
+            width = desc.Width; height = desc.Height; depth = desc.Depth;
+            mipLevels = desc.MipLevels; arraySize = 1; format = desc.Format;
+        }
+        break;
+    default:
+        return 0;
+    }
+
+    UINT64 bytes = 0;
+    for( UINT mip=0; mip<mipLevels; mip++ )
+    {
+        size_t numBytes = 0;
+        DirectX::GetSurfaceInfo( std::max<UINT>( width >> mip, 1 ), std::max<UINT>( height >> mip, 1 ), format, &numBytes, NULL, NULL );
+        bytes += (UINT64)numBytes * std::max<UINT>( depth >> mip, 1 );
+    }
+    return bytes * arraySize;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTTextureCacheDX11::AddTexture( CPUTTexture *pTexture, const cString &absolutePathAndFilename, bool loadAsSRGB )
+{
+    Entry entry;
+    entry.pTexture                = (CPUTTextureDX11*)pTexture;
+    entry.absolutePathAndFilename = absolutePathAndFilename;
+    entry.loadAsSRGB              = loadAsSRGB;
+    entry.residency               = RESIDENCY_RESIDENT;
+    entry.generation              = entry.pTexture->GetGeneration();
+    entry.bytes                   = ComputeTextureBytes( entry.pTexture->GetTextureResource() );
+    entry.pTexture->AddRef();
+    mEntries.push_back( entry );
+    mResidentBytes += entry.bytes;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTTextureCacheDX11::Update()
+{
+    CPUTTextureLoaderDX11   *pLoader   = CPUTTextureLoaderDX11::GetTextureLoader();
+    CPUTTextureStreamerDX11 *pStreamer = CPUTTextureStreamerDX11::GetTextureStreamer();
+
+    // Stop tracking textures that only we (and the streamer, for streamed ones) still hold: the
+    // library and every material let go of them, so they shouldn't live on or count against the budget
+    size_t kept = 0;
+    for( size_t ii=0; ii<mEntries.size(); ii++ )
+    {
+        CPUTTextureDX11 *pTexture = mEntries[ii].pTexture;
+        int refCount = pTexture->GetRefCount();
+        if( refCount == 1 || (refCount == 2 && pStreamer->IsStreaming( pTexture )) )
+        {
+            SAFE_RELEASE( mEntries[ii].pTexture );
+            continue;
+        }
+        if( kept != ii )
+        {
+            mEntries[kept] = mEntries[ii];
+        }
+        kept++;
+    }
+    mEntries.erase( mEntries.begin() + kept, mEntries.end() );
+
+    // Count last frame's uses and bring back what was drawn but isn't resident
+    UINT64 residentBytes = 0;
+    for( size_t ii=0; ii<mEntries.size(); ii++ )
+    {
+        Entry &entry = mEntries[ii];
+        CPUTTextureDX11 *pTexture = entry.pTexture;
+        if( entry.residency == RESIDENCY_LOADING && entry.generation != pTexture->GetGeneration() )
+        {
+            entry.residency = RESIDENCY_RESIDENT; // the loader swapped it in
+        }
+        if( pTexture->GetLastUsedFrame() == mFrame )
+        {
+            switch( entry.residency )
+            {
+            case RESIDENCY_RESIDENT:
+                mHits++;
+                break;
+            case RESIDENCY_EVICTED:
+                mMisses++;
+                pLoader->ReloadTexture( pTexture, entry.absolutePathAndFilename, entry.loadAsSRGB );
+                entry.residency = RESIDENCY_LOADING;
+                break;
+            case RESIDENCY_DEMOTED:
+                mMisses++;
+                pStreamer->RequestMip( pTexture, 0 );
+                entry.residency = RESIDENCY_RESIDENT;
+                break;
+            default:
+                break;
+            }
+        }
+        if( entry.residency != RESIDENCY_EVICTED && entry.residency != RESIDENCY_LOADING && entry.generation != pTexture->GetGeneration() )
+        {
+            entry.generation = pTexture->GetGeneration();
+            entry.bytes      = ComputeTextureBytes( pTexture->GetTextureResource() );
+        }
+        residentBytes += entry.bytes;
+    }
+
+    if( mBudgetBytes && residentBytes > mBudgetBytes )
+    {
+        // Least recently drawn first.  Never drawn means not ours to evict.
+        std::vector<Entry*> candidates;
+        for( size_t ii=0; ii<mEntries.size(); ii++ )
+        {
+            Entry &entry = mEntries[ii];
+            UINT lastUsedFrame = entry.pTexture->GetLastUsedFrame();
+            if( entry.residency == RESIDENCY_RESIDENT && lastUsedFrame != 0 && mFrame - lastUsedFrame >= mMinIdleFrames )
+            {
+                candidates.push_back( &entry );
+            }
+        }
+        std::sort( candidates.begin(), candidates.end(),
+            []( const Entry *pA, const Entry *pB ) { return pA->pTexture->GetLastUsedFrame() < pB->pTexture->GetLastUsedFrame(); } );
+
+        for( size_t ii=0; ii<candidates.size() && residentBytes > mBudgetBytes; ii++ )
+        {
+            Entry &entry = *candidates[ii];
+            CPUTTextureDX11 *pTexture = entry.pTexture;
+            if( pStreamer->IsStreaming( pTexture ) )
+            {
+                // The streamer owns these.  Shrink them to the tail; it's tiny, so never evict.
+                UINT tailMip     = pStreamer->GetTailMip( pTexture );
+                UINT residentMip = pStreamer->GetResidentMip( pTexture );
+                if( !mDemoteToTail || residentMip >= tailMip )
+                {
+                    continue;
+                }
+                pStreamer->RequestMip( pTexture, tailMip );
+                // The streamer drops the levels on its next Update(); until then, estimate
+                // a quarter per level so we don't evict more than needed.
+                UINT64 tailBytes = entry.bytes >> (2 * (tailMip - residentMip));
+                residentBytes -= entry.bytes - tailBytes;
+                entry.residency = RESIDENCY_DEMOTED;
+                mDemotions++;
+            }
+            else
+            {
+                pLoader->BindPlaceholder( pTexture );
+                CPUTAssetLibrary::RebindTexture( pTexture );
+                residentBytes -= entry.bytes;
+                entry.bytes      = 0;
+                entry.generation = pTexture->GetGeneration();
+                entry.residency  = RESIDENCY_EVICTED;
+                mEvictions++;
+            }
+        }
+    }
+
+    mResidentBytes = residentBytes;
+    mFrame++;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTTextureCacheDX11::GetStats( CPUTTextureCacheStats *pStats ) const
+{
+    pStats->hits          = mHits;
+    pStats->misses        = mMisses;
+    pStats->evictions     = mEvictions;
+    pStats->demotions     = mDemotions;
+    pStats->residentBytes = mResidentBytes;
+    pStats->budgetBytes   = mBudgetBytes;
+    pStats->textureCount  = (UINT)mEntries.size();
+}
+
+//-----------------------------------------------------------------------------
+void CPUTTextureCacheDX11::ResetCounters()
+{
+    mHits      = 0;
+    mMisses    = 0;
+    mEvictions = 0;
+    mDemotions = 0;
+}
@@ -0,0 +1,118 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTTEXTURECACHEDX11_H__
+#define __CPUTTEXTURECACHEDX11_H__
+
+// Texture residency under a GPU memory budget.
+//
+// Every texture loaded from a file is registered here with its size.  Materials stamp their
+// textures with the current frame number when they bind them, and Update() (called once per
+// frame by CPUT_DX11, before rendering) uses those stamps as the LRU order: while the total is
+// over budget, the textures used longest ago are demoted to their mip tail (streamed textures,
+// see CPUTTextureStreamerDX11) or evicted, i.e. pointed at the loader's 1x1 placeholder with
+// their own resources released.  The texture objects themselves stay in the asset library, so
+// materials keep working; a texture that gets drawn again is reloaded in the background.  Once
+// the library and the materials release a texture, Update() drops it and its reference too.
+//
+// Textures that have never been drawn through a material (GUI atlases, fonts, textures the
+// application binds itself) are never evicted.
+#include "CPUT.h"
+#include <d3d11.h>
+#include <vector>
+
+class CPUTTexture;
+class CPUTTextureDX11;
+
+struct CPUTTextureCacheStats
+{
+    UINT64 hits;          // resident textures drawn, counted once per texture per frame
+    UINT64 misses;        // evicted or demoted textures that were drawn and had to be reloaded
+    UINT64 evictions;
+    UINT64 demotions;
+    UINT64 residentBytes;
+    UINT64 budgetBytes;
+    UINT   textureCount;
+};
+
+class CPUTTextureCacheDX11
+{
+public:
+    static CPUTTextureCacheDX11 *GetTextureCache();
+    static void                  DeleteTextureCache();
+
+    // The stamp materials put on the textures they bind
+    static UINT GetFrame() { return mFrame; }
+
+    // Start tracking a texture that can be reloaded from absolutePathAndFilename
+    void AddTexture( CPUTTexture *pTexture, const cString &absolutePathAndFilename, bool loadAsSRGB );
+
+    // Count last frame's uses, reload the evicted textures among them and evict down to the budget.
+    // Must be called on the device thread.
+    void Update();
+
+    // Bytes of texture memory to aim for.  0 (the default) means no limit; only the counters run.
+    void   SetBudget( UINT64 budgetBytes )         { mBudgetBytes = budgetBytes; }
+    UINT64 GetBudget() const                       { return mBudgetBytes; }
+    // Textures drawn within this many frames are never evicted
+    void   SetMinIdleFrames( UINT minIdleFrames )  { mMinIdleFrames = minIdleFrames; }
+    // Shrink streamed textures to their mip tail instead of evicting them
+    void   SetDemoteToTail( bool demoteToTail )    { mDemoteToTail = demoteToTail; }
+
+    void GetStats( CPUTTextureCacheStats *pStats ) const;
+    void ResetCounters();
+
+    // Memory held by a texture: every mip of every array slice, sized per format
+    static UINT64 ComputeTextureBytes( ID3D11Resource *pResource );
+
+private:
+    enum eResidency
+    {
+        RESIDENCY_RESIDENT,
+        RESIDENCY_LOADING,  // reload in flight
+        RESIDENCY_DEMOTED,
+        RESIDENCY_EVICTED,
+    };
+    struct Entry
+    {
+        CPUTTextureDX11 *pTexture;
+        cString          absolutePathAndFilename;
+        bool             loadAsSRGB;
+        eResidency       residency;
+        UINT             generation; // of pTexture when bytes was computed
+        UINT64           bytes;
+    };
+
+    CPUTTextureCacheDX11();
+    ~CPUTTextureCacheDX11();
+
+    static CPUTTextureCacheDX11 *mpTextureCache;
+    static UINT                  mFrame;
+
+    std::vector<Entry> mEntries;
+    UINT64             mBudgetBytes;
+    UINT64             mResidentBytes;
+    UINT               mMinIdleFrames;
+    bool               mDemoteToTail;
+    UINT64             mHits;
+    UINT64             mMisses;
+    UINT64             mEvictions;
+    UINT64             mDemotions;
+
+    CPUTTextureCacheDX11(const CPUTTextureCacheDX11 &);
+    CPUTTextureCacheDX11 &operator=(const CPUTTextureCacheDX11 &);
+};
+
+#endif // __CPUTTEXTURECACHEDX11_H__
@@ -15,8 +15,13 @@
 /////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "CPUTTextureDX11.h"
+#include "CPUTTextureLoaderDX11.h"
+#include "CPUTTextureCacheDX11.h"
+#include "CPUTTextureStreamerDX11.h"
+#include "CPUTMappedFile.h"
 
 #include "DDSTextureLoader.h"
+#include "DDSImageCache.h"
 
 // TODO: Would be nice to find a better place for this decl.  But, not another file just for this.
 const cString gDXGIFormatNames[] =
@@ -141,10 +146,25 @@ CPUTTexture *CPUTTextureDX11::CreateTexture( const cString &name, const cString
     pShaderResourceView->Release();
 
     CPUTAssetLibrary::GetAssetLibrary()->AddTexture( absolutePathAndFilename, pNewTexture);
+    CPUTTextureCacheDX11::GetTextureCache()->AddTexture( pNewTexture, absolutePathAndFilename, loadAsSRGB );
 
     return pNewTexture;
 }
 
+// Returns immediately with a placeholder.  See CPUTTextureLoaderDX11.
+//-----------------------------------------------------------------------------
+CPUTTexture *CPUTTextureDX11::CreateTextureAsync( const cString &name, const cString &absolutePathAndFilename, bool loadAsSRGB )
+{
+    return CPUTTextureLoaderDX11::GetTextureLoader()->LoadTexture( name, absolutePathAndFilename, loadAsSRGB );
+}
+
+// Returns the mip tail now and refines it over the following frames.  See CPUTTextureStreamerDX11.
+//-----------------------------------------------------------------------------
+CPUTTexture *CPUTTextureDX11::CreateTextureStreaming( const cString &name, const cString &absolutePathAndFilename, bool loadAsSRGB )
+{
+    return CPUTTextureStreamerDX11::GetTextureStreamer()->StreamTexture( name, absolutePathAndFilename, loadAsSRGB );
+}
+
 //-----------------------------------------------------------------------------
 CPUTResult CPUTTextureDX11::CreateNativeTexture(
     ID3D11Device *pD3dDevice,
@@ -155,6 +175,65 @@ CPUTResult CPUTTextureDX11::CreateNativeTexture(
 {
     HRESULT hr;
 
+    // Archived textures are created straight from the archive's mapping
+    CPUTArchiveData archived;
+    if(CPUTOSServices::GetOSServices()->ReadArchivedFile(fileName, &archived))
+    {
+        hr = DirectX::CreateDDSTextureFromMemoryEx(
+            pD3dDevice,
+            archived.pData,
+            archived.size,
+            0,//maxsize
+            D3D11_USAGE_DEFAULT,
+            D3D11_BIND_SHADER_RESOURCE,
+            0,
+            0,
+            ForceLoadAsSRGB,
+            ppTexture,
+            ppShaderResourceView);
+        if(FAILED(hr))
+        {
+            return CPUT_TEXTURE_LOAD_ERROR;
+        }
+        CPUTSetDebugName( *ppTexture, fileName );
+        CPUTSetDebugName( *ppShaderResourceView, fileName );
+        return CPUT_SUCCESS;
+    }
+
+    // With the metadata cache, map the file and let the cache skip parsing it
+    if(CPUTAssetLibrary::GetAssetLibrary()->GetCacheTextureMetadata())
+    {
+        CPUTMappedFile file;
+        DirectX::DDSCachedImage image;
+        if(!file.Open(fileName.c_str()))
+        {
+            return CPUT_ERROR_TEXTURE_FILE_NOT_FOUND;
+        }
+        if(DirectX::DDS_OK != DirectX::ParseDDSImageCached(fileName.c_str(), file.GetData(), file.GetSize(), &image))
+        {
+            return CPUT_ERROR_UNSUPPORTED_IMAGE_FORMAT;
+        }
+        hr = DirectX::CreateDDSTextureFromCachedImage(
+            pD3dDevice,
+            image,
+            file.GetData(),
+            0,//maxsize
+            D3D11_USAGE_DEFAULT,
+            D3D11_BIND_SHADER_RESOURCE,
+            0,
+            0,
+            ForceLoadAsSRGB,
+            ppTexture,
+            ppShaderResourceView);
+        if(FAILED(hr))
+        {
+            return CPUT_TEXTURE_LOAD_ERROR;
+        }
+        CPUTSetDebugName( *ppTexture, fileName );
+        CPUTSetDebugName( *ppShaderResourceView, fileName );
+        return CPUT_SUCCESS;
+    }
+
 	hr = DirectX::CreateDDSTextureFromFileEx(
 		pD3dDevice,
 		fileName.c_str(),
@@ -28,6 +28,8 @@ private:
     ID3D11ShaderResourceView *mpShaderResourceView;
     ID3D11Resource           *mpTexture;
     ID3D11Resource           *mpTextureStaging;
+    UINT                      mLastUsedFrame; // see CPUTTextureCacheDX11
+    UINT                      mGeneration;    // bumped whenever the resources change
 
     // Destructor is not public.  Must release instead of delete.
     ~CPUTTextureDX11() {
@@ -42,6 +44,8 @@ public:
     static CPUTResult     GetSRGBEquivalent(DXGI_FORMAT inFormat, DXGI_FORMAT& sRGBFormat) {return CPUT_SUCCESS;};;
 	static bool           DoesExistEquivalentSRGBFormat(DXGI_FORMAT inFormat) {return true;};
 	static CPUTTexture   *CreateTexture( const cString &name, const cString &absolutePathAndFilename, bool loadAsSRGB );
+    static CPUTTexture   *CreateTextureAsync( const cString &name, const cString &absolutePathAndFilename, bool loadAsSRGB );
+    static CPUTTexture   *CreateTextureStreaming( const cString &name, const cString &absolutePathAndFilename, bool loadAsSRGB );
     static CPUTResult     CreateNativeTexture(
                               ID3D11Device *pD3dDevice,
                               const cString &fileName,
@@ -53,16 +57,22 @@ public:
     CPUTTextureDX11() :
         mpShaderResourceView(NULL),
         mpTexture(NULL),
-        mpTextureStaging(NULL)
+        mpTextureStaging(NULL),
+        mLastUsedFrame(0),
+        mGeneration(0)
     {}
     CPUTTextureDX11(cString &name) :
         mpShaderResourceView(NULL),
         mpTexture(NULL),
         mpTextureStaging(NULL),
+        mLastUsedFrame(0),
+        mGeneration(0),
         CPUTTexture(name)
     {}
     CPUTTextureDX11(cString &name, ID3D11Resource *pTextureResource, ID3D11ShaderResourceView *pSrv ) :
         mpTextureStaging(NULL),
+        mLastUsedFrame(0),
+        mGeneration(0),
         CPUTTexture(name)
     {
         mpShaderResourceView = pSrv;
@@ -75,6 +85,7 @@ public:
     {
         SAFE_RELEASE(mpShaderResourceView);
         SAFE_RELEASE(mpTexture);
+        mGeneration++;
     }
     void SetTexture(ID3D11Resource *pTextureResource, ID3D11ShaderResourceView *pSrv )
     {
@@ -83,6 +94,7 @@ public:
 
         mpTexture = pTextureResource;
         if(mpTexture) mpTexture->AddRef();
+        mGeneration++;
     }
 
     ID3D11ShaderResourceView* GetShaderResourceView()
@@ -100,7 +112,13 @@ public:
         if( mpTexture ) mpTexture->AddRef();
         mpShaderResourceView = pShaderResourceView;
         mpShaderResourceView->AddRef();
+        mGeneration++;
     }
+
+    ID3D11Resource *GetTextureResource() { return mpTexture; }
+    UINT GetGeneration() const           { return mGeneration; }
+    UINT GetLastUsedFrame() const        { return mLastUsedFrame; }
+    void SetLastUsedFrame( UINT frame )  { mLastUsedFrame = frame; }
 	D3D11_MAPPED_SUBRESOURCE  MapTexture(   CPUTRenderParameters &params, eCPUTMapType type, bool wait=true );
 	void                      UnmapTexture( CPUTRenderParameters &params );
 };
@@ -0,0 +1,341 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTTextureLoaderDX11.h"
+#include "CPUTTextureDX11.h"
+#include "CPUTAssetLibrary.h"
+#include "CPUTMappedFile.h"
+#include "CPUTWorkerPool.h"
+#include "CPUTTextureCacheDX11.h"
+
+#include "DDSImageCache.h"
+#include "DDSTextureLoader.h"
+
+// One request, owned by the loader.  The worker only touches the file and the parsed image;
+// the texture's reference count isn't thread safe, so it's only used on the device thread.
+struct CPUTPendingTextureDX11
+{
+    CPUTTextureDX11                      *pTexture;
+    cString                               absolutePathAndFilename;
+    bool                                  loadAsSRGB;
+    bool                                  isReload;
+    CPUTTextureLoaderDX11::LoadedCallback pCallback;
+    void                                 *pUserData;
+    CPUTMappedFile                        file;
+    CPUTArchiveData                       archived; // instead of file, when the texture is in a mounted archive
+    const unsigned char                  *pData;    // whichever of the two holds the .dds
+    size_t                                dataSize;
+    DirectX::DDSCachedImage               image;
+    CPUTResult                            result;
+};
+
+CPUTTextureLoaderDX11 *CPUTTextureLoaderDX11::mpTextureLoader = NULL;
+
+//-----------------------------------------------------------------------------
+CPUTTextureLoaderDX11 *CPUTTextureLoaderDX11::GetTextureLoader()
+{
+    if(NULL == mpTextureLoader)
+    {
+        mpTextureLoader = new CPUTTextureLoaderDX11();
+    }
+    return mpTextureLoader;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTTextureLoaderDX11::DeleteTextureLoader()
+{
+    delete mpTextureLoader;
+    mpTextureLoader = NULL;
+}
+
+//-----------------------------------------------------------------------------
+CPUTTextureLoaderDX11::CPUTTextureLoaderDX11() :
+    mpPlaceholderTexture(NULL),
+    mpPlaceholderView(NULL),
+    mTexturesPerFrame(4),
+    mReading(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+CPUTTextureLoaderDX11::~CPUTTextureLoaderDX11()
+{
+    // The workers hold a pointer to us; wait for them before dropping what's left
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        while( mReading )
+        {
+            mReadComplete.wait(lock);
+        }
+    }
+    for( size_t ii=0; ii<mCompleted.size(); ii++ )
+    {
+        SAFE_RELEASE( mCompleted[ii]->pTexture );
+        delete mCompleted[ii];
+    }
+    mCompleted.clear();
+    SAFE_RELEASE( mpPlaceholderView );
+    SAFE_RELEASE( mpPlaceholderTexture );
+}
+
+// Opaque white, so lit and tinted surfaces look plausible until the real texture arrives
+//-----------------------------------------------------------------------------
+CPUTResult CPUTTextureLoaderDX11::CreatePlaceholder()
+{
+    static const UINT white = 0xffffffff;
+
+    D3D11_TEXTURE2D_DESC desc;
+    memset( &desc, 0, sizeof(desc) );
+    desc.Width            = 1;
+    desc.Height           = 1;
+    desc.MipLevels        = 1;
+    desc.ArraySize        = 1;
+    desc.Format           = DXGI_FORMAT_R8G8B8A8_UNORM;
+    desc.SampleDesc.Count = 1;
+    desc.Usage            = D3D11_USAGE_IMMUTABLE;
+    desc.BindFlags        = D3D11_BIND_SHADER_RESOURCE;
+
+    D3D11_SUBRESOURCE_DATA initData = { &white, sizeof(white), sizeof(white) };
+
+    ID3D11Device *pD3dDevice = CPUT_DX11::GetDevice();
+    ID3D11Texture2D *pTexture = NULL;
+    HRESULT hr = pD3dDevice->CreateTexture2D( &desc, &initData, &pTexture );
+    if( FAILED(hr) )
+    {
+        return CPUT_TEXTURE_LOAD_ERROR;
+    }
+    hr = pD3dDevice->CreateShaderResourceView( pTexture, NULL, &mpPlaceholderView );
+    if( FAILED(hr) )
+    {
+        SAFE_RELEASE( pTexture );
+        return CPUT_TEXTURE_LOAD_ERROR;
+    }
+    mpPlaceholderTexture = pTexture;
+    CPUTSetDebugName( mpPlaceholderTexture, _L("Texture loader placeholder") );
+    CPUTSetDebugName( mpPlaceholderView, _L("Texture loader placeholder") );
+    return CPUT_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+CPUTTexture *CPUTTextureLoaderDX11::LoadTexture( const cString &name, const cString &absolutePathAndFilename, bool loadAsSRGB, LoadedCallback pCallback, void *pUserData )
+{
+    if( NULL == mpPlaceholderView )
+    {
+        CPUTResult result = CreatePlaceholder();
+        ASSERT( CPUTSUCCESS(result), _L("Error creating the placeholder texture") );
+        UNREFERENCED_PARAMETER(result);
+    }
+
+    cString textureName = name;
+    CPUTTextureDX11 *pNewTexture = new CPUTTextureDX11( textureName, mpPlaceholderTexture, mpPlaceholderView );
+    CPUTAssetLibrary::GetAssetLibrary()->AddTexture( absolutePathAndFilename, pNewTexture );
+
+    QueueRead( pNewTexture, absolutePathAndFilename, loadAsSRGB, false, pCallback, pUserData );
+    return pNewTexture;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTTextureLoaderDX11::ReloadTexture( CPUTTexture *pTexture, const cString &absolutePathAndFilename, bool loadAsSRGB, LoadedCallback pCallback, void *pUserData )
+{
+    QueueRead( pTexture, absolutePathAndFilename, loadAsSRGB, true, pCallback, pUserData );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTTextureLoaderDX11::QueueRead( CPUTTexture *pTexture, const cString &absolutePathAndFilename, bool loadAsSRGB, bool isReload, LoadedCallback pCallback, void *pUserData )
+{
+    CPUTPendingTextureDX11 *pPending = new CPUTPendingTextureDX11();
+    pPending->pTexture                = (CPUTTextureDX11*)pTexture;
+    pPending->pTexture->AddRef(); // Held until swapped in
+    pPending->absolutePathAndFilename = absolutePathAndFilename;
+    pPending->loadAsSRGB              = loadAsSRGB;
+    pPending->isReload                = isReload;
+    pPending->pCallback               = pCallback;
+    pPending->pUserData               = pUserData;
+    pPending->pData                   = NULL;
+    pPending->dataSize                = 0;
+    pPending->result                  = CPUT_SUCCESS;
+
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mReading++;
+    }
+    CPUTWorkerPool::GetWorkerPool()->Submit( [this, pPending]() { ReadAndParse( pPending ); } );
+}
+
+//-----------------------------------------------------------------------------
+void CPUTTextureLoaderDX11::BindPlaceholder( CPUTTexture *pTexture )
+{
+    if( NULL == mpPlaceholderView )
+    {
+        CPUTResult result = CreatePlaceholder();
+        ASSERT( CPUTSUCCESS(result), _L("Error creating the placeholder texture") );
+        UNREFERENCED_PARAMETER(result);
+    }
+    ((CPUTTextureDX11*)pTexture)->SetTextureAndShaderResourceView( mpPlaceholderTexture, mpPlaceholderView );
+}
+
+// Runs on a worker
+//-----------------------------------------------------------------------------
+void CPUTTextureLoaderDX11::ReadAndParse( CPUTPendingTextureDX11 *pPending )
+{
+    // Only loose files have a metadata cache next to them
+    const wchar_t *pCacheKeyFileName = NULL;
+    if( CPUTOSServices::GetOSServices()->ReadArchivedFile( pPending->absolutePathAndFilename, &pPending->archived ) )
+    {
+        pPending->pData    = pPending->archived.pData;
+        pPending->dataSize = pPending->archived.size;
+    }
+    else if( pPending->file.Open( pPending->absolutePathAndFilename.c_str() ) )
+    {
+        pPending->file.WillNeed();
+        pPending->pData    = pPending->file.GetData();
+        pPending->dataSize = pPending->file.GetSize();
+        if( CPUTAssetLibrary::GetAssetLibrary()->GetCacheTextureMetadata() )
+        {
+            pCacheKeyFileName = pPending->absolutePathAndFilename.c_str();
+        }
+    }
+
+    if( NULL == pPending->pData )
+    {
+        pPending->result = CPUT_ERROR_TEXTURE_FILE_NOT_FOUND;
+    }
+    else if( DirectX::DDS_OK != DirectX::ParseDDSImageCached( pCacheKeyFileName, pPending->pData, pPending->dataSize, &pPending->image ) )
+    {
+        pPending->result = CPUT_ERROR_UNSUPPORTED_IMAGE_FORMAT;
+        pPending->file.Close();
+        pPending->archived = CPUTArchiveData();
+    }
+    else
+    {
+        // Fault the whole file in here, so creating the texture on the device thread
+        // never waits on the disk.
+        const volatile unsigned char *pData = pPending->pData;
+        unsigned char touch = 0;
+        for( size_t offset = 0; offset < pPending->dataSize; offset += 4096 )
+        {
+            touch ^= pData[offset];
+        }
+        UNREFERENCED_PARAMETER(touch);
+    }
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCompleted.push_back( pPending );
+    mReading--;
+    mReadComplete.notify_all();
+}
+
+//-----------------------------------------------------------------------------
+UINT CPUTTextureLoaderDX11::ProcessCompletedTextures( UINT maxTextures )
+{
+    std::vector<CPUTPendingTextureDX11*> batch;
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        size_t count = mCompleted.size();
+        if( maxTextures && count > maxTextures )
+        {
+            count = maxTextures;
+        }
+        batch.assign( mCompleted.begin(), mCompleted.begin() + count );
+        mCompleted.erase( mCompleted.begin(), mCompleted.begin() + count );
+    }
+    if( batch.empty() )
+    {
+        return 0;
+    }
+
+    ID3D11Device *pD3dDevice = CPUT_DX11::GetDevice();
+    for( size_t ii=0; ii<batch.size(); ii++ )
+    {
+        CPUTPendingTextureDX11 *pPending = batch[ii];
+        if( CPUTSUCCESS(pPending->result) )
+        {
+            ID3D11Resource *pTexture = NULL;
+            ID3D11ShaderResourceView *pShaderResourceView = NULL;
+            HRESULT hr = DirectX::CreateDDSTextureFromCachedImage(
+                pD3dDevice,
+                pPending->image,
+                pPending->pData,
+                0, // maxsize
+                D3D11_USAGE_DEFAULT,
+                D3D11_BIND_SHADER_RESOURCE,
+                0,
+                0,
+                pPending->loadAsSRGB,
+                &pTexture,
+                &pShaderResourceView );
+            if( SUCCEEDED(hr) )
+            {
+                CPUTSetDebugName( pTexture, pPending->absolutePathAndFilename );
+                CPUTSetDebugName( pShaderResourceView, pPending->absolutePathAndFilename );
+                pPending->pTexture->SetTextureAndShaderResourceView( pTexture, pShaderResourceView );
+                pTexture->Release();
+                pShaderResourceView->Release();
+                // Materials hold their own references to the views they bind; swap only this texture's
+                CPUTAssetLibrary::RebindTexture( pPending->pTexture );
+                if( !pPending->isReload )
+                {
+                    // Only now is there something to count or evict
+                    CPUTTextureCacheDX11::GetTextureCache()->AddTexture( pPending->pTexture, pPending->absolutePathAndFilename, pPending->loadAsSRGB );
+                }
+            }
+            else
+            {
+                pPending->result = CPUT_TEXTURE_LOAD_ERROR;
+            }
+        }
+        ASSERT( CPUTSUCCESS(pPending->result), _L("Error loading texture: '")+pPending->absolutePathAndFilename );
+        pPending->file.Close();
+        pPending->archived = CPUTArchiveData();
+    }
+
+    for( size_t ii=0; ii<batch.size(); ii++ )
+    {
+        CPUTPendingTextureDX11 *pPending = batch[ii];
+        if( pPending->pCallback )
+        {
+            pPending->pCallback( pPending->pTexture, pPending->result, pPending->pUserData );
+        }
+        SAFE_RELEASE( pPending->pTexture );
+        delete pPending;
+    }
+    return (UINT)batch.size();
+}
+
+//-----------------------------------------------------------------------------
+void CPUTTextureLoaderDX11::Flush()
+{
+    for(;;)
+    {
+        ProcessCompletedTextures();
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        if( !mReading && mCompleted.empty() )
+        {
+            return;
+        }
+        while( mReading && mCompleted.empty() )
+        {
+            mReadComplete.wait(lock);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+UINT CPUTTextureLoaderDX11::GetPendingCount()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    return mReading + (UINT)mCompleted.size();
+}
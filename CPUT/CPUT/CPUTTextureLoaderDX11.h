@@ -0,0 +1,93 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTTEXTURELOADERDX11_H__
+#define __CPUTTEXTURELOADERDX11_H__
+
+// Asynchronous texture loading.  LoadTexture() hands back a texture immediately, bound to a
+// 1x1 placeholder.  A worker from CPUTWorkerPool maps the .dds file (or finds it in a mounted
+// archive), faults it in and parses the headers; the device objects are then created in
+// batches on the thread that owns the device (ProcessCompletedTextures(), called once per
+// frame by CPUT_DX11) and swapped into the texture in place, so materials that already hold
+// it pick up the real view when it's rebound.
+#include "CPUT.h"
+#include <d3d11.h>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+
+class CPUTTexture;
+class CPUTTextureDX11;
+struct CPUTPendingTextureDX11;
+
+class CPUTTextureLoaderDX11
+{
+public:
+    // Called on the device thread once the texture has been swapped in, or failed to load
+    // (in which case it keeps the placeholder).
+    typedef void (*LoadedCallback)(CPUTTexture *pTexture, CPUTResult result, void *pUserData);
+
+    static CPUTTextureLoaderDX11 *GetTextureLoader();
+    static void                   DeleteTextureLoader();
+
+    // Returns a new texture, already added to the asset library under absolutePathAndFilename.
+    // Must be called on the device thread.
+    CPUTTexture *LoadTexture( const cString &name, const cString &absolutePathAndFilename, bool loadAsSRGB, LoadedCallback pCallback=NULL, void *pUserData=NULL );
+
+    // Read the file again for a texture that already exists, e.g. one the residency cache evicted.
+    // It keeps whatever it's bound to until the new resources are swapped in.
+    void ReloadTexture( CPUTTexture *pTexture, const cString &absolutePathAndFilename, bool loadAsSRGB, LoadedCallback pCallback=NULL, void *pUserData=NULL );
+
+    // Point pTexture at the 1x1 placeholder, dropping its own resources.  The caller rebinds materials.
+    void BindPlaceholder( CPUTTexture *pTexture );
+
+    // Create the device objects for up to maxTextures finished reads (0 for all of them) and swap
+    // them in.  Only the materials' bind points for those textures are rebound.  Returns the number
+    // of textures swapped in.
+    UINT ProcessCompletedTextures( UINT maxTextures=0 );
+
+    // Fence: block until every texture requested so far has been swapped in
+    void Flush();
+
+    // Requests not yet swapped in, including the ones still being read
+    UINT GetPendingCount();
+
+    // How many textures ProcessCompletedTextures() swaps in when CPUT_DX11 calls it each frame
+    void SetTexturesPerFrame( UINT texturesPerFrame ) { mTexturesPerFrame = texturesPerFrame; }
+    UINT GetTexturesPerFrame() const { return mTexturesPerFrame; }
+
+private:
+    CPUTTextureLoaderDX11();
+    ~CPUTTextureLoaderDX11();
+
+    CPUTResult CreatePlaceholder();
+    void       QueueRead( CPUTTexture *pTexture, const cString &absolutePathAndFilename, bool loadAsSRGB, bool isReload, LoadedCallback pCallback, void *pUserData );
+    void       ReadAndParse( CPUTPendingTextureDX11 *pPending );
+
+    static CPUTTextureLoaderDX11 *mpTextureLoader;
+
+    ID3D11Resource                       *mpPlaceholderTexture;
+    ID3D11ShaderResourceView             *mpPlaceholderView;
+    UINT                                  mTexturesPerFrame;
+    UINT                                  mReading;   // submitted to the pool and not back yet
+    std::vector<CPUTPendingTextureDX11*>  mCompleted; // read and parsed, waiting for the device
+    std::mutex                            mMutex;
+    std::condition_variable               mReadComplete;
+
+    CPUTTextureLoaderDX11(const CPUTTextureLoaderDX11 &);
+    CPUTTextureLoaderDX11 &operator=(const CPUTTextureLoaderDX11 &);
+};
+
+#endif // __CPUTTEXTURELOADERDX11_H__
@@ -0,0 +1,490 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTTextureStreamerDX11.h"
+#include "CPUTTextureDX11.h"
+#include "CPUTAssetLibrary.h"
+#include "CPUTFileReader.h"
+#include "CPUTWorkerPool.h"
+#include "CPUTTextureCacheDX11.h"
+
+#include "DDSImage.h"
+#include <algorithm>
+
+// One streamed texture.  Only the device thread changes the resident range; while a read is in
+// flight the worker fills readData and nothing else.
+struct CPUTStreamingTextureDX11
+{
+    CPUTTextureDX11            *pTexture;
+    cString                     absolutePathAndFilename;
+    CPUTFileReader              file;
+    DirectX::DDSImage           image;
+    DXGI_FORMAT                 format;
+    ID3D11Texture2D            *pResource;     // holds mips [residentMip, mipCount)
+    UINT                        residentMip;
+    UINT                        tailMip;       // what StreamTexture() loaded
+    UINT                        requestedMip;
+    float                       priority;
+    UINT64                      residentBytes;
+
+    bool                        reading;
+    bool                        readSucceeded;
+    UINT                        readTopMip;    // the read covers [readTopMip, residentMip)
+    std::vector<unsigned char>  readData;      // per array item, back to back
+};
+
+CPUTTextureStreamerDX11 *CPUTTextureStreamerDX11::mpTextureStreamer = NULL;
+
+// Offset of a mip within an array item.  mipCount is the end of the item.
+//-----------------------------------------------------------------------------
+static size_t MipStart( const DirectX::DDSImage &image, UINT mip )
+{
+    return mip < image.mipCount ? image.mipOffset[mip] : image.itemBytes;
+}
+
+//-----------------------------------------------------------------------------
+static bool IsBlockCompressed( DXGI_FORMAT format )
+{
+    return (format >= DXGI_FORMAT_BC1_TYPELESS && format <= DXGI_FORMAT_BC5_SNORM) ||
+           (format >= DXGI_FORMAT_BC6H_TYPELESS && format <= DXGI_FORMAT_BC7_UNORM_SRGB);
+}
+
+//-----------------------------------------------------------------------------
+CPUTTextureStreamerDX11 *CPUTTextureStreamerDX11::GetTextureStreamer()
+{
+    if(NULL == mpTextureStreamer)
+    {
+        mpTextureStreamer = new CPUTTextureStreamerDX11();
+    }
+    return mpTextureStreamer;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTTextureStreamerDX11::DeleteTextureStreamer()
+{
+    delete mpTextureStreamer;
+    mpTextureStreamer = NULL;
+}
+
+//-----------------------------------------------------------------------------
+CPUTTextureStreamerDX11::CPUTTextureStreamerDX11() :
+    mReadsInFlight(0),
+    mTailBytes(64*1024),
+    mUploadBytesPerFrame(4*1024*1024),
+    mMaxReadsInFlight(4),
+    mResidentBytes(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+CPUTTextureStreamerDX11::~CPUTTextureStreamerDX11()
+{
+    // The workers hold pointers to our streams; wait for them before deleting anything
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        while( mReadsInFlight )
+        {
+            mReadComplete.wait(lock);
+        }
+    }
+    for( size_t ii=0; ii<mStreams.size(); ii++ )
+    {
+        SAFE_RELEASE( mStreams[ii]->pResource );
+        SAFE_RELEASE( mStreams[ii]->pTexture );
+        delete mStreams[ii];
+    }
+    mStreams.clear();
+    mStreamMap.clear();
+    mCompleted.clear();
+}
+
+// D3D11 needs the top level of a block compressed texture to be a whole number of blocks.
+// Mip 0 is whatever the file says; the loader would fail on it just the same.
+//-----------------------------------------------------------------------------
+bool CPUTTextureStreamerDX11::IsValidTopMip( const CPUTStreamingTextureDX11 *pStream, UINT mip ) const
+{
+    if( mip == 0 || !IsBlockCompressed( pStream->format ) )
+    {
+        return true;
+    }
+    return ((pStream->image.width >> mip) % 4) == 0 && ((pStream->image.height >> mip) % 4) == 0;
+}
+
+// The next level(s) to read: one level up, or more when the level above can't be a top mip
+//-----------------------------------------------------------------------------
+UINT CPUTTextureStreamerDX11::NextMipToRead( const CPUTStreamingTextureDX11 *pStream ) const
+{
+    UINT mip = pStream->residentMip - 1;
+    while( mip > 0 && !IsValidTopMip( pStream, mip ) )
+    {
+        mip--;
+    }
+    return mip;
+}
+
+//-----------------------------------------------------------------------------
+CPUTTexture *CPUTTextureStreamerDX11::StreamTexture( const cString &name, const cString &absolutePathAndFilename, bool loadAsSRGB )
+{
+    CPUTStreamingTextureDX11 *pStream = new CPUTStreamingTextureDX11();
+    pStream->pTexture                = NULL;
+    pStream->absolutePathAndFilename = absolutePathAndFilename;
+    pStream->pResource               = NULL;
+    pStream->residentMip             = 0;
+    pStream->tailMip                 = 0;
+    pStream->requestedMip            = 0;
+    pStream->priority                = 0.0f;
+    pStream->residentBytes           = 0;
+    pStream->reading                 = false;
+    pStream->readSucceeded           = false;
+    pStream->readTopMip              = 0;
+
+    // Only the headers, to find out where every mip lives.  Textures in a mounted archive
+    // are already mapped, so they're loaded whole.
+    unsigned char header[DDS_MAX_HEADER_SIZE];
+    bool canStream = !CPUTOSServices::GetOSServices()->IsFileArchived( absolutePathAndFilename ) &&
+                     pStream->file.Open( absolutePathAndFilename.c_str() ) && pStream->file.GetSize() <= (size_t)-1;
+    if( canStream )
+    {
+        size_t headerSize = (size_t)std::min<UINT64>( pStream->file.GetSize(), sizeof(header) );
+        canStream = pStream->file.ReadAt( 0, header, headerSize ) &&
+                    DirectX::DDS_OK == DirectX::ParseDDSHeader( header, headerSize, (size_t)pStream->file.GetSize(), &pStream->image ) &&
+                    pStream->image.resourceDimension == DDS_DIMENSION_TEXTURE2D &&
+                    pStream->image.mipCount > 1;
+    }
+    UINT tailMip = 0;
+    if( canStream )
+    {
+        const DirectX::DDSImage &image = pStream->image;
+        pStream->format = loadAsSRGB ? DirectX::MakeSRGB( image.format ) : image.format;
+
+        // As many small levels as fit in the tail budget, at least the last one
+        tailMip = image.mipCount - 1;
+        while( tailMip > 0 && image.itemBytes - image.mipOffset[tailMip-1] <= mTailBytes )
+        {
+            tailMip--;
+        }
+        while( tailMip > 0 && !IsValidTopMip( pStream, tailMip ) )
+        {
+            tailMip--;
+        }
+        // Nothing to gain if the tail is the whole texture
+        canStream = tailMip > 0;
+    }
+    if( !canStream )
+    {
+        delete pStream;
+        return CPUTTextureDX11::CreateTexture( name, absolutePathAndFilename, loadAsSRGB );
+    }
+
+    const DirectX::DDSImage &image = pStream->image;
+    size_t span = image.itemBytes - image.mipOffset[tailMip];
+    std::vector<unsigned char> tail( span * image.arraySize );
+    bool readSucceeded = true;
+    for( UINT item=0; item<image.arraySize && readSucceeded; item++ )
+    {
+        readSucceeded = pStream->file.ReadAt( image.dataOffset + item * image.itemBytes + image.mipOffset[tailMip], &tail[item * span], span );
+    }
+
+    pStream->tailMip = tailMip;
+
+    cString textureName = name;
+    pStream->pTexture = new CPUTTextureDX11( textureName );
+    CPUTResult result = readSucceeded ? CreateResident( pStream, NULL, tailMip, &tail[0] ) : CPUT_ERROR_FILE_READ_ERROR;
+    if( CPUTFAILED(result) )
+    {
+        SAFE_RELEASE( pStream->pTexture );
+        delete pStream;
+        return CPUTTextureDX11::CreateTexture( name, absolutePathAndFilename, loadAsSRGB );
+    }
+    CPUTAssetLibrary::GetAssetLibrary()->AddTexture( absolutePathAndFilename, pStream->pTexture );
+    CPUTTextureCacheDX11::GetTextureCache()->AddTexture( pStream->pTexture, absolutePathAndFilename, loadAsSRGB );
+
+    mStreams.push_back( pStream );
+    mStreamMap[pStream->pTexture] = pStream;
+
+    // One reference for the caller, one for us
+    pStream->pTexture->AddRef();
+    return pStream->pTexture;
+}
+
+//-----------------------------------------------------------------------------
+CPUTStreamingTextureDX11 *CPUTTextureStreamerDX11::Find( CPUTTexture *pTexture )
+{
+    std::unordered_map<const CPUTTexture*, CPUTStreamingTextureDX11*>::iterator it = mStreamMap.find( pTexture );
+    return it == mStreamMap.end() ? NULL : it->second;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTTextureStreamerDX11::RequestMip( CPUTTexture *pTexture, UINT mostDetailedMip, float priority )
+{
+    CPUTStreamingTextureDX11 *pStream = Find( pTexture );
+    if( pStream )
+    {
+        pStream->requestedMip = std::min( mostDetailedMip, pStream->image.mipCount - 1 );
+        pStream->priority     = priority;
+    }
+}
+
+//-----------------------------------------------------------------------------
+UINT CPUTTextureStreamerDX11::GetResidentMip( CPUTTexture *pTexture )
+{
+    CPUTStreamingTextureDX11 *pStream = Find( pTexture );
+    return pStream ? pStream->residentMip : 0;
+}
+
+//-----------------------------------------------------------------------------
+UINT CPUTTextureStreamerDX11::GetTailMip( CPUTTexture *pTexture )
+{
+    CPUTStreamingTextureDX11 *pStream = Find( pTexture );
+    return pStream ? pStream->tailMip : 0;
+}
+
+//-----------------------------------------------------------------------------
+bool CPUTTextureStreamerDX11::IsStreaming( CPUTTexture *pTexture )
+{
+    return Find( pTexture ) != NULL;
+}
+
+// Replace the resident texture with one holding [newTopMip, mipCount).  pNewData holds the levels
+// above the currently resident ones, for every array item; the rest are copied on the GPU.  With
+// nothing resident yet pNewData has every level and the texture is created from it directly.
+//-----------------------------------------------------------------------------
+CPUTResult CPUTTextureStreamerDX11::CreateResident( CPUTStreamingTextureDX11 *pStream, ID3D11DeviceContext *pContext, UINT newTopMip, const unsigned char *pNewData )
+{
+    const DirectX::DDSImage &image = pStream->image;
+    UINT oldTopMip = pStream->pResource ? pStream->residentMip : image.mipCount;
+    UINT oldLevels = image.mipCount - oldTopMip;
+    UINT newLevels = image.mipCount - newTopMip;
+    size_t newSpan = newTopMip < oldTopMip ? MipStart( image, oldTopMip ) - MipStart( image, newTopMip ) : 0;
+
+    D3D11_TEXTURE2D_DESC desc;
+    memset( &desc, 0, sizeof(desc) );
+    desc.Width            = std::max<UINT>( image.width  >> newTopMip, 1 );
+    desc.Height           = std::max<UINT>( image.height >> newTopMip, 1 );
+    desc.MipLevels        = newLevels;
+    desc.ArraySize        = image.arraySize;
+    desc.Format           = pStream->format;
+    desc.SampleDesc.Count = 1;
+    desc.Usage            = D3D11_USAGE_DEFAULT;
+    desc.BindFlags        = D3D11_BIND_SHADER_RESOURCE;
+    desc.MiscFlags        = image.isCubeMap ? D3D11_RESOURCE_MISC_TEXTURECUBE : 0;
+
+    std::vector<D3D11_SUBRESOURCE_DATA> initData;
+    if( !pStream->pResource )
+    {
+        initData.resize( newLevels * image.arraySize );
+        for( UINT item=0; item<image.arraySize; item++ )
+        {
+            for( UINT mip=newTopMip; mip<image.mipCount; mip++ )
+            {
+                D3D11_SUBRESOURCE_DATA &data = initData[D3D11CalcSubresource( mip - newTopMip, item, newLevels )];
+                data.pSysMem          = pNewData + item * newSpan + (image.mipOffset[mip] - image.mipOffset[newTopMip]);
+                data.SysMemPitch      = (UINT)image.mipRowPitch[mip];
+                data.SysMemSlicePitch = (UINT)image.mipSlicePitch[mip];
+            }
+        }
+    }
+
+    ID3D11Device *pD3dDevice = CPUT_DX11::GetDevice();
+    ID3D11Texture2D *pResource = NULL;
+    HRESULT hr = pD3dDevice->CreateTexture2D( &desc, initData.empty() ? NULL : &initData[0], &pResource );
+    if( FAILED(hr) )
+    {
+        return CPUT_TEXTURE_LOAD_ERROR;
+    }
+
+    if( pStream->pResource )
+    {
+        for( UINT item=0; item<image.arraySize; item++ )
+        {
+            for( UINT mip=newTopMip; mip<image.mipCount; mip++ )
+            {
+                UINT dest = D3D11CalcSubresource( mip - newTopMip, item, newLevels );
+                if( mip < oldTopMip )
+                {
+                    const unsigned char *pData = pNewData + item * newSpan + (image.mipOffset[mip] - image.mipOffset[newTopMip]);
+                    pContext->UpdateSubresource( pResource, dest, NULL, pData, (UINT)image.mipRowPitch[mip], (UINT)image.mipSlicePitch[mip] );
+                }
+                else
+                {
+                    UINT source = D3D11CalcSubresource( mip - oldTopMip, item, oldLevels );
+                    pContext->CopySubresourceRegion( pResource, dest, 0, 0, 0, pStream->pResource, source, NULL );
+                }
+            }
+        }
+    }
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc;
+    memset( &viewDesc, 0, sizeof(viewDesc) );
+    viewDesc.Format = desc.Format;
+    if( image.isCubeMap && image.arraySize > 6 )
+    {
+        viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBEARRAY;
+        viewDesc.TextureCubeArray.MipLevels = newLevels;
+        viewDesc.TextureCubeArray.NumCubes  = image.arraySize / 6;
+    }
+    else if( image.isCubeMap )
+    {
+        viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE;
+        viewDesc.TextureCube.MipLevels = newLevels;
+    }
+    else if( image.arraySize > 1 )
+    {
+        viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+        viewDesc.Texture2DArray.MipLevels = newLevels;
+        viewDesc.Texture2DArray.ArraySize = image.arraySize;
+    }
+    else
+    {
+        viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+        viewDesc.Texture2D.MipLevels = newLevels;
+    }
+    ID3D11ShaderResourceView *pShaderResourceView = NULL;
+    hr = pD3dDevice->CreateShaderResourceView( pResource, &viewDesc, &pShaderResourceView );
+    if( FAILED(hr) )
+    {
+        SAFE_RELEASE( pResource );
+        return CPUT_TEXTURE_LOAD_ERROR;
+    }
+    CPUTSetDebugName( pResource, pStream->absolutePathAndFilename );
+    CPUTSetDebugName( pShaderResourceView, pStream->absolutePathAndFilename );
+
+    pStream->pTexture->SetTextureAndShaderResourceView( pResource, pShaderResourceView );
+    pShaderResourceView->Release();
+    SAFE_RELEASE( pStream->pResource );
+    pStream->pResource = pResource;
+    pStream->residentMip = newTopMip;
+
+    mResidentBytes -= pStream->residentBytes;
+    pStream->residentBytes = (UINT64)(image.itemBytes - image.mipOffset[newTopMip]) * image.arraySize;
+    mResidentBytes += pStream->residentBytes;
+    return CPUT_SUCCESS;
+}
+
+// Runs on a worker
+//-----------------------------------------------------------------------------
+void CPUTTextureStreamerDX11::ReadMips( CPUTStreamingTextureDX11 *pStream )
+{
+    const DirectX::DDSImage &image = pStream->image;
+    size_t begin = image.mipOffset[pStream->readTopMip];
+    size_t span  = image.mipOffset[pStream->residentMip] - begin;
+
+    pStream->readData.resize( span * image.arraySize );
+    pStream->readSucceeded = true;
+    for( UINT item=0; item<image.arraySize && pStream->readSucceeded; item++ )
+    {
+        pStream->readSucceeded = pStream->file.ReadAt( image.dataOffset + item * image.itemBytes + begin, &pStream->readData[item * span], span );
+    }
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCompleted.push_back( pStream );
+    mReadsInFlight--;
+    mReadComplete.notify_all();
+}
+
+//-----------------------------------------------------------------------------
+void CPUTTextureStreamerDX11::Update( ID3D11DeviceContext *pContext )
+{
+    if( mStreams.empty() )
+    {
+        return;
+    }
+
+    // Materials hold their own references to the views they bind, so each texture whose view
+    // is swapped has just its bind points rebound.
+    // Drop levels nobody needs any more.  No I/O, just a GPU copy of the ones that stay.
+    for( size_t ii=0; ii<mStreams.size(); ii++ )
+    {
+        CPUTStreamingTextureDX11 *pStream = mStreams[ii];
+        if( pStream->reading || pStream->requestedMip <= pStream->residentMip )
+        {
+            continue;
+        }
+        UINT newTopMip = pStream->requestedMip;
+        while( newTopMip > pStream->residentMip && !IsValidTopMip( pStream, newTopMip ) )
+        {
+            newTopMip--;
+        }
+        if( newTopMip > pStream->residentMip && CPUTSUCCESS(CreateResident( pStream, pContext, newTopMip, NULL )) )
+        {
+            CPUTAssetLibrary::RebindTexture( pStream->pTexture );
+        }
+    }
+
+    // Swap in finished reads, up to the upload budget.  Always at least one, so a level
+    // bigger than the budget still gets through.
+    std::vector<CPUTStreamingTextureDX11*> completed;
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        size_t count = 0;
+        size_t uploadBytes = 0;
+        while( count < mCompleted.size() && (count == 0 || uploadBytes + mCompleted[count]->readData.size() <= mUploadBytesPerFrame) )
+        {
+            uploadBytes += mCompleted[count]->readData.size();
+            count++;
+        }
+        completed.assign( mCompleted.begin(), mCompleted.begin() + count );
+        mCompleted.erase( mCompleted.begin(), mCompleted.begin() + count );
+    }
+    for( size_t ii=0; ii<completed.size(); ii++ )
+    {
+        CPUTStreamingTextureDX11 *pStream = completed[ii];
+        pStream->reading = false;
+        CPUTResult result = CPUT_ERROR_FILE_READ_ERROR;
+        if( pStream->readSucceeded )
+        {
+            result = CreateResident( pStream, pContext, pStream->readTopMip, &pStream->readData[0] );
+            if( CPUTSUCCESS(result) )
+            {
+                CPUTAssetLibrary::RebindTexture( pStream->pTexture );
+            }
+        }
+        if( CPUTFAILED(result) )
+        {
+            // Keep what we have rather than retrying every frame
+            ASSERT( false, _L("Error streaming texture: '")+pStream->absolutePathAndFilename );
+            pStream->requestedMip = pStream->residentMip;
+        }
+        std::vector<unsigned char>().swap( pStream->readData );
+    }
+
+    // Start reads for the most important textures still missing levels
+    std::vector<CPUTStreamingTextureDX11*> candidates;
+    for( size_t ii=0; ii<mStreams.size(); ii++ )
+    {
+        CPUTStreamingTextureDX11 *pStream = mStreams[ii];
+        if( !pStream->reading && pStream->requestedMip < pStream->residentMip )
+        {
+            candidates.push_back( pStream );
+        }
+    }
+    std::stable_sort( candidates.begin(), candidates.end(),
+        []( const CPUTStreamingTextureDX11 *pA, const CPUTStreamingTextureDX11 *pB ) { return pA->priority > pB->priority; } );
+    for( size_t ii=0; ii<candidates.size(); ii++ )
+    {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            if( mReadsInFlight >= mMaxReadsInFlight )
+            {
+                break;
+            }
+            mReadsInFlight++;
+        }
+        CPUTStreamingTextureDX11 *pStream = candidates[ii];
+        pStream->reading    = true;
+        pStream->readTopMip = NextMipToRead( pStream );
+        CPUTWorkerPool::GetWorkerPool()->Submit( [this, pStream]() { ReadMips( pStream ); } );
+    }
+}
@@ -0,0 +1,97 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTTEXTURESTREAMERDX11_H__
+#define __CPUTTEXTURESTREAMERDX11_H__
+
+// Progressive mip streaming for 2D textures, arrays and cube maps.
+//
+// StreamTexture() reads only the mip tail (the small levels, up to SetTailBytes() per array
+// item), creates a texture holding just those and returns it, so it can be drawn right away.
+// Update(), called once per frame by CPUT_DX11, then refines the textures one or more levels at
+// a time in priority order: a worker reads the exact byte range of the next levels with
+// CPUTFileReader::ReadAt(), and the device thread creates a texture one level bigger, uploads the
+// new levels and copies the resident ones over on the GPU.  Asking for a smaller mip than the
+// resident one drops the big levels the same way, without touching the file.
+//
+// The CPUTTextureDX11 handed out stays the same object throughout; only its resource and view
+// are swapped, and Update() rebinds the materials' bind points for it after each swap.
+#include "CPUT.h"
+#include <d3d11.h>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <unordered_map>
+
+class CPUTTexture;
+class CPUTTextureDX11;
+struct CPUTStreamingTextureDX11;
+
+class CPUTTextureStreamerDX11
+{
+public:
+    static CPUTTextureStreamerDX11 *GetTextureStreamer();
+    static void                     DeleteTextureStreamer();
+
+    // Returns a new texture, already added to the asset library under absolutePathAndFilename.
+    // Anything but a 2D texture (or one that's already small) is loaded whole instead.
+    CPUTTexture *StreamTexture( const cString &name, const cString &absolutePathAndFilename, bool loadAsSRGB );
+
+    // Ask for mip mostDetailedMip (0 is full resolution) to be resident.  Higher priorities are
+    // streamed in first.  New textures ask for mip 0 at priority 0.
+    void RequestMip( CPUTTexture *pTexture, UINT mostDetailedMip, float priority=0.0f );
+    UINT GetResidentMip( CPUTTexture *pTexture );
+    UINT GetTailMip( CPUTTexture *pTexture );
+    bool IsStreaming( CPUTTexture *pTexture );
+
+    // Start reads for the highest priority requests and swap in up to the upload budget of
+    // finished ones.  Must be called on the device thread.
+    void Update( ID3D11DeviceContext *pContext );
+
+    // GPU memory held by streamed textures
+    UINT64 GetResidentBytes() const { return mResidentBytes; }
+
+    void SetTailBytes( UINT tailBytes )                 { mTailBytes = tailBytes; }
+    void SetUploadBytesPerFrame( UINT uploadBytes )     { mUploadBytesPerFrame = uploadBytes; }
+    void SetMaxReadsInFlight( UINT maxReadsInFlight )   { mMaxReadsInFlight = maxReadsInFlight; }
+
+private:
+    CPUTTextureStreamerDX11();
+    ~CPUTTextureStreamerDX11();
+
+    CPUTStreamingTextureDX11 *Find( CPUTTexture *pTexture );
+    UINT       NextMipToRead( const CPUTStreamingTextureDX11 *pStream ) const;
+    bool       IsValidTopMip( const CPUTStreamingTextureDX11 *pStream, UINT mip ) const;
+    void       ReadMips( CPUTStreamingTextureDX11 *pStream );
+    CPUTResult CreateResident( CPUTStreamingTextureDX11 *pStream, ID3D11DeviceContext *pContext, UINT newTopMip, const unsigned char *pNewData );
+
+    static CPUTTextureStreamerDX11 *mpTextureStreamer;
+
+    std::vector<CPUTStreamingTextureDX11*>                                  mStreams;
+    std::unordered_map<const CPUTTexture*, CPUTStreamingTextureDX11*>       mStreamMap;
+    std::vector<CPUTStreamingTextureDX11*>                                  mCompleted; // read, waiting for the device
+    std::mutex                                                              mMutex;
+    std::condition_variable                                                 mReadComplete;
+    UINT                                                                    mReadsInFlight;
+    UINT                                                                    mTailBytes;
+    UINT                                                                    mUploadBytesPerFrame;
+    UINT                                                                    mMaxReadsInFlight;
+    UINT64                                                                  mResidentBytes;
+
+    CPUTTextureStreamerDX11(const CPUTTextureStreamerDX11 &);
+    CPUTTextureStreamerDX11 &operator=(const CPUTTextureStreamerDX11 &);
+};
+
+#endif // __CPUTTEXTURESTREAMERDX11_H__
@@ -0,0 +1,136 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTTransformHierarchy.h"
+#include <string.h>
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define CPUT_TRANSFORM_SSE 1
+#endif
+
+//-----------------------------------------------------------------------------
+uint32_t CPUTTransformHierarchy::Add(int32_t parent, const float pLocal[16])
+{
+    uint32_t index = GetCount();
+    mParent.push_back(parent);
+    mSubtreeEnd.push_back(index + 1);
+    mLocal.insert(mLocal.end(), pLocal, pLocal + 16);
+    mWorld.resize(mWorld.size() + 16, 0.0f);
+
+    // Depth first, so the new node's ancestors' subtrees all end right before it
+    for(int32_t ancestor = parent; ancestor >= 0; ancestor = mParent[ancestor])
+    {
+        mSubtreeEnd[ancestor] = index + 1;
+    }
+
+    if(!mDirty.empty() && mDirty.back().second == index)
+    {
+        mDirty.back().second = index + 1;
+    }
+    else
+    {
+        mDirty.push_back(std::make_pair(index, index + 1));
+    }
+    return index;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTTransformHierarchy::Clear()
+{
+    mLocal.clear();
+    mWorld.clear();
+    mParent.clear();
+    mSubtreeEnd.clear();
+    mDirty.clear();
+}
+
+//-----------------------------------------------------------------------------
+void CPUTTransformHierarchy::SetLocal(uint32_t index, const float pLocal[16])
+{
+    memcpy(&mLocal[(size_t)index * 16], pLocal, 16 * sizeof(float));
+
+    // A node moved over and over before anything reads its world matrix marks the same range
+    std::pair<uint32_t, uint32_t> range(index, mSubtreeEnd[index]);
+    if(mDirty.empty() || mDirty.back() != range)
+    {
+        mDirty.push_back(range);
+    }
+}
+
+// pWorld = pLocal * pParent, row vectors: each row of the result is the local row's components
+// weighting the parent's rows
+//-----------------------------------------------------------------------------
+static inline void Multiply(float *pWorld, const float *pLocal, const float *pParent)
+{
+#ifdef CPUT_TRANSFORM_SSE
+    __m128 p0 = _mm_loadu_ps(pParent);
+    __m128 p1 = _mm_loadu_ps(pParent + 4);
+    __m128 p2 = _mm_loadu_ps(pParent + 8);
+    __m128 p3 = _mm_loadu_ps(pParent + 12);
+    for(int rr=0; rr<4; rr++)
+    {
+        const float *pRow = pLocal + rr*4;
+        __m128 row = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(pRow[0]), p0), _mm_mul_ps(_mm_set1_ps(pRow[1]), p1)),
+                                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(pRow[2]), p2), _mm_mul_ps(_mm_set1_ps(pRow[3]), p3)));
+        _mm_storeu_ps(pWorld + rr*4, row);
+    }
+#else
+    for(int rr=0; rr<4; rr++)
+    {
+        const float *pRow = pLocal + rr*4;
+        for(int cc=0; cc<4; cc++)
+        {
+            pWorld[rr*4 + cc] = pRow[0]*pParent[cc] + pRow[1]*pParent[4 + cc] + pRow[2]*pParent[8 + cc] + pRow[3]*pParent[12 + cc];
+        }
+    }
+#endif
+}
+
+//-----------------------------------------------------------------------------
+uint32_t CPUTTransformHierarchy::Update()
+{
+    // Subtree ranges either nest or don't touch, so in order of their first node each one either
+    // lies inside what's already been updated or starts past it.  A node's parent comes before
+    // it, and is either in the same range or was clean to begin with.
+    std::sort(mDirty.begin(), mDirty.end());
+    uint32_t updated = 0;
+    uint32_t done    = 0;
+    for(size_t rr=0; rr<mDirty.size(); rr++)
+    {
+        uint32_t first = std::max(mDirty[rr].first, done);
+        uint32_t end   = mDirty[rr].second;
+        for(uint32_t ii=first; ii<end; ii++)
+        {
+            int32_t parent = mParent[ii];
+            if(parent < 0)
+            {
+                memcpy(&mWorld[(size_t)ii * 16], &mLocal[(size_t)ii * 16], 16 * sizeof(float));
+            }
+            else
+            {
+                Multiply(&mWorld[(size_t)ii * 16], &mLocal[(size_t)ii * 16], &mWorld[(size_t)parent * 16]);
+            }
+        }
+        if(end > first)
+        {
+            updated += end - first;
+            done = end;
+        }
+    }
+    mDirty.clear();
+    return updated;
+}
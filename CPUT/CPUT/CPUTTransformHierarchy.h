@@ -0,0 +1,68 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTTRANSFORMHIERARCHY_H__
+#define __CPUTTRANSFORMHIERARCHY_H__
+
+// The local and world matrices of a tree of nodes, kept in two contiguous arrays in depth first
+// order: every node comes after its parent, with all its descendants right behind it, so a
+// subtree is one range of indices.  Changing a node's local matrix marks just its subtree's
+// range dirty, and Update() walks the dirty ranges front to back in one linear pass, building
+// each world matrix from its parent's, which is up to date by the time it's reached.  The
+// multiplies use SSE when the build targets it, else plain floats.
+//
+// Matrices are 16 floats, row major, taking row vectors, as float4x4 has them: a node's world
+// matrix is its local matrix times its parent's world matrix.
+// Only depends on the C++ standard library, so tools built on it also run off Windows.
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+class CPUTTransformHierarchy
+{
+public:
+    CPUTTransformHierarchy() {}
+
+    // Appends a node under parent, or as a root when parent is -1, returning its index.  Nodes
+    // have to be added depth first, so parent is either the last node added or one of its
+    // ancestors.  The new node starts out dirty.
+    uint32_t     Add(int32_t parent, const float pLocal[16]);
+    void         Clear();
+
+    uint32_t     GetCount() const                 { return (uint32_t)mParent.size(); }
+    int32_t      GetParent(uint32_t index) const  { return mParent[index]; }
+    uint32_t     GetSubtreeEnd(uint32_t index) const { return mSubtreeEnd[index]; } // one past the node's last descendant
+    const float *GetLocal(uint32_t index) const   { return &mLocal[(size_t)index * 16]; }
+
+    // Sets a node's local matrix and marks it and its descendants dirty
+    void         SetLocal(uint32_t index, const float pLocal[16]);
+
+    // A node's world matrix, updating the dirty ranges first if there are any
+    const float *GetWorld(uint32_t index)         { if(!mDirty.empty()) { Update(); } return &mWorld[(size_t)index * 16]; }
+    bool         IsDirty() const                  { return !mDirty.empty(); }
+
+    // Recomputes the world matrices of every dirty node, and returns how many that was
+    uint32_t     Update();
+
+private:
+    std::vector<float>    mLocal;         // 16 per node
+    std::vector<float>    mWorld;         // 16 per node
+    std::vector<int32_t>  mParent;        // -1 for roots, else less than the node's own index
+    std::vector<uint32_t> mSubtreeEnd;
+    std::vector< std::pair<uint32_t, uint32_t> > mDirty; // [first, end) ranges, in no order, maybe nested
+};
+
+#endif // __CPUTTRANSFORMHIERARCHY_H__
@@ -0,0 +1,348 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTVertexQuantizer.h"
+#include <math.h>
+#include <string.h>
+
+#define UNORM16_MAX 65535.0f
+#define SNORM16_MAX 32767.0f
+
+//-----------------------------------------------------------------------------
+uint32_t CPUTPlanVertexQuantization(const CPUTModelFileElement *pElements, uint32_t elementCount, std::vector<CPUTQuantizedElement> *pPlan)
+{
+    pPlan->clear();
+    uint32_t sourceOffset = 0;
+    uint32_t offset = 0;
+    for(uint32_t ii=0; ii<elementCount; ii++)
+    {
+        const CPUTModelFileElement &element = pElements[ii];
+        bool isFloat = element.vertexElementType == CPUT_MODEL_FILE_TYPE_FLOAT;
+
+        CPUTQuantizedElement quantized;
+        quantized.sourceOffset = sourceOffset;
+        quantized.sourceSize   = element.elementSizeInBytes;
+        switch(element.vertexElementSemantic)
+        {
+        case CPUT_MODEL_FILE_SEMANTIC_POSITION:
+        case CPUT_MODEL_FILE_SEMANTIC_NORMAL:
+        case CPUT_MODEL_FILE_SEMANTIC_TANGENT:
+        case CPUT_MODEL_FILE_SEMANTIC_BINORMAL:
+            if(!isFloat || element.elementSizeInBytes != 3 * sizeof(float))
+            {
+                pPlan->clear();
+                return 0;
+            }
+            if(element.vertexElementSemantic == CPUT_MODEL_FILE_SEMANTIC_POSITION)
+            {
+                quantized.format = CPUT_QUANTIZED_POSITION_UNORM16;
+                quantized.size   = 4 * sizeof(uint16_t);
+            }
+            else
+            {
+                quantized.format = CPUT_QUANTIZED_OCTAHEDRAL_SNORM16;
+                quantized.size   = 2 * sizeof(int16_t);
+            }
+            break;
+        case CPUT_MODEL_FILE_SEMANTIC_TEXCOORD:
+            if(isFloat && element.elementSizeInBytes == 2 * sizeof(float))
+            {
+                quantized.format = CPUT_QUANTIZED_HALF2;
+                quantized.size   = 2 * sizeof(uint16_t);
+                break;
+            }
+            // Other texture coordinates are copied
+            // fall through
+        default:
+            quantized.format = CPUT_QUANTIZED_COPY;
+            quantized.size   = element.elementSizeInBytes;
+            break;
+        }
+        quantized.offset = offset;
+        pPlan->push_back(quantized);
+        sourceOffset += element.elementSizeInBytes;
+        offset       += quantized.size;
+    }
+    return offset;
+}
+
+//-----------------------------------------------------------------------------
+static void ReadFloats(const unsigned char *pSrc, float *pValues, int count)
+{
+    memcpy(pValues, pSrc, count * sizeof(float));
+}
+
+//-----------------------------------------------------------------------------
+void CPUTGrowQuantizationBounds(const unsigned char *pVertices, uint32_t vertexCount, uint32_t vertexStride,
+                                const std::vector<CPUTQuantizedElement> &plan, float pMin[3], float pMax[3])
+{
+    for(size_t ee=0; ee<plan.size(); ee++)
+    {
+        if(plan[ee].format != CPUT_QUANTIZED_POSITION_UNORM16)
+        {
+            continue;
+        }
+        const unsigned char *pPosition = pVertices + plan[ee].sourceOffset;
+        for(uint32_t ii=0; ii<vertexCount; ii++, pPosition += vertexStride)
+        {
+            float position[3];
+            ReadFloats(pPosition, position, 3);
+            for(int cc=0; cc<3; cc++)
+            {
+                pMin[cc] = position[cc] < pMin[cc] ? position[cc] : pMin[cc];
+                pMax[cc] = position[cc] > pMax[cc] ? position[cc] : pMax[cc];
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTMakeQuantizationBox(const float pMin[3], const float pMax[3], CPUTQuantizationBox *pBox)
+{
+    for(int cc=0; cc<3; cc++)
+    {
+        bool empty = !(pMin[cc] <= pMax[cc]);
+        pBox->scale[cc] = empty ? 0.0f : pMax[cc] - pMin[cc];
+        pBox->bias[cc]  = empty ? 0.0f : pMin[cc];
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTDecodeOctahedral(int16_t x, int16_t y, float pDirection[3])
+{
+    // SNORM conversion as the input assembler does it, then the shaders' DecodeDirection()
+    float ex = x / SNORM16_MAX;
+    float ey = y / SNORM16_MAX;
+    ex = ex < -1.0f ? -1.0f : ex;
+    ey = ey < -1.0f ? -1.0f : ey;
+    float nz = 1.0f - fabsf(ex) - fabsf(ey);
+    float t  = nz < 0.0f ? -nz : 0.0f;
+    float nx = ex + (ex >= 0.0f ? -t : t);
+    float ny = ey + (ey >= 0.0f ? -t : t);
+    float length = sqrtf(nx*nx + ny*ny + nz*nz);
+    pDirection[0] = nx / length;
+    pDirection[1] = ny / length;
+    pDirection[2] = nz / length;
+}
+
+//-----------------------------------------------------------------------------
+static int16_t ToSNORM16(float value)
+{
+    value = value < -SNORM16_MAX ? -SNORM16_MAX : (value > SNORM16_MAX ? SNORM16_MAX : value);
+    return (int16_t)value;
+}
+
+//-----------------------------------------------------------------------------
+static double AngleBetween(const float pA[3], const double pB[3])
+{
+    double cross[3] = {
+        pA[1]*pB[2] - pA[2]*pB[1],
+        pA[2]*pB[0] - pA[0]*pB[2],
+        pA[0]*pB[1] - pA[1]*pB[0]
+    };
+    double sine   = sqrt(cross[0]*cross[0] + cross[1]*cross[1] + cross[2]*cross[2]);
+    double cosine = pA[0]*pB[0] + pA[1]*pB[1] + pA[2]*pB[2];
+    return atan2(sine, cosine) * (180.0 / 3.14159265358979323846);
+}
+
+// Project onto the octahedron, fold the lower half over the upper one, then try the four
+// SNORM values around the result and keep the one that decodes closest (plain rounding is up
+// to twice as far off).  Returns the angle it's off by, or 0 for a zero direction.
+//-----------------------------------------------------------------------------
+static double EncodeOctahedral(const float pDirection[3], int16_t *pX, int16_t *pY)
+{
+    double length = sqrt((double)pDirection[0]*pDirection[0] + (double)pDirection[1]*pDirection[1] + (double)pDirection[2]*pDirection[2]);
+    if(!(length > 0.0))
+    {
+        *pX = *pY = 0;
+        return 0.0;
+    }
+    double direction[3] = { pDirection[0]/length, pDirection[1]/length, pDirection[2]/length };
+    double l1 = fabs(direction[0]) + fabs(direction[1]) + fabs(direction[2]);
+    double x = direction[0] / l1;
+    double y = direction[1] / l1;
+    if(direction[2] < 0.0)
+    {
+        double foldedX = (1.0 - fabs(y)) * (x >= 0.0 ? 1.0 : -1.0);
+        double foldedY = (1.0 - fabs(x)) * (y >= 0.0 ? 1.0 : -1.0);
+        x = foldedX;
+        y = foldedY;
+    }
+
+    float baseX = (float)floor(x * SNORM16_MAX);
+    float baseY = (float)floor(y * SNORM16_MAX);
+    double bestAngle = 360.0;
+    for(int ii=0; ii<4; ii++)
+    {
+        int16_t candidateX = ToSNORM16(baseX + (ii & 1));
+        int16_t candidateY = ToSNORM16(baseY + (ii >> 1));
+        float decoded[3];
+        CPUTDecodeOctahedral(candidateX, candidateY, decoded);
+        double angle = AngleBetween(decoded, direction);
+        if(angle < bestAngle)
+        {
+            bestAngle = angle;
+            *pX = candidateX;
+            *pY = candidateY;
+        }
+    }
+    return bestAngle;
+}
+
+//-----------------------------------------------------------------------------
+uint16_t CPUTFloatToHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign      = (bits >> 16) & 0x8000;
+    uint32_t magnitude = bits & 0x7fffffff;
+
+    if(magnitude >= 0x7f800000)
+    {
+        // Infinity stays infinity, NaN stays NaN
+        return (uint16_t)(sign | 0x7c00 | (magnitude > 0x7f800000 ? 0x200 : 0));
+    }
+    if(magnitude >= 0x477ff000)
+    {
+        // Would round past 65504, the largest half; clamp rather than go to infinity
+        return (uint16_t)(sign | 0x7bff);
+    }
+    if(magnitude < 0x38800000)
+    {
+        // Below the smallest normal half, 2^-14: a denormal, rounded to nearest even
+        if(magnitude < 0x33000000)
+        {
+            return (uint16_t)sign;
+        }
+        uint32_t exponent  = magnitude >> 23;
+        uint32_t mantissa  = (magnitude & 0x7fffff) | 0x800000;
+        uint32_t shift     = 126 - exponent;
+        uint32_t half      = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway   = 1u << (shift - 1);
+        if(remainder > halfway || (remainder == halfway && (half & 1)))
+        {
+            half++;
+        }
+        return (uint16_t)(sign | half);
+    }
+    // Rebias the exponent from 127 to 15 and round the mantissa to nearest even.  A carry
+    // out of the mantissa correctly bumps the exponent.
+    uint32_t half      = (magnitude - 0x38000000) >> 13;
+    uint32_t remainder = magnitude & 0x1fff;
+    if(remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+    {
+        half++;
+    }
+    return (uint16_t)(sign | half);
+}
+
+//-----------------------------------------------------------------------------
+float CPUTHalfToFloat(uint16_t value)
+{
+    uint32_t sign     = (uint32_t)(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1f;
+    uint32_t mantissa = value & 0x3ff;
+    uint32_t bits;
+    if(exponent == 0)
+    {
+        float magnitude = ldexpf((float)mantissa, -24);
+        return sign ? -magnitude : magnitude;
+    }
+    else if(exponent == 31)
+    {
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    }
+    else
+    {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTQuantizeVertices(unsigned char *pDst, const unsigned char *pSrc, uint32_t vertexCount, uint32_t srcStride,
+                          const std::vector<CPUTQuantizedElement> &plan, const CPUTQuantizationBox &box, CPUTQuantizationError *pError)
+{
+    uint32_t dstStride = plan.empty() ? 0 : plan.back().offset + plan.back().size;
+    double positionError = 0.0, directionError = 0.0, texCoordError = 0.0;
+    for(uint32_t ii=0; ii<vertexCount; ii++, pSrc += srcStride, pDst += dstStride)
+    {
+        for(size_t ee=0; ee<plan.size(); ee++)
+        {
+            const CPUTQuantizedElement &element = plan[ee];
+            const unsigned char *pFrom = pSrc + element.sourceOffset;
+            unsigned char *pTo = pDst + element.offset;
+            switch(element.format)
+            {
+            case CPUT_QUANTIZED_POSITION_UNORM16:
+            {
+                float position[3];
+                ReadFloats(pFrom, position, 3);
+                uint16_t quantized[4] = { 0, 0, 0, 0xffff };
+                double distanceSquared = 0.0;
+                for(int cc=0; cc<3; cc++)
+                {
+                    float scale = box.scale[cc];
+                    float unit  = scale > 0.0f ? (position[cc] - box.bias[cc]) / scale : 0.0f;
+                    unit = unit < 0.0f ? 0.0f : (unit > 1.0f ? 1.0f : unit);
+                    quantized[cc] = (uint16_t)(unit * UNORM16_MAX + 0.5f);
+                    double difference = (double)(quantized[cc] / UNORM16_MAX * scale + box.bias[cc]) - position[cc];
+                    distanceSquared += difference * difference;
+                }
+                memcpy(pTo, quantized, sizeof(quantized));
+                double distance = sqrt(distanceSquared);
+                positionError = distance > positionError ? distance : positionError;
+                break;
+            }
+            case CPUT_QUANTIZED_OCTAHEDRAL_SNORM16:
+            {
+                float direction[3];
+                ReadFloats(pFrom, direction, 3);
+                int16_t quantized[2];
+                double angle = EncodeOctahedral(direction, &quantized[0], &quantized[1]);
+                memcpy(pTo, quantized, sizeof(quantized));
+                directionError = angle > directionError ? angle : directionError;
+                break;
+            }
+            case CPUT_QUANTIZED_HALF2:
+            {
+                float texCoord[2];
+                ReadFloats(pFrom, texCoord, 2);
+                uint16_t quantized[2];
+                for(int cc=0; cc<2; cc++)
+                {
+                    quantized[cc] = CPUTFloatToHalf(texCoord[cc]);
+                    double difference = fabs((double)CPUTHalfToFloat(quantized[cc]) - texCoord[cc]);
+                    texCoordError = difference > texCoordError ? difference : texCoordError;
+                }
+                memcpy(pTo, quantized, sizeof(quantized));
+                break;
+            }
+            default:
+                memcpy(pTo, pFrom, element.size);
+                break;
+            }
+        }
+    }
+    if(pError)
+    {
+        pError->position  = (float)positionError;
+        pError->direction = (float)directionError;
+        pError->texCoord  = (float)texCoordError;
+    }
+}
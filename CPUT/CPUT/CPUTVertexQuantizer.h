@@ -0,0 +1,90 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTVERTEXQUANTIZER_H__
+#define __CPUTVERTEXQUANTIZER_H__
+
+// Packs model file vertices into fewer bytes for the GPU:
+//
+//   positions            three floats -> four 16-bit UNORMs, across a box the shader maps back
+//                        with position * scale + bias (the fourth is 1)
+//   normals, tangents    three floats -> two 16-bit SNORMs, octahedral encoded (Meyer et al., "On
+//   and binormals        Floating-Point Normal Vectors", 2010); see CPUTDecodeOctahedral()
+//   texture coordinates  two floats -> two half floats, which the input assembler widens itself
+//
+// Anything else is copied as it is.  A position, normal and texture coordinate vertex goes from
+// 32 bytes to 16.  The reading side, CPUTModel::LoadModelPayload(), feeds these to the shaders as
+// DXGI_FORMAT_R16G16B16A16_UNORM, R16G16_SNORM and R16G16_FLOAT.
+// Only depends on the C++ standard library, so tools built on it also run off Windows.
+#include "CPUTModelFile.h"
+
+enum CPUTQuantizedFormat
+{
+    CPUT_QUANTIZED_COPY = 0,
+    CPUT_QUANTIZED_POSITION_UNORM16,      // 4 x 16 bits
+    CPUT_QUANTIZED_OCTAHEDRAL_SNORM16,    // 2 x 16 bits
+    CPUT_QUANTIZED_HALF2,                 // 2 x 16 bits
+};
+
+// Where one model file element comes from and goes to.  Offsets are in packed vertices, the
+// way the loader lays them out.
+struct CPUTQuantizedElement
+{
+    CPUTQuantizedFormat format;
+    uint32_t            sourceOffset;
+    uint32_t            sourceSize;
+    uint32_t            offset;
+    uint32_t            size;
+};
+
+// Object space position = quantized position * scale + bias
+struct CPUTQuantizationBox
+{
+    float scale[3];
+    float bias[3];
+};
+
+// The furthest any vertex moved
+struct CPUTQuantizationError
+{
+    float position;     // distance, in object space units
+    float direction;    // angle off a normal, tangent or binormal, in degrees
+    float texCoord;     // difference in a texture coordinate
+};
+
+// How to quantize vertices made of these elements.  Returns the quantized stride, or 0 with
+// pPlan empty if a position, normal, tangent or binormal isn't three floats: the shaders decode
+// those the same way for every mesh of a model, so a model is quantized whole or not at all.
+uint32_t CPUTPlanVertexQuantization(const CPUTModelFileElement *pElements, uint32_t elementCount, std::vector<CPUTQuantizedElement> *pPlan);
+
+// Grow pMin and pMax around every position the plan quantizes.  Start them at +FLT_MAX and -FLT_MAX.
+void CPUTGrowQuantizationBounds(const unsigned char *pVertices, uint32_t vertexCount, uint32_t vertexStride,
+                                const std::vector<CPUTQuantizedElement> &plan, float pMin[3], float pMax[3]);
+
+// The box that spans pMin to pMax.  Empty bounds give scale 0 and bias 0.
+void CPUTMakeQuantizationBox(const float pMin[3], const float pMax[3], CPUTQuantizationBox *pBox);
+
+// Quantize vertexCount vertices from pSrc to pDst, which holds vertexCount * the plan's stride bytes.
+// Positions outside the box are clamped to it.  pError is optional.
+void CPUTQuantizeVertices(unsigned char *pDst, const unsigned char *pSrc, uint32_t vertexCount, uint32_t srcStride,
+                          const std::vector<CPUTQuantizedElement> &plan, const CPUTQuantizationBox &box, CPUTQuantizationError *pError);
+
+// The same decode the shaders do, for checking
+void CPUTDecodeOctahedral(int16_t x, int16_t y, float pDirection[3]);
+
+uint16_t CPUTFloatToHalf(float value);
+float    CPUTHalfToFloat(uint16_t value);
+
+#endif // __CPUTVERTEXQUANTIZER_H__
@@ -0,0 +1,186 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "CPUTWorkerPool.h"
+#include <atomic>
+#include <memory>
+
+CPUTWorkerPool *CPUTWorkerPool::mpWorkerPool = NULL;
+
+//-----------------------------------------------------------------------------
+CPUTWorkerPool *CPUTWorkerPool::GetWorkerPool()
+{
+    if(NULL == mpWorkerPool)
+    {
+        unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        mpWorkerPool = new CPUTWorkerPool( hardwareThreads > 1 ? hardwareThreads - 1 : 1 );
+    }
+    return mpWorkerPool;
+}
+
+//-----------------------------------------------------------------------------
+void CPUTWorkerPool::DeleteWorkerPool()
+{
+    delete mpWorkerPool;
+    mpWorkerPool = NULL;
+}
+
+//-----------------------------------------------------------------------------
+CPUTWorkerPool::CPUTWorkerPool(unsigned int numThreads) :
+    mRunning(0),
+    mShutdown(false)
+{
+    for( unsigned int ii=0; ii<numThreads; ii++ )
+    {
+        mThreads.push_back( std::thread( &CPUTWorkerPool::WorkerLoop, this ) );
+    }
+}
+
+//-----------------------------------------------------------------------------
+CPUTWorkerPool::~CPUTWorkerPool()
+{
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mShutdown = true;
+    }
+    mWorkAvailable.notify_all();
+    for( size_t ii=0; ii<mThreads.size(); ii++ )
+    {
+        mThreads[ii].join();
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTWorkerPool::Submit(const Task &task)
+{
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mQueue.push_back(task);
+    }
+    mWorkAvailable.notify_one();
+}
+
+//-----------------------------------------------------------------------------
+void CPUTWorkerPool::WaitIdle()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    while( !mQueue.empty() || mRunning )
+    {
+        mIdle.wait(lock);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void CPUTWorkerPool::WorkerLoop()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    for(;;)
+    {
+        while( mQueue.empty() && !mShutdown )
+        {
+            mWorkAvailable.wait(lock);
+        }
+        if( mQueue.empty() )
+        {
+            return; // shutting down and nothing left to run
+        }
+        Task task = mQueue.front();
+        mQueue.pop_front();
+        mRunning++;
+        lock.unlock();
+        task();
+        lock.lock();
+        mRunning--;
+        if( mQueue.empty() && !mRunning )
+        {
+            mIdle.notify_all();
+        }
+    }
+}
+
+// State shared by the threads taking part in one ParallelFor.  Helpers that only get to run after
+// the loop finished still hold a reference, so it must outlive the call.
+//-----------------------------------------------------------------------------
+struct CPUTParallelForState
+{
+    CPUTWorkerPool::RangeTask  task;
+    unsigned int               count;
+    unsigned int               grain;
+    unsigned int               numChunks;
+    std::atomic<unsigned int>  nextChunk;
+    std::atomic<unsigned int>  doneChunks;
+    std::mutex                 mutex;
+    std::condition_variable    done;
+
+    void Run()
+    {
+        unsigned int chunk;
+        while( (chunk = nextChunk++) < numChunks )
+        {
+            unsigned int begin = chunk * grain;
+            unsigned int end   = begin + grain < count ? begin + grain : count;
+            task(begin, end);
+            if( ++doneChunks == numChunks )
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                done.notify_all();
+            }
+        }
+    }
+};
+
+//-----------------------------------------------------------------------------
+void CPUTWorkerPool::ParallelFor(unsigned int count, unsigned int grain, const RangeTask &task, unsigned int maxThreads)
+{
+    if( count == 0 )
+    {
+        return;
+    }
+    if( grain == 0 )
+    {
+        grain = 1;
+    }
+    unsigned int numChunks = (count + grain - 1) / grain;
+    unsigned int numThreads = maxThreads ? maxThreads : GetThreadCount() + 1;
+    if( numThreads > numChunks )
+    {
+        numThreads = numChunks;
+    }
+    if( numThreads <= 1 )
+    {
+        task(0, count);
+        return;
+    }
+
+    std::shared_ptr<CPUTParallelForState> pState = std::make_shared<CPUTParallelForState>();
+    pState->task       = task;
+    pState->count      = count;
+    pState->grain      = grain;
+    pState->numChunks  = numChunks;
+    pState->nextChunk  = 0;
+    pState->doneChunks = 0;
+
+    for( unsigned int ii=1; ii<numThreads; ii++ )
+    {
+        Submit( [pState]() { pState->Run(); } );
+    }
+    pState->Run();
+
+    std::unique_lock<std::mutex> lock(pState->mutex);
+    while( pState->doneChunks < numChunks )
+    {
+        pState->done.wait(lock);
+    }
+}
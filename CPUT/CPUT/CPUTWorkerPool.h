@@ -0,0 +1,72 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __CPUTWORKERPOOL_H__
+#define __CPUTWORKERPOOL_H__
+
+// Fixed size pool of worker threads for CPU side work (tiling, decompression, file I/O, parsing).
+// Only depends on the C++ standard library, so code built on top of it also runs off Windows.
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+
+class CPUTWorkerPool
+{
+public:
+    typedef std::function<void()> Task;
+    // Called with a [begin, end) range of iterations
+    typedef std::function<void(unsigned int, unsigned int)> RangeTask;
+
+    // Singleton.  Created on first use with one worker per hardware thread, minus the calling thread.
+    static CPUTWorkerPool *GetWorkerPool();
+    static void            DeleteWorkerPool();
+
+    explicit CPUTWorkerPool(unsigned int numThreads);
+    ~CPUTWorkerPool();
+
+    unsigned int GetThreadCount() const { return (unsigned int)mThreads.size(); }
+
+    // Queue a task.  It runs on some worker, in FIFO order with other tasks.
+    void Submit(const Task &task);
+
+    // Block until the queue is empty and no task is running
+    void WaitIdle();
+
+    // Split [0, count) in chunks of grain iterations and run them on up to maxThreads threads
+    // (0 means all workers plus the caller).  The calling thread takes chunks too, so this makes
+    // progress even when every worker is busy.  Returns once every chunk has run.
+    void ParallelFor(unsigned int count, unsigned int grain, const RangeTask &task, unsigned int maxThreads=0);
+
+private:
+    void WorkerLoop();
+
+    static CPUTWorkerPool   *mpWorkerPool;
+
+    std::vector<std::thread> mThreads;
+    std::deque<Task>         mQueue;
+    std::mutex               mMutex;
+    std::condition_variable  mWorkAvailable;
+    std::condition_variable  mIdle;
+    unsigned int             mRunning;
+    bool                     mShutdown;
+
+    CPUTWorkerPool(const CPUTWorkerPool &);
+    CPUTWorkerPool &operator=(const CPUTWorkerPool &);
+};
+
+#endif // __CPUTWORKERPOOL_H__
@@ -17,6 +17,10 @@
 #include "CPUTRenderStateBlockDX11.h"
 #include "CPUTBufferDX11.h"
 #include "CPUTTextureDX11.h"
+#include "CPUTWorkerPool.h"
+#include "CPUTTextureLoaderDX11.h"
+#include "CPUTTextureStreamerDX11.h"
+#include "CPUTTextureCacheDX11.h"
 #ifdef _DEBUG
 #include "DXGIDebug.h"
 #endif
@@ -797,6 +801,14 @@ void CPUT_DX11::InnerExecutionLoop()
         double totalSeconds = mpTimer->GetTotalTime();
         UpdatePerFrameConstantBuffer(totalSeconds);
         CPUTMaterialDX11::ResetStateTracking();
+
+        // Swap in a few textures that finished loading in the background, stream mips
+        // and keep the textures within the memory budget
+        CPUTTextureLoaderDX11 *pTextureLoader = CPUTTextureLoaderDX11::GetTextureLoader();
+        pTextureLoader->ProcessCompletedTextures( pTextureLoader->GetTexturesPerFrame() );
+        CPUTTextureStreamerDX11::GetTextureStreamer()->Update( mpContext );
+        CPUTTextureCacheDX11::GetTextureCache()->Update();
+
         if(CPUTRenderTargetColor::GetActiveHeight() > 64 && CPUTRenderTargetColor::GetActiveWidth() > 64)
 			Render(deltaSeconds);
 		if(!CPUTOSServices::GetOSServices()->DoesWindowHaveFocus())
@@ -1172,6 +1184,10 @@ void CPUT_DX11::ShutdownAndDestroy()
 
     // call the user's OnShutdown code
     Shutdown();
+    CPUTTextureCacheDX11::DeleteTextureCache();
+    CPUTTextureLoaderDX11::DeleteTextureLoader();
+    CPUTTextureStreamerDX11::DeleteTextureStreamer();
+    CPUTWorkerPool::DeleteWorkerPool();
     CPUTInputLayoutCacheDX11::DeleteInputLayoutCache();
     CPUTAssetLibraryDX11::DeleteAssetLibrary();
     CPUTGuiControllerDX11::DeleteController();
@@ -0,0 +1,399 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+// CPUTPack: packs a media directory into a CPUT archive (see CPUT/CPUT/CPUTArchive.h).
+//
+//   CPUTPack [--cook] [--lz4 | --zstd] <directory> <archive.cpak>
+//
+// Every file under directory is stored under its path relative to it.  Mount the archive over
+// the same directory with CPUTOSServices::MountArchive() and the loaders find the files there.
+// .dds, .mdl, .set and .mtl payloads start on 4KB boundaries.  With --lz4 or --zstd each
+// payload is compressed, and kept only if that saves at least an eighth of it; the tool and
+// the runtime must both be built with CPUT_ARCHIVE_LZ4 / CPUT_ARCHIVE_ZSTD to use them.
+// With --cook, .set, .mtl and .rs files are stored parsed (see CPUT/CPUT/CPUTCookedConfig.h),
+// so a scene's hierarchy, matrices, bounds and material tables load without any text parsing.
+//
+// Builds on its own, on Windows or off it:
+//   cl /EHsc /O2 /I..\CPUT CPUTPack.cpp ..\CPUT\CPUTArchive.cpp ..\CPUT\CPUTMappedFile.cpp ..\CPUT\CPUTCookedConfig.cpp
+//   g++ -std=c++11 -O2 -I../CPUT CPUTPack.cpp ../CPUT/CPUTArchive.cpp ../CPUT/CPUTMappedFile.cpp ../CPUT/CPUTCookedConfig.cpp
+#include "CPUTArchive.h"
+#include "CPUTCookedConfig.h"
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+typedef std::basic_string<CPUTMappedFile::PathChar> PathString;
+
+struct PackFile
+{
+    PathString  path;
+    std::string name; // normalized, UTF-8
+};
+
+//-----------------------------------------------------------------------------
+static std::string ToUtf8(const PathString &path)
+{
+#ifdef _WIN32
+    if(path.empty())
+    {
+        return std::string();
+    }
+    int length = WideCharToMultiByte(CP_UTF8, 0, path.c_str(), (int)path.size(), NULL, 0, NULL, NULL);
+    std::string utf8(length, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, path.c_str(), (int)path.size(), &utf8[0], length, NULL, NULL);
+    return utf8;
+#else
+    return path;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+static bool ListFiles(const PathString &directory, const PathString &relative, std::vector<PackFile> *pFiles)
+{
+#ifdef _WIN32
+    WIN32_FIND_DATAW findData;
+    HANDLE hFind = FindFirstFileW((directory + L"\\*").c_str(), &findData);
+    if(INVALID_HANDLE_VALUE == hFind)
+    {
+        return false;
+    }
+    bool result = true;
+    do
+    {
+        PathString entry = findData.cFileName;
+        if(entry == L"." || entry == L"..")
+        {
+            continue;
+        }
+        if(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        {
+            result = ListFiles(directory + L"\\" + entry, relative + entry + L"/", pFiles) && result;
+        }
+        else
+        {
+            PackFile file;
+            file.path = directory + L"\\" + entry;
+            file.name = CPUTArchive::NormalizeName(ToUtf8(relative + entry));
+            pFiles->push_back(file);
+        }
+    } while(FindNextFileW(hFind, &findData));
+    FindClose(hFind);
+    return result;
+#else
+    DIR *pDir = opendir(directory.c_str());
+    if(!pDir)
+    {
+        return false;
+    }
+    bool result = true;
+    while(struct dirent *pEntry = readdir(pDir))
+    {
+        PathString entry = pEntry->d_name;
+        if(entry == "." || entry == "..")
+        {
+            continue;
+        }
+        PathString path = directory + "/" + entry;
+        struct stat status;
+        if(0 != stat(path.c_str(), &status))
+        {
+            result = false;
+        }
+        else if(S_ISDIR(status.st_mode))
+        {
+            result = ListFiles(path, relative + entry + "/", pFiles) && result;
+        }
+        else if(S_ISREG(status.st_mode))
+        {
+            PackFile file;
+            file.path = path;
+            file.name = CPUTArchive::NormalizeName(relative + entry);
+            pFiles->push_back(file);
+        }
+    }
+    closedir(pDir);
+    return result;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+static bool ReadWholeFile(const PathString &path, std::vector<unsigned char> *pData)
+{
+#ifdef _WIN32
+    FILE *pFile = _wfopen(path.c_str(), L"rb");
+#else
+    FILE *pFile = fopen(path.c_str(), "rb");
+#endif
+    if(!pFile)
+    {
+        return false;
+    }
+    pData->clear();
+    unsigned char buffer[65536];
+    size_t count;
+    while((count = fread(buffer, 1, sizeof(buffer), pFile)) > 0)
+    {
+        pData->insert(pData->end(), buffer, buffer + count);
+    }
+    bool result = !ferror(pFile);
+    fclose(pFile);
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+static bool HasExtension(const std::string &name, const char **ppExtensions, size_t extensionCount)
+{
+    for(size_t ii=0; ii<extensionCount; ii++)
+    {
+        size_t length = strlen(ppExtensions[ii]);
+        if(name.size() >= length && 0 == name.compare(name.size() - length, length, ppExtensions[ii]))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The payloads the runtime hands to the loaders and the GPU in place
+//-----------------------------------------------------------------------------
+static bool IsPageAligned(const std::string &name)
+{
+    static const char *extensions[] = { ".dds", ".mdl", ".set", ".mtl" };
+    return HasExtension(name, extensions, sizeof(extensions)/sizeof(extensions[0]));
+}
+
+// The files CPUTConfigFile reads
+//-----------------------------------------------------------------------------
+static bool IsConfigFile(const std::string &name)
+{
+    static const char *extensions[] = { ".set", ".mtl", ".rs" };
+    return HasExtension(name, extensions, sizeof(extensions)/sizeof(extensions[0]));
+}
+
+// Replaces a config file's text with its cooked image.  Returns false, leaving it as text, if
+// it can't be cooked.
+//-----------------------------------------------------------------------------
+static bool Cook(std::vector<unsigned char> *pData)
+{
+    std::vector<CPUTConfigTextBlock> blocks;
+    std::vector<unsigned char> cooked;
+    CPUTParseConfigText(pData->empty() ? "" : (const char *)&(*pData)[0], pData->size(), &blocks);
+    if(!CPUTCookConfig(blocks, &cooked))
+    {
+        return false;
+    }
+    pData->swap(cooked);
+    return true;
+}
+
+// Returns false if compression isn't available or doesn't pay off
+//-----------------------------------------------------------------------------
+static bool Compress(uint16_t compression, const std::vector<unsigned char> &source, std::vector<unsigned char> *pCompressed)
+{
+    if(source.empty())
+    {
+        return false;
+    }
+    return CPUTArchive::Compress(compression, &source[0], source.size(), pCompressed) &&
+           pCompressed->size() <= source.size() - source.size() / 8;
+}
+
+//-----------------------------------------------------------------------------
+static bool WriteAt(FILE *pFile, uint64_t offset, const void *pData, size_t size)
+{
+#ifdef _WIN32
+    if(0 != _fseeki64(pFile, (__int64)offset, SEEK_SET))
+#else
+    if(0 != fseeko(pFile, (off_t)offset, SEEK_SET))
+#endif
+    {
+        return false;
+    }
+    return 0 == size || fwrite(pData, 1, size, pFile) == size;
+}
+
+//-----------------------------------------------------------------------------
+static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+//-----------------------------------------------------------------------------
+static int Pack(const PathString &directory, const PathString &archiveName, uint16_t compression, bool cook)
+{
+    std::vector<PackFile> files;
+    if(!ListFiles(directory, PathString(), &files))
+    {
+        fprintf(stderr, "CPUTPack: can't read every file under %s\n", ToUtf8(directory).c_str());
+        return 1;
+    }
+    std::sort(files.begin(), files.end(), [](const PackFile &a, const PackFile &b) { return a.name < b.name; });
+
+#ifdef _WIN32
+    FILE *pArchive = _wfopen(archiveName.c_str(), L"wb");
+#else
+    FILE *pArchive = fopen(archiveName.c_str(), "wb");
+#endif
+    if(!pArchive)
+    {
+        fprintf(stderr, "CPUTPack: can't create %s\n", ToUtf8(archiveName).c_str());
+        return 1;
+    }
+
+    std::vector<CPUTArchiveEntry> entries;
+    std::string names;
+    std::vector<unsigned char> data, compressed;
+    uint64_t offset = sizeof(CPUTArchiveHeader);
+    uint64_t totalSize = 0;
+    uint32_t cookedCount = 0;
+    for(size_t ii=0; ii<files.size(); ii++)
+    {
+        const PackFile &file = files[ii];
+        if(file.name.size() > 0xffff || names.size() + file.name.size() > 0xffffffff)
+        {
+            fprintf(stderr, "CPUTPack: name too long: %s\n", file.name.c_str());
+            fclose(pArchive);
+            return 1;
+        }
+        if(!ReadWholeFile(file.path, &data))
+        {
+            fprintf(stderr, "CPUTPack: can't read %s\n", file.name.c_str());
+            fclose(pArchive);
+            return 1;
+        }
+        if(cook && IsConfigFile(file.name))
+        {
+            if(Cook(&data))
+            {
+                cookedCount++;
+            }
+            else
+            {
+                fprintf(stderr, "CPUTPack: %s has a block with more than %d entries; storing it as text\n", file.name.c_str(), CPUT_COOKED_CONFIG_ENTRIES);
+            }
+        }
+
+        CPUTArchiveEntry entry;
+        entry.nameHash    = CPUTArchive::HashName(file.name);
+        entry.nameOffset  = (uint32_t)names.size();
+        entry.nameLength  = (uint16_t)file.name.size();
+        entry.size        = data.size();
+        entry.compression = CPUT_ARCHIVE_COMPRESSION_NONE;
+        const std::vector<unsigned char> *pStored = &data;
+        if(compression != CPUT_ARCHIVE_COMPRESSION_NONE && !data.empty() && Compress(compression, data, &compressed))
+        {
+            entry.compression = compression;
+            pStored = &compressed;
+        }
+        entry.storedSize = pStored->size();
+        entry.offset     = AlignUp(offset, IsPageAligned(file.name) ? CPUT_ARCHIVE_ALIGNMENT : 16);
+        if(!WriteAt(pArchive, entry.offset, pStored->empty() ? NULL : &(*pStored)[0], pStored->size()))
+        {
+            fprintf(stderr, "CPUTPack: error writing %s\n", ToUtf8(archiveName).c_str());
+            fclose(pArchive);
+            return 1;
+        }
+        offset = entry.offset + entry.storedSize;
+        totalSize += entry.size;
+        names += file.name;
+        entries.push_back(entry);
+    }
+
+    // The runtime binary searches the table of contents by hash
+    std::stable_sort(entries.begin(), entries.end(), [](const CPUTArchiveEntry &a, const CPUTArchiveEntry &b) { return a.nameHash < b.nameHash; });
+
+    CPUTArchiveHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic       = CPUT_ARCHIVE_MAGIC;
+    header.version     = CPUT_ARCHIVE_VERSION;
+    header.headerSize  = sizeof(CPUTArchiveHeader);
+    header.entryCount  = (uint32_t)entries.size();
+    header.alignment   = CPUT_ARCHIVE_ALIGNMENT;
+    header.tocOffset   = AlignUp(offset, 16);
+    header.namesOffset = header.tocOffset + entries.size() * sizeof(CPUTArchiveEntry);
+    header.namesSize   = names.size();
+    bool result = WriteAt(pArchive, header.tocOffset, entries.empty() ? NULL : &entries[0], entries.size() * sizeof(CPUTArchiveEntry)) &&
+                  WriteAt(pArchive, header.namesOffset, names.data(), names.size()) &&
+                  WriteAt(pArchive, 0, &header, sizeof(header));
+    result = (0 == fclose(pArchive)) && result;
+    if(!result)
+    {
+        fprintf(stderr, "CPUTPack: error writing %s\n", ToUtf8(archiveName).c_str());
+        return 1;
+    }
+    printf("CPUTPack: %u files (%u cooked), %llu bytes packed into %llu\n", header.entryCount, cookedCount,
+           (unsigned long long)totalSize, (unsigned long long)(header.namesOffset + header.namesSize));
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+#ifdef _WIN32
+int wmain(int argc, wchar_t **argv)
+#else
+int main(int argc, char **argv)
+#endif
+{
+    uint16_t compression = CPUT_ARCHIVE_COMPRESSION_NONE;
+    bool cook = false;
+    int argument = 1;
+    for( ; argument < argc - 2; argument++)
+    {
+        std::string option = ToUtf8(argv[argument]);
+        if(option == "--cook")
+        {
+            cook = true;
+        }
+        else if(option == "--lz4" && compression == CPUT_ARCHIVE_COMPRESSION_NONE)
+        {
+            compression = CPUT_ARCHIVE_COMPRESSION_LZ4;
+        }
+        else if(option == "--zstd" && compression == CPUT_ARCHIVE_COMPRESSION_NONE)
+        {
+            compression = CPUT_ARCHIVE_COMPRESSION_ZSTD;
+        }
+        else
+        {
+            argc = 0;
+            break;
+        }
+    }
+    if(argc < 3 || argument != argc - 2)
+    {
+        fprintf(stderr, "usage: CPUTPack [--cook] [--lz4 | --zstd] <directory> <archive.cpak>\n");
+        return 1;
+    }
+#ifndef CPUT_ARCHIVE_LZ4
+    if(compression == CPUT_ARCHIVE_COMPRESSION_LZ4)
+    {
+        fprintf(stderr, "CPUTPack: built without CPUT_ARCHIVE_LZ4\n");
+        return 1;
+    }
+#endif
+#ifndef CPUT_ARCHIVE_ZSTD
+    if(compression == CPUT_ARCHIVE_COMPRESSION_ZSTD)
+    {
+        fprintf(stderr, "CPUTPack: built without CPUT_ARCHIVE_ZSTD\n");
+        return 1;
+    }
+#endif
+    return Pack(argv[argument], argv[argument + 1], compression, cook);
+}
@@ -0,0 +1,199 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+// CullBench: times frustum culling world space bounding boxes one at a time, as
+// CPUTModelDX11::Render() does, against CPUTCullBoxes() (see CPUT/CPUT/CPUTBoxCulling.h).
+//
+//   CullBench [--runs <runs>] [<box count>...]
+//
+// Boxes of up to a few units are scattered through a cube 2000 units across around a camera at
+// its centre looking down +z with a 60 degree field of view, so about one in twenty is
+// visible; 10000, 100000 and 1000000 boxes by default.  Each count is culled <runs> times
+// (10 by default) four ways, keeping the fastest run of each:
+//   nodes    one box per node the size of a model, visited in shuffled order the way the
+//            recursive render traversal reaches models, with CPUTFrustum::IsVisible()'s test
+//   array    the same test over one contiguous array of boxes
+//   mask     CPUTCullBoxes() into a bitmask
+//   list     CPUTCullBoxes() then CPUTListVisibleBoxes()
+// and prints nanoseconds per box for each, and how many boxes the batched test decides
+// differently (only ever boxes touching a plane, when the build fuses multiply-adds).
+//
+// Builds on its own, on Windows or off it; add /arch:AVX or /arch:AVX512 (-mavx or -mavx512f)
+// for the wider batches:
+//   cl /EHsc /O2 /I..\CPUT CullBench.cpp ..\CPUT\CPUTBoxCulling.cpp
+//   g++ -std=c++11 -O2 -I../CPUT CullBench.cpp ../CPUT/CPUTBoxCulling.cpp
+#include "CPUTBoxCulling.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+// A render node's worth of memory around its bounds, so visiting nodes costs what it does in CPUT
+struct BenchNode
+{
+    float center[3];
+    float half[3];
+    char  rest[200];
+};
+
+//-----------------------------------------------------------------------------
+static bool IsVisible(const float pPlanes[6][4], const float pCenter[3], const float pHalf[3])
+{
+    for(int pp=0; pp<6; pp++)
+    {
+        float distance = pPlanes[pp][0]*pCenter[0] + pPlanes[pp][1]*pCenter[1] + pPlanes[pp][2]*pCenter[2] + pPlanes[pp][3];
+        float reach    = fabsf(pPlanes[pp][0])*pHalf[0] + fabsf(pPlanes[pp][1])*pHalf[1] + fabsf(pPlanes[pp][2])*pHalf[2];
+        if(distance > reach)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Planes of a camera at the origin looking down +z, normals out
+//-----------------------------------------------------------------------------
+static void MakePlanes(float fov, float nearDistance, float farDistance, float pPlanes[6][4])
+{
+    float c = cosf(fov * 0.5f), s = sinf(fov * 0.5f);
+    float planes[6][4] = {
+        {  0.0f, 0.0f, -1.0f,  nearDistance },  // near
+        { -c,    0.0f, -s,     0.0f },          // left
+        {  c,    0.0f, -s,     0.0f },          // right
+        {  0.0f,  c,   -s,     0.0f },          // top
+        {  0.0f, -c,   -s,     0.0f },          // bottom
+        {  0.0f, 0.0f,  1.0f, -farDistance },   // far
+    };
+    memcpy(pPlanes, planes, sizeof(planes));
+}
+
+//-----------------------------------------------------------------------------
+static double Seconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//-----------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    int runs = 10;
+    std::vector<uint32_t> counts;
+    for(int ii=1; ii<argc; ii++)
+    {
+        if(0 == strcmp(argv[ii], "--runs") && ii + 1 < argc)
+        {
+            runs = atoi(argv[++ii]);
+        }
+        else
+        {
+            counts.push_back((uint32_t)strtoul(argv[ii], NULL, 10));
+        }
+    }
+    if(counts.empty())
+    {
+        counts.push_back(10000);
+        counts.push_back(100000);
+        counts.push_back(1000000);
+    }
+    if(runs < 1)
+    {
+        runs = 1;
+    }
+
+    float planes[6][4];
+    MakePlanes(60.0f * 3.14159265f / 180.0f, 0.1f, 1000.0f, planes);
+    printf("CPUTCullBoxes() built with %s\n", CPUTCullBoxesInstructionSet());
+    printf("%10s %8s %10s %10s %10s %10s %10s\n", "boxes", "visible", "nodes", "array", "mask", "list", "differ");
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> position(-1000.0f, 1000.0f);
+    std::uniform_real_distribution<float> size(0.1f, 4.0f);
+    for(size_t cc=0; cc<counts.size(); cc++)
+    {
+        uint32_t count = counts[cc];
+        std::vector<BenchNode> nodes(count);
+        std::vector<BenchNode*> order(count);
+        CPUTCullBoxSet boxes;
+        boxes.Resize(count);
+        for(uint32_t ii=0; ii<count; ii++)
+        {
+            BenchNode &node = nodes[ii];
+            for(int kk=0; kk<3; kk++)
+            {
+                node.center[kk] = position(random);
+                node.half[kk]   = size(random);
+            }
+            boxes.Set(ii, node.center, node.half);
+            order[ii] = &node;
+        }
+        std::shuffle(order.begin(), order.end(), random);
+
+        std::vector<uint32_t> visible(CPUTCullBoxMaskWords(count));
+        std::vector<uint32_t> indices(count);
+        std::vector<unsigned char> expected(count);
+        double best[4] = { 1e30, 1e30, 1e30, 1e30 };
+        uint32_t seen[4] = { 0, 0, 0, 0 };
+        for(int rr=0; rr<runs; rr++)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            seen[0] = 0;
+            for(uint32_t ii=0; ii<count; ii++)
+            {
+                seen[0] += IsVisible(planes, order[ii]->center, order[ii]->half) ? 1 : 0;
+            }
+            best[0] = std::min(best[0], Seconds(start));
+
+            start = std::chrono::steady_clock::now();
+            seen[1] = 0;
+            for(uint32_t ii=0; ii<count; ii++)
+            {
+                expected[ii] = IsVisible(planes, nodes[ii].center, nodes[ii].half) ? 1 : 0;
+                seen[1] += expected[ii];
+            }
+            best[1] = std::min(best[1], Seconds(start));
+
+            start = std::chrono::steady_clock::now();
+            seen[2] = CPUTCullBoxes(boxes, planes, &visible[0]);
+            best[2] = std::min(best[2], Seconds(start));
+
+            start = std::chrono::steady_clock::now();
+            CPUTCullBoxes(boxes, planes, &visible[0]);
+            seen[3] = CPUTListVisibleBoxes(&visible[0], count, &indices[0]);
+            best[3] = std::min(best[3], Seconds(start));
+        }
+
+        uint32_t differ = 0;
+        for(uint32_t ii=0; ii<count; ii++)
+        {
+            differ += ((visible[ii / 32] >> (ii % 32)) & 1) != expected[ii] ? 1 : 0;
+        }
+        if(seen[0] != seen[1] || seen[2] != seen[3])
+        {
+            printf("visible counts disagree: %u %u %u %u\n", seen[0], seen[1], seen[2], seen[3]);
+            return 1;
+        }
+        printf("%10u %8u", count, seen[1]);
+        for(int ww=0; ww<4; ww++)
+        {
+            printf(" %8.2fns", best[ww] * 1e9 / count);
+        }
+        printf(" %10u\n", differ);
+    }
+    return 0;
+}
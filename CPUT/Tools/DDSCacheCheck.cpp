@@ -0,0 +1,261 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+// DDSCacheCheck: checks DDS metadata caches (name.dds.ddscache, see DDSImageCache.h) against a
+// fresh parse of their .dds files.
+//
+//   DDSCacheCheck [--write] [--key] <directory | file.dds>...
+//
+// Every .dds found (directories are searched recursively) is parsed with ParseDDSImage, and its
+// cache, if there is one, read back and compared with the result. Each file gets one line:
+//   ok        the cache matches the fresh parse
+//   missing   no cache; the runtime writes one on first load
+//   stale     the cache is for other contents (or damaged); the runtime rewrites it
+//   MISMATCH  the cache is current but describes the texture differently than the parser does
+//   INVALID   the .dds itself doesn't parse
+// By default the file name, size and time the cache was keyed on are not compared, so caches
+// made on another machine can be checked. --key compares them too, as the runtime does.
+// --write (re)writes every cache first, keyed on the files as they are here.
+// Returns 1 if any file is MISMATCH or INVALID.
+//
+// Builds on its own, on Windows or off it (dxgiformat.h comes from the DirectX-Headers package):
+//   cl /EHsc /O2 /I..\CPUT /I..\..\DirectXTex\DDSTextureLoader DDSCacheCheck.cpp ..\CPUT\CPUTMappedFile.cpp
+//      ..\..\DirectXTex\DDSTextureLoader\DDSImage.cpp ..\..\DirectXTex\DDSTextureLoader\DDSImageCache.cpp
+//   g++ -std=c++11 -O2 -I../CPUT -I../../DirectXTex/DDSTextureLoader -I<DirectX-Headers>/include/directx
+//      DDSCacheCheck.cpp ../CPUT/CPUTMappedFile.cpp ../../DirectXTex/DDSTextureLoader/DDSImage.cpp
+//      ../../DirectXTex/DDSTextureLoader/DDSImageCache.cpp
+#include "CPUTMappedFile.h"
+#include "DDSImageCache.h"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+typedef std::basic_string<CPUTMappedFile::PathChar> PathString;
+
+#ifdef _WIN32
+#define PATH_FORMAT "%ls"
+#else
+#define PATH_FORMAT "%s"
+#endif
+
+//-----------------------------------------------------------------------------
+static bool IsDDSFileName(const PathString &path)
+{
+    if(path.size() < 4)
+    {
+        return false;
+    }
+    const CPUTMappedFile::PathChar *pExtension = path.c_str() + path.size() - 4;
+    const char *dds = ".dds";
+    for(int ii=0; ii<4; ii++)
+    {
+        CPUTMappedFile::PathChar c = pExtension[ii];
+        if(c >= 'A' && c <= 'Z')
+        {
+            c += 'a' - 'A';
+        }
+        if(c != (CPUTMappedFile::PathChar)dds[ii])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+static bool ListDDSFiles(const PathString &directory, std::vector<PathString> *pFiles)
+{
+#ifdef _WIN32
+    WIN32_FIND_DATAW findData;
+    HANDLE hFind = FindFirstFileW((directory + L"\\*").c_str(), &findData);
+    if(INVALID_HANDLE_VALUE == hFind)
+    {
+        return false;
+    }
+    bool result = true;
+    do
+    {
+        PathString entry = findData.cFileName;
+        if(entry == L"." || entry == L"..")
+        {
+            continue;
+        }
+        if(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        {
+            result = ListDDSFiles(directory + L"\\" + entry, pFiles) && result;
+        }
+        else if(IsDDSFileName(entry))
+        {
+            pFiles->push_back(directory + L"\\" + entry);
+        }
+    } while(FindNextFileW(hFind, &findData));
+    FindClose(hFind);
+    return result;
+#else
+    DIR *pDir = opendir(directory.c_str());
+    if(!pDir)
+    {
+        return false;
+    }
+    bool result = true;
+    while(struct dirent *pEntry = readdir(pDir))
+    {
+        PathString entry = pEntry->d_name;
+        if(entry == "." || entry == "..")
+        {
+            continue;
+        }
+        PathString path = directory + "/" + entry;
+        struct stat status;
+        if(0 != stat(path.c_str(), &status))
+        {
+            result = false;
+        }
+        else if(S_ISDIR(status.st_mode))
+        {
+            result = ListDDSFiles(path, pFiles) && result;
+        }
+        else if(S_ISREG(status.st_mode) && IsDDSFileName(entry))
+        {
+            pFiles->push_back(path);
+        }
+    }
+    closedir(pDir);
+    return result;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+static bool IsDirectory(const PathString &path)
+{
+#ifdef _WIN32
+    DWORD attributes = GetFileAttributesW(path.c_str());
+    return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+    struct stat status;
+    return 0 == stat(path.c_str(), &status) && S_ISDIR(status.st_mode);
+#endif
+}
+
+enum CheckResult { CHECK_OK, CHECK_MISSING, CHECK_STALE, CHECK_MISMATCH, CHECK_INVALID };
+
+//-----------------------------------------------------------------------------
+static CheckResult CheckFile(const PathString &path, bool write, bool compareKey)
+{
+    CPUTMappedFile file;
+    DirectX::DDSImage image;
+    if(!file.Open(path.c_str()) ||
+       DirectX::ParseDDSImage(file.GetData(), file.GetSize(), &image) != DirectX::DDS_OK)
+    {
+        return CHECK_INVALID;
+    }
+    DirectX::DDSCachedImage parsed;
+    DirectX::BuildDDSCachedImage(image, &parsed);
+
+    DirectX::DDSCacheKey key;
+    if(!DirectX::GetDDSCacheKey(path.c_str(), &key))
+    {
+        return CHECK_INVALID;
+    }
+    PathString cacheFileName = DirectX::GetDDSCacheFileName(path.c_str());
+    if(write && !DirectX::WriteDDSImageCache(cacheFileName.c_str(), key, file.GetData(), file.GetSize(), parsed))
+    {
+        fprintf(stderr, "Can't write " PATH_FORMAT "\n", cacheFileName.c_str());
+    }
+
+    DirectX::DDSCacheKey cacheKey;
+    if(!DirectX::GetDDSCacheKey(cacheFileName.c_str(), &cacheKey))
+    {
+        return CHECK_MISSING;
+    }
+
+    DirectX::DDSCachedImage cached;
+    if(DirectX::ReadDDSImageCache(cacheFileName.c_str(), compareKey ? &key : NULL, file.GetData(), file.GetSize(), &cached) != DirectX::DDS_OK)
+    {
+        return CHECK_STALE;
+    }
+    return DirectX::IsSameDDSCachedImage(cached, parsed) ? CHECK_OK : CHECK_MISMATCH;
+}
+
+//-----------------------------------------------------------------------------
+#ifdef _WIN32
+int wmain(int argc, wchar_t **argv)
+#else
+int main(int argc, char **argv)
+#endif
+{
+    bool write = false;
+    bool compareKey = false;
+    std::vector<PathString> files;
+    for(int ii=1; ii<argc; ii++)
+    {
+        PathString argument = argv[ii];
+        const char *pOption = NULL;
+        if(argument.size() > 2 && argument[0] == '-' && argument[1] == '-')
+        {
+            static const char *options[] = { "--write", "--key" };
+            for(size_t jj=0; jj<sizeof(options)/sizeof(options[0]); jj++)
+            {
+                if(argument == PathString(options[jj], options[jj] + strlen(options[jj])))
+                {
+                    pOption = options[jj];
+                }
+            }
+            if(!pOption)
+            {
+                fprintf(stderr, "Unknown option " PATH_FORMAT "\n", argument.c_str());
+                return 1;
+            }
+            write      = write || 0 == strcmp(pOption, "--write");
+            compareKey = compareKey || 0 == strcmp(pOption, "--key");
+        }
+        else if(IsDirectory(argument))
+        {
+            if(!ListDDSFiles(argument, &files))
+            {
+                fprintf(stderr, "Can't list " PATH_FORMAT "\n", argument.c_str());
+            }
+        }
+        else
+        {
+            files.push_back(argument);
+        }
+    }
+    if(files.empty())
+    {
+        fprintf(stderr, "Usage: DDSCacheCheck [--write] [--key] <directory | file.dds>...\n");
+        return 1;
+    }
+
+    static const char *names[] = { "ok", "missing", "stale", "MISMATCH", "INVALID" };
+    unsigned int counts[5] = { 0 };
+    for(size_t ii=0; ii<files.size(); ii++)
+    {
+        CheckResult result = CheckFile(files[ii], write, compareKey);
+        counts[result]++;
+        printf("%-8s  " PATH_FORMAT "\n", names[result], files[ii].c_str());
+    }
+    printf("%u ok, %u missing, %u stale, %u mismatched, %u invalid\n",
+           counts[CHECK_OK], counts[CHECK_MISSING], counts[CHECK_STALE], counts[CHECK_MISMATCH], counts[CHECK_INVALID]);
+    return (counts[CHECK_MISMATCH] || counts[CHECK_INVALID]) ? 1 : 0;
+}
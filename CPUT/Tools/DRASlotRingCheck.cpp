@@ -0,0 +1,225 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+// DRASlotRingCheck: drives DRASlotRing (see InstantAccess_Tiling/DRASlotRing.h), the slot
+// bookkeeping behind DRATextureRing, against a fake fence whose GPU only gets as far as it's told.
+//
+//   DRASlotRingCheck
+//
+// Each check prints one line, ok or FAILED with what it expected:
+//   publish     acquire, publish and submit hand out slots in order and fence what was submitted
+//   reacquire   acquiring again before publishing returns the same slot
+//   wrap        once every slot is in flight nothing is free, and the first slot to retire is
+//               handed out again, past the end of the ring and back to its start
+//   published   the published slot isn't handed out, even once the GPU has finished with it
+//   blocking    AcquireBlocking() waits on the oldest fence that isn't the published slot's
+//               when nothing is free, and doesn't wait at all when something is
+//   single      a one slot ring hands out its published slot, after waiting for the GPU
+// Returns 1 if any check fails.
+//
+// Builds on its own, on Windows or off it:
+//   cl /EHsc /O2 /I..\..\InstantAccess_Tiling DRASlotRingCheck.cpp
+//   g++ -std=c++11 -O2 -I../../InstantAccess_Tiling DRASlotRingCheck.cpp
+#include "DRASlotRing.h"
+#include <stdio.h>
+#include <vector>
+
+// A GPU timeline that only moves when Complete() says so, or when waited on
+class FakeFence : public DRAFenceSource
+{
+public:
+    FakeFence() : mSignaled(0), mCompleted(0) {}
+
+    uint64_t Signal()            { return ++mSignaled; }
+    uint64_t GetCompletedValue() { return mCompleted; }
+    void     WaitForValue(uint64_t value)
+    {
+        // A real wait returns once the GPU gets there; this one gets it there
+        mWaits.push_back(value);
+        if( value > mCompleted )
+        {
+            mCompleted = value;
+        }
+    }
+    void     Complete(uint64_t value) { mCompleted = value; }
+
+    uint64_t              mSignaled;
+    uint64_t              mCompleted;
+    std::vector<uint64_t> mWaits;
+};
+
+static unsigned int gFailures = 0;
+
+//-----------------------------------------------------------------------------
+static bool Expect(bool passed, const char *pWhat)
+{
+    if( !passed )
+    {
+        printf("    expected %s\n", pWhat);
+    }
+    return passed;
+}
+
+//-----------------------------------------------------------------------------
+static void Report(const char *pName, bool passed)
+{
+    printf("%-8s  %s\n", passed ? "ok" : "FAILED", pName);
+    gFailures += passed ? 0 : 1;
+}
+
+// One frame of DRATextureRing: map, write, unmap, draw, submit
+//-----------------------------------------------------------------------------
+static unsigned int Frame(DRASlotRing &ring)
+{
+    unsigned int slot = ring.Acquire();
+    if( slot != DRASlotRing::INVALID_SLOT )
+    {
+        ring.Publish();
+        ring.Submit();
+    }
+    return slot;
+}
+
+//-----------------------------------------------------------------------------
+static bool CheckPublish()
+{
+    FakeFence fence;
+    DRASlotRing ring;
+    ring.Reset( &fence, 3 );
+    bool passed = Expect( ring.GetPublished() == DRASlotRing::INVALID_SLOT, "nothing published before the first frame" );
+    for( unsigned int ii=0; ii<3; ii++ )
+    {
+        passed &= Expect( ring.Acquire() == ii, "slots handed out in order" );
+        passed &= Expect( ring.GetAcquired() == ii, "the acquired slot to be remembered" );
+        passed &= Expect( ring.Publish() == ii, "Publish() to return the slot just written" );
+        passed &= Expect( ring.GetAcquired() == DRASlotRing::INVALID_SLOT, "nothing acquired after publishing" );
+        ring.Submit();
+        passed &= Expect( ring.GetSlotFence(ii) == ii + 1, "Submit() to fence the published slot with the next value" );
+    }
+    passed &= Expect( fence.mWaits.empty(), "no waits" );
+    return passed;
+}
+
+//-----------------------------------------------------------------------------
+static bool CheckReacquire()
+{
+    FakeFence fence;
+    DRASlotRing ring;
+    ring.Reset( &fence, 3 );
+    unsigned int first = ring.Acquire();
+    bool passed = Expect( ring.Acquire() == first, "the same slot until it's published" );
+    passed &= Expect( ring.Publish() == first, "that slot published" );
+    passed &= Expect( ring.Acquire() != first, "a different slot after publishing" );
+    return passed;
+}
+
+//-----------------------------------------------------------------------------
+static bool CheckWrap()
+{
+    FakeFence fence;
+    DRASlotRing ring;
+    ring.Reset( &fence, 3 );
+    bool passed = true;
+    for( unsigned int ii=0; ii<3; ii++ )
+    {
+        Frame( ring );
+    }
+    // Fences 1, 2 and 3 are out, on slots 0, 1 and 2; slot 2 is published
+    passed &= Expect( ring.Acquire() == DRASlotRing::INVALID_SLOT, "no free slot while all are in flight" );
+    fence.Complete( 1 );
+    passed &= Expect( Frame( ring ) == 0, "slot 0 again once its fence passed" );
+    passed &= Expect( ring.Acquire() == DRASlotRing::INVALID_SLOT, "slot 1 still busy" );
+    fence.Complete( 3 );
+    passed &= Expect( Frame( ring ) == 1, "slot 1 next around the ring" );
+    fence.Complete( 5 );
+    passed &= Expect( Frame( ring ) == 2, "then slot 2" );
+    passed &= Expect( Frame( ring ) == 0, "then back to slot 0" );
+    passed &= Expect( fence.mWaits.empty(), "no waits" );
+    return passed;
+}
+
+//-----------------------------------------------------------------------------
+static bool CheckPublished()
+{
+    FakeFence fence;
+    DRASlotRing ring;
+    ring.Reset( &fence, 2 );
+    Frame( ring );
+    Frame( ring );
+    fence.Complete( 2 );
+    // Both retired; slot 1 is published, so only slot 0 may be written
+    bool passed = Expect( Frame( ring ) == 0, "slot 0" );
+    fence.Complete( 3 );
+    passed &= Expect( Frame( ring ) == 1, "slot 1, now that slot 0 is the published one" );
+    fence.Complete( fence.mSignaled );
+    passed &= Expect( ring.Acquire() != ring.GetPublished(), "never the published slot" );
+    return passed;
+}
+
+//-----------------------------------------------------------------------------
+static bool CheckBlocking()
+{
+    FakeFence fence;
+    DRASlotRing ring;
+    ring.Reset( &fence, 3 );
+    for( unsigned int ii=0; ii<3; ii++ )
+    {
+        Frame( ring );
+    }
+    // Slots 0, 1 and 2 carry fences 1, 2 and 3, none passed, slot 2 published
+    unsigned int slot = ring.AcquireBlocking();
+    bool passed = Expect( fence.mWaits.size() == 1 && fence.mWaits[0] == 1, "one wait, on fence 1" );
+    passed &= Expect( slot == 0, "slot 0 once its fence passed" );
+    ring.Publish();
+    ring.Submit();
+
+    // Slot 0 is published with fence 4; the oldest other fence is slot 1's 2
+    slot = ring.AcquireBlocking();
+    passed &= Expect( fence.mWaits.size() == 2 && fence.mWaits[1] == 2, "a second wait, on fence 2" );
+    passed &= Expect( slot == 1, "slot 1" );
+    ring.Publish();
+    ring.Submit();
+
+    fence.Complete( fence.mSignaled );
+    slot = ring.AcquireBlocking();
+    passed &= Expect( fence.mWaits.size() == 2, "no wait while a slot is free" );
+    passed &= Expect( slot != ring.GetPublished(), "a slot other than the published one" );
+    return passed;
+}
+
+//-----------------------------------------------------------------------------
+static bool CheckSingle()
+{
+    FakeFence fence;
+    DRASlotRing ring;
+    ring.Reset( &fence, 1 );
+    bool passed = Expect( Frame( ring ) == 0, "slot 0" );
+    passed &= Expect( ring.Acquire() == DRASlotRing::INVALID_SLOT, "nothing free while the GPU reads it" );
+    passed &= Expect( ring.AcquireBlocking() == 0, "slot 0 again, after waiting" );
+    passed &= Expect( fence.mWaits.size() == 1 && fence.mWaits[0] == 1, "one wait, on fence 1" );
+    return passed;
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+    Report( "publish",   CheckPublish() );
+    Report( "reacquire", CheckReacquire() );
+    Report( "wrap",      CheckWrap() );
+    Report( "published", CheckPublished() );
+    Report( "blocking",  CheckBlocking() );
+    Report( "single",    CheckSingle() );
+    return gFailures ? 1 : 0;
+}
@@ -0,0 +1,496 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+// MDLCheck: validates binary model files (.mdl, see CPUT/CPUT/CPUTModelFile.h) and times
+// loading them.
+//
+//   MDLCheck [--bench <runs>] [--quantize] [--clusters] <directory | file.mdl>...
+//
+// Every .mdl found (directories are searched recursively) is mapped and parsed in place, as
+// CPUTModel::LoadModelPayload() does.  Each file gets one line with its mesh, vertex and index
+// counts and how many meshes load with 16-bit indices (stored that way or narrowed at load), or
+// the reason it doesn't parse.  With --bench each file is also loaded <runs> times
+// two ways, keeping the fastest run of each:
+//   mapped  map the file and parse it in place
+//   stream  read it through std::ifstream into heap buffers, one per mesh, as CPUT used to
+// Both sum every vertex and index byte afterwards, standing in for the copy the GPU makes, so
+// the difference is the cost of the stream reads and heap copies.  Run it twice to time the
+// file cache rather than the disk.
+// With --quantize each mesh is also packed as the loader does when
+// CPUTAssetLibrary::SetQuantizeVertices() is on (see CPUT/CPUT/CPUTVertexQuantizer.h), printing
+// its vertex size before and after and how far that moved any position, direction or texture
+// coordinate.
+// With --clusters each mesh is also split into clusters as the loader does when
+// CPUTAssetLibrary::SetClusterMeshes() is on (see CPUT/CPUT/CPUTMeshClusters.h), printing how
+// many there are, then the share of triangles left to draw after culling them from six views
+// along the axes, backfaces only, and with a frustum plane through the middle of the mesh.
+// Returns 1 if any file doesn't parse.
+//
+// Builds on its own, on Windows or off it:
+//   cl /EHsc /O2 /I..\CPUT MDLCheck.cpp ..\CPUT\CPUTModelFile.cpp ..\CPUT\CPUTMappedFile.cpp ..\CPUT\CPUTVertexQuantizer.cpp ..\CPUT\CPUTMeshClusters.cpp
+//   g++ -std=c++11 -O2 -I../CPUT MDLCheck.cpp ../CPUT/CPUTModelFile.cpp ../CPUT/CPUTMappedFile.cpp ../CPUT/CPUTVertexQuantizer.cpp ../CPUT/CPUTMeshClusters.cpp
+#include "CPUTMappedFile.h"
+#include "CPUTMeshClusters.h"
+#include "CPUTModelFile.h"
+#include "CPUTVertexQuantizer.h"
+#include <float.h>
+#include <chrono>
+#include <fstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+typedef std::basic_string<CPUTMappedFile::PathChar> PathString;
+
+#ifdef _WIN32
+#define PATH_FORMAT "%ls"
+#else
+#define PATH_FORMAT "%s"
+#endif
+
+//-----------------------------------------------------------------------------
+static bool IsMDLFileName(const PathString &path)
+{
+    if(path.size() < 4)
+    {
+        return false;
+    }
+    const CPUTMappedFile::PathChar *pExtension = path.c_str() + path.size() - 4;
+    const char *mdl = ".mdl";
+    for(int ii=0; ii<4; ii++)
+    {
+        CPUTMappedFile::PathChar c = pExtension[ii];
+        if(c >= 'A' && c <= 'Z')
+        {
+            c += 'a' - 'A';
+        }
+        if(c != (CPUTMappedFile::PathChar)mdl[ii])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+static bool ListMDLFiles(const PathString &directory, std::vector<PathString> *pFiles)
+{
+#ifdef _WIN32
+    WIN32_FIND_DATAW findData;
+    HANDLE hFind = FindFirstFileW((directory + L"\\*").c_str(), &findData);
+    if(INVALID_HANDLE_VALUE == hFind)
+    {
+        return false;
+    }
+    bool result = true;
+    do
+    {
+        PathString entry = findData.cFileName;
+        if(entry == L"." || entry == L"..")
+        {
+            continue;
+        }
+        if(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        {
+            result = ListMDLFiles(directory + L"\\" + entry, pFiles) && result;
+        }
+        else if(IsMDLFileName(entry))
+        {
+            pFiles->push_back(directory + L"\\" + entry);
+        }
+    } while(FindNextFileW(hFind, &findData));
+    FindClose(hFind);
+    return result;
+#else
+    DIR *pDir = opendir(directory.c_str());
+    if(!pDir)
+    {
+        return false;
+    }
+    bool result = true;
+    while(struct dirent *pEntry = readdir(pDir))
+    {
+        PathString entry = pEntry->d_name;
+        if(entry == "." || entry == "..")
+        {
+            continue;
+        }
+        PathString path = directory + "/" + entry;
+        struct stat status;
+        if(0 != stat(path.c_str(), &status))
+        {
+            result = false;
+        }
+        else if(S_ISDIR(status.st_mode))
+        {
+            result = ListMDLFiles(path, pFiles) && result;
+        }
+        else if(S_ISREG(status.st_mode) && IsMDLFileName(entry))
+        {
+            pFiles->push_back(path);
+        }
+    }
+    closedir(pDir);
+    return result;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+static bool IsDirectory(const PathString &path)
+{
+#ifdef _WIN32
+    DWORD attributes = GetFileAttributesW(path.c_str());
+    return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+    struct stat status;
+    return 0 == stat(path.c_str(), &status) && S_ISDIR(status.st_mode);
+#endif
+}
+
+//-----------------------------------------------------------------------------
+static uint64_t SumBytes(const void *pData, uint64_t size)
+{
+    const unsigned char *pBytes = (const unsigned char *)pData;
+    uint64_t sum = 0;
+    for(uint64_t ii=0; ii<size; ii++)
+    {
+        sum += pBytes[ii];
+    }
+    return sum;
+}
+
+//-----------------------------------------------------------------------------
+static bool LoadMapped(const PathString &path, uint64_t *pSum)
+{
+    CPUTMappedFile file;
+    if(!file.Open(path.c_str()))
+    {
+        return false;
+    }
+    file.WillNeed();
+    std::vector<CPUTModelFileMesh> meshes;
+    if(CPUTParseModelFile(file.GetData(), file.GetSize(), &meshes) != CPUT_MODEL_FILE_OK)
+    {
+        return false;
+    }
+    uint64_t sum = 0;
+    for(size_t ii=0; ii<meshes.size(); ii++)
+    {
+        sum += SumBytes(meshes[ii].pIndices, (uint64_t)meshes[ii].indexCount * meshes[ii].indexSize);
+        sum += SumBytes(meshes[ii].pVertices, meshes[ii].verticesSizeInBytes);
+    }
+    *pSum = sum;
+    return true;
+}
+
+// The reads CPUTRawMeshData::Read() makes, without its checks
+//-----------------------------------------------------------------------------
+static bool LoadStream(const PathString &path, uint64_t *pSum)
+{
+    std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+    if(!file)
+    {
+        return false;
+    }
+    uint64_t sum = 0;
+    for(;;)
+    {
+        uint32_t cookie;
+        file.read((char*)&cookie, sizeof(cookie));
+        if(!file.good())
+        {
+            break;
+        }
+        CPUTModelFileMeshHeader header;
+        file.read((char*)&header, sizeof(header));
+        std::vector<CPUTModelFileElement> elements(header.formatDescriptorCount);
+        if(!elements.empty())
+        {
+            file.read((char*)&elements[0], elements.size() * sizeof(CPUTModelFileElement));
+        }
+        uint32_t indexCount, indexType;
+        file.read((char*)&indexCount, sizeof(indexCount));
+        file.read((char*)&indexType, sizeof(indexType));
+        if(!file.good())
+        {
+            return false;
+        }
+        size_t indicesSize = (size_t)indexCount * (indexType == CPUT_MODEL_FILE_INDEX_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t));
+        char *pIndices = new char[indicesSize];
+        file.read(pIndices, indicesSize);
+        file.read((char*)&cookie, sizeof(cookie));
+        sum += SumBytes(pIndices, indicesSize);
+        delete [] pIndices;
+        if(header.totalVerticesSizeInBytes != 0)
+        {
+            size_t size = (size_t)header.vertexCount * (header.stride + header.paddingSize);
+            char *pVertices = new char[size];
+            memset(pVertices, 0, size);
+            file.read(pVertices, size);
+            sum += SumBytes(pVertices, size);
+            delete [] pVertices;
+        }
+        file.read((char*)&cookie, sizeof(cookie));
+        if(!file.good())
+        {
+            return false;
+        }
+    }
+    *pSum = sum;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+template<typename Load>
+static double BestTime(Load load, const PathString &path, int runs, uint64_t *pSum)
+{
+    double best = 0.0;
+    for(int ii=0; ii<runs; ii++)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        if(!load(path, pSum))
+        {
+            return -1.0;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = (ii == 0 || seconds < best) ? seconds : best;
+    }
+    return best;
+}
+
+// One box spans every mesh of a model, as in CPUTModel::LoadModelPayload()
+//-----------------------------------------------------------------------------
+static void PrintQuantization(const std::vector<CPUTModelFileMesh> &meshes)
+{
+    std::vector< std::vector<CPUTQuantizedElement> > plans(meshes.size());
+    float minimum[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float maximum[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for(size_t ii=0; ii<meshes.size(); ii++)
+    {
+        const CPUTModelFileMesh &mesh = meshes[ii];
+        if(mesh.pVertices && !CPUTPlanVertexQuantization(mesh.pElements, mesh.pHeader->formatDescriptorCount, &plans[ii]))
+        {
+            printf("         mesh %u has a position or direction that isn't three floats, not quantized\n", (unsigned int)ii);
+            return;
+        }
+        CPUTGrowQuantizationBounds((const unsigned char *)mesh.pVertices, mesh.pHeader->vertexCount, mesh.vertexStride, plans[ii], minimum, maximum);
+    }
+    CPUTQuantizationBox box;
+    CPUTMakeQuantizationBox(minimum, maximum, &box);
+
+    std::vector<unsigned char> quantized;
+    for(size_t ii=0; ii<meshes.size(); ii++)
+    {
+        const CPUTModelFileMesh &mesh = meshes[ii];
+        if(plans[ii].empty())
+        {
+            continue;
+        }
+        uint32_t stride = plans[ii].back().offset + plans[ii].back().size;
+        quantized.resize((size_t)mesh.pHeader->vertexCount * stride);
+        CPUTQuantizationError error;
+        CPUTQuantizeVertices(quantized.empty() ? NULL : &quantized[0], (const unsigned char *)mesh.pVertices, mesh.pHeader->vertexCount,
+                             mesh.vertexStride, plans[ii], box, &error);
+        printf("         mesh %4u  %3u -> %3u bytes per vertex   error: position %g  direction %.4f degrees  uv %g\n",
+               (unsigned int)ii, mesh.vertexStride, stride, error.position, error.direction, error.texCoord);
+    }
+}
+
+//-----------------------------------------------------------------------------
+static void PrintClusters(const std::vector<CPUTModelFileMesh> &meshes)
+{
+    std::vector<uint32_t> indices;
+    std::vector<CPUTMeshCluster> clusters;
+    std::vector<CPUTMeshClusterRange> ranges;
+    for(size_t ii=0; ii<meshes.size(); ii++)
+    {
+        const CPUTModelFileMesh &mesh = meshes[ii];
+        int positionOffset = CPUTGetModelFilePositionOffset(mesh);
+        CPUTReadModelFileIndices(mesh, &indices);
+        if(!mesh.pVertices || positionOffset < 0 || indices.empty() ||
+           !CPUTBuildMeshClusters(&indices[0], indices.size(), (const unsigned char *)mesh.pVertices + positionOffset, mesh.vertexStride,
+                                  mesh.pHeader->vertexCount, CPUT_MESH_CLUSTER_TRIANGLES, &clusters))
+        {
+            printf("         mesh %4u  no positions, or not a triangle list over its vertices\n", (unsigned int)ii);
+            continue;
+        }
+
+        // The views are twice the mesh's size away from its middle
+        float minimum[3] = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
+        float maximum[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+        for(size_t jj=0; jj<clusters.size(); jj++)
+        {
+            for(int cc=0; cc<3; cc++)
+            {
+                float low  = clusters[jj].boundsCenter[cc] - clusters[jj].boundsHalf[cc];
+                float high = clusters[jj].boundsCenter[cc] + clusters[jj].boundsHalf[cc];
+                minimum[cc] = low  < minimum[cc] ? low  : minimum[cc];
+                maximum[cc] = high > maximum[cc] ? high : maximum[cc];
+            }
+        }
+        float center[3], size = 0.0f;
+        for(int cc=0; cc<3; cc++)
+        {
+            center[cc] = (minimum[cc] + maximum[cc]) * 0.5f;
+            size = maximum[cc] - minimum[cc] > size ? maximum[cc] - minimum[cc] : size;
+        }
+        float everything[6][4] = { { 0, 0, 0, -1 }, { 0, 0, 0, -1 }, { 0, 0, 0, -1 }, { 0, 0, 0, -1 }, { 0, 0, 0, -1 }, { 0, 0, 0, -1 } };
+        double backfaceKept = 0.0, halfKept = 0.0;
+        for(int view=0; view<6; view++)
+        {
+            float eye[3] = { center[0], center[1], center[2] };
+            eye[view / 2] += (view & 1 ? -2.0f : 2.0f) * size;
+            backfaceKept += (double)CPUTCullMeshClusters(&clusters[0], clusters.size(), everything, eye, &ranges) / indices.size() / 6.0;
+
+            float half[6][4];
+            memcpy(half, everything, sizeof(half));
+            half[0][view / 2] = view & 1 ? -1.0f : 1.0f;
+            half[0][3]        = view & 1 ? center[view / 2] : -center[view / 2];
+            halfKept += (double)CPUTCullMeshClusters(&clusters[0], clusters.size(), half, NULL, &ranges) / indices.size() / 6.0;
+        }
+        printf("         mesh %4u  %6u clusters of %5.1f triangles   drawn: %5.1f%% backface culled, %5.1f%% half out of the frustum\n",
+               (unsigned int)ii, (unsigned int)clusters.size(), indices.size() / 3.0 / clusters.size(), backfaceKept * 100.0, halfKept * 100.0);
+    }
+}
+
+//-----------------------------------------------------------------------------
+#ifdef _WIN32
+int wmain(int argc, wchar_t **argv)
+#else
+int main(int argc, char **argv)
+#endif
+{
+    int runs = 0;
+    bool quantize = false;
+    bool cluster = false;
+    std::vector<PathString> files;
+    for(int ii=1; ii<argc; ii++)
+    {
+        PathString argument = argv[ii];
+        static const char bench[] = "--bench";
+        static const char quantizeOption[] = "--quantize";
+        static const char clustersOption[] = "--clusters";
+        if(argument == PathString(bench, bench + strlen(bench)) && ii + 1 < argc)
+        {
+            PathString count = argv[++ii];
+            runs = atoi(std::string(count.begin(), count.end()).c_str());
+        }
+        else if(argument == PathString(quantizeOption, quantizeOption + strlen(quantizeOption)))
+        {
+            quantize = true;
+        }
+        else if(argument == PathString(clustersOption, clustersOption + strlen(clustersOption)))
+        {
+            cluster = true;
+        }
+        else if(argument.size() > 2 && argument[0] == '-' && argument[1] == '-')
+        {
+            fprintf(stderr, "Unknown option " PATH_FORMAT "\n", argument.c_str());
+            return 1;
+        }
+        else if(IsDirectory(argument))
+        {
+            if(!ListMDLFiles(argument, &files))
+            {
+                fprintf(stderr, "Can't list " PATH_FORMAT "\n", argument.c_str());
+            }
+        }
+        else
+        {
+            files.push_back(argument);
+        }
+    }
+    if(files.empty() || runs < 0)
+    {
+        fprintf(stderr, "Usage: MDLCheck [--bench <runs>] [--quantize] [--clusters] <directory | file.mdl>...\n");
+        return 1;
+    }
+
+    static const char *reasons[] = { "ok", "bad cookie", "truncated", "elements don't fit the stride or bad index type" };
+    unsigned int invalid = 0;
+    double mappedTotal = 0.0, streamTotal = 0.0, megabytes = 0.0;
+    for(size_t ii=0; ii<files.size(); ii++)
+    {
+        CPUTMappedFile file;
+        if(!file.Open(files[ii].c_str()))
+        {
+            printf("INVALID  can't open  " PATH_FORMAT "\n", files[ii].c_str());
+            invalid++;
+            continue;
+        }
+        std::vector<CPUTModelFileMesh> meshes;
+        CPUTModelFileResult result = CPUTParseModelFile(file.GetData(), file.GetSize(), &meshes);
+        if(result != CPUT_MODEL_FILE_OK)
+        {
+            printf("INVALID  %s  " PATH_FORMAT "\n", reasons[result], files[ii].c_str());
+            invalid++;
+            continue;
+        }
+        uint64_t vertices = 0, indices = 0;
+        unsigned int meshes16Bit = 0;
+        std::vector<uint16_t> narrowed;
+        for(size_t jj=0; jj<meshes.size(); jj++)
+        {
+            const CPUTModelFileMesh &mesh = meshes[jj];
+            vertices += mesh.pHeader->vertexCount;
+            indices  += mesh.indexCount;
+            if(mesh.indexType == CPUT_MODEL_FILE_INDEX_UINT16 ||
+               CPUTNarrowIndices(mesh.pIndices, mesh.indexCount, mesh.pHeader->vertexCount, &narrowed))
+            {
+                meshes16Bit++;
+            }
+        }
+        printf("ok       %4u meshes %10llu vertices %10llu indices  %4u 16-bit  " PATH_FORMAT "\n",
+               (unsigned int)meshes.size(), (unsigned long long)vertices, (unsigned long long)indices, meshes16Bit, files[ii].c_str());
+        if(quantize)
+        {
+            PrintQuantization(meshes);
+        }
+        if(cluster)
+        {
+            PrintClusters(meshes);
+        }
+
+        if(runs > 0)
+        {
+            uint64_t mappedSum = 0, streamSum = 0;
+            double mapped = BestTime(LoadMapped, files[ii], runs, &mappedSum);
+            double stream = BestTime(LoadStream, files[ii], runs, &streamSum);
+            double size = file.GetSize() / (1024.0 * 1024.0);
+            printf("         mapped %9.3f ms %8.1f MB/s   stream %9.3f ms %8.1f MB/s%s\n",
+                   mapped * 1000.0, size / mapped, stream * 1000.0, size / stream,
+                   (mapped < 0.0 || stream < 0.0 || mappedSum != streamSum) ? "   (loads disagree)" : "");
+            mappedTotal += mapped;
+            streamTotal += stream;
+            megabytes   += size;
+        }
+    }
+    if(runs > 0 && mappedTotal > 0.0 && streamTotal > 0.0)
+    {
+        printf("total    mapped %9.3f ms %8.1f MB/s   stream %9.3f ms %8.1f MB/s\n",
+               mappedTotal * 1000.0, megabytes / mappedTotal, streamTotal * 1000.0, megabytes / streamTotal);
+    }
+    printf("%u ok, %u invalid\n", (unsigned int)(files.size() - invalid), invalid);
+    return invalid ? 1 : 0;
+}
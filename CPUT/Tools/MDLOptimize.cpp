@@ -0,0 +1,205 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+// MDLOptimize: cooks binary model files (.mdl) for the GPU with CPUTMeshOptimizer (see
+// CPUT/CPUT/CPUTMeshOptimizer.h), so the loader doesn't have to.
+//
+//   MDLOptimize [--cache <size>] [--threshold <t>] [--no-overdraw] [--no-fetch] <in.mdl> [<out.mdl>]
+//
+// Every mesh's triangles are reordered for the post-transform vertex cache and for overdraw,
+// then its vertices for fetch locality.  Unused vertices are dropped, and meshes of at most
+// 65535 vertices are written with 16-bit indices.  Prints each mesh's ACMR (vertices transformed
+// per triangle) and ATVR (per vertex used) before and after, with a FIFO cache of --cache
+// vertices (16 by default, also the size the reordering targets).  Without out.mdl nothing is
+// written; out.mdl may be in.mdl.
+// --threshold is how much ACMR the overdraw pass may give up to split clusters (1.05 by default).
+//
+// Builds on its own, on Windows or off it:
+//   cl /EHsc /O2 /I..\CPUT MDLOptimize.cpp ..\CPUT\CPUTMeshOptimizer.cpp ..\CPUT\CPUTModelFile.cpp ..\CPUT\CPUTMappedFile.cpp
+//   g++ -std=c++11 -O2 -I../CPUT MDLOptimize.cpp ../CPUT/CPUTMeshOptimizer.cpp ../CPUT/CPUTModelFile.cpp ../CPUT/CPUTMappedFile.cpp
+#include "CPUTMappedFile.h"
+#include "CPUTMeshOptimizer.h"
+#include "CPUTModelFile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+typedef std::basic_string<CPUTMappedFile::PathChar> PathString;
+
+#ifdef _WIN32
+#define PATH_FORMAT "%ls"
+#else
+#define PATH_FORMAT "%s"
+#endif
+
+//-----------------------------------------------------------------------------
+static bool IsOption(const PathString &argument, const char *pOption)
+{
+    return argument == PathString(pOption, pOption + strlen(pOption));
+}
+
+//-----------------------------------------------------------------------------
+static double ToNumber(const PathString &argument)
+{
+    return atof(std::string(argument.begin(), argument.end()).c_str());
+}
+
+//-----------------------------------------------------------------------------
+static bool WriteFile(const PathString &fileName, const std::vector<unsigned char> &data)
+{
+#ifdef _WIN32
+    FILE *pFile = _wfopen(fileName.c_str(), L"wb");
+#else
+    FILE *pFile = fopen(fileName.c_str(), "wb");
+#endif
+    if(!pFile)
+    {
+        return false;
+    }
+    bool result = data.empty() || fwrite(&data[0], data.size(), 1, pFile) == 1;
+    return (0 == fclose(pFile)) && result;
+}
+
+//-----------------------------------------------------------------------------
+static void PrintStats(const char *pLabel, const CPUTVertexCacheStats &before, const CPUTVertexCacheStats &after)
+{
+    printf("%-6s %10llu triangles   ACMR %.3f -> %.3f   ATVR %.3f -> %.3f\n", pLabel,
+           (unsigned long long)before.triangleCount, before.acmr, after.acmr, before.atvr, after.atvr);
+}
+
+//-----------------------------------------------------------------------------
+#ifdef _WIN32
+int wmain(int argc, wchar_t **argv)
+#else
+int main(int argc, char **argv)
+#endif
+{
+    CPUTMeshOptimizerOptions options;
+    std::vector<PathString> files;
+    for(int ii=1; ii<argc; ii++)
+    {
+        PathString argument = argv[ii];
+        if(IsOption(argument, "--cache") && ii + 1 < argc)
+        {
+            options.cacheSize = (uint32_t)ToNumber(argv[++ii]);
+        }
+        else if(IsOption(argument, "--threshold") && ii + 1 < argc)
+        {
+            options.overdrawThreshold = (float)ToNumber(argv[++ii]);
+        }
+        else if(IsOption(argument, "--no-overdraw"))
+        {
+            options.optimizeOverdraw = false;
+        }
+        else if(IsOption(argument, "--no-fetch"))
+        {
+            options.optimizeVertexFetch = false;
+        }
+        else if(argument.size() > 2 && argument[0] == '-' && argument[1] == '-')
+        {
+            fprintf(stderr, "Unknown option " PATH_FORMAT "\n", argument.c_str());
+            return 1;
+        }
+        else
+        {
+            files.push_back(argument);
+        }
+    }
+    if(files.empty() || files.size() > 2 || !options.cacheSize)
+    {
+        fprintf(stderr, "Usage: MDLOptimize [--cache <size>] [--threshold <t>] [--no-overdraw] [--no-fetch] <in.mdl> [<out.mdl>]\n");
+        return 1;
+    }
+
+    CPUTMappedFile file;
+    std::vector<CPUTModelFileMesh> meshes;
+    if(!file.Open(files[0].c_str()) || CPUTParseModelFile(file.GetData(), file.GetSize(), &meshes) != CPUT_MODEL_FILE_OK)
+    {
+        fprintf(stderr, "Can't read " PATH_FORMAT "\n", files[0].c_str());
+        return 1;
+    }
+
+    std::vector<unsigned char> output;
+    CPUTVertexCacheStats totalBefore = CPUTVertexCacheStats(), totalAfter = CPUTVertexCacheStats();
+    for(size_t ii=0; ii<meshes.size(); ii++)
+    {
+        const CPUTModelFileMesh &mesh = meshes[ii];
+        CPUTModelFileMeshHeader header = *mesh.pHeader;
+        std::vector<uint32_t> indices;
+        CPUTReadModelFileIndices(mesh, &indices);
+        std::vector<unsigned char> vertices((const unsigned char *)mesh.pVertices, (const unsigned char *)mesh.pVertices + mesh.verticesSizeInBytes);
+
+        CPUTVertexCacheStats before, after;
+        CPUTAnalyzeVertexCache(indices.empty() ? NULL : &indices[0], indices.size(), header.vertexCount, options.cacheSize, &before);
+        bool optimized = mesh.pVertices &&
+                         CPUTOptimizeMesh(&indices, &vertices, mesh.vertexStride, CPUTGetModelFilePositionOffset(mesh), options);
+        if(optimized)
+        {
+            header.vertexCount = (uint32_t)(vertices.size() / mesh.vertexStride);
+            header.totalVerticesSizeInBytes = vertices.size();
+        }
+        CPUTAnalyzeVertexCache(indices.empty() ? NULL : &indices[0], indices.size(), header.vertexCount, options.cacheSize, &after);
+
+        char label[32];
+        sprintf(label, "%u", (unsigned int)ii);
+        PrintStats(label, before, after);
+        if(!optimized)
+        {
+            printf("       not a triangle list over its vertices, left as it is\n");
+        }
+        totalBefore.triangleCount += before.triangleCount;
+        totalBefore.vertexCount   += before.vertexCount;
+        totalBefore.missCount     += before.missCount;
+        totalAfter.triangleCount  += after.triangleCount;
+        totalAfter.vertexCount    += after.vertexCount;
+        totalAfter.missCount      += after.missCount;
+
+        std::vector<uint16_t> narrowed;
+        if(optimized && !indices.empty() && CPUTNarrowIndices(&indices[0], (uint32_t)indices.size(), header.vertexCount, &narrowed))
+        {
+            CPUTAppendModelFileMesh(&output, header, mesh.pElements, (uint32_t)narrowed.size(), CPUT_MODEL_FILE_INDEX_UINT16, &narrowed[0],
+                                    vertices.empty() ? NULL : &vertices[0]);
+        }
+        else if(optimized)
+        {
+            CPUTAppendModelFileMesh(&output, header, mesh.pElements, (uint32_t)indices.size(), CPUT_MODEL_FILE_INDEX_UINT32,
+                                    indices.empty() ? NULL : &indices[0], vertices.empty() ? NULL : &vertices[0]);
+        }
+        else
+        {
+            CPUTAppendModelFileMesh(&output, header, mesh.pElements, mesh.indexCount, mesh.indexType, mesh.pIndices, mesh.pVertices);
+        }
+    }
+    totalBefore.acmr = totalBefore.triangleCount ? (double)totalBefore.missCount / totalBefore.triangleCount : 0.0;
+    totalBefore.atvr = totalBefore.vertexCount   ? (double)totalBefore.missCount / totalBefore.vertexCount   : 0.0;
+    totalAfter.acmr  = totalAfter.triangleCount  ? (double)totalAfter.missCount  / totalAfter.triangleCount  : 0.0;
+    totalAfter.atvr  = totalAfter.vertexCount    ? (double)totalAfter.missCount  / totalAfter.vertexCount    : 0.0;
+    PrintStats("total", totalBefore, totalAfter);
+
+    // Done with the input before it's overwritten
+    file.Close();
+    if(files.size() > 1)
+    {
+        if(!WriteFile(files[1], output))
+        {
+            fprintf(stderr, "Can't write " PATH_FORMAT "\n", files[1].c_str());
+            return 1;
+        }
+        printf("Wrote " PATH_FORMAT ", %llu bytes\n", files[1].c_str(), (unsigned long long)output.size());
+    }
+    return 0;
+}
@@ -0,0 +1,341 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+// TransformBench: times moving a few nodes of a scene graph and then reading every node's world
+// matrix, the way a frame of CPUT does, with CPUTRenderNode's old per-node transforms against
+// CPUTTransformHierarchy (see CPUT/CPUT/CPUTTransformHierarchy.h).
+//
+//   TransformBench [--runs <runs>] [--moves <moves>] [<node count>...]
+//
+// Each node hangs under a random earlier one, and gets a random rotation, scale and offset;
+// 10000, 100000 and 1000000 nodes by default.  A frame moves <moves> random nodes (16 by
+// default) and then reads every world matrix in depth first order, as the recursive render
+// reaches them.  Each count runs <runs> frames (10 by default) three ways, keeping the fastest:
+//   siblings   nodes scattered over the heap, each marking its children and its later siblings
+//              dirty when it moves, and recomputing its world matrix up the parent chain when read,
+//              as CPUTRenderNode::MarkDirty() and GetWorldMatrix() used to
+//   subtree    the same nodes marking only their own subtrees dirty
+//   flat       CPUTTransformHierarchy::SetLocal() for the moves, then its arrays read in order
+// and prints microseconds per frame for each, how many world matrices each recomputed per frame,
+// and the largest difference between the flat world matrices and the others.
+//
+// Builds on its own, on Windows or off it:
+//   cl /EHsc /O2 /I..\CPUT TransformBench.cpp ..\CPUT\CPUTTransformHierarchy.cpp
+//   g++ -std=c++11 -O2 -I../CPUT TransformBench.cpp ../CPUT/CPUTTransformHierarchy.cpp
+#include "CPUTTransformHierarchy.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+// A render node's worth of memory around its transforms and links
+struct BenchNode
+{
+    BenchNode *pParent;
+    BenchNode *pChild;
+    BenchNode *pSibling;
+    bool       dirty;
+    float      world[16];
+    float      local[16];
+    char       rest[64];
+};
+
+//-----------------------------------------------------------------------------
+static void Multiply(float *pResult, const float *pLocal, const float *pParent)
+{
+    for(int rr=0; rr<4; rr++)
+    {
+        for(int cc=0; cc<4; cc++)
+        {
+            pResult[rr*4 + cc] = pLocal[rr*4]*pParent[cc] + pLocal[rr*4 + 1]*pParent[4 + cc] + pLocal[rr*4 + 2]*pParent[8 + cc] + pLocal[rr*4 + 3]*pParent[12 + cc];
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+static const float *GetWorld(BenchNode *pNode, uint32_t *pUpdated)
+{
+    if(pNode->dirty)
+    {
+        if(pNode->pParent)
+        {
+            Multiply(pNode->world, pNode->local, GetWorld(pNode->pParent, pUpdated));
+        }
+        else
+        {
+            memcpy(pNode->world, pNode->local, sizeof(pNode->world));
+        }
+        pNode->dirty = false;
+        ++*pUpdated;
+    }
+    return pNode->world;
+}
+
+//-----------------------------------------------------------------------------
+static void MarkDirtySiblings(BenchNode *pNode)
+{
+    pNode->dirty = true;
+    if(pNode->pSibling)
+    {
+        MarkDirtySiblings(pNode->pSibling);
+    }
+    if(pNode->pChild)
+    {
+        MarkDirtySiblings(pNode->pChild);
+    }
+}
+
+//-----------------------------------------------------------------------------
+static void MarkDirtySubtree(BenchNode *pNode)
+{
+    pNode->dirty = true;
+    for(BenchNode *pChild = pNode->pChild; pChild; pChild = pChild->pSibling)
+    {
+        MarkDirtySubtree(pChild);
+    }
+}
+
+// Random rotation about a random axis, scale and offset
+//-----------------------------------------------------------------------------
+static void RandomLocal(std::mt19937 &random, float pLocal[16])
+{
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    float axis[3] = { unit(random), unit(random), unit(random) };
+    float length = sqrtf(axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2]);
+    if(length < 1e-3f)
+    {
+        axis[0] = 1.0f; axis[1] = 0.0f; axis[2] = 0.0f; length = 1.0f;
+    }
+    float x = axis[0] / length, y = axis[1] / length, z = axis[2] / length;
+    float angle = unit(random) * 3.14159265f;
+    float c = cosf(angle), s = sinf(angle), t = 1.0f - c;
+    float scale = 0.9f + 0.2f * (unit(random) * 0.5f + 0.5f);
+    float matrix[16] = {
+        (t*x*x + c)   * scale, (t*x*y + s*z) * scale, (t*x*z - s*y) * scale, 0.0f,
+        (t*x*y - s*z) * scale, (t*y*y + c)   * scale, (t*y*z + s*x) * scale, 0.0f,
+        (t*x*z + s*y) * scale, (t*y*z - s*x) * scale, (t*z*z + c)   * scale, 0.0f,
+        unit(random) * 10.0f,  unit(random) * 10.0f,  unit(random) * 10.0f,  1.0f,
+    };
+    memcpy(pLocal, matrix, sizeof(matrix));
+}
+
+//-----------------------------------------------------------------------------
+static double Seconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//-----------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    int runs = 10;
+    uint32_t moves = 16;
+    std::vector<uint32_t> counts;
+    for(int ii=1; ii<argc; ii++)
+    {
+        if(0 == strcmp(argv[ii], "--runs") && ii + 1 < argc)
+        {
+            runs = atoi(argv[++ii]);
+        }
+        else if(0 == strcmp(argv[ii], "--moves") && ii + 1 < argc)
+        {
+            moves = (uint32_t)strtoul(argv[++ii], NULL, 10);
+        }
+        else
+        {
+            counts.push_back((uint32_t)strtoul(argv[ii], NULL, 10));
+        }
+    }
+    if(counts.empty())
+    {
+        counts.push_back(10000);
+        counts.push_back(100000);
+        counts.push_back(1000000);
+    }
+    if(runs < 1)
+    {
+        runs = 1;
+    }
+
+    printf("%10s %6s %10s %10s %10s %10s %10s %10s %10s\n", "nodes", "moves", "siblings", "subtree", "flat",
+           "updated", "updated", "updated", "differ");
+
+    std::mt19937 random(1234);
+    for(size_t cc=0; cc<counts.size(); cc++)
+    {
+        uint32_t count = counts[cc];
+        if(!count)
+        {
+            continue;
+        }
+
+        // Node ii hangs under a random earlier node; children keep the order they were added in
+        std::vector<int32_t> parents(count, -1);
+        std::vector< std::vector<uint32_t> > children(count);
+        for(uint32_t ii=1; ii<count; ii++)
+        {
+            parents[ii] = (int32_t)(random() % ii);
+            children[parents[ii]].push_back(ii);
+        }
+        std::vector<float> locals((size_t)count * 16);
+        for(uint32_t ii=0; ii<count; ii++)
+        {
+            RandomLocal(random, &locals[(size_t)ii * 16]);
+        }
+
+        // The nodes, in shuffled slots so neighbours in the tree aren't neighbours in memory
+        std::vector<BenchNode> storage(count);
+        std::vector<BenchNode*> nodes(count);
+        for(uint32_t ii=0; ii<count; ii++)
+        {
+            nodes[ii] = &storage[ii];
+        }
+        std::shuffle(nodes.begin(), nodes.end(), random);
+        for(uint32_t ii=0; ii<count; ii++)
+        {
+            BenchNode *pNode = nodes[ii];
+            pNode->pParent  = parents[ii] < 0 ? NULL : nodes[parents[ii]];
+            pNode->pChild   = children[ii].empty() ? NULL : nodes[children[ii][0]];
+            pNode->dirty    = true;
+            memcpy(pNode->local, &locals[(size_t)ii * 16], sizeof(pNode->local));
+            for(size_t kk=0; kk<children[ii].size(); kk++)
+            {
+                nodes[children[ii][kk]]->pSibling = kk + 1 < children[ii].size() ? nodes[children[ii][kk+1]] : NULL;
+            }
+        }
+        nodes[0]->pSibling = NULL;
+
+        // Depth first order, which is both the render order and the hierarchy's
+        std::vector<uint32_t> order;
+        order.reserve(count);
+        std::vector<uint32_t> stack(1, 0);
+        while(!stack.empty())
+        {
+            uint32_t node = stack.back();
+            stack.pop_back();
+            order.push_back(node);
+            for(size_t kk=children[node].size(); kk>0; kk--)
+            {
+                stack.push_back(children[node][kk-1]);
+            }
+        }
+        std::vector<uint32_t> flatIndex(count);
+        CPUTTransformHierarchy hierarchy;
+        for(uint32_t ii=0; ii<count; ii++)
+        {
+            uint32_t node = order[ii];
+            flatIndex[node] = hierarchy.Add(parents[node] < 0 ? -1 : (int32_t)flatIndex[parents[node]], &locals[(size_t)node * 16]);
+        }
+        std::vector<BenchNode*> renderOrder(count);
+        for(uint32_t ii=0; ii<count; ii++)
+        {
+            renderOrder[ii] = nodes[order[ii]];
+        }
+
+        // Every way starts with its world matrices up to date
+        uint32_t updated[3] = { 0, 0, 0 };
+        for(uint32_t ii=0; ii<count; ii++)
+        {
+            GetWorld(renderOrder[ii], &updated[0]);
+        }
+        hierarchy.Update();
+
+        std::uniform_int_distribution<uint32_t> pick(0, count - 1);
+        std::uniform_real_distribution<float> offset(-10.0f, 10.0f);
+        double best[3] = { 1e30, 1e30, 1e30 };
+        float differ = 0.0f;
+        float checksum = 0.0f;
+        for(int rr=0; rr<runs; rr++)
+        {
+            // The same moves each way
+            std::vector<uint32_t> moved(moves);
+            std::vector<float> positions((size_t)moves * 3);
+            for(uint32_t mm=0; mm<moves; mm++)
+            {
+                moved[mm] = pick(random);
+                for(int kk=0; kk<3; kk++)
+                {
+                    positions[mm*3 + kk] = offset(random);
+                }
+            }
+
+            for(int ww=0; ww<2; ww++)
+            {
+                updated[ww] = 0;
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                for(uint32_t mm=0; mm<moves; mm++)
+                {
+                    BenchNode *pNode = nodes[moved[mm]];
+                    memcpy(&pNode->local[12], &positions[mm*3], 3 * sizeof(float));
+                    if(ww == 0)
+                    {
+                        MarkDirtySiblings(pNode);
+                    }
+                    else
+                    {
+                        MarkDirtySubtree(pNode);
+                    }
+                }
+                for(uint32_t ii=0; ii<count; ii++)
+                {
+                    checksum += GetWorld(renderOrder[ii], &updated[ww])[12];
+                }
+                best[ww] = std::min(best[ww], Seconds(start));
+            }
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for(uint32_t mm=0; mm<moves; mm++)
+            {
+                uint32_t index = flatIndex[moved[mm]];
+                float local[16];
+                memcpy(local, hierarchy.GetLocal(index), sizeof(local));
+                memcpy(&local[12], &positions[mm*3], 3 * sizeof(float));
+                hierarchy.SetLocal(index, local);
+            }
+            updated[2] = hierarchy.Update();
+            for(uint32_t ii=0; ii<count; ii++)
+            {
+                checksum += hierarchy.GetWorld(ii)[12];
+            }
+            best[2] = std::min(best[2], Seconds(start));
+
+            for(uint32_t ii=0; ii<count; ii++)
+            {
+                const float *pFlat = hierarchy.GetWorld(flatIndex[ii]);
+                for(int kk=0; kk<16; kk++)
+                {
+                    differ = std::max(differ, fabsf(pFlat[kk] - nodes[ii]->world[kk]));
+                }
+            }
+        }
+
+        printf("%10u %6u", count, moves);
+        for(int ww=0; ww<3; ww++)
+        {
+            printf(" %8.1fus", best[ww] * 1e6);
+        }
+        printf(" %10u %10u %10u %10g\n", updated[0], updated[1], updated[2], differ);
+        if(checksum != checksum)
+        {
+            printf("world matrices went bad\n");
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,204 @@
+//--------------------------------------------------------------------------------------
+// File: DDSImage.h
+//
+// Device independent DDS parsing: validates the headers of a DDS file held in memory
+// (a loaded buffer or a mapped file) and describes where every subresource lives in it.
+// Nothing here allocates or touches Direct3D, so the same parser runs in the runtime
+// loader and in tools built off Windows (with dxgiformat.h from the DirectX-Headers package).
+//
+// Split out of DDSTextureLoader.cpp.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248926
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef __DDSIMAGE_H__
+#define __DDSIMAGE_H__
+
+#include <dxgiformat.h>
+#include <stddef.h>
+#include <stdint.h>
+
+//--------------------------------------------------------------------------------------
+// Macros
+//--------------------------------------------------------------------------------------
+#ifndef MAKEFOURCC
+    #define MAKEFOURCC(ch0, ch1, ch2, ch3)                              \
+                ((uint32_t)(uint8_t)(ch0) | ((uint32_t)(uint8_t)(ch1) << 8) |       \
+                ((uint32_t)(uint8_t)(ch2) << 16) | ((uint32_t)(uint8_t)(ch3) << 24 ))
+#endif /* defined(MAKEFOURCC) */
+
+//--------------------------------------------------------------------------------------
+// DDS file structure definitions
+//
+// See DDS.h in the 'Texconv' sample and the 'DirectXTex' library
+//--------------------------------------------------------------------------------------
+#pragma pack(push,1)
+
+#define DDS_MAGIC 0x20534444 // "DDS "
+
+struct DDS_PIXELFORMAT
+{
+    uint32_t    size;
+    uint32_t    flags;
+    uint32_t    fourCC;
+    uint32_t    RGBBitCount;
+    uint32_t    RBitMask;
+    uint32_t    GBitMask;
+    uint32_t    BBitMask;
+    uint32_t    ABitMask;
+};
+
+#define DDS_FOURCC      0x00000004  // DDPF_FOURCC
+#define DDS_RGB         0x00000040  // DDPF_RGB
+#define DDS_RGBA        0x00000041  // DDPF_RGB | DDPF_ALPHAPIXELS
+#define DDS_LUMINANCE   0x00020000  // DDPF_LUMINANCE
+#define DDS_LUMINANCEA  0x00020001  // DDPF_LUMINANCE | DDPF_ALPHAPIXELS
+#define DDS_ALPHA       0x00000002  // DDPF_ALPHA
+#define DDS_PAL8        0x00000020  // DDPF_PALETTEINDEXED8
+
+#define DDS_HEADER_FLAGS_TEXTURE        0x00001007  // DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT
+#define DDS_HEADER_FLAGS_MIPMAP         0x00020000  // DDSD_MIPMAPCOUNT
+#define DDS_HEADER_FLAGS_VOLUME         0x00800000  // DDSD_DEPTH
+#define DDS_HEADER_FLAGS_PITCH          0x00000008  // DDSD_PITCH
+#define DDS_HEADER_FLAGS_LINEARSIZE     0x00080000  // DDSD_LINEARSIZE
+
+#define DDS_HEIGHT 0x00000002 // DDSD_HEIGHT
+#define DDS_WIDTH  0x00000004 // DDSD_WIDTH
+
+#define DDS_SURFACE_FLAGS_TEXTURE 0x00001000 // DDSCAPS_TEXTURE
+#define DDS_SURFACE_FLAGS_MIPMAP  0x00400008 // DDSCAPS_COMPLEX | DDSCAPS_MIPMAP
+#define DDS_SURFACE_FLAGS_CUBEMAP 0x00000008 // DDSCAPS_COMPLEX
+
+#define DDS_CUBEMAP_POSITIVEX 0x00000600 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEX
+#define DDS_CUBEMAP_NEGATIVEX 0x00000a00 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEX
+#define DDS_CUBEMAP_POSITIVEY 0x00001200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEY
+#define DDS_CUBEMAP_NEGATIVEY 0x00002200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEY
+#define DDS_CUBEMAP_POSITIVEZ 0x00004200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEZ
+#define DDS_CUBEMAP_NEGATIVEZ 0x00008200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEZ
+
+#define DDS_CUBEMAP_ALLFACES ( DDS_CUBEMAP_POSITIVEX | DDS_CUBEMAP_NEGATIVEX |\
+                               DDS_CUBEMAP_POSITIVEY | DDS_CUBEMAP_NEGATIVEY |\
+                               DDS_CUBEMAP_POSITIVEZ | DDS_CUBEMAP_NEGATIVEZ )
+
+#define DDS_CUBEMAP 0x00000200 // DDSCAPS2_CUBEMAP
+
+#define DDS_FLAGS_VOLUME 0x00200000 // DDSCAPS2_VOLUME
+
+typedef struct
+{
+    uint32_t        size;
+    uint32_t        flags;
+    uint32_t        height;
+    uint32_t        width;
+    uint32_t        pitchOrLinearSize;
+    uint32_t        depth; // only if DDS_HEADER_FLAGS_VOLUME is set in flags
+    uint32_t        mipMapCount;
+    uint32_t        reserved1[11];
+    DDS_PIXELFORMAT ddspf;
+    uint32_t        caps;
+    uint32_t        caps2;
+    uint32_t        caps3;
+    uint32_t        caps4;
+    uint32_t        reserved2;
+} DDS_HEADER;
+
+typedef struct
+{
+    DXGI_FORMAT     dxgiFormat;
+    uint32_t        resourceDimension;
+    uint32_t        miscFlag; // see D3D11_RESOURCE_MISC_FLAG
+    uint32_t        arraySize;
+    uint32_t        reserved;
+} DDS_HEADER_DXT10;
+
+#pragma pack(pop)
+
+// Same values as D3D11_RESOURCE_DIMENSION and D3D11_RESOURCE_MISC_TEXTURECUBE
+#define DDS_DIMENSION_UNKNOWN   0
+#define DDS_DIMENSION_TEXTURE1D 2
+#define DDS_DIMENSION_TEXTURE2D 3
+#define DDS_DIMENSION_TEXTURE3D 4
+#define DDS_MISC_TEXTURECUBE    0x4
+
+// D3D11_REQ_MIP_LEVELS
+#define DDS_MAX_MIP_LEVELS 15
+
+// Magic number, DDS_HEADER and DDS_HEADER_DXT10; reading this much is always enough to parse
+#define DDS_MAX_HEADER_SIZE (sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10))
+
+namespace DirectX
+{
+    enum DDS_RESULT
+    {
+        DDS_OK = 0,
+        DDS_ERROR_INVALID_HEADER,   // not a DDS file, or a header that fails validation
+        DDS_ERROR_INVALID_DATA,     // well formed headers describing an impossible texture
+        DDS_ERROR_NOT_SUPPORTED,    // a format or size the runtime can't create
+        DDS_ERROR_TRUNCATED,        // the subresources run past the end of the data
+    };
+
+    // Where one subresource (one mip of one array item) lives, relative to the start of the file
+    struct DDSSubresource
+    {
+        size_t   offset;
+        size_t   rowPitch;   // bytes per row of pixels, or of 4x4 blocks for BC formats
+        size_t   slicePitch; // bytes per depth slice
+        size_t   numRows;
+        uint32_t width, height, depth;
+    };
+
+    // Everything needed to create or stream the texture, without holding on to the data.
+    // Array items follow each other, each one a full mip chain; mip i of every item has the
+    // same size, so any subresource is found in constant time.
+    struct DDSImage
+    {
+        DXGI_FORMAT format;
+        uint32_t    resourceDimension; // DDS_DIMENSION_*
+        uint32_t    width, height, depth;
+        uint32_t    arraySize;         // six per cube for cube maps
+        uint32_t    mipCount;
+        bool        isCubeMap;
+        size_t      dataOffset;        // start of the first subresource
+        size_t      itemBytes;         // one array item, every mip and depth slice
+        size_t      mipOffset[DDS_MAX_MIP_LEVELS];  // relative to the start of an item
+        size_t      mipRowPitch[DDS_MAX_MIP_LEVELS];
+        size_t      mipSlicePitch[DDS_MAX_MIP_LEVELS];
+        size_t      mipNumRows[DDS_MAX_MIP_LEVELS];
+
+        size_t      GetSubresourceCount() const { return (size_t)arraySize * mipCount; }
+        size_t      GetDataSize() const { return itemBytes * arraySize; }
+    };
+
+    // Validates the headers of ddsData and fills in image. All of the subresources must be
+    // inside ddsDataSize, so later reads from the described offsets are safe.
+    DDS_RESULT ParseDDSImage( const uint8_t* ddsData, size_t ddsDataSize, DDSImage* image );
+
+    // Same checks when only the start of the file is in memory (at least DDS_MAX_HEADER_SIZE
+    // bytes, or the whole file if it's shorter): ddsData holds the headers and fileSize is the
+    // size of the whole file, for streaming readers that fetch each subresource on its own.
+    DDS_RESULT ParseDDSHeader( const uint8_t* ddsData, size_t ddsDataSize, size_t fileSize, DDSImage* image );
+
+    // Returns false if item or mip is out of range
+    bool GetDDSSubresource( const DDSImage& image, size_t item, size_t mip, DDSSubresource* subresource );
+
+    // Format helpers shared with the loader
+    size_t      BitsPerPixel( DXGI_FORMAT fmt );
+    void        GetSurfaceInfo( size_t width, size_t height, DXGI_FORMAT fmt,
+                                size_t* outNumBytes, size_t* outRowBytes, size_t* outNumRows );
+    DXGI_FORMAT GetDXGIFormat( const DDS_PIXELFORMAT& ddpf );
+    DXGI_FORMAT MakeSRGB( DXGI_FORMAT format );
+}
+
+#endif // __DDSIMAGE_H__
@@ -0,0 +1,372 @@
+//--------------------------------------------------------------------------------------
+// File: DDSImageCache.cpp
+//
+// Sidecar cache of parsed DDS metadata, see DDSImageCache.h
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248926
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#include "DDSImageCache.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+using namespace DirectX;
+
+//--------------------------------------------------------------------------------------
+// Cache file layout: the header, then subresourceCount DDSCachedSubresource records
+//--------------------------------------------------------------------------------------
+#pragma pack(push,1)
+
+struct DDSCacheHeader
+{
+    uint32_t    magic;
+    uint32_t    version;
+    DDSCacheKey key;
+    uint64_t    headerHash;         // of the first DDS_MAX_HEADER_SIZE bytes of the .dds
+    uint32_t    format;
+    uint32_t    srgbFormat;
+    uint32_t    resourceDimension;
+    uint32_t    width, height, depth;
+    uint32_t    arraySize;
+    uint32_t    mipCount;
+    uint32_t    isCubeMap;
+    uint64_t    dataOffset;
+    uint64_t    itemBytes;
+    uint32_t    subresourceCount;
+    uint64_t    checksum;           // over this header (with checksum zero) and the records
+};
+
+#pragma pack(pop)
+
+static_assert( sizeof(DDSCachedSubresource) == 32, "DDSCachedSubresource is stored as is" );
+
+// Limits a cache file has to respect before its table is even read
+#define DDS_CACHE_MAX_SUBRESOURCES (2048 * DDS_MAX_MIP_LEVELS)
+
+//--------------------------------------------------------------------------------------
+static const uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+
+static uint64_t HashBytes( uint64_t hash, const void* data, size_t size )
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>( data );
+    for( size_t i = 0; i < size; ++i )
+    {
+        hash = ( hash ^ bytes[i] ) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static uint64_t HashDDSHeaders( const uint8_t* ddsData, size_t ddsDataSize )
+{
+    return HashBytes( FNV_OFFSET_BASIS, ddsData, std::min<size_t>( ddsDataSize, DDS_MAX_HEADER_SIZE ) );
+}
+
+static uint64_t HashRecord( const DDSCacheHeader& header, const DDSCachedSubresource* subresources )
+{
+    DDSCacheHeader copy = header;
+    copy.checksum = 0;
+    uint64_t hash = HashBytes( FNV_OFFSET_BASIS, &copy, sizeof(copy) );
+    return HashBytes( hash, subresources, sizeof(DDSCachedSubresource) * header.subresourceCount );
+}
+
+//--------------------------------------------------------------------------------------
+static FILE* OpenFile( const DDSPathChar* fileName, bool write )
+{
+    FILE* file = nullptr;
+#ifdef _WIN32
+    if ( _wfopen_s( &file, fileName, write ? L"wb" : L"rb" ) != 0 )
+    {
+        file = nullptr;
+    }
+#else
+    file = fopen( fileName, write ? "wb" : "rb" );
+#endif
+    return file;
+}
+
+//--------------------------------------------------------------------------------------
+void DirectX::BuildDDSCachedImage( const DDSImage& image, DDSCachedImage* cachedImage )
+{
+    cachedImage->image = image;
+    cachedImage->srgbFormat = MakeSRGB( image.format );
+    cachedImage->subresources.resize( image.GetSubresourceCount() );
+
+    size_t index = 0;
+    for( size_t j = 0; j < image.arraySize; j++ )
+    {
+        for( size_t i = 0; i < image.mipCount; i++ )
+        {
+            DDSSubresource sub;
+            GetDDSSubresource( image, j, i, &sub );
+
+            DDSCachedSubresource& cached = cachedImage->subresources[index++];
+            cached.offset     = sub.offset;
+            cached.rowPitch   = static_cast<uint32_t>( sub.rowPitch );
+            cached.slicePitch = static_cast<uint32_t>( sub.slicePitch );
+            cached.numRows    = static_cast<uint32_t>( sub.numRows );
+            cached.width      = sub.width;
+            cached.height     = sub.height;
+            cached.depth      = sub.depth;
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------
+bool DirectX::GetDDSCacheKey( const DDSPathChar* ddsFileName, DDSCacheKey* key )
+{
+    if ( !ddsFileName || !key )
+    {
+        return false;
+    }
+
+    // The name without its directory, so the key survives moving the media tree
+    const DDSPathChar* name = ddsFileName;
+    for( const DDSPathChar* p = ddsFileName; *p; ++p )
+    {
+        if ( *p == '/' || *p == '\\' )
+        {
+            name = p + 1;
+        }
+    }
+    key->nameHash = FNV_OFFSET_BASIS;
+    for( const DDSPathChar* p = name; *p; ++p )
+    {
+        uint32_t c = static_cast<uint32_t>( *p );
+        if ( c >= 'A' && c <= 'Z' )
+        {
+            c += 'a' - 'A';
+        }
+        key->nameHash = HashBytes( key->nameHash, &c, sizeof(c) );
+    }
+
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if ( !GetFileAttributesExW( ddsFileName, GetFileExInfoStandard, &data ) )
+    {
+        return false;
+    }
+    key->fileSize = ( static_cast<uint64_t>( data.nFileSizeHigh ) << 32 ) | data.nFileSizeLow;
+    key->fileTime = ( static_cast<uint64_t>( data.ftLastWriteTime.dwHighDateTime ) << 32 ) | data.ftLastWriteTime.dwLowDateTime;
+#else
+    struct stat st;
+    if ( stat( ddsFileName, &st ) != 0 )
+    {
+        return false;
+    }
+#ifdef __APPLE__
+    const uint64_t nanoseconds = static_cast<uint64_t>( st.st_mtimespec.tv_nsec );
+#else
+    const uint64_t nanoseconds = static_cast<uint64_t>( st.st_mtim.tv_nsec );
+#endif
+    // FILETIME units: 100ns since 1601-01-01, which is 11644473600 seconds before the Unix epoch
+    key->fileSize = static_cast<uint64_t>( st.st_size );
+    key->fileTime = ( static_cast<uint64_t>( st.st_mtime ) + 11644473600ULL ) * 10000000ULL + nanoseconds / 100;
+#endif
+    return true;
+}
+
+//--------------------------------------------------------------------------------------
+std::basic_string<DDSPathChar> DirectX::GetDDSCacheFileName( const DDSPathChar* ddsFileName )
+{
+    std::basic_string<DDSPathChar> cacheFileName( ddsFileName );
+    static const char extension[] = ".ddscache";
+    cacheFileName.append( extension, extension + sizeof(extension) - 1 );
+    return cacheFileName;
+}
+
+//--------------------------------------------------------------------------------------
+DDS_RESULT DirectX::ReadDDSImageCache( const DDSPathChar* cacheFileName, const DDSCacheKey* key,
+                                       const uint8_t* ddsData, size_t ddsDataSize, DDSCachedImage* cachedImage )
+{
+    if ( !cacheFileName || !ddsData || !cachedImage )
+    {
+        return DDS_ERROR_INVALID_HEADER;
+    }
+
+    FILE* file = OpenFile( cacheFileName, false );
+    if ( !file )
+    {
+        return DDS_ERROR_INVALID_HEADER;
+    }
+
+    DDSCacheHeader header;
+    bool valid = fread( &header, sizeof(header), 1, file ) == 1 &&
+                 header.magic == DDS_CACHE_MAGIC &&
+                 header.version == DDS_CACHE_VERSION &&
+                 header.key.fileSize == ddsDataSize &&
+                 ( !key || ( header.key.nameHash == key->nameHash &&
+                             header.key.fileSize == key->fileSize &&
+                             header.key.fileTime == key->fileTime ) ) &&
+                 header.headerHash == HashDDSHeaders( ddsData, ddsDataSize ) &&
+                 header.mipCount > 0 && header.mipCount <= DDS_MAX_MIP_LEVELS &&
+                 header.arraySize > 0 && header.arraySize <= DDS_CACHE_MAX_SUBRESOURCES / header.mipCount &&
+                 header.subresourceCount == header.arraySize * header.mipCount;
+    if ( valid )
+    {
+        cachedImage->subresources.resize( header.subresourceCount );
+        valid = fread( cachedImage->subresources.data(), sizeof(DDSCachedSubresource), header.subresourceCount, file ) == header.subresourceCount &&
+                header.checksum == HashRecord( header, cachedImage->subresources.data() );
+    }
+    fclose( file );
+    if ( !valid )
+    {
+        return DDS_ERROR_INVALID_HEADER;
+    }
+
+    // The checksum catches damage, not lies: keep the guarantee ParseDDSImage gives, that
+    // every subresource is inside the data
+    for( uint32_t i = 0; i < header.subresourceCount; ++i )
+    {
+        const DDSCachedSubresource& sub = cachedImage->subresources[i];
+        const uint64_t size = static_cast<uint64_t>( sub.slicePitch ) * sub.depth;
+        if ( sub.offset > ddsDataSize || size > ddsDataSize - sub.offset )
+        {
+            return DDS_ERROR_INVALID_HEADER;
+        }
+    }
+
+    DDSImage& image = cachedImage->image;
+    image.format            = static_cast<DXGI_FORMAT>( header.format );
+    image.resourceDimension = header.resourceDimension;
+    image.width             = header.width;
+    image.height            = header.height;
+    image.depth             = header.depth;
+    image.arraySize         = header.arraySize;
+    image.mipCount          = header.mipCount;
+    image.isCubeMap         = header.isCubeMap != 0;
+    image.dataOffset        = static_cast<size_t>( header.dataOffset );
+    image.itemBytes         = static_cast<size_t>( header.itemBytes );
+    for( uint32_t i = 0; i < header.mipCount; ++i )
+    {
+        // The first item's mips
+        const DDSCachedSubresource& sub = cachedImage->subresources[i];
+        image.mipOffset[i]     = static_cast<size_t>( sub.offset - header.dataOffset );
+        image.mipRowPitch[i]   = sub.rowPitch;
+        image.mipSlicePitch[i] = sub.slicePitch;
+        image.mipNumRows[i]    = sub.numRows;
+    }
+    cachedImage->srgbFormat = static_cast<DXGI_FORMAT>( header.srgbFormat );
+
+    return DDS_OK;
+}
+
+//--------------------------------------------------------------------------------------
+bool DirectX::WriteDDSImageCache( const DDSPathChar* cacheFileName, const DDSCacheKey& key,
+                                  const uint8_t* ddsData, size_t ddsDataSize, const DDSCachedImage& cachedImage )
+{
+    const DDSImage& image = cachedImage.image;
+    if ( !cacheFileName || !ddsData || key.fileSize != ddsDataSize ||
+         cachedImage.subresources.size() != image.GetSubresourceCount() ||
+         image.GetSubresourceCount() > DDS_CACHE_MAX_SUBRESOURCES )
+    {
+        return false;
+    }
+
+    DDSCacheHeader header;
+    memset( &header, 0, sizeof(header) );
+    header.magic             = DDS_CACHE_MAGIC;
+    header.version           = DDS_CACHE_VERSION;
+    header.key               = key;
+    header.headerHash        = HashDDSHeaders( ddsData, ddsDataSize );
+    header.format            = static_cast<uint32_t>( image.format );
+    header.srgbFormat        = static_cast<uint32_t>( cachedImage.srgbFormat );
+    header.resourceDimension = image.resourceDimension;
+    header.width             = image.width;
+    header.height            = image.height;
+    header.depth             = image.depth;
+    header.arraySize         = image.arraySize;
+    header.mipCount          = image.mipCount;
+    header.isCubeMap         = image.isCubeMap ? 1 : 0;
+    header.dataOffset        = image.dataOffset;
+    header.itemBytes         = image.itemBytes;
+    header.subresourceCount  = static_cast<uint32_t>( cachedImage.subresources.size() );
+    header.checksum          = HashRecord( header, cachedImage.subresources.data() );
+
+    FILE* file = OpenFile( cacheFileName, true );
+    if ( !file )
+    {
+        return false;
+    }
+    bool written = fwrite( &header, sizeof(header), 1, file ) == 1 &&
+                   fwrite( cachedImage.subresources.data(), sizeof(DDSCachedSubresource), header.subresourceCount, file ) == header.subresourceCount;
+    written = ( fclose( file ) == 0 ) && written;
+    return written;
+}
+
+//--------------------------------------------------------------------------------------
+DDS_RESULT DirectX::ParseDDSImageCached( const DDSPathChar* ddsFileName, const uint8_t* ddsData, size_t ddsDataSize,
+                                         DDSCachedImage* cachedImage )
+{
+    if ( !ddsData || !cachedImage )
+    {
+        return DDS_ERROR_INVALID_HEADER;
+    }
+
+    DDSCacheKey key;
+    const bool hasKey = ddsFileName && GetDDSCacheKey( ddsFileName, &key );
+    std::basic_string<DDSPathChar> cacheFileName;
+    if ( hasKey )
+    {
+        cacheFileName = GetDDSCacheFileName( ddsFileName );
+        if ( ReadDDSImageCache( cacheFileName.c_str(), &key, ddsData, ddsDataSize, cachedImage ) == DDS_OK )
+        {
+            return DDS_OK;
+        }
+    }
+
+    DDSImage image;
+    DDS_RESULT result = ParseDDSImage( ddsData, ddsDataSize, &image );
+    if ( result != DDS_OK )
+    {
+        return result;
+    }
+    BuildDDSCachedImage( image, cachedImage );
+
+    if ( hasKey )
+    {
+        // Best effort: the media directory may well be read only
+        WriteDDSImageCache( cacheFileName.c_str(), key, ddsData, ddsDataSize, *cachedImage );
+    }
+    return DDS_OK;
+}
+
+//--------------------------------------------------------------------------------------
+bool DirectX::IsSameDDSCachedImage( const DDSCachedImage& a, const DDSCachedImage& b )
+{
+    const DDSImage& ia = a.image;
+    const DDSImage& ib = b.image;
+    if ( ia.format != ib.format || ia.resourceDimension != ib.resourceDimension ||
+         ia.width != ib.width || ia.height != ib.height || ia.depth != ib.depth ||
+         ia.arraySize != ib.arraySize || ia.mipCount != ib.mipCount || ia.isCubeMap != ib.isCubeMap ||
+         ia.dataOffset != ib.dataOffset || ia.itemBytes != ib.itemBytes ||
+         a.srgbFormat != b.srgbFormat || a.subresources.size() != b.subresources.size() )
+    {
+        return false;
+    }
+    for( size_t i = 0; i < ia.mipCount; ++i )
+    {
+        if ( ia.mipOffset[i] != ib.mipOffset[i] || ia.mipRowPitch[i] != ib.mipRowPitch[i] ||
+             ia.mipSlicePitch[i] != ib.mipSlicePitch[i] || ia.mipNumRows[i] != ib.mipNumRows[i] )
+        {
+            return false;
+        }
+    }
+    return a.subresources.empty() ||
+           memcmp( a.subresources.data(), b.subresources.data(), sizeof(DDSCachedSubresource) * a.subresources.size() ) == 0;
+}
@@ -0,0 +1,108 @@
+//--------------------------------------------------------------------------------------
+// File: DDSImageCache.h
+//
+// Sidecar cache of parsed DDS metadata. ParseDDSImage sniffs the pixel format, resolves
+// the sRGB variant and walks every mip through GetSurfaceInfo; none of that changes
+// between runs. The first load of "name.dds" writes the result to "name.dds.ddscache":
+// the resolved formats and a table with the offset, pitches and size of every
+// subresource, ready to go into D3D11_SUBRESOURCE_DATA. Later loads read the table back
+// and skip parsing.
+//
+// A cache file is used only if it still describes its .dds:
+//   - the file name, size and last write time match the ones it was written for;
+//   - a hash of the .dds headers matches, so a different texture with the same name,
+//     size and time is not mistaken for it;
+//   - a checksum over the record matches, and every subresource lies inside the data.
+// Otherwise the .dds is parsed again and the cache rewritten. The name is keyed without
+// its directory, so moving a media tree together with its caches keeps them valid.
+//
+// Device independent like DDSImage.h; builds off Windows for tools.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248926
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef __DDSIMAGECACHE_H__
+#define __DDSIMAGECACHE_H__
+
+#include "DDSImage.h"
+#include <string>
+#include <vector>
+
+#define DDS_CACHE_MAGIC     0x58534444 // "DDSX"
+#define DDS_CACHE_VERSION   1
+
+namespace DirectX
+{
+#ifdef _WIN32
+    typedef wchar_t DDSPathChar;
+#else
+    typedef char    DDSPathChar;
+#endif
+
+    // What a cache file is keyed on, see GetDDSCacheKey
+    struct DDSCacheKey
+    {
+        uint64_t nameHash;  // FNV-1a of the file name, without its directory, ASCII lowercased
+        uint64_t fileSize;
+        uint64_t fileTime;  // last write, in 100ns ticks since 1601 (a FILETIME) on every platform
+    };
+
+    // One subresource, as D3D11_SUBRESOURCE_DATA wants it
+    struct DDSCachedSubresource
+    {
+        uint64_t offset;     // from the start of the file
+        uint32_t rowPitch;
+        uint32_t slicePitch;
+        uint32_t numRows;
+        uint32_t width, height, depth;
+    };
+
+    struct DDSCachedImage
+    {
+        DDSImage    image;
+        DXGI_FORMAT srgbFormat;     // MakeSRGB(image.format)
+        std::vector<DDSCachedSubresource> subresources; // GetDDSSubresource(item, mip) at item * mipCount + mip
+    };
+
+    // Fills in the table from an image ParseDDSImage validated
+    void BuildDDSCachedImage( const DDSImage& image, DDSCachedImage* cachedImage );
+
+    // Returns false if the file can't be found
+    bool GetDDSCacheKey( const DDSPathChar* ddsFileName, DDSCacheKey* key );
+
+    // ddsFileName + ".ddscache"
+    std::basic_string<DDSPathChar> GetDDSCacheFileName( const DDSPathChar* ddsFileName );
+
+    // Reads a cache file written for ddsData (the whole .dds). key can be null to accept any
+    // name and time, for tools that check caches written on another machine. Returns
+    // DDS_ERROR_INVALID_HEADER if the file is missing, stale or damaged.
+    DDS_RESULT ReadDDSImageCache( const DDSPathChar* cacheFileName, const DDSCacheKey* key,
+                                  const uint8_t* ddsData, size_t ddsDataSize, DDSCachedImage* cachedImage );
+
+    // Returns false if the file can't be written. Two threads writing the cache of the same
+    // texture write the same bytes, and a reader that sees it half written fails the checksum.
+    bool WriteDDSImageCache( const DDSPathChar* cacheFileName, const DDSCacheKey& key,
+                             const uint8_t* ddsData, size_t ddsDataSize, const DDSCachedImage& cachedImage );
+
+    // ParseDDSImage through the cache of ddsFileName: reads it if it is current, otherwise parses
+    // ddsData and (re)writes it. With a null ddsFileName this just parses and builds the table.
+    DDS_RESULT ParseDDSImageCached( const DDSPathChar* ddsFileName, const uint8_t* ddsData, size_t ddsDataSize,
+                                    DDSCachedImage* cachedImage );
+
+    // True if both describe the same texture the same way
+    bool IsSameDDSCachedImage( const DDSCachedImage& a, const DDSCachedImage& b );
+}
+
+#endif // __DDSIMAGECACHE_H__
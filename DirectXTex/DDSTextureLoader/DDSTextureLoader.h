@@ -41,6 +41,9 @@
 
 namespace DirectX
 {
+    struct DDSImage;
+    struct DDSCachedImage;
+
     HRESULT CreateDDSTextureFromMemory( _In_ ID3D11Device* d3dDevice,
                                         _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
                                         _In_ size_t ddsDataSize,
@@ -80,4 +83,34 @@ namespace DirectX
                                         _Out_opt_ ID3D11Resource** texture,
                                         _Out_opt_ ID3D11ShaderResourceView** textureView
                                     );
+
+    // Creates the texture from a DDS already parsed by ParseDDSImage (see DDSImage.h), for
+    // callers that hold the file in memory some other way, e.g. a mapped file.
+    HRESULT CreateDDSTextureFromImage( _In_ ID3D11Device* d3dDevice,
+                                       _In_ const DDSImage& image,
+                                       _In_ const uint8_t* ddsData,
+                                       _In_ size_t maxsize,
+                                       _In_ D3D11_USAGE usage,
+                                       _In_ unsigned int bindFlags,
+                                       _In_ unsigned int cpuAccessFlags,
+                                       _In_ unsigned int miscFlags,
+                                       _In_ bool forceSRGB,
+                                       _Out_opt_ ID3D11Resource** texture,
+                                       _Out_opt_ ID3D11ShaderResourceView** textureView
+                                     );
+
+    // Same, from the table of a DDSCachedImage (see DDSImageCache.h): the subresource data is
+    // copied from the table and the sRGB format is the resolved one, nothing is computed per mip.
+    HRESULT CreateDDSTextureFromCachedImage( _In_ ID3D11Device* d3dDevice,
+                                             _In_ const DDSCachedImage& cachedImage,
+                                             _In_ const uint8_t* ddsData,
+                                             _In_ size_t maxsize,
+                                             _In_ D3D11_USAGE usage,
+                                             _In_ unsigned int bindFlags,
+                                             _In_ unsigned int cpuAccessFlags,
+                                             _In_ unsigned int miscFlags,
+                                             _In_ bool forceSRGB,
+                                             _Out_opt_ ID3D11Resource** texture,
+                                             _Out_opt_ ID3D11ShaderResourceView** textureView
+                                           );
 }
\ No newline at end of file
@@ -0,0 +1,334 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "DDSChunkedSource.h"
+#include "DDSImage.h"
+#include "CPUTWorkerPool.h"
+#include <atomic>
+#include <stdio.h>
+#include <string.h>
+
+// Chunks that are stored as is get tiled straight from the mapping with aligned loads
+static const UINT gPayloadAlignment = 64;
+
+//-----------------------------------------------------------------------------
+static bool IsBlockCompressed(DXGI_FORMAT format)
+{
+    return (format >= DXGI_FORMAT_BC1_TYPELESS && format <= DXGI_FORMAT_BC5_SNORM) ||
+           (format >= DXGI_FORMAT_BC6H_TYPELESS && format <= DXGI_FORMAT_BC7_UNORM_SRGB);
+}
+
+// Same restrictions as DDSMappedSource.  Returns 0 for layouts the copy kernels can't take.
+//-----------------------------------------------------------------------------
+static UINT GetBytesPerBlock(const DirectX::DDSImage &image)
+{
+    if(image.resourceDimension != DDS_DIMENSION_TEXTURE2D || image.arraySize != 1 || image.mipCount > DDS_MAPPED_MAX_MIPS)
+    {
+        return 0;
+    }
+    size_t bitsPerPixel = DirectX::BitsPerPixel(image.format);
+    if(!IsBlockCompressed(image.format) && (bitsPerPixel & 7))
+    {
+        return 0;
+    }
+    return (UINT)(IsBlockCompressed(image.format) ? bitsPerPixel * 2 : bitsPerPixel / 8);
+}
+
+//-----------------------------------------------------------------------------
+static bool WriteAt(FILE *pFile, uint64_t offset, const void *pData, size_t size)
+{
+#ifdef _WIN32
+    if(0 != _fseeki64(pFile, (__int64)offset, SEEK_SET))
+#else
+    if(0 != fseeko(pFile, (off_t)offset, SEEK_SET))
+#endif
+    {
+        return false;
+    }
+    return 0 == size || fwrite(pData, 1, size, pFile) == size;
+}
+
+//-----------------------------------------------------------------------------
+bool DDSChunkedSource::Cook(const CPUTMappedFile::PathChar *ddsFileName, const CPUTMappedFile::PathChar *chunkedFileName, uint16_t compression)
+{
+    CPUTMappedFile dds;
+    DirectX::DDSImage image;
+    if(!dds.Open(ddsFileName) ||
+       DirectX::ParseDDSImage(dds.GetData(), dds.GetSize(), &image) != DirectX::DDS_OK ||
+       GetBytesPerBlock(image) == 0)
+    {
+        return false;
+    }
+
+    // Bands of whole rows: a power of two of them, at least 4 so the kernel can take 64B lines,
+    // and as many as fit in the chunk size
+    std::vector<DDSChunk> chunks;
+    for(UINT mip = 0; mip < image.mipCount; mip++)
+    {
+        DirectX::DDSSubresource sub;
+        DirectX::GetDDSSubresource(image, 0, mip, &sub);
+        UINT numRows = (UINT)sub.numRows;
+        UINT rows = 4;
+        while(rows * 2 <= numRows && rows * 2 * sub.rowPitch <= DDS_CHUNKED_CHUNK_SIZE)
+        {
+            rows *= 2;
+        }
+        for(UINT firstRow = 0; firstRow < numRows; firstRow += rows)
+        {
+            DDSChunk chunk;
+            chunk.mip        = mip;
+            chunk.firstRow   = firstRow;
+            chunk.rowCount   = min(rows, numRows - firstRow);
+            chunk.size       = (uint32_t)(chunk.rowCount * sub.rowPitch);
+            chunk.storedSize = 0;
+            chunk.offset     = sub.offset + firstRow * sub.rowPitch; // in the .dds, for now
+            chunks.push_back(chunk);
+        }
+    }
+
+#ifdef _WIN32
+    FILE *pFile = _wfopen(chunkedFileName, L"wb");
+#else
+    FILE *pFile = fopen(chunkedFileName, "wb");
+#endif
+    if(!pFile)
+    {
+        return false;
+    }
+    DDSChunkedHeader header;
+    header.magic         = DDS_CHUNKED_MAGIC;
+    header.version       = DDS_CHUNKED_VERSION;
+    header.compression   = compression;
+    header.ddsHeaderSize = (uint32_t)image.dataOffset;
+    header.chunkCount    = (uint32_t)chunks.size();
+    header.ddsFileSize   = dds.GetSize();
+
+    bool result = true;
+    std::vector<unsigned char> compressed;
+    uint64_t offset = sizeof(header) + image.dataOffset + chunks.size() * sizeof(DDSChunk);
+    for(size_t ii = 0; ii < chunks.size() && result; ii++)
+    {
+        DDSChunk &chunk = chunks[ii];
+        const unsigned char *pStored = dds.GetData() + chunk.offset;
+        chunk.storedSize = chunk.size;
+        if(compression != CPUT_ARCHIVE_COMPRESSION_NONE)
+        {
+            result = CPUTArchive::Compress(compression, pStored, chunk.size, &compressed);
+            if(result && compressed.size() < chunk.size)
+            {
+                pStored = &compressed[0];
+                chunk.storedSize = (uint32_t)compressed.size();
+            }
+        }
+        chunk.offset = (offset + gPayloadAlignment - 1) / gPayloadAlignment * gPayloadAlignment;
+        result = result && WriteAt(pFile, chunk.offset, pStored, chunk.storedSize);
+        offset = chunk.offset + chunk.storedSize;
+    }
+    result = result &&
+             WriteAt(pFile, 0, &header, sizeof(header)) &&
+             WriteAt(pFile, sizeof(header), dds.GetData(), image.dataOffset) &&
+             WriteAt(pFile, sizeof(header) + image.dataOffset, chunks.empty() ? NULL : &chunks[0], chunks.size() * sizeof(DDSChunk));
+    result = (0 == fclose(pFile)) && result;
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+bool DDSChunkedSource::Open(const CPUTMappedFile::PathChar *fileName)
+{
+    Close();
+    if(!mFile.Open(fileName))
+    {
+        return false;
+    }
+
+    // Every offset and size in the file is checked here, so WriteMip can trust them
+    const BYTE *pData = mFile.GetData();
+    const size_t fileSize = mFile.GetSize();
+    const DDSChunkedHeader *pHeader = (const DDSChunkedHeader *)pData;
+    DirectX::DDSImage image;
+    UINT bytesPerBlock = 0;
+    if(fileSize >= sizeof(DDSChunkedHeader) &&
+       pHeader->magic == DDS_CHUNKED_MAGIC &&
+       pHeader->version == DDS_CHUNKED_VERSION &&
+       pHeader->ddsHeaderSize <= DDS_MAX_HEADER_SIZE &&
+       pHeader->ddsHeaderSize <= fileSize - sizeof(DDSChunkedHeader) &&
+       pHeader->chunkCount <= (fileSize - sizeof(DDSChunkedHeader) - pHeader->ddsHeaderSize) / sizeof(DDSChunk) &&
+       pHeader->ddsFileSize <= (size_t)-1 &&
+       DirectX::ParseDDSHeader(pData + sizeof(DDSChunkedHeader), pHeader->ddsHeaderSize, (size_t)pHeader->ddsFileSize, &image) == DirectX::DDS_OK &&
+       image.dataOffset == pHeader->ddsHeaderSize)
+    {
+        bytesPerBlock = GetBytesPerBlock(image);
+    }
+    if(bytesPerBlock == 0)
+    {
+        Close();
+        return false;
+    }
+
+    mCompression = pHeader->compression;
+    mpChunks     = (const DDSChunk *)(pData + sizeof(DDSChunkedHeader) + pHeader->ddsHeaderSize);
+    mMipCount    = image.mipCount;
+    mScratchSize = 0;
+    UINT heightInBlocks = 0;
+    UINT chunk = 0;
+    for(UINT mip = 0; mip < mMipCount; mip++)
+    {
+        DirectX::DDSSubresource sub;
+        DirectX::GetDDSSubresource(image, 0, mip, &sub);
+        if(mip == 0)
+        {
+            heightInBlocks = (UINT)sub.numRows;
+        }
+        mMipFirstChunk[mip] = chunk;
+        mMipRowPitch[mip]   = (UINT)sub.rowPitch;
+        for(UINT row = 0; row < sub.numRows; chunk++)
+        {
+            // The chunks of a mip must cover its rows in order, each a band of whole rows
+            const DDSChunk *pChunk = &mpChunks[chunk];
+            if(chunk >= pHeader->chunkCount ||
+               pChunk->mip != mip || pChunk->firstRow != row ||
+               pChunk->rowCount == 0 || pChunk->rowCount > sub.numRows - row ||
+               pChunk->size != pChunk->rowCount * sub.rowPitch ||
+               pChunk->offset > fileSize || pChunk->storedSize > fileSize - pChunk->offset ||
+               (pChunk->storedSize == pChunk->size && (pChunk->offset & 15)))
+            {
+                Close();
+                return false;
+            }
+            if(pChunk->storedSize != pChunk->size)
+            {
+                mScratchSize = max(mScratchSize, (size_t)pChunk->size);
+            }
+            row += pChunk->rowCount;
+        }
+    }
+    mMipFirstChunk[mMipCount] = chunk;
+    if(chunk != pHeader->chunkCount)
+    {
+        Close();
+        return false;
+    }
+
+    mInfo.widthInBlocks  = mMipRowPitch[0] / bytesPerBlock;
+    mInfo.heightInBlocks = heightInBlocks;
+    mInfo.mips           = mMipCount;
+    mInfo.bytesPerBlock  = bytesPerBlock;
+    mInfo.allocateBytes  = (UINT)image.itemBytes;
+    mInfo.dxgiFormat     = image.format;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+void DDSChunkedSource::Close()
+{
+    mFile.Close();
+    mMipCount = 0;
+    mpChunks  = NULL;
+    memset(&mInfo, 0, sizeof(mInfo));
+
+    std::unique_lock<std::mutex> lock(mScratchMutex);
+    for(size_t ii = 0; ii < mScratch.size(); ii++)
+    {
+        _aligned_free(mScratch[ii]);
+    }
+    mScratch.clear();
+    mScratchSize = 0;
+}
+
+//-----------------------------------------------------------------------------
+bool DDSChunkedSource::IsKernelCompatible(UINT mip) const
+{
+    if(mip >= mMipCount)
+    {
+        return false;
+    }
+    return (mMipRowPitch[mip] & 15) == 0 &&
+           (mInfo.widthInBlocks & (mInfo.widthInBlocks - 1)) == 0 && (mInfo.heightInBlocks & (mInfo.heightInBlocks - 1)) == 0;
+}
+
+//-----------------------------------------------------------------------------
+BYTE *DDSChunkedSource::AcquireScratch()
+{
+    {
+        std::unique_lock<std::mutex> lock(mScratchMutex);
+        if(!mScratch.empty())
+        {
+            BYTE *pScratch = mScratch.back();
+            mScratch.pop_back();
+            return pScratch;
+        }
+    }
+    return (BYTE *)_aligned_malloc(mScratchSize, 64);
+}
+
+//-----------------------------------------------------------------------------
+void DDSChunkedSource::ReleaseScratch(BYTE *pScratch)
+{
+    std::unique_lock<std::mutex> lock(mScratchMutex);
+    mScratch.push_back(pScratch);
+}
+
+//-----------------------------------------------------------------------------
+bool DDSChunkedSource::WriteMip(INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA *pGPUSubResourceData, UINT mip, UINT threads)
+{
+    if(mip >= mMipCount)
+    {
+        return false;
+    }
+
+    // Each chunk is a band of the mip, written like WriteDRA_CopyParallel writes its bands: the
+    // band starts firstRow rows further down and is rowCount rows high
+    const UINT firstChunk = mMipFirstChunk[mip];
+    std::atomic<bool> failed(false);
+    CPUTWorkerPool::GetWorkerPool()->ParallelFor(mMipFirstChunk[mip + 1] - firstChunk, 1, [&](UINT begin, UINT end)
+    {
+        BYTE *pScratch = NULL;
+        for (UINT ii = begin; ii < end; ii++)
+        {
+            const DDSChunk &chunk = mpChunks[firstChunk + ii];
+            const BYTE *pStored = mFile.GetData() + chunk.offset;
+            D3D11_MAPPED_SUBRESOURCE bandSrc;
+            bandSrc.RowPitch   = mMipRowPitch[mip];
+            bandSrc.DepthPitch = chunk.size;
+            if (chunk.storedSize == chunk.size)
+            {
+                bandSrc.pData = (void *)pStored;
+            }
+            else
+            {
+                if (!pScratch)
+                {
+                    pScratch = AcquireScratch();
+                }
+                if (!pScratch || !CPUTArchive::Decompress(mCompression, pStored, chunk.storedSize, pScratch, chunk.size))
+                {
+                    failed = true;
+                    continue;
+                }
+                bandSrc.pData = pScratch;
+            }
+            INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA bandData = *pGPUSubResourceData;
+            bandData.YOffset += chunk.firstRow;
+            TextureInfo bandInfo = mInfo;
+            bandInfo.heightInBlocks = chunk.rowCount << mip;
+            WriteDRA_Copy(MODE_LINEAR_INTRINSICS, &bandData, &bandInfo, mip, bandSrc);
+        }
+        if (pScratch)
+        {
+            ReleaseScratch(pScratch);
+        }
+    }, threads);
+    return !failed;
+}
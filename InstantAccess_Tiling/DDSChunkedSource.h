@@ -0,0 +1,112 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __DDSCHUNKEDSOURCE_H__
+#define __DDSCHUNKEDSOURCE_H__
+
+#include "DDSMappedSource.h"
+#include "CPUTArchive.h"
+#include <mutex>
+#include <vector>
+
+#define DDS_CHUNKED_MAGIC      0x43534444 // "DDSC"
+#define DDS_CHUNKED_VERSION    1
+// Nominal decompressed size of a chunk: small enough to stay in L2 between decompression and tiling
+#define DDS_CHUNKED_CHUNK_SIZE (64 * 1024)
+
+// Chunked, compressed .dds container (.ddsc)
+//
+//   DDSChunkedHeader
+//   the .dds headers (magic, DDS_HEADER and DDS_HEADER_DXT10 if present), as in the original file
+//   DDSChunk[chunkCount], ordered by mip then row
+//   payloads, 64 byte aligned
+//
+// Every chunk is a band of whole block rows of one mip: a power of two number of rows, at least 4
+// (or the whole mip), as many as fit in DDS_CHUNKED_CHUNK_SIZE. So each chunk is, on its own, a
+// valid linear source for WriteDRA_Copy of that band, and tiling never needs the mip in one piece.
+// Chunks that don't compress are stored as is (storedSize == size).
+#pragma pack(push,1)
+struct DDSChunkedHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t compression;      // CPUTArchiveCompression
+    uint32_t ddsHeaderSize;
+    uint32_t chunkCount;
+    uint64_t ddsFileSize;      // of the original .dds
+};
+
+struct DDSChunk
+{
+    uint64_t offset;           // of the payload, from the start of the file
+    uint32_t storedSize;
+    uint32_t size;             // rowCount * the mip's row pitch
+    uint32_t mip;
+    uint32_t firstRow;         // in blocks
+    uint32_t rowCount;
+};
+#pragma pack(pop)
+
+// DDSChunkedSource
+// Tiles a texture straight from a memory mapped .ddsc. The chunks of a mip are spread over the CPUT
+// worker pool; each thread decompresses a chunk into a small scratch buffer that stays in cache and
+// immediately streams it into the DRA allocation with the linear TileY kernel, so the decompressed
+// mip never exists in one piece. Stored (uncompressed) chunks are tiled from the mapping directly.
+// Same restrictions as DDSMappedSource: plain 2D textures with a single array slice.
+class DDSChunkedSource
+{
+public:
+    DDSChunkedSource() : mMipCount(0), mCompression(CPUT_ARCHIVE_COMPRESSION_NONE), mpChunks(NULL), mScratchSize(0) {}
+    ~DDSChunkedSource() { Close(); }
+
+    // Writes chunkedFileName from a .dds. Compression the build doesn't support fails.
+    static bool Cook(const CPUTMappedFile::PathChar *ddsFileName, const CPUTMappedFile::PathChar *chunkedFileName, uint16_t compression);
+
+    // Returns false if the file can't be mapped or fails validation
+    bool Open(const CPUTMappedFile::PathChar *fileName);
+    void Close();
+
+    bool               IsOpen() const { return mFile.IsOpen(); }
+    const TextureInfo &GetTextureInfo() const { return mInfo; }
+
+    // The linear TileY kernel reads 16 byte rows and expects power of two sizes
+    bool IsKernelCompatible(UINT mip) const;
+
+    // Decompresses and tiles one mip on up to threads threads (0 for the whole pool).
+    // Returns false if the mip isn't in the file or a chunk fails to decompress.
+    bool WriteMip(INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA *pGPUSubResourceData, UINT mip, UINT threads = 0);
+
+private:
+    BYTE *AcquireScratch();
+    void  ReleaseScratch(BYTE *pScratch);
+
+    CPUTMappedFile      mFile;
+    TextureInfo         mInfo;
+    UINT                mMipCount;
+    uint16_t            mCompression;
+    const DDSChunk     *mpChunks;
+    UINT                mMipFirstChunk[DDS_MAPPED_MAX_MIPS + 1];
+    UINT                mMipRowPitch[DDS_MAPPED_MAX_MIPS];
+
+    // Decompression buffers, reused across threads and calls so they stay warm
+    std::vector<BYTE *> mScratch;
+    size_t              mScratchSize;
+    std::mutex          mScratchMutex;
+
+    DDSChunkedSource(const DDSChunkedSource &);
+    DDSChunkedSource &operator=(const DDSChunkedSource &);
+};
+
+#endif // __DDSCHUNKEDSOURCE_H__
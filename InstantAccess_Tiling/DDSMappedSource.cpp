@@ -0,0 +1,104 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "DDSMappedSource.h"
+#include "DDSImage.h"
+#include <string.h>
+
+//-----------------------------------------------------------------------------
+static bool IsBlockCompressed(DXGI_FORMAT format)
+{
+    return (format >= DXGI_FORMAT_BC1_TYPELESS && format <= DXGI_FORMAT_BC5_SNORM) ||
+           (format >= DXGI_FORMAT_BC6H_TYPELESS && format <= DXGI_FORMAT_BC7_UNORM_SRGB);
+}
+
+//-----------------------------------------------------------------------------
+bool DDSMappedSource::Open(const CPUTMappedFile::PathChar *fileName)
+{
+    Close();
+    if(!mFile.Open(fileName))
+    {
+        return false;
+    }
+
+    DirectX::DDSImage image;
+    if(DirectX::ParseDDSImage(mFile.GetData(), mFile.GetSize(), &image) != DirectX::DDS_OK ||
+       image.resourceDimension != DDS_DIMENSION_TEXTURE2D || image.arraySize != 1)
+    {
+        Close();
+        return false;
+    }
+    // Whole bytes per block: 4x4 blocks for BC formats, single texels otherwise
+    size_t bitsPerPixel = DirectX::BitsPerPixel(image.format);
+    UINT bytesPerBlock = (UINT)(IsBlockCompressed(image.format) ? bitsPerPixel * 2 : bitsPerPixel / 8);
+    if(bytesPerBlock == 0 || (!IsBlockCompressed(image.format) && (bitsPerPixel & 7)))
+    {
+        Close();
+        return false;
+    }
+
+    mMipCount = min(image.mipCount, (UINT)DDS_MAPPED_MAX_MIPS);
+    for(UINT mip = 0; mip < mMipCount; mip++)
+    {
+        DirectX::DDSSubresource sub;
+        DirectX::GetDDSSubresource(image, 0, mip, &sub);
+        mMipOffset[mip]     = sub.offset;
+        mMipRowPitch[mip]   = (UINT)sub.rowPitch;
+        mMipSlicePitch[mip] = (UINT)sub.slicePitch;
+    }
+
+    mInfo.widthInBlocks  = mMipRowPitch[0] / bytesPerBlock;
+    mInfo.heightInBlocks = mMipSlicePitch[0] / mMipRowPitch[0];
+    mInfo.mips           = mMipCount;
+    mInfo.bytesPerBlock  = bytesPerBlock;
+    mInfo.allocateBytes  = (UINT)image.itemBytes;
+    mInfo.dxgiFormat     = image.format;
+
+    // The copy reads every byte of the mips once, front to back
+    mFile.WillNeed();
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+void DDSMappedSource::Close()
+{
+    mFile.Close();
+    mMipCount = 0;
+    memset(&mInfo, 0, sizeof(mInfo));
+}
+
+//-----------------------------------------------------------------------------
+bool DDSMappedSource::GetMip(UINT mip, D3D11_MAPPED_SUBRESOURCE *pMip) const
+{
+    if(mip >= mMipCount)
+    {
+        return false;
+    }
+    pMip->pData      = (void *)(mFile.GetData() + mMipOffset[mip]);
+    pMip->RowPitch   = mMipRowPitch[mip];
+    pMip->DepthPitch = mMipSlicePitch[mip];
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+bool DDSMappedSource::IsKernelCompatible(UINT mip) const
+{
+    if(mip >= mMipCount)
+    {
+        return false;
+    }
+    return ((UINT_PTR)(mFile.GetData() + mMipOffset[mip]) & 15) == 0 && (mMipRowPitch[mip] & 15) == 0 &&
+           (mInfo.widthInBlocks & (mInfo.widthInBlocks - 1)) == 0 && (mInfo.heightInBlocks & (mInfo.heightInBlocks - 1)) == 0;
+}
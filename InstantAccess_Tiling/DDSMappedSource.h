@@ -0,0 +1,60 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __DDSMAPPEDSOURCE_H__
+#define __DDSMAPPEDSOURCE_H__
+
+#include "InstantAccess_Tiling.h"
+#include "CPUTMappedFile.h"
+
+#define DDS_MAPPED_MAX_MIPS 16
+
+// DDSMappedSource
+// Linear source for WriteDRA_Copy read straight out of a memory mapped .dds file. The header is
+// parsed in place and each mip is handed out as a D3D11_MAPPED_SUBRESOURCE pointing into the
+// mapping, so the tiling write is the only copy of the texel data: no heap buffer for the file, no
+// staging texture and no Map of it.
+// The header is validated by ParseDDSImage (DDSImage.h). Only plain 2D textures (one array slice,
+// no cube or volume) are supported.
+class DDSMappedSource
+{
+public:
+    DDSMappedSource() : mMipCount(0) {}
+
+    // Returns false if the file can't be mapped or isn't a DDS layout described above
+    bool Open(const CPUTMappedFile::PathChar *fileName);
+    void Close();
+
+    bool               IsOpen() const { return mFile.IsOpen(); }
+    const TextureInfo &GetTextureInfo() const { return mInfo; }
+
+    // Linear view of one mip. pData points into the file mapping and stays valid until Close.
+    bool GetMip(UINT mip, D3D11_MAPPED_SUBRESOURCE *pMip) const;
+
+    // The SSE copy kernels load 16 bytes at a time with aligned loads and expect power of two sizes.
+    // Legacy DDS headers put the texels at byte 128 of the mapping, but a DX10 header moves them to
+    // byte 148, in which case the caller has to go through a staging copy instead.
+    bool IsKernelCompatible(UINT mip) const;
+
+private:
+    CPUTMappedFile mFile;
+    TextureInfo    mInfo;
+    UINT           mMipCount;
+    size_t         mMipOffset[DDS_MAPPED_MAX_MIPS];
+    UINT           mMipRowPitch[DDS_MAPPED_MAX_MIPS];
+    UINT           mMipSlicePitch[DDS_MAPPED_MAX_MIPS];
+};
+
+#endif // __DDSMAPPEDSOURCE_H__
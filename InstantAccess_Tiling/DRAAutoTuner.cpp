@@ -0,0 +1,219 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "DRAAutoTuner.h"
+#include "CPUTOSServicesWin.h"
+#include "CPUTTimerWin.h"
+#include "CPUTWorkerPool.h"
+
+const UINT TileH = 32; // height of tile in blocks
+
+// Candidate band heights, in block rows.  Each is a power of two so the band still satisfies the
+// power-of-two assertion of the kernels.
+static const UINT gChunkRows[] = { 32, 64, 128, 256 };
+static const UINT gModes[] = { MODE_TILED, MODE_LINEAR_ROWS, MODE_LINEAR_COLUMNS, MODE_LINEAR_INTRINSICS };
+// Runs per candidate.  The first one warms up the caches and the pool, the best of the rest is kept.
+static const UINT gTimedRuns = 3;
+
+//-----------------------------------------------------------------------------
+void WriteDRA_CopyParallel(UINT mode, INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA * pGPUSubResourceData, TextureInfo *pTexInfo,
+                           UINT mip, D3D11_MAPPED_SUBRESOURCE &texData, UINT threads, UINT chunkRows)
+{
+    const UINT mipHeightInBlock = max(pTexInfo->heightInBlocks >> mip, 1u);
+    const UINT mipWidthInBytes  = max(pTexInfo->widthInBlocks >> mip, 1u) * pTexInfo->bytesPerBlock;
+    // MODE_TILED writes the mip's tiles back to back, so it only fits a mip that starts the map
+    // and whose rows are exactly as wide as the map's
+    if (mode == MODE_TILED && (pGPUSubResourceData->XOffset != 0 || pGPUSubResourceData->YOffset != 0 ||
+                               pGPUSubResourceData->Pitch != mipWidthInBytes))
+    {
+        mode = MODE_LINEAR_INTRINSICS;
+    }
+    if (threads <= 1 || chunkRows < TileH || chunkRows >= mipHeightInBlock)
+    {
+        WriteDRA_Copy(mode, pGPUSubResourceData, pTexInfo, mip, texData);
+        return;
+    }
+
+    // Each band looks like a shorter mip: same width, chunkRows high, starting chunkRows*band rows further down.
+    // The tiled modes address the destination from the band's YOffset; MODE_TILED writes the tiles out
+    // sequentially, so its base address moves past the rows above the band, Pitch bytes each, instead.
+    CPUTWorkerPool::GetWorkerPool()->ParallelFor(mipHeightInBlock / chunkRows, 1, [&](UINT begin, UINT end)
+    {
+        for (UINT band = begin; band < end; band++)
+        {
+            const UINT y0 = band * chunkRows;
+            INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA bandData = *pGPUSubResourceData;
+            if (mode == MODE_TILED)
+            {
+                bandData.pBaseAddress = (BYTE*)bandData.pBaseAddress + y0 * bandData.Pitch;
+            }
+            else
+            {
+                bandData.YOffset += y0;
+            }
+            TextureInfo bandInfo = *pTexInfo;
+            bandInfo.heightInBlocks = chunkRows << mip;
+            D3D11_MAPPED_SUBRESOURCE bandSrc = texData;
+            bandSrc.pData = (BYTE*)texData.pData + y0 * texData.RowPitch;
+            WriteDRA_Copy(mode, &bandData, &bandInfo, mip, bandSrc);
+        }
+    }, threads);
+}
+
+//-----------------------------------------------------------------------------
+DRATuningKey DRAAutoTuner::MakeKey(INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA * pGPUSubResourceData, TextureInfo *pTexInfo, UINT mip)
+{
+    DRATuningKey key;
+    key.widthInBlocks  = max(pTexInfo->widthInBlocks >> mip, 1u);
+    key.heightInBlocks = max(pTexInfo->heightInBlocks >> mip, 1u);
+    key.bytesPerBlock  = pTexInfo->bytesPerBlock;
+    key.tileFormat     = pGPUSubResourceData->TileFormat;
+    return key;
+}
+
+//-----------------------------------------------------------------------------
+const DRATuningChoice *DRAAutoTuner::FindChoice(const DRATuningKey &key) const
+{
+    for (size_t ii = 0; ii < mProfile.size(); ii++)
+    {
+        if (mProfile[ii].key == key)
+        {
+            return &mProfile[ii].choice;
+        }
+    }
+    return NULL;
+}
+
+//-----------------------------------------------------------------------------
+DRATuningChoice DRAAutoTuner::Tune(INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA * pGPUSubResourceData, TextureInfo *pTexInfo,
+                                   UINT mip, D3D11_MAPPED_SUBRESOURCE &texData)
+{
+    const UINT mipHeightInBlock = max(pTexInfo->heightInBlocks >> mip, 1u);
+    const UINT maxThreads = CPUTWorkerPool::GetWorkerPool()->GetThreadCount() + 1;
+
+    DRATuningChoice best = { MODE_LINEAR_INTRINSICS, 1, mipHeightInBlock, 1.0e30 };
+    CPUTTimerWin timer;
+    for (UINT mm = 0; mm < ARRAYSIZE(gModes); mm++)
+    {
+        for (UINT threads = 1; threads <= maxThreads; threads *= 2)
+        {
+            for (UINT cc = 0; cc < ARRAYSIZE(gChunkRows); cc++)
+            {
+                // a single thread does not split; more threads need at least two bands
+                UINT chunkRows = (threads == 1) ? mipHeightInBlock : gChunkRows[cc];
+                if (threads > 1 && chunkRows * 2 > mipHeightInBlock)
+                {
+                    break;
+                }
+                double seconds = 1.0e30;
+                for (UINT run = 0; run <= gTimedRuns; run++)
+                {
+                    timer.StartTimer();
+                    WriteDRA_CopyParallel(gModes[mm], pGPUSubResourceData, pTexInfo, mip, texData, threads, chunkRows);
+                    double elapsed = timer.StopTimer();
+                    if (run > 0)
+                    {
+                        seconds = min(seconds, elapsed);
+                    }
+                }
+                if (seconds < best.seconds)
+                {
+                    best.mode      = gModes[mm];
+                    best.threads   = threads;
+                    best.chunkRows = chunkRows;
+                    best.seconds   = seconds;
+                }
+                if (threads == 1)
+                {
+                    break;
+                }
+            }
+        }
+    }
+    return best;
+}
+
+//-----------------------------------------------------------------------------
+void DRAAutoTuner::WriteDRA_Copy(INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA * pGPUSubResourceData, TextureInfo *pTexInfo,
+                                 UINT mip, D3D11_MAPPED_SUBRESOURCE &texData)
+{
+    DRATuningKey key = MakeKey(pGPUSubResourceData, pTexInfo, mip);
+    const DRATuningChoice *pChoice = FindChoice(key);
+    if (!pChoice)
+    {
+        // Tuning leaves the destination holding a complete copy, same as the call it replaces
+        Entry entry = { key, Tune(pGPUSubResourceData, pTexInfo, mip, texData) };
+        mProfile.push_back(entry);
+        SaveProfile();
+        return;
+    }
+    WriteDRA_CopyParallel(pChoice->mode, pGPUSubResourceData, pTexInfo, mip, texData, pChoice->threads, pChoice->chunkRows);
+}
+
+//-----------------------------------------------------------------------------
+CPUTResult DRAAutoTuner::LoadProfile(const cString &fileName)
+{
+    mProfileFileName = fileName;
+    mProfile.clear();
+
+    FILE *pFile = NULL;
+    CPUTResult result = CPUTOSServices::GetOSServices()->OpenFile(fileName, &pFile);
+    if (CPUTFAILED(result))
+    {
+        return CPUT_SUCCESS; // nothing tuned yet
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), pFile))
+    {
+        Entry entry;
+        if (line[0] == '#' ||
+            8 != sscanf_s(line, "%u %u %u %u %u %u %u %lf",
+                          &entry.key.widthInBlocks, &entry.key.heightInBlocks, &entry.key.bytesPerBlock, &entry.key.tileFormat,
+                          &entry.choice.mode, &entry.choice.threads, &entry.choice.chunkRows, &entry.choice.seconds))
+        {
+            continue;
+        }
+        // A profile from a machine with more cores than this one still works; the pool just runs fewer threads.
+        mProfile.push_back(entry);
+    }
+    fclose(pFile);
+    return CPUT_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+CPUTResult DRAAutoTuner::SaveProfile()
+{
+    if (mProfileFileName.empty())
+    {
+        return CPUT_ERROR_INVALID_PARAMETER;
+    }
+    FILE *pFile = NULL;
+    errno_t err = _wfopen_s(&pFile, mProfileFileName.c_str(), _L("w"));
+    if (err)
+    {
+        return CPUTOSServices::GetOSServices()->TranslateFileError(err);
+    }
+    fprintf(pFile, "# DRA copy tuning profile\n");
+    fprintf(pFile, "# widthInBlocks heightInBlocks bytesPerBlock tileFormat mode threads chunkRows seconds\n");
+    for (size_t ii = 0; ii < mProfile.size(); ii++)
+    {
+        const Entry &entry = mProfile[ii];
+        fprintf(pFile, "%u %u %u %u %u %u %u %.9f\n",
+                entry.key.widthInBlocks, entry.key.heightInBlocks, entry.key.bytesPerBlock, entry.key.tileFormat,
+                entry.choice.mode, entry.choice.threads, entry.choice.chunkRows, entry.choice.seconds);
+    }
+    fclose(pFile);
+    return CPUT_SUCCESS;
+}
@@ -0,0 +1,78 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __DRAAUTOTUNER_H__
+#define __DRAAUTOTUNER_H__
+
+#include "CPUT.h"
+#include "InstantAccess_Tiling.h"
+#include <vector>
+
+// Not a WriteDRA_Copy mode: tells the sample to dispatch through DRAAutoTuner
+#define MODE_AUTO_TUNED 4
+
+// WriteDRA_CopyParallel
+// WriteDRA_Copy split into bands of chunkRows block rows (a multiple of the 32 row tile height, so no
+// two threads write the same tile) run on up to threads threads of the CPUT worker pool.
+// MODE_TILED writes from the start of the allocation, so it is only used for mips at offset 0 whose
+// rows are exactly Pitch bytes, and falls back to MODE_LINEAR_INTRINSICS otherwise.
+void WriteDRA_CopyParallel(UINT mode, INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA * pGPUSubResourceData, TextureInfo *pTexInfo,
+                           UINT mip, D3D11_MAPPED_SUBRESOURCE &texData, UINT threads, UINT chunkRows);
+
+// Surfaces that behave the same as far as copy speed goes
+struct DRATuningKey
+{
+    UINT widthInBlocks, heightInBlocks, bytesPerBlock, tileFormat;
+    bool operator==(const DRATuningKey &other) const
+    {
+        return widthInBlocks == other.widthInBlocks && heightInBlocks == other.heightInBlocks &&
+               bytesPerBlock == other.bytesPerBlock && tileFormat == other.tileFormat;
+    }
+};
+
+struct DRATuningChoice { UINT mode, threads, chunkRows; double seconds; };
+
+// DRAAutoTuner
+// Which copy wins (tile order, linear rows/columns, the intrinsics path; how many threads; how big the
+// bands) depends on the surface, whether the source is in cache, and the CPU. The first time a surface
+// class is copied, every candidate is timed on the real source and destination, the fastest one is
+// stored in a small text profile, and every later copy of that class goes straight to it.
+class DRAAutoTuner
+{
+public:
+    DRAAutoTuner() {}
+
+    // The profile is a text file, one line per surface class:
+    //    widthInBlocks heightInBlocks bytesPerBlock tileFormat mode threads chunkRows seconds
+    // A missing file is not an error; it gets created on the first save.
+    CPUTResult LoadProfile(const cString &fileName);
+    CPUTResult SaveProfile();
+
+    void WriteDRA_Copy(INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA * pGPUSubResourceData, TextureInfo *pTexInfo,
+                       UINT mip, D3D11_MAPPED_SUBRESOURCE &texData);
+
+    const DRATuningChoice *FindChoice(const DRATuningKey &key) const;
+    DRATuningChoice        Tune(INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA * pGPUSubResourceData, TextureInfo *pTexInfo,
+                                UINT mip, D3D11_MAPPED_SUBRESOURCE &texData);
+
+    static DRATuningKey    MakeKey(INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA * pGPUSubResourceData, TextureInfo *pTexInfo, UINT mip);
+
+private:
+    struct Entry { DRATuningKey key; DRATuningChoice choice; };
+    std::vector<Entry> mProfile;
+    cString            mProfileFileName;
+};
+
+#endif // __DRAAUTOTUNER_H__
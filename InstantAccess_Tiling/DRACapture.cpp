@@ -0,0 +1,254 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "DRACapture.h"
+#include "InstantAccess_TileTraversal.h"
+#include "DDSImage.h"
+#include "CPUTWorkerPool.h"
+#include <stdio.h>
+#include <string.h>
+#include "emmintrin.h"
+
+// The texels start on a cacheline so the detiling kernels can use aligned stores; the DDS headers sit
+// right in front of them and the file is written from there in one go.
+static const size_t gHeaderSize  = sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10);
+static const size_t gPixelOffset = (gHeaderSize + 63) & ~(size_t)63;
+
+//-----------------------------------------------------------------------------
+static bool IsBlockCompressed(DXGI_FORMAT format)
+{
+    return (format >= DXGI_FORMAT_BC1_TYPELESS && format <= DXGI_FORMAT_BC5_SNORM) ||
+           (format >= DXGI_FORMAT_BC6H_TYPELESS && format <= DXGI_FORMAT_BC7_UNORM_SRGB);
+}
+
+//-----------------------------------------------------------------------------
+static UINT MipSize(UINT size, UINT mip)
+{
+    return (size >> mip) > 0 ? (size >> mip) : 1;
+}
+
+// Always written with the DX10 header, which stores the DXGI format as is
+//-----------------------------------------------------------------------------
+static void WriteDDSHeader(BYTE *pDest, const TextureInfo &texInfo, UINT mip)
+{
+    const bool compressed = IsBlockCompressed(texInfo.dxgiFormat);
+    const UINT texelsPerBlock = compressed ? 4 : 1;
+    const UINT rowPitch = MipSize(texInfo.widthInBlocks, mip) * texInfo.bytesPerBlock;
+
+    uint32_t magic = DDS_MAGIC;
+    DDS_HEADER header;
+    memset(&header, 0, sizeof(header));
+    header.size              = sizeof(DDS_HEADER);
+    header.flags             = DDS_HEADER_FLAGS_TEXTURE | (compressed ? DDS_HEADER_FLAGS_LINEARSIZE : DDS_HEADER_FLAGS_PITCH);
+    header.width             = MipSize(texInfo.widthInBlocks, mip) * texelsPerBlock;
+    header.height            = MipSize(texInfo.heightInBlocks, mip) * texelsPerBlock;
+    header.pitchOrLinearSize = compressed ? rowPitch * MipSize(texInfo.heightInBlocks, mip) : rowPitch;
+    header.mipMapCount       = 1;
+    header.ddspf.size        = sizeof(DDS_PIXELFORMAT);
+    header.ddspf.flags       = DDS_FOURCC;
+    header.ddspf.fourCC      = MAKEFOURCC('D', 'X', '1', '0');
+    header.caps              = DDS_SURFACE_FLAGS_TEXTURE;
+
+    DDS_HEADER_DXT10 header10;
+    memset(&header10, 0, sizeof(header10));
+    header10.dxgiFormat        = texInfo.dxgiFormat;
+    header10.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+    header10.arraySize         = 1;
+
+    memcpy(pDest, &magic, sizeof(magic));
+    memcpy(pDest + sizeof(magic), &header, sizeof(header));
+    memcpy(pDest + sizeof(magic) + sizeof(header), &header10, sizeof(header10));
+}
+
+//-----------------------------------------------------------------------------
+static bool WriteFileContents(const CPUTMappedFile::PathChar *fileName, const BYTE *pData, size_t size)
+{
+#ifdef _WIN32
+    HANDLE hFile = CreateFileW(fileName, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if(hFile == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    DWORD written = 0;
+    BOOL result = WriteFile(hFile, pData, (DWORD)size, &written, NULL);
+    CloseHandle(hFile);
+    return result && written == size;
+#else
+    FILE *pFile = fopen(fileName, "wb");
+    if(pFile == NULL)
+    {
+        return false;
+    }
+    bool result = fwrite(pData, 1, size, pFile) == size;
+    return (0 == fclose(pFile)) && result;
+#endif
+}
+
+// Copies the 16 byte (or narrower, at the edges) rows of the tiled walk to their linear place
+struct LinearCopyVisitor
+{
+    BYTE *pDest;
+    UINT  rowPitch;
+    void operator()(BYTE *pRow, UINT x, UINT y, UINT span)
+    {
+        memcpy(pDest + y * rowPitch + x, pRow, span);
+    }
+};
+
+//-----------------------------------------------------------------------------
+DRACapture::~DRACapture()
+{
+    Flush();
+    for(size_t ii = 0; ii < mSnapshotBuffers.size(); ii++)
+    {
+        _aligned_free(mSnapshotBuffers[ii].pData);
+    }
+    for(size_t ii = 0; ii < mLinearBuffers.size(); ii++)
+    {
+        _aligned_free(mLinearBuffers[ii].pData);
+    }
+}
+
+//-----------------------------------------------------------------------------
+DRACapture::Buffer DRACapture::AcquireBuffer(std::vector<Buffer> &pool, size_t size)
+{
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        for(size_t ii = 0; ii < pool.size(); ii++)
+        {
+            if(pool[ii].size >= size)
+            {
+                Buffer buffer = pool[ii];
+                pool.erase(pool.begin() + ii);
+                return buffer;
+            }
+        }
+    }
+    Buffer buffer = { (BYTE*)_aligned_malloc(size, 64), size };
+    return buffer;
+}
+
+//-----------------------------------------------------------------------------
+void DRACapture::ReleaseBuffer(std::vector<Buffer> &pool, const Buffer &buffer)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    pool.push_back(buffer);
+}
+
+//-----------------------------------------------------------------------------
+bool DRACapture::Capture(INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA *pGPUSubResourceData, const TextureInfo *pTexInfo,
+                         UINT mip, const CPUTMappedFile::PathChar *fileName)
+{
+    if(pTexInfo->dxgiFormat == DXGI_FORMAT_UNKNOWN || pTexInfo->bytesPerBlock == 0 || mip >= pTexInfo->mips ||
+       (pGPUSubResourceData->TileFormat != INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_TILE_TYPE_TILE_Y &&
+        pGPUSubResourceData->TileFormat != INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_TILE_TYPE_TILE_Y_NO_CSX_SWIZZLE) ||
+       mPending >= DRA_CAPTURE_MAX_PENDING)
+    {
+        return false;
+    }
+
+    Job job;
+    job.texInfo  = *pTexInfo;
+    job.mip      = mip;
+    job.fileName = fileName;
+    job.snapshot = AcquireBuffer(mSnapshotBuffers, GetDRASnapshotSize(pGPUSubResourceData, &job.texInfo, mip));
+    if(job.snapshot.pData == NULL)
+    {
+        return false;
+    }
+    SnapshotDRA(pGPUSubResourceData, &job.texInfo, mip, job.snapshot.pData, &job.snapshotData);
+
+    mPending++;
+    CPUTWorkerPool::GetWorkerPool()->Submit([this, job]() mutable { Run(job); });
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+void DRACapture::Run(Job &job)
+{
+    const UINT mipHeight = MipSize(job.texInfo.heightInBlocks, job.mip);
+    const UINT rowPitch  = MipSize(job.texInfo.widthInBlocks, job.mip) * job.texInfo.bytesPerBlock;
+    const size_t fileSize = gHeaderSize + (size_t)rowPitch * mipHeight;
+    Buffer linear = AcquireBuffer(mLinearBuffers, gPixelOffset + (size_t)rowPitch * mipHeight);
+    bool written = false;
+    if(linear.pData != NULL)
+    {
+        BYTE *pPixels = linear.pData + gPixelOffset;
+        WriteDDSHeader(pPixels - gHeaderSize, job.texInfo, job.mip);
+
+        // ReadDRA's row kernel handles the CSX TileY layout of 4 byte formats, in whole 16 byte columns.
+        // Anything else goes through the generic tiled walk.
+        const bool readRows = job.snapshotData.TileFormat == INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_TILE_TYPE_TILE_Y &&
+                              job.texInfo.bytesPerBlock == 4 && rowPitch % 16 == 0 && job.snapshotData.XOffset % 16 == 0;
+
+        // One tile row per band, rounding up so a partial last band is read too. The kernels want power of two
+        // heights, so a partial band is read in power of two pieces.
+        const UINT bandHeight = mipHeight < DRATile::TileH ? mipHeight : DRATile::TileH;
+        CPUTWorkerPool::GetWorkerPool()->ParallelFor((mipHeight + bandHeight - 1) / bandHeight, 1, [&](unsigned int begin, unsigned int end)
+        {
+            for(UINT band = begin; band < end; band++)
+            {
+                UINT y0 = band * bandHeight;
+                UINT rowsLeft = mipHeight - y0 < bandHeight ? mipHeight - y0 : bandHeight;
+                while(rowsLeft > 0)
+                {
+                    UINT pieceHeight = 1;
+                    while(pieceHeight * 2 <= rowsLeft) { pieceHeight *= 2; }
+                    INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA bandData = job.snapshotData;
+                    bandData.YOffset += y0;
+                    TextureInfo bandInfo = job.texInfo;
+                    bandInfo.heightInBlocks = pieceHeight << job.mip;
+                    if(readRows)
+                    {
+                        D3D11_MAPPED_SUBRESOURCE texData = { pPixels + (size_t)y0 * rowPitch, rowPitch, 0 };
+                        ReadDRA(MODE_LINEAR_ROWS, &bandData, &bandInfo, job.mip, texData);
+                    }
+                    else
+                    {
+                        LinearCopyVisitor visitor = { pPixels + (size_t)y0 * rowPitch, rowPitch };
+                        DRATile::ForEachRowTiled(&bandData, &bandInfo, job.mip, visitor);
+                    }
+                    y0       += pieceHeight;
+                    rowsLeft -= pieceHeight;
+                }
+            }
+        });
+        _mm_sfence(); // ReadDRA uses streaming stores
+
+        written = WriteFileContents(job.fileName.c_str(), pPixels - gHeaderSize, fileSize);
+        ReleaseBuffer(mLinearBuffers, linear);
+    }
+    ReleaseBuffer(mSnapshotBuffers, job.snapshot);
+    if(!written)
+    {
+        mFailed++;
+    }
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    if(--mPending == 0)
+    {
+        mDone.notify_all();
+    }
+}
+
+//-----------------------------------------------------------------------------
+void DRACapture::Flush()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    while(mPending > 0)
+    {
+        mDone.wait(lock);
+    }
+}
@@ -0,0 +1,81 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __DRACAPTURE_H__
+#define __DRACAPTURE_H__
+
+#include "InstantAccess_Tiling.h"
+#include "CPUTMappedFile.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Captures in flight before Capture starts refusing new ones
+#define DRA_CAPTURE_MAX_PENDING 4
+
+// DRACapture
+// Saves a mip of a DRA resource to a .dds file without stalling the frame. Capture runs on the render
+// thread while the resource is mapped and only takes a snapshot of its tiles (SnapshotDRA). Everything
+// else happens on the CPUT worker pool: the snapshot is detiled in bands of a tile row on several
+// workers, into a linear buffer that already has room for the DDS headers in front of the texels, and
+// the result is written with a single write call. Snapshot and linear buffers are pooled, so after the
+// first few captures no memory is allocated.
+class DRACapture
+{
+public:
+    DRACapture() : mPending(0), mFailed(0) {}
+    ~DRACapture();
+
+    // Returns false, without touching the resource, if the format has no DDS equivalent, the tile
+    // format isn't TileY or DRA_CAPTURE_MAX_PENDING captures are still in flight.
+    bool Capture(INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA *pGPUSubResourceData, const TextureInfo *pTexInfo,
+                 UINT mip, const CPUTMappedFile::PathChar *fileName);
+
+    // Blocks until every queued capture is on disk
+    void Flush();
+
+    UINT GetPendingCount() const { return mPending; }
+    // Captures whose file couldn't be written
+    UINT GetFailedCount() const { return mFailed; }
+
+private:
+    struct Buffer { BYTE *pData; size_t size; };
+    struct Job
+    {
+        Buffer                                          snapshot;
+        INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA snapshotData;
+        TextureInfo                                     texInfo;
+        UINT                                            mip;
+        std::basic_string<CPUTMappedFile::PathChar>     fileName;
+    };
+
+    void   Run(Job &job);
+    Buffer AcquireBuffer(std::vector<Buffer> &pool, size_t size);
+    void   ReleaseBuffer(std::vector<Buffer> &pool, const Buffer &buffer);
+
+    std::atomic<UINT>       mPending;
+    std::atomic<UINT>       mFailed;
+    std::vector<Buffer>     mSnapshotBuffers;
+    std::vector<Buffer>     mLinearBuffers;
+    std::mutex              mMutex;
+    std::condition_variable mDone;
+
+    DRACapture(const DRACapture &);
+    DRACapture &operator=(const DRACapture &);
+};
+
+#endif // __DRACAPTURE_H__
@@ -0,0 +1,138 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __DRASLOTRING_H__
+#define __DRASLOTRING_H__
+
+// The slot bookkeeping for DRATextureRing lives in this header on its own so it
+// does not pull in any D3D or Windows headers. It can be compiled and driven with a
+// fake DRAFenceSource on any platform.
+#include <stddef.h>
+#include <stdint.h>
+
+// A monotonically increasing GPU timeline. Signal() enqueues a marker behind all
+// work submitted so far and returns its value (values start at 1). GetCompletedValue()
+// returns the largest value the GPU is known to have passed.
+class DRAFenceSource
+{
+public:
+    virtual ~DRAFenceSource() {}
+    virtual uint64_t Signal() = 0;
+    virtual uint64_t GetCompletedValue() = 0;
+    // Block until GetCompletedValue() >= value
+    virtual void     WaitForValue(uint64_t value) = 0;
+};
+
+// Round robin over N slots. Each slot remembers the fence value signaled after the
+// last GPU work that read it, and is only handed out again once that fence passed.
+class DRASlotRing
+{
+public:
+    static const unsigned int MAX_SLOTS = 8;
+    static const unsigned int INVALID_SLOT = ~0u;
+
+    DRASlotRing() : mpFence(NULL), mNumSlots(0) { Reset(NULL, 0); }
+
+    void Reset(DRAFenceSource *pFence, unsigned int numSlots)
+    {
+        mpFence    = pFence;
+        mNumSlots  = numSlots < MAX_SLOTS ? numSlots : MAX_SLOTS;
+        mNext      = 0;
+        mAcquired  = INVALID_SLOT;
+        mPublished = INVALID_SLOT;
+        for( unsigned int ii=0; ii<MAX_SLOTS; ii++ )
+        {
+            mSlotFence[ii] = 0; // 0 means the GPU never used the slot
+        }
+    }
+
+    // Returns a slot the GPU has finished with, or INVALID_SLOT if every slot is still in flight.
+    // Never returns the published slot, since the GPU may be about to sample it
+    // (unless the ring has a single slot, which degenerates to the old Map-and-wait behavior).
+    unsigned int Acquire()
+    {
+        if( mAcquired != INVALID_SLOT )
+        {
+            return mAcquired;
+        }
+        uint64_t completed = mpFence ? mpFence->GetCompletedValue() : 0;
+        for( unsigned int ii=0; ii<mNumSlots; ii++ )
+        {
+            unsigned int slot = (mNext + ii) % mNumSlots;
+            if( (slot != mPublished || mNumSlots == 1) && mSlotFence[slot] <= completed )
+            {
+                mAcquired = slot;
+                mNext     = (slot + 1) % mNumSlots;
+                return slot;
+            }
+        }
+        return INVALID_SLOT;
+    }
+
+    // Like Acquire(), but waits on the oldest in-flight slot when none is free.
+    unsigned int AcquireBlocking()
+    {
+        unsigned int slot = Acquire();
+        if( slot == INVALID_SLOT && mpFence )
+        {
+            uint64_t oldest = 0;
+            for( unsigned int ii=0; ii<mNumSlots; ii++ )
+            {
+                if( (ii != mPublished || mNumSlots == 1) && (oldest == 0 || mSlotFence[ii] < oldest) )
+                {
+                    oldest = mSlotFence[ii];
+                }
+            }
+            mpFence->WaitForValue(oldest);
+            slot = Acquire();
+        }
+        return slot;
+    }
+
+    // The CPU finished writing the acquired slot. It becomes the slot the GPU reads from.
+    unsigned int Publish()
+    {
+        if( mAcquired != INVALID_SLOT )
+        {
+            mPublished = mAcquired;
+            mAcquired  = INVALID_SLOT;
+        }
+        return mPublished;
+    }
+
+    // All GPU work reading the published slot has been submitted. Fence it.
+    void Submit()
+    {
+        if( mPublished != INVALID_SLOT && mpFence )
+        {
+            mSlotFence[mPublished] = mpFence->Signal();
+        }
+    }
+
+    unsigned int GetPublished() const { return mPublished; }
+    unsigned int GetAcquired() const  { return mAcquired; }
+    unsigned int GetNumSlots() const  { return mNumSlots; }
+    uint64_t     GetSlotFence(unsigned int slot) const { return mSlotFence[slot]; }
+
+private:
+    DRAFenceSource *mpFence;
+    unsigned int    mNumSlots;
+    unsigned int    mNext;
+    unsigned int    mAcquired;
+    unsigned int    mPublished;
+    uint64_t        mSlotFence[MAX_SLOTS];
+};
+
+#endif // __DRASLOTRING_H__
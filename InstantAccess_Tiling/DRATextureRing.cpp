@@ -0,0 +1,259 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "DRATextureRing.h"
+#include "CPUTAssetLibrary.h"
+
+//-----------------------------------------------------------------------------
+DRAQueryFence::DRAQueryFence() :
+    mpContext(NULL),
+    mSignaled(0),
+    mCompleted(0)
+{
+    ZeroMemory( mpQueries, sizeof(mpQueries) );
+}
+
+//-----------------------------------------------------------------------------
+DRAQueryFence::~DRAQueryFence()
+{
+    Release();
+}
+
+//-----------------------------------------------------------------------------
+HRESULT DRAQueryFence::Create(ID3D11Device *pDevice, ID3D11DeviceContext *pContext)
+{
+    Release();
+    mpContext = pContext;
+
+    D3D11_QUERY_DESC desc;
+    desc.Query     = D3D11_QUERY_EVENT;
+    desc.MiscFlags = 0;
+    for( UINT ii=0; ii<MAX_QUERIES; ii++ )
+    {
+        HRESULT hr = pDevice->CreateQuery( &desc, &mpQueries[ii] );
+        if( FAILED(hr) )
+        {
+            return hr;
+        }
+    }
+    return S_OK;
+}
+
+//-----------------------------------------------------------------------------
+void DRAQueryFence::Release()
+{
+    for( UINT ii=0; ii<MAX_QUERIES; ii++ )
+    {
+        SAFE_RELEASE( mpQueries[ii] );
+    }
+    mpContext  = NULL;
+    mSignaled  = 0;
+    mCompleted = 0;
+}
+
+//-----------------------------------------------------------------------------
+uint64_t DRAQueryFence::Signal()
+{
+    // Fence value v lives in query (v-1) % MAX_QUERIES.  Don't reuse a query that is still pending.
+    if( mSignaled - mCompleted >= MAX_QUERIES )
+    {
+        WaitForValue( mSignaled - MAX_QUERIES + 1 );
+    }
+    mpContext->End( mpQueries[mSignaled % MAX_QUERIES] );
+    return ++mSignaled;
+}
+
+//-----------------------------------------------------------------------------
+uint64_t DRAQueryFence::GetCompletedValue()
+{
+    // Event queries complete in submission order, so stop at the first pending one.
+    while( mCompleted < mSignaled )
+    {
+        ID3D11Query *pQuery = mpQueries[mCompleted % MAX_QUERIES];
+        if( S_OK != mpContext->GetData( pQuery, NULL, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH ) )
+        {
+            break;
+        }
+        mCompleted++;
+    }
+    return mCompleted;
+}
+
+//-----------------------------------------------------------------------------
+void DRAQueryFence::WaitForValue(uint64_t value)
+{
+    if( GetCompletedValue() >= value )
+    {
+        return;
+    }
+    // The queries may still be sitting in the command buffer.  Kick it once, then spin.
+    mpContext->Flush();
+    while( GetCompletedValue() < value )
+    {
+        YieldProcessor();
+    }
+}
+
+//-----------------------------------------------------------------------------
+DRATextureRing::DRATextureRing() :
+    mpContext(NULL),
+    mpLibraryTexture(NULL),
+    mBoundSlot(DRASlotRing::INVALID_SLOT),
+    mMappedSlot(DRASlotRing::INVALID_SLOT),
+    mMappedForWrite(false)
+{
+    ZeroMemory( mpCPUTextures, sizeof(mpCPUTextures) );
+    ZeroMemory( mpGPUTextures, sizeof(mpGPUTextures) );
+    ZeroMemory( mpSRVs, sizeof(mpSRVs) );
+}
+
+//-----------------------------------------------------------------------------
+DRATextureRing::~DRATextureRing()
+{
+    Release();
+}
+
+//-----------------------------------------------------------------------------
+HRESULT DRATextureRing::Create(ID3D11Device *pDevice, ID3D11DeviceContext *pContext,
+                               const D3D11_TEXTURE2D_DESC *pCPUDesc, const D3D11_TEXTURE2D_DESC *pGPUDesc,
+                               UINT numSlots, const cString &textureName)
+{
+    Release();
+    mpContext = pContext;
+    numSlots  = min( max(numSlots, 1u), DRASlotRing::MAX_SLOTS );
+
+    HRESULT hr = mFence.Create( pDevice, pContext );
+    if( FAILED(hr) )
+    {
+        return hr;
+    }
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvdesc;
+    srvdesc.Texture2D.MipLevels       = pGPUDesc->MipLevels;
+    srvdesc.Format                    = pGPUDesc->Format;
+    srvdesc.Texture2D.MostDetailedMip = 0;
+    srvdesc.ViewDimension             = D3D11_SRV_DIMENSION_TEXTURE2D;
+
+    for( UINT ii=0; ii<numSlots; ii++ )
+    {
+        hr = IGFX::CreateSharedTexture2D( pDevice, pCPUDesc, &mpCPUTextures[ii], pGPUDesc, &mpGPUTextures[ii], NULL );
+        if( FAILED(hr) )
+        {
+            return hr;
+        }
+        pContext->CopyResource( mpCPUTextures[ii], mpGPUTextures[ii] );
+
+        hr = pDevice->CreateShaderResourceView( mpGPUTextures[ii], &srvdesc, &mpSRVs[ii] );
+        if( FAILED(hr) )
+        {
+            return hr;
+        }
+    }
+    mSlots.Reset( &mFence, numSlots );
+
+    // Materials reference the texture by name.  Register slot 0 under that name; later
+    // publishes repoint the same library entry at whichever slot was written last.
+    mpLibraryTexture = new CPUTTextureDX11( std::wstring(textureName), mpGPUTextures[0], mpSRVs[0] );
+    CPUTAssetLibrary::GetAssetLibrary()->AddTexture( mpLibraryTexture->Name(), mpLibraryTexture );
+    mBoundSlot = 0;
+
+    return S_OK;
+}
+
+//-----------------------------------------------------------------------------
+void DRATextureRing::Release()
+{
+    if( mMappedSlot != DRASlotRing::INVALID_SLOT )
+    {
+        Unmap();
+    }
+    SAFE_RELEASE( mpLibraryTexture );
+    for( UINT ii=0; ii<DRASlotRing::MAX_SLOTS; ii++ )
+    {
+        SAFE_RELEASE( mpSRVs[ii] );
+        SAFE_RELEASE( mpGPUTextures[ii] );
+        SAFE_RELEASE( mpCPUTextures[ii] );
+    }
+    mFence.Release();
+    mSlots.Reset( NULL, 0 );
+    mpContext  = NULL;
+    mBoundSlot = DRASlotRing::INVALID_SLOT;
+}
+
+//-----------------------------------------------------------------------------
+INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA *DRATextureRing::MapForWrite()
+{
+    UINT slot = mSlots.AcquireBlocking();
+    if( slot == DRASlotRing::INVALID_SLOT )
+    {
+        return NULL;
+    }
+    D3D11_MAPPED_SUBRESOURCE mappedResource;
+    if( FAILED(mpContext->Map( mpCPUTextures[slot], 0, D3D11_MAP_WRITE, 0, &mappedResource )) )
+    {
+        return NULL;
+    }
+    mMappedSlot     = slot;
+    mMappedForWrite = true;
+    return (INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA*)(mappedResource.pData);
+}
+
+//-----------------------------------------------------------------------------
+INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA *DRATextureRing::MapForRead()
+{
+    UINT slot = (mSlots.GetPublished() != DRASlotRing::INVALID_SLOT) ? mSlots.GetPublished() : 0;
+
+    // Only the CPU reads, and Map() already waits for the GPU to finish with this one texture
+
+    D3D11_MAPPED_SUBRESOURCE mappedResource;
+    if( FAILED(mpContext->Map( mpCPUTextures[slot], 0, D3D11_MAP_READ, 0, &mappedResource )) )
+    {
+        return NULL;
+    }
+    mMappedSlot     = slot;
+    mMappedForWrite = false;
+    return (INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA*)(mappedResource.pData);
+}
+
+//-----------------------------------------------------------------------------
+void DRATextureRing::Unmap()
+{
+    mpContext->Unmap( mpCPUTextures[mMappedSlot], 0 );
+    if( mMappedForWrite )
+    {
+        BindSlot( mSlots.Publish() );
+    }
+    mMappedSlot = DRASlotRing::INVALID_SLOT;
+}
+
+//-----------------------------------------------------------------------------
+void DRATextureRing::Submit()
+{
+    mSlots.Submit();
+}
+
+//-----------------------------------------------------------------------------
+void DRATextureRing::BindSlot(UINT slot)
+{
+    if( slot == mBoundSlot || slot == DRASlotRing::INVALID_SLOT )
+    {
+        return;
+    }
+    // Materials cache the SRV pointers, so swap the texture's view and repoint only the
+    // materials that sample it.
+    mpLibraryTexture->SetTextureAndShaderResourceView( mpGPUTextures[slot], mpSRVs[slot] );
+    CPUTAssetLibrary::RebindTexture( mpLibraryTexture );
+    mBoundSlot = slot;
+}
@@ -0,0 +1,96 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef __DRATEXTURERING_H__
+#define __DRATEXTURERING_H__
+
+#include "CPUTTextureDX11.h"
+#include "IGFXExtensionsHelper.h"
+#include "DRASlotRing.h"
+
+// DRAQueryFence
+// DRAFenceSource backed by D3D11 event queries. One query is kept per outstanding fence value.
+class DRAQueryFence : public DRAFenceSource
+{
+public:
+    static const UINT MAX_QUERIES = DRASlotRing::MAX_SLOTS + 1;
+
+    DRAQueryFence();
+    ~DRAQueryFence();
+
+    HRESULT  Create(ID3D11Device *pDevice, ID3D11DeviceContext *pContext);
+    void     Release();
+
+    uint64_t Signal();
+    uint64_t GetCompletedValue();
+    void     WaitForValue(uint64_t value);
+
+private:
+    ID3D11DeviceContext *mpContext;
+    ID3D11Query         *mpQueries[MAX_QUERIES];
+    uint64_t             mSignaled;
+    uint64_t             mCompleted;
+};
+
+// DRATextureRing
+// Owns N pairs of DRA textures (the GPU texture that is sampled and the CPU texture that is
+// mapped to reach its memory), created with IGFX::CreateSharedTexture2D. Mapping for write
+// always returns a slot the GPU has finished sampling, so Map() does not stall on the frame
+// that is still in flight. Unmap() publishes the slot by pointing the named texture in the
+// asset library (e.g. $DRATextureGPU) at that slot's SRV and rebinding just the materials
+// that sample it.
+//
+// Usage per frame:
+//    MAP_DATA *pData = ring.MapForWrite(); ... write ... ring.Unmap();
+//    ... draw everything that samples the texture ...
+//    ring.Submit();
+class DRATextureRing
+{
+public:
+    DRATextureRing();
+    ~DRATextureRing();
+
+    HRESULT Create(ID3D11Device *pDevice, ID3D11DeviceContext *pContext,
+                   const D3D11_TEXTURE2D_DESC *pCPUDesc, const D3D11_TEXTURE2D_DESC *pGPUDesc,
+                   UINT numSlots, const cString &textureName);
+    void    Release();
+
+    INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA *MapForWrite();
+    // Maps the published slot, the one with the latest contents. Map() waits for draws still
+    // sampling that slot, but not for the rest of the GPU.
+    INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA *MapForRead();
+    void    Unmap();
+    void    Submit();
+
+    UINT             GetNumSlots() const { return mSlots.GetNumSlots(); }
+    ID3D11Texture2D *GetCPUTexture(UINT slot) { return mpCPUTextures[slot]; }
+    ID3D11Texture2D *GetGPUTexture(UINT slot) { return mpGPUTextures[slot]; }
+
+private:
+    void BindSlot(UINT slot);
+
+    ID3D11DeviceContext      *mpContext;
+    DRAQueryFence             mFence;
+    DRASlotRing               mSlots;
+    ID3D11Texture2D          *mpCPUTextures[DRASlotRing::MAX_SLOTS];
+    ID3D11Texture2D          *mpGPUTextures[DRASlotRing::MAX_SLOTS];
+    ID3D11ShaderResourceView *mpSRVs[DRASlotRing::MAX_SLOTS];
+    CPUTTextureDX11          *mpLibraryTexture;
+    UINT                      mBoundSlot;
+    UINT                      mMappedSlot;
+    bool                      mMappedForWrite;
+};
+
+#endif // __DRATEXTURERING_H__
@@ -0,0 +1,269 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Header only traversal of the TileY layout used by DRA resources.
+//
+// The kernels in InstantAccess_Tiling.cpp each spell out the address math (rygs incremental method,
+// the tile row wrap, the CSX swizzle). The templates below do the same walks once and call a visitor
+// with the address of each piece of tiled memory and the mip relative position it holds. Visitors
+// are template parameters, so the compiler inlines them into the loop and the result is the same
+// code as a hand written kernel.
+//
+//   Linear order walks the mip row by row (what a linear source wants).
+//   Tile order walks the allocation in memory order (what write combined memory wants).
+//
+// Each walk is available per 64B line (16 bytes x 4 rows, one CPU cacheline) or per 4 byte element.
+// x is in bytes and y in blocks, both relative to the mip. span is the number of valid bytes per row
+// at the visited address.
+//
+// Example, filling a mip with a color:
+//    struct Fill { __m128i c; void operator()(BYTE *p, UINT, UINT, UINT) {
+//        for (UINT r = 0; r < 4; r++) _mm_stream_si128((__m128i*)p + r, c); } };
+//    Fill fill = { _mm_set1_epi32(color) };
+//    DRATile::ForEachLineLinear(pMapData, &texInfo, mip, fill);
+
+#include <assert.h>
+#include "InstantAccess_Tiling.h"
+
+namespace DRATile
+{
+    const UINT TileH = 32;               // height of a tile in blocks
+    const UINT ColumnBytes = 16 * TileH; // a tile is made of 16 byte wide columns
+
+    inline UINT SwizzleX(UINT x /* in bytes */)  { return (x & 0xF) | ((x & 0xFFFFFFF0) << 5); }
+    inline UINT SwizzleY(UINT y /* in blocks */) { return (y & 0x1F) << 4; }
+
+    // Tile formats.
+    // Swizzle() maps a tiled address to the address in memory.
+    // RowSwap is the y bits flipped by the swizzle in odd columns (the inverse, used by the tile order walks).
+    struct TileY
+    {
+        static UINT Swizzle(UINT tiledAddr) { return tiledAddr ^ ((tiledAddr & (1 << 9)) >> 3); }
+        static const UINT RowSwap = 4;
+    };
+    struct TileYNoCSX
+    {
+        static UINT Swizzle(UINT tiledAddr) { return tiledAddr; }
+        static const UINT RowSwap = 0;
+    };
+
+    // Where a mip lives in the DRA allocation
+    struct Layout
+    {
+        BYTE *pBase;
+        UINT  xoffset;      // in bytes
+        UINT  yoffset;      // in blocks
+        UINT  widthInBytes;
+        UINT  height;       // in blocks
+        UINT  incr_y;       // byte size of a full row of tiles
+        UINT  tileFormat;
+
+        Layout(INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA *pMapData, const TextureInfo *pTexInfo, UINT mip)
+        {
+            // this is incorrect for non-power-of-two sizes (see WriteDRA_Copy)
+            assert(((pTexInfo->widthInBlocks & (pTexInfo->widthInBlocks - 1)) == 0) &&
+                   ((pTexInfo->heightInBlocks & (pTexInfo->heightInBlocks - 1)) == 0));
+            const UINT mipWidth = (pTexInfo->widthInBlocks >> mip) > 0 ? (pTexInfo->widthInBlocks >> mip) : 1;
+            pBase        = (BYTE*)pMapData->pBaseAddress;
+            xoffset      = pMapData->XOffset;
+            yoffset      = pMapData->YOffset;
+            widthInBytes = mipWidth * pTexInfo->bytesPerBlock;
+            height       = (pTexInfo->heightInBlocks >> mip) > 0 ? (pTexInfo->heightInBlocks >> mip) : 1;
+            incr_y       = SwizzleX(pMapData->Pitch);
+            tileFormat   = pMapData->TileFormat;
+        }
+
+        // True when the mip can be visited in whole 64B lines
+        bool IsLineAligned() const
+        {
+            return xoffset % 16 == 0 && yoffset % 4 == 0 && widthInBytes % 16 == 0 && height % 4 == 0;
+        }
+    };
+
+    //-----------------------------------------------------------------------------
+    // Linear order, 64B lines: visitor(BYTE *pLine, UINT x, UINT y, UINT span)
+    // pLine holds rows y..y+3, bytes x..x+15 of each (16 bytes per row, span is always 16).
+    // Requires layout.IsLineAligned().
+    template<class Format, class Visitor>
+    inline void ForEachLineLinear(const Layout &layout, Visitor &visitor)
+    {
+        assert(layout.IsLineAligned());
+        // rygs method: x_mask/y_mask are the increments for 16 bytes / 4 rows in tiled address space.
+        // offs_x0 also carries the tile row, and moves to the next one whenever offs_y wraps.
+        const UINT x_mask = SwizzleX((UINT)-16);
+        const UINT y_mask = SwizzleY((UINT)-4);
+        UINT offs_x0 = SwizzleX(layout.xoffset) + layout.incr_y * (layout.yoffset / TileH);
+        UINT offs_y  = SwizzleY(layout.yoffset);
+        for (UINT y = 0; y < layout.height; y += 4)
+        {
+            UINT offs_x = offs_x0;
+            for (UINT x = 0; x < layout.widthInBytes; x += 16)
+            {
+                visitor(layout.pBase + Format::Swizzle(offs_y + offs_x), x, y, 16u);
+                offs_x = (offs_x - x_mask) & x_mask;
+            }
+            offs_y = (offs_y - y_mask) & y_mask;
+            if (!offs_y) offs_x0 += layout.incr_y;
+        }
+    }
+
+    //-----------------------------------------------------------------------------
+    // Linear order, 4 byte elements: visitor(UINT *pElement, UINT x, UINT y)
+    // Works for any mip, including the small ones of the mip tail.
+    template<class Format, class Visitor>
+    inline void ForEachElementLinear(const Layout &layout, Visitor &visitor)
+    {
+        const UINT x_mask = SwizzleX((UINT)-4);
+        const UINT y_mask = SwizzleY(~0u);
+        UINT offs_x0 = SwizzleX(layout.xoffset) + layout.incr_y * (layout.yoffset / TileH);
+        UINT offs_y  = SwizzleY(layout.yoffset);
+        for (UINT y = 0; y < layout.height; y++)
+        {
+            UINT offs_x = offs_x0;
+            for (UINT x = 0; x < layout.widthInBytes; x += 4)
+            {
+                visitor((UINT*)(layout.pBase + Format::Swizzle(offs_y + offs_x)), x, y);
+                offs_x = (offs_x - x_mask) & x_mask;
+            }
+            offs_y = (offs_y - y_mask) & y_mask;
+            if (!offs_y) offs_x0 += layout.incr_y;
+        }
+    }
+
+    //-----------------------------------------------------------------------------
+    // Tile order, 16 byte rows: visitor(BYTE *pRow, UINT x, UINT y, UINT span)
+    // Visits memory front to back. The columns covering the mip's x range are contiguous within a tile
+    // row, and each 64B line of a column holds 4 consecutive rows. pRow points at the first valid byte;
+    // span < 16 only at the left/right edge of mips that are not 16 byte aligned. Padding is skipped.
+    template<class Format, class Visitor>
+    inline void ForEachRowTiled(const Layout &layout, Visitor &visitor)
+    {
+        const UINT xend = layout.xoffset + layout.widthInBytes;
+        const UINT yend = layout.yoffset + layout.height;
+        for (UINT tileRow = layout.yoffset / TileH; tileRow <= (yend - 1) / TileH; tileRow++)
+        {
+            const UINT tileY  = tileRow * TileH;
+            const UINT yfirst = tileY > layout.yoffset ? tileY : layout.yoffset;
+            const UINT ylast  = tileY + TileH < yend ? tileY + TileH : yend;
+            for (UINT col = layout.xoffset >> 4; col <= (xend - 1) >> 4; col++)
+            {
+                BYTE *pColumn    = layout.pBase + tileRow * layout.incr_y + col * ColumnBytes;
+                const UINT colX  = col << 4;
+                const UINT first = colX < layout.xoffset ? layout.xoffset - colX : 0;
+                const UINT span  = (xend - colX < 16 ? xend - colX : 16) - first;
+                const UINT x     = colX + first - layout.xoffset;
+                const UINT swap  = (col & 1) ? Format::RowSwap : 0;
+                for (UINT line = 0; line < TileH; line += 4)
+                {
+                    const UINT y0 = tileY + (line ^ swap);
+                    if (y0 + 4 <= yfirst || y0 >= ylast)
+                    {
+                        continue;
+                    }
+                    BYTE *pLine = pColumn + line * 16;
+                    for (UINT row = 0; row < 4; row++)
+                    {
+                        const UINT y = y0 + row;
+                        if (y >= yfirst && y < ylast)
+                        {
+                            visitor(pLine + row * 16 + first, x, y - layout.yoffset, span);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    //-----------------------------------------------------------------------------
+    // Tile order, 64B lines: visitor(BYTE *pLine, UINT x, UINT y, UINT span)
+    // Same lines as ForEachLineLinear, in memory order. Requires layout.IsLineAligned().
+    template<class Format, class Visitor>
+    inline void ForEachLineTiled(const Layout &layout, Visitor &visitor)
+    {
+        assert(layout.IsLineAligned());
+        const UINT xend = layout.xoffset + layout.widthInBytes;
+        const UINT yend = layout.yoffset + layout.height;
+        for (UINT tileRow = layout.yoffset / TileH; tileRow <= (yend - 1) / TileH; tileRow++)
+        {
+            const UINT tileY = tileRow * TileH;
+            for (UINT col = layout.xoffset >> 4; col < xend >> 4; col++)
+            {
+                BYTE *pColumn   = layout.pBase + tileRow * layout.incr_y + col * ColumnBytes;
+                const UINT swap = (col & 1) ? Format::RowSwap : 0;
+                for (UINT line = 0; line < TileH; line += 4)
+                {
+                    const UINT y = tileY + (line ^ swap);
+                    if (y >= layout.yoffset && y < yend)
+                    {
+                        visitor(pColumn + line * 16, (col << 4) - layout.xoffset, y - layout.yoffset, 16u);
+                    }
+                }
+            }
+        }
+    }
+
+    //-----------------------------------------------------------------------------
+    // Tile order, 4 byte elements: visitor(UINT *pElement, UINT x, UINT y)
+    template<class Visitor>
+    struct RowToElements
+    {
+        Visitor &visitor;
+        RowToElements(Visitor &v) : visitor(v) {}
+        void operator()(BYTE *pRow, UINT x, UINT y, UINT span)
+        {
+            for (UINT i = 0; i < span; i += 4)
+            {
+                visitor((UINT*)(pRow + i), x + i, y);
+            }
+        }
+    private:
+        RowToElements &operator=(const RowToElements &);
+    };
+    template<class Format, class Visitor>
+    inline void ForEachElementTiled(const Layout &layout, Visitor &visitor)
+    {
+        RowToElements<Visitor> rows(visitor);
+        ForEachRowTiled<Format>(layout, rows);
+    }
+
+    //-----------------------------------------------------------------------------
+    // Entry points taking the mapped DRA data directly. They pick the tile format at run time
+    // (once, outside the loop) and return false if the format is not one of the TileY variants.
+#define DRATILE_DISPATCH(walk)                                                                                      \
+    template<class Visitor>                                                                                         \
+    inline bool walk(INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA *pMapData, const TextureInfo *pTexInfo,      \
+                     UINT mip, Visitor &visitor)                                                                    \
+    {                                                                                                               \
+        Layout layout(pMapData, pTexInfo, mip);                                                                     \
+        switch (layout.tileFormat)                                                                                  \
+        {                                                                                                           \
+        case INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_TILE_TYPE_TILE_Y:                                          \
+            walk<TileY>(layout, visitor);                                                                           \
+            return true;                                                                                            \
+        case INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_TILE_TYPE_TILE_Y_NO_CSX_SWIZZLE:                           \
+            walk<TileYNoCSX>(layout, visitor);                                                                      \
+            return true;                                                                                            \
+        }                                                                                                           \
+        return false;                                                                                               \
+    }
+    DRATILE_DISPATCH(ForEachLineLinear)
+    DRATILE_DISPATCH(ForEachElementLinear)
+    DRATILE_DISPATCH(ForEachRowTiled)
+    DRATILE_DISPATCH(ForEachLineTiled)
+    DRATILE_DISPATCH(ForEachElementTiled)
+#undef DRATILE_DISPATCH
+}
@@ -23,6 +23,8 @@
 
 #include <stdio.h>
 #include "emmintrin.h"
+#include "nmmintrin.h" // SSE4.1 streaming loads and SSE4.2 crc32 for the reductions
+#include "InstantAccess_TileTraversal.h"
 
 // Each function uses the following helper functions to convert to and from tiled addresses.
 
@@ -706,3 +708,273 @@ void ReadDRA(UINT mode, INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA * pGPUS
 	}
 }
 
+// The reductions below visit the tiled allocation in memory order (DRATile::ForEachRowTiled).
+// Each visitor gets a 16 byte row chunk, or the valid part of one at the edges of unaligned mips.
+
+// DRA memory is write combined. Regular loads are uncached there; MOVNTDQA streams a full line at a time.
+static inline __m128i LoadDRA(const BYTE *p)
+{
+	return _mm_stream_load_si128((__m128i*)p);
+}
+
+static inline UINT CRC32C_Chunk(UINT crc, __m128i chunk)
+{
+#ifdef _M_X64
+	crc = (UINT)_mm_crc32_u64(crc, (UINT64)_mm_cvtsi128_si64(chunk));
+	crc = (UINT)_mm_crc32_u64(crc, (UINT64)_mm_cvtsi128_si64(_mm_srli_si128(chunk, 8)));
+#else
+	crc = _mm_crc32_u32(crc, (UINT)_mm_cvtsi128_si32(chunk));
+	crc = _mm_crc32_u32(crc, (UINT)_mm_cvtsi128_si32(_mm_srli_si128(chunk, 4)));
+	crc = _mm_crc32_u32(crc, (UINT)_mm_cvtsi128_si32(_mm_srli_si128(chunk, 8)));
+	crc = _mm_crc32_u32(crc, (UINT)_mm_cvtsi128_si32(_mm_srli_si128(chunk, 12)));
+#endif
+	return crc;
+}
+
+// Streaming loads need 16 byte alignment; partial rows load their whole chunk and use part of it.
+static inline const BYTE *AlignChunk(const BYTE *p) { return (const BYTE*)((UINT_PTR)p & ~(UINT_PTR)15); }
+
+struct CRC32CTiledVisitor
+{
+	UINT crc;
+	void operator()(BYTE *pRow, UINT, UINT, UINT span)
+	{
+		if (span == 16)
+		{
+			crc = CRC32C_Chunk(crc, LoadDRA(pRow));
+			return;
+		}
+		const BYTE *pChunk = AlignChunk(pRow);
+		const UINT first = (UINT)(pRow - pChunk);
+		__declspec(align(16)) BYTE bytes[16];
+		_mm_store_si128((__m128i*)bytes, LoadDRA(pChunk));
+		for (UINT i = first; i < first + span; i++)
+		{
+			crc = _mm_crc32_u8(crc, bytes[i]);
+		}
+	}
+};
+
+struct CRC32CLinearVisitor
+{
+	UINT crc;
+	const BYTE *pSrc;
+	UINT rowPitch;
+	void operator()(BYTE *, UINT x, UINT y, UINT span)
+	{
+		const BYTE *pRow = pSrc + y * rowPitch + x;
+		if (span == 16)
+		{
+			crc = CRC32C_Chunk(crc, _mm_loadu_si128((const __m128i*)pRow));
+			return;
+		}
+		for (UINT i = 0; i < span; i++)
+		{
+			crc = _mm_crc32_u8(crc, pRow[i]);
+		}
+	}
+};
+
+UINT ReduceDRA_CRC32C(INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA * pGPUSubresourceData, TextureInfo *pTexInfo, UINT mip)
+{
+	CRC32CTiledVisitor visitor = { ~0u };
+	DRATile::ForEachRowTiled(pGPUSubresourceData, pTexInfo, mip, visitor);
+	return ~visitor.crc;
+}
+
+UINT ReduceLinear_CRC32C(INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA * pGPUSubresourceData, TextureInfo *pTexInfo,
+                         UINT mip, D3D11_MAPPED_SUBRESOURCE &texData)
+{
+	CRC32CLinearVisitor visitor = { ~0u, (const BYTE*)texData.pData, texData.RowPitch };
+	DRATile::ForEachRowTiled(pGPUSubresourceData, pTexInfo, mip, visitor);
+	return ~visitor.crc;
+}
+
+struct HistogramVisitor
+{
+	DRAHistogram *pHistogram;
+	void operator()(BYTE *pRow, UINT x, UINT, UINT span)
+	{
+		const BYTE *pChunk = AlignChunk(pRow);
+		const UINT first = (UINT)(pRow - pChunk);
+		__declspec(align(16)) BYTE bytes[16];
+		_mm_store_si128((__m128i*)bytes, LoadDRA(pChunk));
+		if (span == 16)
+		{
+			for (UINT i = 0; i < 16; i += 4)
+			{
+				pHistogram->bins[0][bytes[i]]++;
+				pHistogram->bins[1][bytes[i + 1]]++;
+				pHistogram->bins[2][bytes[i + 2]]++;
+				pHistogram->bins[3][bytes[i + 3]]++;
+			}
+			return;
+		}
+		for (UINT i = 0; i < span; i++)
+		{
+			pHistogram->bins[(x + i) & 3][bytes[first + i]]++;
+		}
+	}
+};
+
+void ReduceDRA_Histogram(INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA * pGPUSubresourceData, TextureInfo *pTexInfo,
+                         UINT mip, DRAHistogram *pHistogram)
+{
+	assert(pTexInfo->bytesPerBlock == 4);
+	memset(pHistogram, 0, sizeof(DRAHistogram));
+	HistogramVisitor visitor = { pHistogram };
+	DRATile::ForEachRowTiled(pGPUSubresourceData, pTexInfo, mip, visitor);
+}
+
+struct StatsVisitor
+{
+	__m128i minValue, maxValue;
+	__m128i sum[4];       // two 64 bit partial sums per channel (from _mm_sad_epu8)
+	__m128i channelMask[4];
+	UINT    partialMin[4], partialMax[4];
+	UINT64  partialSum[4];
+
+	void Init()
+	{
+		minValue = _mm_set1_epi8((char)0xFF);
+		maxValue = _mm_setzero_si128();
+		for (UINT c = 0; c < 4; c++)
+		{
+			sum[c] = _mm_setzero_si128();
+			channelMask[c] = _mm_set1_epi32(0xFF << (c * 8));
+			partialMin[c] = 0xFF;
+			partialMax[c] = 0;
+			partialSum[c] = 0;
+		}
+	}
+	void operator()(BYTE *pRow, UINT x, UINT, UINT span)
+	{
+		if (span == 16)
+		{
+			__m128i texels = LoadDRA(pRow);
+			minValue = _mm_min_epu8(minValue, texels);
+			maxValue = _mm_max_epu8(maxValue, texels);
+			// sad against zero sums the bytes of each 8 byte half. Masking keeps one channel at a time.
+			for (UINT c = 0; c < 4; c++)
+			{
+				sum[c] = _mm_add_epi64(sum[c], _mm_sad_epu8(_mm_and_si128(texels, channelMask[c]), _mm_setzero_si128()));
+			}
+			return;
+		}
+		const BYTE *pChunk = AlignChunk(pRow);
+		const UINT first = (UINT)(pRow - pChunk);
+		__declspec(align(16)) BYTE bytes[16];
+		_mm_store_si128((__m128i*)bytes, LoadDRA(pChunk));
+		for (UINT i = 0; i < span; i++)
+		{
+			UINT c = (x + i) & 3;
+			UINT value = bytes[first + i];
+			partialMin[c] = min(partialMin[c], value);
+			partialMax[c] = max(partialMax[c], value);
+			partialSum[c] += value;
+		}
+	}
+};
+
+void ReduceDRA_Stats(INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA * pGPUSubresourceData, TextureInfo *pTexInfo,
+                     UINT mip, DRAStats *pStats)
+{
+	assert(pTexInfo->bytesPerBlock == 4);
+	StatsVisitor visitor;
+	visitor.Init();
+	DRATile::ForEachRowTiled(pGPUSubresourceData, pTexInfo, mip, visitor);
+
+	// fold the 4 texels of the SIMD accumulators together
+	__declspec(align(16)) BYTE minBytes[16];
+	__declspec(align(16)) BYTE maxBytes[16];
+	__declspec(align(16)) UINT64 sums[2];
+	_mm_store_si128((__m128i*)minBytes, visitor.minValue);
+	_mm_store_si128((__m128i*)maxBytes, visitor.maxValue);
+	for (UINT c = 0; c < 4; c++)
+	{
+		_mm_store_si128((__m128i*)sums, visitor.sum[c]);
+		pStats->sum[c]      = sums[0] + sums[1] + visitor.partialSum[c];
+		pStats->minValue[c] = visitor.partialMin[c];
+		pStats->maxValue[c] = visitor.partialMax[c];
+		for (UINT i = c; i < 16; i += 4)
+		{
+			pStats->minValue[c] = min(pStats->minValue[c], (UINT)minBytes[i]);
+			pStats->maxValue[c] = max(pStats->maxValue[c], (UINT)maxBytes[i]);
+		}
+	}
+
+	const UINT mipHeightInBlock = max(pTexInfo->heightInBlocks >> mip, 1u);
+	const UINT mipWidthInBlock  = max(pTexInfo->widthInBlocks >> mip, 1u);
+	pStats->texelCount = (UINT64)mipWidthInBlock * mipHeightInBlock;
+	for (UINT c = 0; c < 4; c++)
+	{
+		pStats->mean[c] = (float)((double)pStats->sum[c] / (double)pStats->texelCount);
+	}
+
+	// luminance is linear in the channels, so its sum falls out of the channel sums
+	bool bgra = pTexInfo->dxgiFormat == DXGI_FORMAT_B8G8R8A8_UNORM || pTexInfo->dxgiFormat == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB ||
+	            pTexInfo->dxgiFormat == DXGI_FORMAT_B8G8R8X8_UNORM || pTexInfo->dxgiFormat == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB;
+	UINT r = bgra ? 2 : 0;
+	UINT b = bgra ? 0 : 2;
+	pStats->luminanceSum  = 0.2126 * (double)pStats->sum[r] + 0.7152 * (double)pStats->sum[1] + 0.0722 * (double)pStats->sum[b];
+	pStats->luminanceMean = (float)(pStats->luminanceSum / (double)pStats->texelCount);
+}
+
+// The snapshot covers the tile rows holding the mip and, within them, the columns from an even one
+// (so the CSX swizzle, which depends on the column's parity, is unchanged) to the last one the mip
+// touches. Those bytes are contiguous in every tile row.
+static void GetSnapshotRange(INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA * pGPUSubresourceData, TextureInfo *pTexInfo,
+                             UINT mip, UINT *pFirstTileRow, UINT *pTileRows, UINT *pFirstColumn, UINT *pColumns)
+{
+	DRATile::Layout layout(pGPUSubresourceData, pTexInfo, mip);
+	const UINT firstColumn = (layout.xoffset >> 4) & ~1u;
+	const UINT lastColumn  = (layout.xoffset + layout.widthInBytes - 1) >> 4;
+	*pFirstTileRow = layout.yoffset / DRATile::TileH;
+	*pTileRows     = (layout.yoffset + layout.height - 1) / DRATile::TileH - *pFirstTileRow + 1;
+	*pFirstColumn  = firstColumn;
+	*pColumns      = lastColumn - firstColumn + 1;
+}
+
+UINT GetDRASnapshotSize(INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA * pGPUSubresourceData, TextureInfo *pTexInfo, UINT mip)
+{
+	UINT firstTileRow, tileRows, firstColumn, columns;
+	GetSnapshotRange(pGPUSubresourceData, pTexInfo, mip, &firstTileRow, &tileRows, &firstColumn, &columns);
+	return tileRows * columns * DRATile::ColumnBytes;
+}
+
+void SnapshotDRA(INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA * pGPUSubresourceData, TextureInfo *pTexInfo,
+                 UINT mip, BYTE *pDest, INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA *pSnapshot)
+{
+	assert(((UINT_PTR)pDest & 15) == 0);
+	UINT firstTileRow, tileRows, firstColumn, columns;
+	GetSnapshotRange(pGPUSubresourceData, pTexInfo, mip, &firstTileRow, &tileRows, &firstColumn, &columns);
+
+	const UINT incr_y   = swizzle_x(pGPUSubresourceData->Pitch);
+	const UINT rowBytes = columns * DRATile::ColumnBytes;
+	__m128i *pOut = (__m128i*)pDest;
+	for (UINT tileRow = firstTileRow; tileRow < firstTileRow + tileRows; tileRow++)
+	{
+		const BYTE *pIn  = (const BYTE*)pGPUSubresourceData->pBaseAddress + tileRow * incr_y + firstColumn * DRATile::ColumnBytes;
+		const BYTE *pEnd = pIn + rowBytes;
+		// a cacheline of streaming loads at a time, so each line is fetched from the write combined memory once
+		for (; pIn < pEnd; pIn += 64, pOut += 4)
+		{
+			__m128i a = LoadDRA(pIn);
+			__m128i b = LoadDRA(pIn + 16);
+			__m128i c = LoadDRA(pIn + 32);
+			__m128i d = LoadDRA(pIn + 48);
+			_mm_store_si128(pOut, a);
+			_mm_store_si128(pOut + 1, b);
+			_mm_store_si128(pOut + 2, c);
+			_mm_store_si128(pOut + 3, d);
+		}
+	}
+
+	// The same mip in a smaller allocation: a tile row is now rowBytes long
+	*pSnapshot = *pGPUSubresourceData;
+	pSnapshot->pBaseAddress = pDest;
+	pSnapshot->XOffset     -= firstColumn * 16;
+	pSnapshot->YOffset     -= firstTileRow * DRATile::TileH;
+	pSnapshot->Pitch        = columns * 16;
+	pSnapshot->Size         = tileRows * rowBytes;
+}
@@ -13,6 +13,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 /////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
 #include "DXGIFormat.h"
 #include "IGFXExtensionsHelper.h"
 
@@ -69,3 +71,50 @@ void WriteDRA_Copy(UINT mode, INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA *
 // Reads the memory of a DRA resource.
 void ReadDRA(UINT mode, INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA * pGPUSubResourceData, TextureInfo *pTexInfo,
                    UINT mip, D3D11_MAPPED_SUBRESOURCE &texData);
+
+// Read-only reductions over a DRA resource.
+// Checksums, histograms and min/max/mean do not care about texel order, so there is no reason to detile
+// into a linear buffer first. These functions stream the tiled allocation once, in memory order
+// (MODE_TILED order), skip the padding outside the mip's rectangle, and use streaming loads which are
+// the fast way to read write combined memory. All of them handle both TileY formats and any mip offset.
+
+// Per channel statistics of a 4 byte per texel (RGBA8/BGRA8) mip, in stored units (0-255).
+// The luminance values use Rec. 709 weights on the stored (not linearized) channel values.
+struct DRAStats { UINT minValue[4], maxValue[4]; UINT64 sum[4]; UINT64 texelCount; float mean[4]; float luminanceMean; double luminanceSum; };
+
+// Per channel 256 bin histograms of a 4 byte per texel mip
+struct DRAHistogram { UINT bins[4][256]; };
+
+// ReduceDRA_CRC32C
+// CRC32C of the mip's texel bytes, taken in tile order. Compare it against ReduceLinear_CRC32C of the source.
+UINT ReduceDRA_CRC32C(INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA * pGPUSubResourceData, TextureInfo *pTexInfo, UINT mip);
+
+// ReduceLinear_CRC32C
+// CRC32C of a linearly mapped texture, visiting it in the tile order that pGPUSubResourceData describes.
+// Equal to ReduceDRA_CRC32C of the DRA resource after a correct WriteDRA_Copy of texData.
+UINT ReduceLinear_CRC32C(INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA * pGPUSubResourceData, TextureInfo *pTexInfo,
+                         UINT mip, D3D11_MAPPED_SUBRESOURCE &texData);
+
+// ReduceDRA_Histogram
+void ReduceDRA_Histogram(INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA * pGPUSubResourceData, TextureInfo *pTexInfo,
+                         UINT mip, DRAHistogram *pHistogram);
+
+// ReduceDRA_Stats
+// Min, max, sum and mean per channel, plus luminance sum and mean (for auto exposure).
+void ReduceDRA_Stats(INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA * pGPUSubResourceData, TextureInfo *pTexInfo,
+                     UINT mip, DRAStats *pStats);
+
+// Snapshots
+// Reading write combined memory is slow, and a mapped DRA resource can't be held while the CPU works on it.
+// SnapshotDRA copies the tiles holding one mip to cacheable memory with streaming loads (still tiled, so the
+// copy is a few long sequential runs) and describes the copy in pSnapshot. Every function taking MAP_DATA
+// works on the snapshot, on any thread, once the resource is unmapped.
+
+// GetDRASnapshotSize
+// Size of the buffer SnapshotDRA needs for mip. A multiple of 64 bytes.
+UINT GetDRASnapshotSize(INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA * pGPUSubResourceData, TextureInfo *pTexInfo, UINT mip);
+
+// SnapshotDRA
+// pDest must be 16 byte aligned and GetDRASnapshotSize bytes long.
+void SnapshotDRA(INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA * pGPUSubResourceData, TextureInfo *pTexInfo,
+                 UINT mip, BYTE *pDest, INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA *pSnapshot);
@@ -33,6 +33,13 @@ cbuffer cbPerModelValues
               float4   LightDirection;
               float4   EyePosition;
     row_major float4x4 LightWorldViewProjection;
+    row_major float4x4 ViewProjection;
+              float4   BoundingBoxCenterWorldSpace;
+              float4   BoundingBoxHalfWorldSpace;
+              float4   BoundingBoxCenterObjectSpace;
+              float4   BoundingBoxHalfObjectSpace;
+              float4   QuantizedPositionScale; // Positions of quantized models are 16-bit across their bounding box
+              float4   QuantizedPositionBias;
 };
 
 // ********************************************************************************************************
@@ -47,7 +54,8 @@ cbuffer cbPerFrameValues
 PS_INPUT VSMain( VS_INPUT input )
 {
     PS_INPUT output = (PS_INPUT)0;
-    output.Pos = mul( float4( input.Pos, 1.0f), WorldViewProjection );
+    float3 position = input.Pos * QuantizedPositionScale.xyz + QuantizedPositionBias.xyz;
+    output.Pos = mul( float4( position, 1.0f), WorldViewProjection );
     output.Pos.z -= 0.0001 * output.Pos.w;
     return output;
 }
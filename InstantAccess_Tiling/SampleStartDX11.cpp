@@ -16,12 +16,24 @@
 #include "SampleStartDX11.h"
 #include "CPUTRenderTarget.h"
 #include "IGFXExtensionsHelper.h"
+#include "DDSImageCache.h"
 
 const UINT SHADOW_WIDTH_HEIGHT = 2048;
 
+// Compression used when cooking the chunked copy of the test texture
+#if defined(CPUT_ARCHIVE_LZ4)
+const uint16_t CHUNKED_TEXTURE_COMPRESSION = CPUT_ARCHIVE_COMPRESSION_LZ4;
+#elif defined(CPUT_ARCHIVE_ZSTD)
+const uint16_t CHUNKED_TEXTURE_COMPRESSION = CPUT_ARCHIVE_COMPRESSION_ZSTD;
+#else
+const uint16_t CHUNKED_TEXTURE_COMPRESSION = CPUT_ARCHIVE_COMPRESSION_NONE;
+#endif
+
 #define ID_TEST_SOLID 2001
 #define ID_TEST_COPY 2002
 #define ID_TEST_READ 2003
+#define ID_TEST_MAPPED_SOURCE 2004
+#define ID_TEST_CHUNKED_SOURCE 2005
 #define ID_TEST_SOLID_DROPDOWN 3001
 #define ID_TEST_COPY_DROPDOWN 3002
 
@@ -170,6 +182,15 @@ void MySample::Create()
     cString ExecutableDirectory;
     CPUTOSServices::GetOSServices()->GetExecutableDirectory(&ExecutableDirectory);
 
+    // Serve the media out of Media.cpak when it has been packed (see CPUT\Tools\CPUTPack.cpp)
+    cString MediaArchive = ExecutableDirectory + _L("..\\..\\..\\Media.cpak");
+    if(CPUTSUCCESS(CPUTOSServices::GetOSServices()->DoesFileExist(MediaArchive)))
+    {
+        CPUTOSServices::GetOSServices()->MountArchive(MediaArchive, ExecutableDirectory + _L("..\\..\\..\\Media\\"));
+    }
+
+    // Loose textures keep their parsed headers in .ddscache files next to them (see DDSImageCache.h)
+    pAssetLibrary->SetCacheTextureMetadata(true);
     pAssetLibrary->SetMediaDirectoryName(    _L("..\\..\\..\\Media\\"));
 
     //Initialize the extensions here
@@ -220,7 +241,6 @@ void MySample::Create()
 		//swSRVdesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
 		//pDevice->CreateShaderResourceView(pSWTexture, &swSRVdesc, &pSWTextureSRV);
 
-		ID3D11Texture2D *pDRATextureGPU = NULL;
         cpudesc.ArraySize = gpudesc.ArraySize = 1;
         cpudesc.BindFlags = 0;
         gpudesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
@@ -249,25 +269,41 @@ void MySample::Create()
         }
         testTextureInfo.allocateBytes = bytes;
         testTextureInfo.dxgiFormat = testdesc.Format;
-        IGFX::CreateSharedTexture2D(pDevice, &cpudesc, &mpDRATextureCPU, &gpudesc, &pDRATextureGPU, NULL);
-        CPUT_DX11::GetContext()->CopyResource(mpDRATextureCPU, pDRATextureGPU);
-
-        ID3D11ShaderResourceView *pDRATextureSRV;
-        D3D11_SHADER_RESOURCE_VIEW_DESC srvdesc;
-        srvdesc.Texture2D.MipLevels = gpudesc.MipLevels;
-        srvdesc.Format = gpudesc.Format;
-        srvdesc.Texture2D.MostDetailedMip = 0;
-        srvdesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-        pDevice->CreateShaderResourceView(pDRATextureGPU, &srvdesc, &pDRATextureSRV);
-
-        CPUTTextureDX11 *pDRATextureGPUCPUT = new CPUTTextureDX11(std::wstring(_L("$DRATextureGPU")), pDRATextureGPU, pDRATextureSRV);
-        CPUTTextureDX11 *pDRATextureCPUT = new CPUTTextureDX11(std::wstring(_L("$DRATextureCPU")), mpDRATextureCPU, NULL);
-        pAssetLibrary->AddTexture(pDRATextureGPUCPUT->Name(), pDRATextureGPUCPUT);
-        pAssetLibrary->AddTexture(pDRATextureCPUT->Name(), pDRATextureCPUT);
-        SAFE_RELEASE(pDRATextureGPU);
-        SAFE_RELEASE(pDRATextureSRV);
-        SAFE_RELEASE(pDRATextureGPUCPUT);
-        SAFE_RELEASE(pDRATextureCPUT);
+
+        // The same texels, straight out of a mapping of the .dds file. Copying from it skips reading the
+        // file into memory and the staging texture map, when the file layout suits the copy kernels.
+        bool hasMappedSource = mMappedSource.Open((pAssetLibrary->GetTextureDirectoryName() + _L("TestTexture.dds")).c_str()) &&
+            mMappedSource.IsKernelCompatible(0) &&
+            mMappedSource.GetTextureInfo().widthInBlocks == testTextureInfo.widthInBlocks &&
+            mMappedSource.GetTextureInfo().heightInBlocks == testTextureInfo.heightInBlocks &&
+            mMappedSource.GetTextureInfo().bytesPerBlock == testTextureInfo.bytesPerBlock;
+        if(!hasMappedSource)
+        {
+            mMappedSource.Close();
+        }
+
+        // A chunked, compressed copy of it, cooked next to the executable, and again whenever the .dds
+        // is newer. Copying from it decompresses 64KB bands on the worker pool and tiles each one while
+        // it is still in cache.
+        cString ChunkedFileName = ExecutableDirectory + _L("TestTexture.ddsc");
+        cString TestTextureFileName = pAssetLibrary->GetTextureDirectoryName() + _L("TestTexture.dds");
+        DirectX::DDSCacheKey chunkedKey, sourceKey;
+        if(!DirectX::GetDDSCacheKey(ChunkedFileName.c_str(), &chunkedKey) ||
+           (DirectX::GetDDSCacheKey(TestTextureFileName.c_str(), &sourceKey) && sourceKey.fileTime > chunkedKey.fileTime))
+        {
+            DDSChunkedSource::Cook(TestTextureFileName.c_str(), ChunkedFileName.c_str(), CHUNKED_TEXTURE_COMPRESSION);
+        }
+        bool hasChunkedSource = mChunkedSource.Open(ChunkedFileName.c_str()) &&
+            mChunkedSource.IsKernelCompatible(0) &&
+            mChunkedSource.GetTextureInfo().widthInBlocks == testTextureInfo.widthInBlocks &&
+            mChunkedSource.GetTextureInfo().heightInBlocks == testTextureInfo.heightInBlocks &&
+            mChunkedSource.GetTextureInfo().bytesPerBlock == testTextureInfo.bytesPerBlock;
+        if(!hasChunkedSource)
+        {
+            mChunkedSource.Close();
+        }
+        mDRATextureRing.Create(pDevice, CPUT_DX11::GetContext(), &cpudesc, &gpudesc, DRA_TEXTURE_RING_SIZE, _L("$DRATextureGPU"));
+        mAutoTuner.LoadProfile(ExecutableDirectory + _L("DRATuning.txt"));
 
         ID3D11Texture2D* pDXDestTexture;
         pDevice->CreateTexture2D(&cpudesc, NULL, &pDXDestTexture);
@@ -300,7 +336,18 @@ void MySample::Create()
         pDropdown->AddSelectionItem(_L("Linear Row"), false);
         pDropdown->AddSelectionItem(_L("Linear Column"), false);
         pDropdown->AddSelectionItem(_L("Linear Optimized"), true);
+        pDropdown->AddSelectionItem(_L("Auto Tuned"), false);
         pDropdown->SetVisibility(false);
+        if(hasMappedSource)
+        {
+            pGUI->CreateCheckbox(_L("Copy from mapped .dds"), ID_TEST_MAPPED_SOURCE, ID_MAIN_PANEL, &pCheckbox);
+            pCheckbox->SetCheckboxState(CPUT_CHECKBOX_UNCHECKED);
+        }
+        if(hasChunkedSource)
+        {
+            pGUI->CreateCheckbox(_L("Copy from compressed .ddsc"), ID_TEST_CHUNKED_SOURCE, ID_MAIN_PANEL, &pCheckbox);
+            pCheckbox->SetCheckboxState(CPUT_CHECKBOX_UNCHECKED);
+        }
 
         pGUI->CreateCheckbox(_L("READ"), ID_TEST_READ, ID_MAIN_PANEL, &pCheckbox);
         pCheckbox->SetCheckboxState(CPUT_CHECKBOX_UNCHECKED);
@@ -318,6 +365,7 @@ void MySample::Create()
         pGUI->CreateText( _L("Q - camera position up"), ID_IGNORE_CONTROL_ID, ID_SECONDARY_PANEL);
         pGUI->CreateText( _L("E - camera position down"), ID_IGNORE_CONTROL_ID, ID_SECONDARY_PANEL);
         pGUI->CreateText( _L("mouse + right click - camera look location"), ID_IGNORE_CONTROL_ID, ID_SECONDARY_PANEL);
+        pGUI->CreateText( _L("P - save the DRA texture to Capture_<frame>.dds"), ID_IGNORE_CONTROL_ID, ID_SECONDARY_PANEL);
 
         pGUI->SetActivePanel(ID_MAIN_PANEL);
         pGUI->DrawFPS(true);
@@ -473,7 +521,13 @@ CPUTEventHandledCode MySample::HandleKeyboardEvent(CPUTKey key)
     case KEY_2:
     case KEY_3: 
     case KEY_4:		   
+    case KEY_5:
         {
+            // only the copy test has an auto tuned mode
+            if(key == KEY_5 && ((CPUTCheckbox*)pGUI->GetControl(ID_TEST_COPY))->GetCheckboxState() != CPUT_CHECKBOX_CHECKED)
+            {
+                break;
+            }
             mMode = key - KEY_1; // key 1 maps to mode 0 (tiled), key 2 to 1 (rows) ...  
             CPUTDropdown *pDropdown = NULL;
             CPUTCheckbox *pCheckbox = (CPUTCheckbox*)pGUI->GetControl(ID_TEST_SOLID);
@@ -516,6 +570,11 @@ CPUTEventHandledCode MySample::HandleKeyboardEvent(CPUTKey key)
             HandleCallbackEvent((CPUTEventID)0, controlID, pCheckbox);
         }
         break;
+    case KEY_P:
+        // saved at the end of the next frame
+        mCaptureRequested = true;
+        handled = CPUT_EVENT_HANDLED;
+        break;
     }
     // pass it to the camera controller
     if(handled == CPUT_EVENT_UNHANDLED)
@@ -566,12 +625,26 @@ void MySample::HandleCallbackEvent( CPUTEventID Event, CPUTControlID ControlID,
             pCheckbox->SetCheckboxState(CPUT_CHECKBOX_UNCHECKED);
         }
         break;
+    case ID_TEST_MAPPED_SOURCE:
+        {
+            CPUTCheckbox* pCheckbox = (CPUTCheckbox*)pGUI->GetControl(ID_TEST_MAPPED_SOURCE);
+            mUseMappedSource = pCheckbox->GetCheckboxState() == CPUT_CHECKBOX_CHECKED;
+        }
+        break;
+    case ID_TEST_CHUNKED_SOURCE:
+        {
+            CPUTCheckbox* pCheckbox = (CPUTCheckbox*)pGUI->GetControl(ID_TEST_CHUNKED_SOURCE);
+            mUseChunkedSource = pCheckbox->GetCheckboxState() == CPUT_CHECKBOX_CHECKED;
+        }
+        break;
     case ID_TEST_SOLID:
         {	
             CPUTCheckbox* pCheckbox = (CPUTCheckbox*)pGUI->GetControl(ID_TEST_SOLID);
             pCheckbox->SetCheckboxState(CPUT_CHECKBOX_CHECKED);
             mTest = TEST_SOLID;
+            mMode = MODE_TILED;
             CPUTDropdown *pDropdown = (CPUTDropdown*)pGUI->GetControl(ID_TEST_SOLID_DROPDOWN);
+            pDropdown->SetSelectedItem(mMode);
             pDropdown->SetVisibility(true);
 
             pCheckbox = (CPUTCheckbox*)pGUI->GetControl(ID_TEST_COPY);
@@ -653,11 +726,16 @@ void MySample::Render(double deltaSeconds)
 
     static UINT frame = 0;
 
-    D3D11_MAPPED_SUBRESOURCE mappedResource;
-
-    if(mTest == TEST_COPY)
+    if(mTest == TEST_COPY && !mUseChunkedSource)
     {
-        mTestData = mpTestTexture->MapTexture(renderParams, CPUT_MAP_READ);
+        if(mUseMappedSource)
+        {
+            mMappedSource.GetMip(0, &mTestData);
+        }
+        else
+        {
+            mTestData = mpTestTexture->MapTexture(renderParams, CPUT_MAP_READ);
+        }
     }
     if(mTest == TEST_READ)
     {
@@ -684,33 +762,43 @@ void MySample::Render(double deltaSeconds)
         else
         {
             //Write a solid color to the dra resource.
-            mpContext->Map(mpDRATextureCPU, 0, D3D11_MAP_WRITE, NULL, &mappedResource);
-            INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA *pdata = (INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA*)(mappedResource.pData);
+            INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA *pdata = mDRATextureRing.MapForWrite();
             WriteDRA_Solid(mMode, pdata, &testTextureInfo, 0, frame);
-            mpContext->Unmap(mpDRATextureCPU, 0);
+            mDRATextureRing.Unmap();
         }
     }
     else if(mTest == TEST_COPY)
     {
         // Copies the texture data from the source texture to the dra texture. This test illustrates the
         // cost of doing the swizzle.
-        mpContext->Map(mpDRATextureCPU, 0, D3D11_MAP_WRITE, NULL, &mappedResource);
-        INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA *pdata = (INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA*)(mappedResource.pData);
-        WriteDRA_Copy(mMode, pdata, &testTextureInfo, 0, mTestData);
-        mpContext->Unmap(mpDRATextureCPU, 0);
+        INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA *pdata = mDRATextureRing.MapForWrite();
+        if(mUseChunkedSource)
+        {
+            // decompression is part of the timed copy; the tiling mode is always the optimized linear one
+            mChunkedSource.WriteMip(pdata, 0);
+        }
+        else if(mMode == MODE_AUTO_TUNED)
+        {
+            // the first frame times every candidate, so it is much slower than the ones after it
+            mAutoTuner.WriteDRA_Copy(pdata, &testTextureInfo, 0, mTestData);
+        }
+        else
+        {
+            WriteDRA_Copy(mMode, pdata, &testTextureInfo, 0, mTestData);
+        }
+        mDRATextureRing.Unmap();
     }
     else if(mTest == TEST_READ)
     {
         // Reads from the DRA texture. Note: DRA textures use write combined memory, so reading from this memory is slow.
-        mpContext->Map(mpDRATextureCPU, 0, D3D11_MAP_READ, NULL, &mappedResource);
-        INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA *pdata = (INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA*)(mappedResource.pData);
+        INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA *pdata = mDRATextureRing.MapForRead();
         ReadDRA(mMode, pdata, &testTextureInfo, 0, mTestData);
-        mpContext->Unmap(mpDRATextureCPU, 0);
+        mDRATextureRing.Unmap();
     }
 
     double time = mpTimer->StopTimer();
 
-    if(mTest == TEST_COPY)
+    if(mTest == TEST_COPY && !mUseMappedSource && !mUseChunkedSource)
     {
         mpTestTexture->UnmapTexture(renderParams);
     }
@@ -718,12 +806,28 @@ void MySample::Render(double deltaSeconds)
     {
         mpDestTexture->UnmapTexture(renderParams);
     }
+    if(mCaptureRequested)
+    {
+        // Only the snapshot of the tiles is taken here; detiling and writing the .dds run on the worker pool
+        mCaptureRequested = false;
+        cString fileName;
+        CPUTOSServices::GetOSServices()->GetExecutableDirectory(&fileName);
+        fileName += _L("Capture_") + std::to_wstring((unsigned long long)frame) + _L(".dds");
+        INTC::RESOURCE_EXTENSION_DIRECT_ACCESS::MAP_DATA *pdata = mDRATextureRing.MapForRead();
+        if(pdata != NULL)
+        {
+            mCapture.Capture(pdata, &testTextureInfo, 0, fileName.c_str());
+            mDRATextureRing.Unmap();
+        }
+    }
     double avg = UpdateAverage(time);
 
     if(frame % 30 == 0)
         mpText->SetText(_L("avg Test time: ") + std::to_wstring((long double)(avg*1000)) + _L(" ms"));
     frame++;
     mpDebugSprite->DrawSprite(renderParams);
+    // The sprite was the last draw sampling the DRA texture this frame
+    mDRATextureRing.Submit();
 
     CPUTDrawGUI();
 }
@@ -775,12 +879,30 @@ row_major float4x4 InverseWorld : INVERSEWORLD;\n\
 float4   LightDirection;\n\
 float4   EyePosition;\n\
 row_major float4x4 LightWorldViewProjection;\n\
+row_major float4x4 ViewProjection;\n\
 float4   BoundingBoxCenterWorldSpace;\n\
 float4   BoundingBoxHalfWorldSpace;\n\
 float4   BoundingBoxCenterObjectSpace;\n\
 float4   BoundingBoxHalfObjectSpace;\n\
+float4   QuantizedPositionScale;\n\
+float4   QuantizedPositionBias; // w is 1 when directions are octahedral encoded\n\
 };\n\
 // ********************************************************************************************************\n\
+// Models loaded with CPUTAssetLibrary::SetQuantizeVertices() have 16-bit positions across their\n\
+// bounding box and octahedral normals; the rest get a scale of 1, a bias of 0 and plain normals.\n\
+float3 DecodePosition( float3 position )\n\
+{\n\
+return position * QuantizedPositionScale.xyz + QuantizedPositionBias.xyz;\n\
+}\n\
+float3 DecodeDirection( float3 direction )\n\
+{\n\
+if( QuantizedPositionBias.w == 0.0f ) { return direction; }\n\
+float3 n = float3( direction.xy, 1.0f - abs(direction.x) - abs(direction.y) );\n\
+float  t = saturate( -n.z );\n\
+n.xy += (n.xy >= 0.0f) ? -t : t;\n\
+return normalize( n );\n\
+}\n\
+// ********************************************************************************************************\n\
 // TODO: Note: nothing sets these values yet\n\
 cbuffer cbPerFrameValues\n\
 {\n\
@@ -796,12 +918,13 @@ row_major float4x4 InverseView;\n\
 PS_INPUT VSMain( VS_INPUT input )\n\
 {\n\
 PS_INPUT output = (PS_INPUT)0;\n\
-output.Pos      = mul( float4( input.Pos, 1.0f), WorldViewProjection );\n\
-output.Position = mul( float4( input.Pos, 1.0f), World ).xyz;\n\
+float3 position = DecodePosition( input.Pos );\n\
+output.Pos      = mul( float4( position, 1.0f), WorldViewProjection );\n\
+output.Position = mul( float4( position, 1.0f), World ).xyz;\n\
 // TODO: transform the light into object space instead of the normal into world space\n\
-output.Norm = mul( input.Norm, (float3x3)World );\n\
+output.Norm = mul( DecodeDirection( input.Norm ), (float3x3)World );\n\
 output.Uv   = float2(input.Uv.x, input.Uv.y);\n\
-output.LightUv   = mul( float4( input.Pos, 1.0f), LightWorldViewProjection );\n\
+output.LightUv   = mul( float4( position, 1.0f), LightWorldViewProjection );\n\
 return output;\n\
 }\n\
 // ********************************************************************************************************\n\
@@ -841,11 +964,12 @@ float3 Position : TEXCOORD0; // Object space position \n\
 PS_INPUT_NO_TEX VSMainNoTexture( VS_INPUT_NO_TEX input )\n\
 {\n\
 PS_INPUT_NO_TEX output = (PS_INPUT_NO_TEX)0;\n\
-output.Pos      = mul( float4( input.Pos, 1.0f), WorldViewProjection );\n\
-output.Position = mul( float4( input.Pos, 1.0f), World ).xyz;\n\
+float3 position = DecodePosition( input.Pos );\n\
+output.Pos      = mul( float4( position, 1.0f), WorldViewProjection );\n\
+output.Position = mul( float4( position, 1.0f), World ).xyz;\n\
 // TODO: transform the light into object space instead of the normal into world space\n\
-output.Norm = mul( input.Norm, (float3x3)World );\n\
-output.LightUv   = mul( float4( input.Pos, 1.0f), LightWorldViewProjection );\n\
+output.Norm = mul( DecodeDirection( input.Norm ), (float3x3)World );\n\
+output.LightUv   = mul( float4( position, 1.0f), LightWorldViewProjection );\n\
 return output;\n\
 }\n\
 // ********************************************************************************************************\n\
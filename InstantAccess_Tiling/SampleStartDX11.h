@@ -28,8 +28,16 @@
 #endif
 
 #include "InstantAccess_Tiling.h"
+#include "DRATextureRing.h"
+#include "DRAAutoTuner.h"
+#include "DDSMappedSource.h"
+#include "DDSChunkedSource.h"
+#include "DRACapture.h"
 #define MODE_DX 3
 
+// Number of DRA textures cycled through so the CPU never maps the one the GPU is sampling
+#define DRA_TEXTURE_RING_SIZE 3
+
 
 // define some controls
 const CPUTControlID ID_MAIN_PANEL = 10;
@@ -59,7 +67,14 @@ private:
 #ifdef USE_SSAO
     SSAOTechnique          mSSAO;
 #endif
-    ID3D11Texture2D *mpDRATextureCPU;
+    DRATextureRing mDRATextureRing;
+    DRAAutoTuner mAutoTuner;
+    DDSMappedSource mMappedSource;
+    bool mUseMappedSource;
+    DDSChunkedSource mChunkedSource;
+    bool mUseChunkedSource;
+    DRACapture mCapture;
+    bool mCaptureRequested;
     TextureInfo testTextureInfo;
     bool mHasDRA;
     UINT mMode;
@@ -72,7 +87,9 @@ public:
         mpShadowCameraSet(NULL),
         mpShadowRenderTarget(NULL),
         mHasDRA(false),
-        mpDRATextureCPU(NULL),
+        mUseMappedSource(false),
+        mUseChunkedSource(false),
+        mCaptureRequested(false),
         mpTestTexture(NULL),
 		mpDestTexture(NULL),
         mMode(MODE_TILED),
@@ -83,7 +100,6 @@ public:
         // Note: these two are defined in the base.  We release them because we addref them.
         SAFE_RELEASE(mpCamera);
         SAFE_RELEASE(mpShadowCamera);
-        SAFE_RELEASE(mpDRATextureCPU);
         SAFE_RELEASE(mpAssetSet);
         SAFE_DELETE( mpCameraController );
         SAFE_DELETE( mpDebugSprite);